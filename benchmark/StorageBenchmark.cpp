@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Backend;
+
+namespace {
+
+const std::size_t memory = 64 * 1024 * 1024;
+
+// Every stripe of StripedLRU needs at least a megabyte
+std::size_t StripedMemory(std::size_t limit, std::size_t stripes) {
+    return std::max(limit, stripes * 1024 * 1024);
+}
+
+/**
+ * Storages under test, stripes are ignored by unstriped ones
+ */
+struct Simple {
+    static std::unique_ptr<Storage> Make(std::size_t limit, std::size_t) {
+        return std::unique_ptr<Storage>(new SimpleLRU(limit));
+    }
+};
+
+struct Locked {
+    static std::unique_ptr<Storage> Make(std::size_t limit, std::size_t) {
+        return std::unique_ptr<Storage>(new ThreadSafeSimplLRU(limit));
+    }
+};
+
+struct Striped {
+    static std::unique_ptr<Storage> Make(std::size_t limit, std::size_t stripes) {
+        return std::unique_ptr<Storage>(BuildStripedLRU(StripedMemory(limit, stripes), stripes));
+    }
+};
+
+// xorshift, so that picking a key costs next to nothing next to the operation
+class Random {
+public:
+    explicit Random(uint64_t seed) : _state(seed * 2654435761u + 1) {}
+
+    uint64_t Next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 7;
+        _state ^= _state << 17;
+        return _state;
+    }
+
+private:
+    uint64_t _state;
+};
+
+// Key of given size ending with the number, so keys of any size stay distinct
+std::string Key(uint64_t n, std::size_t size) {
+    char digits[32];
+    int length = std::snprintf(digits, sizeof(digits), "%016llx", static_cast<unsigned long long>(n));
+    std::string key(std::max<std::size_t>(size, length), 'k');
+    key.replace(key.size() - length, length, digits);
+    return key;
+}
+
+std::vector<std::string> Keys(std::size_t count, std::size_t size, uint64_t first = 0) {
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        keys.push_back(Key(first + i, size));
+    }
+    return keys;
+}
+
+void Fill(Storage &storage, const std::vector<std::string> &keys, const std::string &value) {
+    for (auto &key : keys) {
+        storage.Put(key, value);
+    }
+}
+
+/**
+ * Get of a present key, args: number of keys
+ */
+template <typename Kind> void BM_GetHit(benchmark::State &state) {
+    std::unique_ptr<Storage> storage = Kind::Make(memory, 16);
+    std::vector<std::string> keys = Keys(state.range(0), 16);
+    Fill(*storage, keys, std::string(32, 'v'));
+
+    Random random(1);
+    std::string value;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(storage->Get(keys[random.Next() % keys.size()], value));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Get of an absent key in a storage with given number of keys
+ */
+template <typename Kind> void BM_GetMiss(benchmark::State &state) {
+    std::unique_ptr<Storage> storage = Kind::Make(memory, 16);
+    Fill(*storage, Keys(state.range(0), 16), std::string(32, 'v'));
+    std::vector<std::string> absent = Keys(state.range(0), 16, state.range(0));
+
+    Random random(1);
+    std::string value;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(storage->Get(absent[random.Next() % absent.size()], value));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Put of a new key into a full storage, so every put evicts. Args: value size
+ */
+template <typename Kind> void BM_PutEvict(benchmark::State &state) {
+    const std::size_t limit = 16 * 1024 * 1024;
+    std::unique_ptr<Storage> storage = Kind::Make(limit, 16);
+    std::string value(state.range(0), 'v');
+
+    // Twice as many bytes as storage holds
+    uint64_t n = 0;
+    for (std::size_t filled = 0; filled < 2 * limit; filled += 16 + value.size()) {
+        storage->Put(Key(n++, 16), value);
+    }
+
+    std::string key = Key(n, 16);
+    char digits[32];
+    for (auto _ : state) {
+        // Rewrites digits in place instead of building a new string
+        std::snprintf(digits, sizeof(digits), "%016llx", static_cast<unsigned long long>(n++));
+        key.replace(0, 16, digits, 16);
+        benchmark::DoNotOptimize(storage->Put(key, value));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+/**
+ * Gets and puts of existing keys, args: percent of gets
+ */
+template <typename Kind> void BM_Mixed(benchmark::State &state) {
+    std::unique_ptr<Storage> storage = Kind::Make(memory, 16);
+    std::vector<std::string> keys = Keys(10000, 16);
+    std::string put_value(32, 'w');
+    Fill(*storage, keys, std::string(32, 'v'));
+
+    const uint64_t gets = state.range(0);
+    Random random(1);
+    std::string value;
+    for (auto _ : state) {
+        uint64_t r = random.Next();
+        const std::string &key = keys[(r >> 8) % keys.size()];
+        if (r % 100 < gets) {
+            benchmark::DoNotOptimize(storage->Get(key, value));
+        } else {
+            benchmark::DoNotOptimize(storage->Put(key, put_value));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Put and Get of a key of given size with value of given size, args: key size, value size
+ */
+template <typename Kind> void BM_Sizes(benchmark::State &state) {
+    std::unique_ptr<Storage> storage = Kind::Make(memory, 16);
+    const std::size_t count = std::min<std::size_t>(10000, memory / 2 / (state.range(0) + state.range(1)));
+    std::vector<std::string> keys = Keys(count, state.range(0));
+    std::string put_value(state.range(1), 'v');
+    Fill(*storage, keys, put_value);
+
+    Random random(1);
+    std::string value;
+    for (auto _ : state) {
+        const std::string &key = keys[random.Next() % keys.size()];
+        benchmark::DoNotOptimize(storage->Put(key, put_value));
+        benchmark::DoNotOptimize(storage->Get(key, value));
+    }
+    state.SetItemsProcessed(2 * state.iterations());
+    state.SetBytesProcessed(2 * state.iterations() * (state.range(0) + state.range(1)));
+}
+
+// Storage shared by threads of a contention run, built by Setup before threads start
+std::unique_ptr<Storage> shared;
+std::vector<std::string> shared_keys;
+
+template <typename Kind> void SetupContention(const benchmark::State &state) {
+    shared = Kind::Make(memory, state.range(0));
+    shared_keys = Keys(1000, 16);
+    Fill(*shared, shared_keys, std::string(32, 'v'));
+}
+
+void TeardownContention(const benchmark::State &) {
+    shared.reset();
+    shared_keys.clear();
+}
+
+/**
+ * Threads run 90% gets and 10% puts over a small hot key set of a shared storage, args: stripes
+ */
+template <typename Kind> void BM_Contention(benchmark::State &state) {
+    std::string put_value(32, 'w');
+    Random random(state.thread_index() + 1);
+    std::string value;
+    for (auto _ : state) {
+        uint64_t r = random.Next();
+        const std::string &key = shared_keys[(r >> 8) % shared_keys.size()];
+        if (r % 10 != 0) {
+            benchmark::DoNotOptimize(shared->Get(key, value));
+        } else {
+            benchmark::DoNotOptimize(shared->Put(key, put_value));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void KeyCounts(benchmark::internal::Benchmark *b) { b->RangeMultiplier(10)->Range(100, 100000); }
+
+void SizeSweep(benchmark::internal::Benchmark *b) {
+    b->ArgNames({"key", "value"});
+    for (int key : {8, 32, 128}) {
+        for (int value : {16, 256, 4096, 65536}) {
+            b->Args({key, value});
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_GetHit, Simple)->Apply(KeyCounts);
+BENCHMARK_TEMPLATE(BM_GetHit, Locked)->Apply(KeyCounts);
+BENCHMARK_TEMPLATE(BM_GetHit, Striped)->Apply(KeyCounts);
+
+BENCHMARK_TEMPLATE(BM_GetMiss, Simple)->Apply(KeyCounts);
+BENCHMARK_TEMPLATE(BM_GetMiss, Locked)->Apply(KeyCounts);
+BENCHMARK_TEMPLATE(BM_GetMiss, Striped)->Apply(KeyCounts);
+
+BENCHMARK_TEMPLATE(BM_PutEvict, Simple)->Arg(32)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_PutEvict, Locked)->Arg(32)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_PutEvict, Striped)->Arg(32)->Arg(1024);
+
+BENCHMARK_TEMPLATE(BM_Mixed, Simple)->ArgName("gets%")->Arg(50)->Arg(90)->Arg(99);
+BENCHMARK_TEMPLATE(BM_Mixed, Locked)->ArgName("gets%")->Arg(50)->Arg(90)->Arg(99);
+BENCHMARK_TEMPLATE(BM_Mixed, Striped)->ArgName("gets%")->Arg(50)->Arg(90)->Arg(99);
+
+BENCHMARK_TEMPLATE(BM_Sizes, Simple)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Sizes, Locked)->Apply(SizeSweep);
+BENCHMARK_TEMPLATE(BM_Sizes, Striped)->Apply(SizeSweep);
+
+// SimpleLRU is not thread safe, stripe count is what the curve is for
+BENCHMARK_TEMPLATE(BM_Contention, Locked)
+    ->ArgName("stripes")
+    ->Arg(1)
+    ->Setup(SetupContention<Locked>)
+    ->Teardown(TeardownContention)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention, Striped)
+    ->ArgName("stripes")
+    ->RangeMultiplier(4)
+    ->Range(1, 256)
+    ->Setup(SetupContention<Striped>)
+    ->Teardown(TeardownContention)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
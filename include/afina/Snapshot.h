@@ -0,0 +1,164 @@
+#ifndef AFINA_SNAPSHOT_H
+#define AFINA_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Afina {
+
+/**
+ * # Storage snapshot file
+ * Snapshot keeps items as records of key and value sizes followed by key and value bytes, sizes are varints,
+ * so small items take just two bytes on top of their data. Storage writes items from the least recently used
+ * to the most recently used one, so that loading them one after another restores the recency order.
+ *
+ * Records are grouped in sections, every section is checksummed and could be read and loaded independently
+ * of others, which is what lets loader use several threads. Sections are followed by their table and a
+ * trailer pointing to it, so writer streams sections out as storage produces them. Numbers are in native
+ * byte order, snapshot is not portable between architectures.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * Starts snapshot that replaces file at path on Commit, until then data goes to path.tmp. Throws
+     * std::runtime_error if file couldn't be created
+     */
+    explicit SnapshotWriter(const std::string &path);
+
+    /**
+     * Removes unfinished snapshot, if any
+     */
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter &) = delete;
+    SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+    /**
+     * Appends record to the current section, data are copied right away
+     */
+    void Add(const char *key, std::size_t key_size, const char *value, std::size_t value_size);
+    void Add(const std::string &key, const std::string &value) {
+        Add(key.data(), key.size(), value.data(), value.size());
+    }
+
+    /**
+     * Bytes in the current section so far
+     */
+    std::size_t Pending() const { return _section.size(); }
+
+    /**
+     * Writes the current section out, the next record starts a new one. Empty sections are skipped
+     */
+    void EndSection();
+
+    /**
+     * Ends the last section, writes table, syncs file to disk and puts it in place of the old snapshot
+     */
+    void Commit();
+
+    /**
+     * Number of records and bytes written so far
+     */
+    std::size_t Records() const { return _records; }
+    std::size_t Bytes() const { return _offset; }
+
+private:
+    // Section in the table
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t records;
+        uint64_t checksum;
+    };
+
+    void write(const char *data, std::size_t size);
+
+    std::string _path;
+    std::string _tmp_path;
+    int _fd;
+
+    std::string _section;
+    std::size_t _section_records;
+    std::vector<Entry> _table;
+
+    std::size_t _records;
+    std::size_t _offset;
+};
+
+/**
+ * Reads snapshot written by SnapshotWriter
+ */
+class SnapshotReader {
+public:
+    /**
+     * Records of a single section, keys and values point into reader buffer and are valid only during
+     * the call they are passed to
+     */
+    class Section {
+    public:
+        Section(std::size_t index, const char *data, std::size_t size) : _index(index), _pos(data), _end(data + size) {}
+
+        /**
+         * Position of the section in snapshot, sections are written in this order
+         */
+        std::size_t Index() const { return _index; }
+
+        /**
+         * Takes the next record, returns false once there is none. Throws std::runtime_error if record is
+         * malformed
+         */
+        bool Next(const char *&key, std::size_t &key_size, const char *&value, std::size_t &value_size);
+
+    private:
+        std::size_t _index;
+        const char *_pos;
+        const char *_end;
+    };
+
+    /**
+     * Opens snapshot and reads its table. Throws std::runtime_error if file couldn't be read or isn't
+     * a complete snapshot
+     */
+    explicit SnapshotReader(const std::string &path);
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader &) = delete;
+    SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+    /**
+     * Number of sections and records in snapshot
+     */
+    std::size_t Sections() const { return _table.size(); }
+    std::size_t Records() const;
+
+    /**
+     * Reads sections by up to threads threads and calls fn for every one of them from the thread that read it.
+     * Every thread reads whole sections with large sequential reads, so disk stays busy while other threads
+     * check and load sections they already have. Sections come in no particular order, fn must be thread safe.
+     * Throws std::runtime_error if a section couldn't be read or is corrupted, also rethrows exception of fn,
+     * sections not taken yet are skipped then
+     */
+    void Read(std::size_t threads, const std::function<void(Section &)> &fn);
+
+private:
+    // Section in the table
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t records;
+        uint64_t checksum;
+    };
+
+    void read(char *data, std::size_t size, uint64_t offset);
+
+    std::string _path;
+    int _fd;
+    std::vector<Entry> _table;
+};
+
+} // namespace Afina
+
+#endif // AFINA_SNAPSHOT_H
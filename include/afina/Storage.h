@@ -1,10 +1,16 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstddef>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
+class SnapshotReader;
+class SnapshotWriter;
+
 /**
  *
  */
@@ -84,6 +90,40 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Reports engine specific statistics of memcached "stats <group>", for example "slabs", as name/value
+     * pairs in the order they should be printed
+     *
+     * Method returns false if storage knows nothing about the group
+     *
+     * @param group name of the statistics group
+     * @param stats output parameter to append pairs to
+     */
+    virtual bool Stats(const std::string &group, std::vector<std::pair<std::string, std::string>> &stats) {
+        return false;
+    }
+
+    /**
+     * Writes all items to snapshot, least recently used first, and ends the section of the last of them.
+     * Thread safe storages keep serving requests meanwhile, except for the part being copied
+     *
+     * Method returns false if storage can't be saved, throws std::runtime_error if snapshot couldn't be written
+     *
+     * @param snapshot output parameter to add items to
+     */
+    virtual bool Save(SnapshotWriter &snapshot) { return false; }
+
+    /**
+     * Fills empty storage with items of snapshot restoring their recency order, up to threads threads read
+     * and load snapshot sections in parallel. Items that don't fit get evicted as usual
+     *
+     * Method returns false if storage can't be loaded, throws std::runtime_error if snapshot couldn't be read
+     *
+     * @param snapshot to take items from
+     * @param threads number of threads to use
+     */
+    virtual bool Load(SnapshotReader &snapshot, std::size_t threads) { return false; }
 };
 
 } // namespace Afina
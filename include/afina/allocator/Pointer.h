@@ -7,6 +7,13 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle of memory block allocated by Simple. Block could be moved by defragmentation, so handle doesn't keep
+ * block address itself but refers to a descriptor in allocator table and allocator updates descriptor when
+ * moves block. Copies of the handle refer to the same block.
+ *
+ * Address returned by get() is valid until next defrag() or realloc() of this block
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +24,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _desc == nullptr ? nullptr : *_desc; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **desc);
+
+    // Descriptor of the block or nullptr if pointer is empty
+    void **_desc;
 };
 
 } // namespace Allocator
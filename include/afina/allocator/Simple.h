@@ -18,6 +18,15 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Memory layout: blocks are placed one after another from the beginning of the area, each one is prefixed by
+ * header with its size and descriptor. Descriptors table grows down from the end of the area. Space between
+ * last block and the table is free, blocks released in the middle are kept in free list and reused by
+ * first fit. Defragmentation slides all live blocks down to the beginning, so the whole free memory becomes
+ * one chunk again, and updates descriptors so that Pointer instances keep working.
+ *
+ * Allocator never moves blocks on its own: alloc fails with NoMemory if there is no chunk big enough even
+ * though free_space says there is enough memory, it is up to the caller to decide when to pay for defrag
  */
 // TODO: Implements interface to allow usage as C++ allocators
 class Simple {
@@ -25,37 +34,92 @@ public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes. Throws AllocError of type NoMemory if there is no free chunk
+     * large enough
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block keeping its content, up to the minimum of old and new sizes. Block is resized
+     * in place if possible, otherwise it is moved and p is updated, as well as all its copies. Empty p is
+     * allocated from scratch. On failure throws AllocError, p stays valid then
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block and resets p. Throws AllocError of type InvalidFree if p doesn't refer to live block of
+     * this allocator
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all live blocks to the beginning of the area so that all free memory becomes a single chunk.
+     * Takes time proportional to the size of live data, invalidates addresses got from Pointer::get
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Size of the largest block that could be allocated after defrag
+     */
+    size_t free_space() const;
+
+    /**
+     * Human readable map of the area, block by block
      */
     std::string dump() const;
 
 private:
+    struct Block;
+
+    /**
+     * Takes unused descriptor, throws NoMemory if there is no space for table to grow
+     */
+    void **new_descriptor();
+
+    /**
+     * Looks for free chunk of size bytes, returns nullptr if there is none
+     */
+    Block *find_block(size_t size);
+
+    /**
+     * Live block the pointer refers to, throws InvalidFree if there is none
+     */
+    Block *block_of(const Pointer &p) const;
+
+    /**
+     * Cuts tail of the block off if it is large enough to hold another block and releases it
+     */
+    void shrink(Block *block, size_t size);
+
+    /**
+     * Marks block as free: returns it to the top or puts into free list
+     */
+    void release(Block *block);
+
+    /**
+     * Removes block from the free list
+     */
+    void unlink(Block *block);
+
     void *_base;
     const size_t _base_len;
+
+    // Area of blocks, aligned, and end of the last block there
+    char *_begin;
+    char *_top;
+
+    // Descriptors table occupies [_desc_low, _desc_end), released descriptors are chained through themselves
+    void **_desc_low;
+    void **_desc_end;
+    void **_free_desc;
+
+    // Released blocks below _top, chained through their payload, and their total size including headers
+    Block *_free_blocks;
+    size_t _free_bytes;
 };
 
 } // namespace Allocator
@@ -0,0 +1,311 @@
+#ifndef AFINA_ALLOCATOR_SLAB_H
+#define AFINA_ALLOCATOR_SLAB_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Slab allocator with size classes
+ * The whole memory_limit is reserved at once as a single region, backed by huge pages if kernel allows, and
+ * cut into slabs of slab_size bytes. A slab is given to a size class on demand and split into equal chunks
+ * of the class size. Class sizes grow geometrically by factor as in memcached, so chunk never wastes more
+ * than factor - 1 of itself and memory never gets fragmented: usage is bounded by the limit whatever sizes
+ * come and go. Chunks of a fresh slab are handed out one after another, so its pages are faulted in only
+ * once they are actually needed.
+ *
+ * Free chunks are moved around in magazines, batches of a fixed number of chunks linked through themselves.
+ * Every thread keeps two magazines per class: alloc and free work on the loaded one taking only a flag of
+ * the thread's own cache, when it runs empty or full it is swapped with the previous one, and only if both
+ * are empty or full a whole magazine is taken from or put to the class depot, a lock-free stack. So chunks freed by another
+ * thread than allocated them come back in batches with a single CAS, and threads on different cores meet
+ * only once per magazine. Class lock is taken only to carve chunks out of new slabs. Chunks larger than
+ * the cache could hold bypass thread caches and go to the depot one by one.
+ *
+ * A slab could be moved to another class when the workload changes, see begin_move
+ */
+class Slab {
+public:
+    // Classes are numbered from 0, memcached limit
+    static constexpr std::size_t max_classes = 64;
+
+    // Chunk size alignment
+    static constexpr std::size_t alignment = 8;
+
+    /**
+     * @param memory_limit bytes for all slabs, rounded down to slab_size but at least one slab
+     * @param slab_size bytes in a slab, rounded up to power of two, that is also the largest chunk
+     * @param min_chunk size of the smallest class
+     * @param factor ratio of neighbour class sizes
+     */
+    Slab(std::size_t memory_limit, std::size_t slab_size = 1024 * 1024, std::size_t min_chunk = 64,
+         double factor = 1.25);
+    ~Slab();
+
+    Slab(const Slab &) = delete;
+    Slab &operator=(const Slab &) = delete;
+
+    /**
+     * Number of size classes
+     */
+    std::size_t classes() const { return _class_count; }
+
+    /**
+     * The largest size that could be allocated
+     */
+    std::size_t max_size() const { return _slab_size; }
+
+    /**
+     * Class of the smallest chunks that fit size bytes, size must not exceed max_size
+     */
+    std::size_t class_of(std::size_t size) const;
+
+    /**
+     * Chunk size of the class
+     */
+    std::size_t chunk_size(std::size_t cls) const { return _classes[cls].size; }
+
+    /**
+     * Takes a chunk of the class. Returns nullptr once class has no free chunks and there are no free slabs
+     * left: for a cache that is normal state, not an error, so no exception is thrown
+     */
+    void *alloc(std::size_t cls);
+
+    /**
+     * Returns chunk to its class, could be called by any thread. Throws AllocError of type InvalidFree if
+     * ptr is not a chunk of this allocator
+     */
+    void free(void *ptr);
+
+    /**
+     * Chunks accounting of a single class
+     */
+    struct ClassStats {
+        std::size_t chunk_size;
+        std::size_t chunks_per_slab;
+        std::size_t slabs;
+
+        // Handed out and not freed yet
+        std::size_t used_chunks;
+
+        // Freed ones: in the class depot or cached by threads
+        std::size_t free_chunks;
+
+        // Never used yet at the end of the newest slab
+        std::size_t free_chunks_end;
+
+        // Times alloc found no chunk, that is how much the class lacks memory
+        std::size_t failures;
+    };
+
+    /**
+     * Accounting of every class, could run concurrently with alloc and free
+     */
+    std::vector<ClassStats> stats() const;
+
+    /**
+     * Number of slabs in total and given to classes so far
+     */
+    std::size_t total_slabs() const { return _slab_count; }
+    std::size_t used_slabs() const;
+
+    /**
+     * Number of slabs moved between classes so far
+     */
+    std::size_t slabs_moved() const { return _slabs_moved.load(std::memory_order_relaxed); }
+
+    /**
+     * Starts moving a slab of class from to class to, returns false if from has less than two slabs. Slab is
+     * moved once every its chunk is back: chunks freed or found free from now on are put aside instead of
+     * being reused, the owner must free live chunks in [begin, end) of moving_range. Moves go one at a time,
+     * begin_move, finish_move and cancel_move must be called by a single thread. Slab of a cancelled move is
+     * the last one to be picked again
+     */
+    bool begin_move(std::size_t from, std::size_t to);
+
+    /**
+     * Class and range of the slab being moved, returns false if there is no move
+     */
+    bool moving_range(std::size_t &cls, char *&begin, char *&end) const;
+
+    /**
+     * Collects free chunks of the slab from the class depot and thread caches and completes move if all
+     * chunks are back. Returns true once slab is given to the new class
+     */
+    bool finish_move();
+
+    /**
+     * Chunks of the moving slab that are not back yet. Right after finish_move that is the live ones, which
+     * only the owner could free
+     */
+    std::size_t moving_left() const;
+
+    /**
+     * Gives up the move, chunks put aside return to the class
+     */
+    void cancel_move();
+
+    /**
+     * Whether region is backed by reserved huge pages (MAP_HUGETLB) rather than transparent ones on kernel's
+     * discretion
+     */
+    bool huge_pages() const { return _hugetlb; }
+
+private:
+    /**
+     * Lock-free stack of magazines, linked through the second word of their first chunks. Head keeps chunk
+     * offset along with a counter bumped on every change, so that CAS fails if head was popped and pushed back
+     * meanwhile (ABA)
+     */
+    struct Depot {
+        Depot() : head(0), magazines(0) {}
+
+        std::atomic<uint64_t> head;
+        std::atomic<std::size_t> magazines;
+    };
+
+    struct Class {
+        std::size_t size;
+        std::size_t per_slab;
+
+        // Chunks in a magazine, one for classes not cached by threads
+        std::size_t magazine;
+        bool cached;
+
+        Depot depot;
+
+        // Guards carving, spare chunks and move of the class slab
+        std::mutex lock;
+
+        // Unused tail of the newest slab
+        char *carve;
+        char *carve_end;
+
+        // Free chunks not making a full magazine, left after depot was sorted out by move
+        void *spare;
+        std::size_t spare_count;
+
+        std::size_t slabs;
+        std::atomic<std::size_t> failures;
+    };
+
+    /**
+     * Slab being moved and its chunks put aside so far
+     */
+    struct Move {
+        std::size_t slab;
+        std::size_t from;
+        std::size_t to;
+        std::size_t reclaimed;
+        std::vector<uint64_t> bitmap;
+    };
+
+    /**
+     * Magazines of the owner thread. Counts are read by stats from other threads, magazines holding chunks of
+     * the moving slab are taken away by finish_move under busy flag, so that a thread that doesn't use the
+     * class anymore never holds the move
+     */
+    struct Cache {
+        Cache() : busy(false) {}
+
+        struct Bin {
+            Bin() : loaded(nullptr), loaded_count(0), previous(nullptr), previous_count(0) {}
+
+            void *loaded;
+            std::atomic<std::size_t> loaded_count;
+
+            // Either empty or full
+            void *previous;
+            std::atomic<std::size_t> previous_count;
+        };
+
+        Bin bins[max_classes];
+
+        // Owner takes it on every cached alloc and free, finish_move only while a slab is moving, so it is
+        // contended only then
+        std::atomic<bool> busy;
+    };
+
+    void push(Depot &depot, void *magazine);
+
+    void *pop(Depot &depot);
+
+    /**
+     * Takes a chunk of the class the regular way, may return a chunk of the moving slab
+     */
+    void *take(std::size_t cls);
+
+    /**
+     * Puts aside chunk of the moving slab, returns false if slab is not moving anymore. Takes class lock
+     */
+    bool divert(void *chunk);
+
+    /**
+     * Takes magazines holding chunks of the moving slab out of thread caches of the class, appends their
+     * chunks to list. Class lock must not be held, owners take it under their busy flag
+     */
+    void drain(std::size_t cls, std::vector<void *> &chunks);
+
+    /**
+     * Marks chunk of the moving slab as returned, class lock of the move source must be held
+     */
+    void reclaim(void *chunk);
+
+    /**
+     * Puts chunk into spare list and pushes full magazines out of there to depot, class lock must be held
+     */
+    void add_spare(Class &cls, void *chunk);
+
+    bool is_moving(void *chunk) const {
+        return (static_cast<std::size_t>(static_cast<char *>(chunk) - _region) >> _slab_shift) ==
+               _moving_slab.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Cuts up to count chunks out of the newest slab of the class or a new one, returns them linked and their
+     * number in count
+     */
+    void *carve(Class &cls, std::size_t id, std::size_t &count);
+
+    void map_region(std::size_t size);
+
+    char *_region;
+    std::size_t _region_len;
+    bool _hugetlb;
+
+    std::size_t _slab_size;
+    unsigned _slab_shift;
+    std::size_t _slab_count;
+
+    // Next slab to give out
+    std::atomic<std::size_t> _next_slab;
+
+    // Class of every slab given out, written before any chunk of the slab is
+    std::unique_ptr<std::atomic<uint8_t>[]> _slab_class;
+
+    // Slab being moved or _slab_count, changed under lock of the move source class
+    std::atomic<std::size_t> _moving_slab;
+    Move _move;
+    std::atomic<std::size_t> _slabs_moved;
+
+    // Slab begin_move starts looking from, next to the last cancelled one
+    std::size_t _move_start;
+
+    std::size_t _class_count;
+    std::unique_ptr<Class[]> _classes;
+
+    mutable Concurrency::ThreadLocal<Cache> _caches;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_H
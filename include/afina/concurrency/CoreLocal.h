@@ -1,12 +0,0 @@
-#ifndef AFINA_CONCURRENCY_CORE_LOCAL_H
-#define AFINA_CONCURRENCY_CORE_LOCAL_H
-
-namespace Afina {
-namespace Concurrency {
-
-template <typename T> class CoreLocal {};
-
-} // namespace Concurrency
-} // namespace Afina
-
-#endif // AFINA_CONCURRENCY_CORE_LOCAL_H
@@ -8,11 +8,20 @@
 #include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <stdexcept>
 #include <string>
 #include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <afina/concurrency/Future.h>
+#include <afina/concurrency/InlineTask.h>
+#include <afina/concurrency/MPMCQueue.h>
+#include <afina/concurrency/WorkStealingQueue.h>
 
 namespace Afina {
 namespace Concurrency {
@@ -21,6 +30,25 @@ namespace Concurrency {
 * # Thread pool
 */
 class Executor {
+public:
+    /**
+     * Unit of work, callables up to 64 bytes are stored without heap allocation
+     */
+    using Task = InlineTask<64>;
+
+    /**
+     * How tasks are distributed between threads
+     */
+    enum class Mode {
+        // Single queue protected by mutex. Simple, but every Execute and every task taken contend on the same lock
+        kSharedQueue,
+
+        // Each thread owns a work stealing deque, tasks from outside go through lock-free injection queue.
+        // Idle threads steal from others, spin for a while and only then park
+        kWorkStealing
+    };
+
+private:
     enum class State {
         // Threadpool is fully operational, tasks could be added and get executed
         kRun,
@@ -45,8 +73,63 @@ private:
      */
     void perform();
 
+    /**
+     * Same as perform but for kWorkStealing mode, index is the slot of the thread in workers array
+     */
+    void perform_stealing(std::size_t index);
+
+    /**
+     * Execute implementations for both modes. Enqueue up to count tasks from the given array, moving them out,
+     * and return how many were accepted
+     */
+    std::size_t execute_shared(Task *batch, std::size_t count);
+    std::size_t execute_stealing(Task *batch, std::size_t count);
+
+    /**
+     * Makes sure ring of kSharedQueue mode could hold at least size tasks, must be called with mutex held
+     */
+    void reserve_tasks(std::size_t size);
+
+    /**
+     * Starts new thread in kSharedQueue mode, must be called with mutex held
+     */
+    void spawn_shared();
+
+    /**
+     * Whether callable could be turned into Task without allocation
+     */
+    template <typename Fn>
+    struct stored_inline : std::integral_constant<bool, std::is_same<Fn, Task>::value || Task::fits<Fn>()> {};
+
+    /**
+     * Wraps callable into Task, big ones go through std::function and so cost an allocation
+     */
+    template <typename F> static Task make_task(F &&func) {
+        return make_task(std::forward<F>(func), stored_inline<typename std::decay<F>::type>());
+    }
+    template <typename F> static Task make_task(F &&func, std::true_type) { return Task(std::forward<F>(func)); }
+    template <typename F> static Task make_task(F &&func, std::false_type) {
+        return Task(std::function<void()>(std::forward<F>(func)));
+    }
+
+    /**
+     * Wakes up parked thread or starts a new one if all threads are busy, kWorkStealing mode only
+     */
+    void wake_or_spawn();
+
+    /**
+     * Starts thread in the free slot, must be called with mutex held, kWorkStealing mode only
+     */
+    void spawn_stealing();
+
+    /**
+     * Finds task for the given thread: own deque, then injection queue, then other threads deques
+     */
+    Task *find_task(std::size_t index);
+
     const std::size_t low_watermark, high_watermark, max_queue_size;
     const std::chrono::milliseconds idle_time;
+    const Mode mode;
 
     /**
      * Mutex to protect state below from concurrent modification
@@ -62,23 +145,46 @@ private:
     std::condition_variable stop_condition;
 
     /**
-     * Task queue
+     * Task queue, ring buffer that grows up to max_queue_size and never shrinks
      */
-    std::deque<std::function<void()>> tasks;
+    std::vector<Task> tasks;
+    std::size_t tasks_head, tasks_size;
 
     /**
      * Flag to stop bg threads
      */
-    State state;
+    std::atomic<State> state;
 
     std::size_t threads_cnt, free_threads;
 
+    /**
+     * Per thread state in kWorkStealing mode, one slot per possible thread
+     */
+    struct Worker;
+    std::unique_ptr<Worker[]> workers;
+
+    /**
+     * Preallocated storage for max_queue_size tasks and list of free entries there, kWorkStealing mode only.
+     * Queues pass pointers into it around
+     */
+    std::unique_ptr<Task[]> slots;
+    MPMCQueue<Task *> free_slots;
+
+    /**
+     * Tasks submitted by threads outside of the pool, kWorkStealing mode only
+     */
+    MPMCQueue<Task *> injected;
+
+    /**
+     * Counters for kWorkStealing mode: tasks waiting in any queue, Execute calls in progress, running threads,
+     * threads looking for work and threads sleeping on empty_condition
+     */
+    std::atomic<std::size_t> queued, submitting, running, idle, parked;
+
 public:
     Executor(std::size_t low_watermark, std::size_t high_watermark, std::size_t max_queue_size,
-             std::chrono::milliseconds idle_time)
-            : low_watermark(low_watermark), high_watermark(high_watermark), max_queue_size(max_queue_size),
-              idle_time(idle_time), threads_cnt(0), free_threads(0), state(State::kStopped) {}
-    ~Executor() { Stop(true); }
+             std::chrono::milliseconds idle_time, Mode mode = Mode::kSharedQueue);
+    ~Executor();
 
     /**
      * Start thread pool
@@ -102,28 +208,73 @@ public:
      */
     template <typename F, typename... Types> bool Execute(F &&func, Types... args) {
         // Prepare "task"
-        auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
+        return Execute(make_task(std::bind(std::forward<F>(func), std::forward<Types>(args)...)));
+    }
 
-        std::unique_lock<std::mutex> lock(this->mutex);
-        if (state != State::kRun or tasks.size() >= max_queue_size) {
-            return false;
+    /**
+     * Same as above for already prepared task. Never allocates memory, so this is the way to submit many small
+     * tasks, for example lambdas capturing a few pointers
+     */
+    bool Execute(Task &&task) {
+        if (mode == Mode::kWorkStealing) {
+            return execute_stealing(&task, 1) == 1;
         }
+        return execute_shared(&task, 1) == 1;
+    }
 
-        // Enqueue new task
-        tasks.push_back(exec);
-        if (free_threads >= 1) {
-            empty_condition.notify_one();
-        } else {
-            if (threads_cnt < high_watermark) {
-                threads_cnt++;
-                free_threads++;
-                //lock.unlock();
-                std::thread new_thread(&Executor::perform, this);
-                new_thread.detach();
-            }
+    /**
+     * Same as Execute, but gives access to function result. If task isn't accepted, then get() of the returned
+     * future throws std::runtime_error
+     */
+    template <typename F, typename... Types>
+    Future<typename std::result_of<typename std::decay<F>::type &(Types &...)>::type> Submit(F &&func,
+                                                                                           Types... args) {
+        using Result = typename std::result_of<typename std::decay<F>::type &(Types &...)>::type;
+        using Bound = decltype(std::bind(std::forward<F>(func), std::forward<Types>(args)...));
+
+        auto state = std::make_shared<detail::FutureState<Result>>();
+        detail::FutureTask<Result, Bound> task{state, std::bind(std::forward<F>(func), std::forward<Types>(args)...)};
+        if (!Execute(make_task(std::move(task)))) {
+            state->fail(std::make_exception_ptr(std::runtime_error("Executor rejected task")));
+        }
+        return Future<Result>(std::move(state));
+    }
+
+    /**
+     * Enqueues tasks from the range [first, last) at once: kSharedQueue mode takes lock once for all of them,
+     * kWorkStealing mode reserves queue space with a single atomic operation. Accepted tasks are moved out of
+     * the range, rejected ones are left intact.
+     *
+     * Returns number of accepted tasks, those are always at the beginning of the range. It is less than size
+     * of the range if queue limit is reached and zero if pool isn't running
+     */
+    std::size_t ExecuteBatch(Task *first, Task *last) {
+        if (first == last) {
+            return 0;
         }
-        return true;
+        if (mode == Mode::kWorkStealing) {
+            return execute_stealing(first, last - first);
+        }
+        return execute_shared(first, last - first);
     }
+
+    /**
+     * Same as above for range of arbitrary callables. Callables are consumed whether accepted or not, so
+     * rejected ones are lost
+     */
+    template <typename It> std::size_t ExecuteBatch(It first, It last) {
+        std::vector<Task> batch;
+        batch.reserve(std::distance(first, last));
+        for (; first != last; ++first) {
+            batch.push_back(make_task(std::move(*first)));
+        }
+        return ExecuteBatch(batch.data(), batch.data() + batch.size());
+    }
+
+    /**
+     * Maximum number of threads pool could run
+     */
+    std::size_t MaxThreads() const { return high_watermark; }
 };
 
 } // namespace Concurrency
@@ -1,10 +1,149 @@
 #ifndef AFINA_CONCURRENCY_FLAT_COMBINE_H
 #define AFINA_CONCURRENCY_FLAT_COMBINE_H
 
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename Op> class FlatCombine {};
+/**
+ * # Flat combining
+ * Wraps sequential data structure so that many threads could use it. Instead of taking a lock for every
+ * operation, thread publishes operation into its own slot and tries to become the combiner. Combiner scans
+ * all slots and applies every published operation in one go, the rest just wait until their operation is
+ * marked as done. So the structure is touched by one thread at a time, its data stays in that core cache and
+ * the lock is taken once per batch rather than once per operation.
+ *
+ * Op is a description of operation together with place for its result, it is created by the caller and
+ * must stay alive until Execute returns. Combine function gets array of operations. It should report failure
+ * of an operation through the operation itself: if it throws, every operation of the batch is considered done
+ * and Execute rethrows the exception to each of their owners, combiner goes on with the rest of the slots
+ */
+template <typename Op> class FlatCombine {
+public:
+    using Combiner = std::function<void(Op **ops, std::size_t count)>;
+
+    /**
+     * @param combine function applying batch of operations to the underlying structure
+     * @param max_batch upper bound of operations passed to the combine function at once
+     */
+    explicit FlatCombine(Combiner combine, std::size_t max_batch = 64)
+        : _combine(std::move(combine)), _max_batch(max_batch), _locked(false) {
+        _batch.reserve(max_batch);
+        _owners.reserve(max_batch);
+    }
+
+    FlatCombine(const FlatCombine &) = delete;
+    FlatCombine &operator=(const FlatCombine &) = delete;
+
+    /**
+     * Executes operation, returns once it is applied by this or some other thread. Throws whatever combine
+     * function threw for the batch with this operation
+     */
+    void Execute(Op &op) {
+        Slot &slot = _slots.local();
+        slot.op.store(&op, std::memory_order_release);
+
+        while (slot.op.load(std::memory_order_acquire) != nullptr) {
+            if (!_locked.load(std::memory_order_relaxed) && !_locked.exchange(true, std::memory_order_acquire)) {
+                Unlock unlock(_locked);
+                combine();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        if (slot.error) {
+            std::exception_ptr error = std::move(slot.error);
+            slot.error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    /**
+     * Publication record of a single thread. Slot of exited thread is empty and gets reused by a new one
+     */
+    struct Slot {
+        Slot() : op(nullptr) {}
+
+        // Operation waiting for execution, reset to nullptr by combiner once it is done
+        std::atomic<Op *> op;
+
+        // Exception combine function threw for the operation, set before op is reset
+        std::exception_ptr error;
+    };
+
+    /**
+     * Releases combiner lock on scope exit
+     */
+    class Unlock {
+    public:
+        explicit Unlock(std::atomic<bool> &locked) : _locked(locked) {}
+        ~Unlock() { _locked.store(false, std::memory_order_release); }
+
+    private:
+        std::atomic<bool> &_locked;
+    };
+
+    /**
+     * Applies all published operations, must be called by the lock owner
+     */
+    void combine() {
+        _slots.for_each([this](Slot &slot) {
+            Op *op = slot.op.load(std::memory_order_acquire);
+            if (op != nullptr) {
+                _batch.push_back(op);
+                _owners.push_back(&slot);
+                if (_batch.size() == _max_batch) {
+                    apply();
+                }
+            }
+        });
+        apply();
+    }
+
+    void apply() {
+        if (_batch.empty()) {
+            return;
+        }
+
+        // Failure belongs to owners of the batch, exception never leaves combiner in the middle of the scan
+        std::exception_ptr error;
+        try {
+            _combine(_batch.data(), _batch.size());
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        for (Slot *slot : _owners) {
+            slot->error = error;
+            slot->op.store(nullptr, std::memory_order_release);
+        }
+        _batch.clear();
+        _owners.clear();
+    }
+
+    const Combiner _combine;
+    const std::size_t _max_batch;
+
+    // Combiner lock
+    alignas(cache_line_size) std::atomic<bool> _locked;
+
+    // Publication list
+    ThreadLocal<Slot> _slots;
+
+    // Buffers for the current batch, used by combiner only
+    std::vector<Op *> _batch;
+    std::vector<Slot *> _owners;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,180 @@
+#ifndef AFINA_CONCURRENCY_FUTURE_H
+#define AFINA_CONCURRENCY_FUTURE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Afina {
+namespace Concurrency {
+
+namespace detail {
+
+/**
+ * Storage for result of a task, constructed in place once the task is done
+ */
+template <typename T> class FutureValue {
+public:
+    FutureValue() : _set(false) {}
+    FutureValue(const FutureValue &) = delete;
+    FutureValue &operator=(const FutureValue &) = delete;
+
+    ~FutureValue() {
+        if (_set) {
+            ptr()->~T();
+        }
+    }
+
+    template <typename F> void emplace(F &func) {
+        new (&_storage) T(func());
+        _set = true;
+    }
+
+    T take() { return std::move(*ptr()); }
+
+private:
+    T *ptr() { return reinterpret_cast<T *>(&_storage); }
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage;
+    bool _set;
+};
+
+template <> class FutureValue<void> {
+public:
+    template <typename F> void emplace(F &func) { func(); }
+    void take() {}
+};
+
+/**
+ * State shared between Future and the task producing its value
+ */
+template <typename T> class FutureState {
+public:
+    FutureState() : _ready(false) {}
+
+    /**
+     * Runs function and stores its result or exception
+     */
+    template <typename F> void run(F &func) {
+        try {
+            _value.emplace(func);
+        } catch (...) {
+            _error = std::current_exception();
+        }
+        finish();
+    }
+
+    void fail(std::exception_ptr error) {
+        _error = error;
+        finish();
+    }
+
+    bool ready() const { return _ready.load(std::memory_order_acquire); }
+
+    void wait() {
+        if (ready()) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!ready()) {
+            _condition.wait(lock);
+        }
+    }
+
+    template <typename Rep, typename Period> bool wait_for(const std::chrono::duration<Rep, Period> &timeout) {
+        if (ready()) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _condition.wait_for(lock, timeout, [this] { return ready(); });
+    }
+
+    T take() {
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+        return _value.take();
+    }
+
+private:
+    void finish() {
+        // Flag is set under mutex, otherwise waiter could check it and then miss notification
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.store(true, std::memory_order_release);
+        _condition.notify_all();
+    }
+
+    std::atomic<bool> _ready;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::exception_ptr _error;
+    FutureValue<T> _value;
+};
+
+/**
+ * Callable that runs function and publishes its result into the shared state
+ */
+template <typename T, typename F> struct FutureTask {
+    void operator()() { state->run(func); }
+
+    std::shared_ptr<FutureState<T>> state;
+    F func;
+};
+
+} // namespace detail
+
+/**
+ * # Result of a task submitted to Executor
+ * Lighter version of std::future: single allocation for the shared state, ready() check without locking.
+ * Value could be taken only once, after that future becomes invalid
+ */
+template <typename T> class Future {
+public:
+    Future() {}
+    explicit Future(std::shared_ptr<detail::FutureState<T>> state) : _state(std::move(state)) {}
+
+    /**
+     * Whether future refers to some task, i.e it is not default constructed and get() wasn't called yet
+     */
+    bool valid() const { return _state != nullptr; }
+
+    /**
+     * Whether task is done, never blocks
+     */
+    bool ready() const { return _state->ready(); }
+
+    /**
+     * Blocks until task is done
+     */
+    void wait() const { _state->wait(); }
+
+    /**
+     * Blocks until task is done or timeout expires, returns false in the latter case
+     */
+    template <typename Rep, typename Period> bool wait_for(const std::chrono::duration<Rep, Period> &timeout) const {
+        return _state->wait_for(timeout);
+    }
+
+    /**
+     * Waits for task and returns its result. Exception thrown by the task is rethrown here
+     */
+    T get() {
+        std::shared_ptr<detail::FutureState<T>> state(std::move(_state));
+        state->wait();
+        return state->take();
+    }
+
+private:
+    std::shared_ptr<detail::FutureState<T>> _state;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_FUTURE_H
@@ -0,0 +1,112 @@
+#ifndef AFINA_CONCURRENCY_INLINE_TASK_H
+#define AFINA_CONCURRENCY_INLINE_TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Move-only callable with fixed inline storage
+ * Replacement for std::function<void()> that never touches heap: callable is placed right inside the object,
+ * callables that don't fit are rejected at compile time. Type erasure is done through a static table of
+ * functions per callable type
+ */
+template <std::size_t Capacity> class InlineTask {
+public:
+    InlineTask() noexcept : _ops(nullptr) {}
+
+    template <typename F, typename Fn = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Fn, InlineTask>::value>::type>
+    InlineTask(F &&func) : _ops(&OpsFor<Fn>::ops) {
+        static_assert(sizeof(Fn) <= Capacity, "Callable doesn't fit into InlineTask, capture less or use bigger one");
+        static_assert(alignof(Fn) <= alignof(Storage), "Callable is over-aligned for InlineTask");
+        new (&_storage) Fn(std::forward<F>(func));
+    }
+
+    InlineTask(InlineTask &&other) noexcept : _ops(other._ops) {
+        if (_ops != nullptr) {
+            _ops->move(&other._storage, &_storage);
+            other._ops = nullptr;
+        }
+    }
+
+    InlineTask &operator=(InlineTask &&other) noexcept {
+        if (this != &other) {
+            reset();
+            _ops = other._ops;
+            if (_ops != nullptr) {
+                _ops->move(&other._storage, &_storage);
+                other._ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineTask(const InlineTask &) = delete;
+    InlineTask &operator=(const InlineTask &) = delete;
+
+    ~InlineTask() { reset(); }
+
+    void operator()() { _ops->invoke(&_storage); }
+
+    explicit operator bool() const { return _ops != nullptr; }
+
+    /**
+     * Destroys stored callable, if any
+     */
+    void reset() {
+        if (_ops != nullptr) {
+            _ops->destroy(&_storage);
+            _ops = nullptr;
+        }
+    }
+
+    /**
+     * Whether callable of the given type could be stored inline
+     */
+    template <typename Fn> static constexpr bool fits() {
+        return sizeof(Fn) <= Capacity && alignof(Fn) <= alignof(Storage);
+    }
+
+private:
+    typedef typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type Storage;
+
+    struct Ops {
+        void (*invoke)(void *);
+
+        // Move constructs callable at to and destroys one at from
+        void (*move)(void *from, void *to);
+        void (*destroy)(void *);
+    };
+
+    template <typename Fn> struct OpsFor {
+        static void invoke(void *self) { (*static_cast<Fn *>(self))(); }
+
+        static void move(void *from, void *to) {
+            new (to) Fn(std::move(*static_cast<Fn *>(from)));
+            static_cast<Fn *>(from)->~Fn();
+        }
+
+        static void destroy(void *self) { static_cast<Fn *>(self)->~Fn(); }
+
+        static const Ops ops;
+    };
+
+    Storage _storage;
+    const Ops *_ops;
+};
+
+template <std::size_t Capacity>
+template <typename Fn>
+const typename InlineTask<Capacity>::Ops InlineTask<Capacity>::OpsFor<Fn>::ops = {
+    &InlineTask<Capacity>::OpsFor<Fn>::invoke, &InlineTask<Capacity>::OpsFor<Fn>::move,
+    &InlineTask<Capacity>::OpsFor<Fn>::destroy};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_INLINE_TASK_H
@@ -0,0 +1,123 @@
+#ifndef AFINA_CONCURRENCY_MPMC_QUEUE_H
+#define AFINA_CONCURRENCY_MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Bounded lock-free multi-producer multi-consumer queue
+ * Dmitry Vyukov's array based queue: every cell carries a sequence number telling producers and consumers
+ * whose turn it is, so push and pop cost a single CAS on the shared position in the common case.
+ *
+ * Capacity is rounded up to the power of two
+ */
+template <typename T> class MPMCQueue {
+public:
+    explicit MPMCQueue(std::size_t capacity) {
+        std::size_t cap = 2;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+
+        _mask = cap - 1;
+        _buffer.reset(new Cell[cap]);
+        for (std::size_t i = 0; i < cap; i++) {
+            _buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        _enqueue_pos.store(0, std::memory_order_relaxed);
+        _dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+
+    MPMCQueue(const MPMCQueue &) = delete;
+    MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+    /**
+     * Adds element to the queue, returns false if queue is full
+     */
+    bool push(T item) {
+        Cell *cell;
+        std::size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &_buffer[pos & _mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Takes element from the queue, returns false if queue is empty
+     */
+    bool pop(T &item) {
+        Cell *cell;
+        std::size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &_buffer[pos & _mask];
+            std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        item = std::move(cell->data);
+        cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Approximate number of elements in the queue
+     */
+    std::size_t size() const {
+        std::size_t enq = _enqueue_pos.load(std::memory_order_relaxed);
+        std::size_t deq = _dequeue_pos.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    std::size_t capacity() const { return _mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> _buffer;
+    std::size_t _mask;
+    char _buffer_padding[64];
+
+    // Producers and consumers work on different cache lines
+    std::atomic<std::size_t> _enqueue_pos;
+    char _enqueue_padding[64 - sizeof(std::atomic<std::size_t>)];
+
+    std::atomic<std::size_t> _dequeue_pos;
+    char _dequeue_padding[64 - sizeof(std::atomic<std::size_t>)];
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_MPMC_QUEUE_H
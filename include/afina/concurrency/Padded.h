@@ -0,0 +1,69 @@
+#ifndef AFINA_CONCURRENCY_PADDED_H
+#define AFINA_CONCURRENCY_PADDED_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * Size of the unit of cache coherency. Data written by different threads must not share it, otherwise every
+ * write invalidates the line in caches of other cores even though they never touch the same bytes
+ */
+const std::size_t cache_line_size = 64;
+
+/**
+ * Value occupying whole cache lines. Note that operator new doesn't respect such alignment before C++17, so
+ * dynamic instances must be created with make_padded
+ */
+template <typename T> struct alignas(cache_line_size) Padded {
+    template <typename... Args> explicit Padded(Args &&... args) : value(std::forward<Args>(args)...) {}
+
+    T value;
+};
+
+/**
+ * Allocates array of count padded values aligned on the cache line boundary, values are default constructed
+ */
+template <typename T> Padded<T> *make_padded(std::size_t count = 1) {
+    void *memory = nullptr;
+    if (posix_memalign(&memory, cache_line_size, sizeof(Padded<T>) * count) != 0) {
+        throw std::bad_alloc();
+    }
+
+    auto *result = static_cast<Padded<T> *>(memory);
+    std::size_t i = 0;
+    try {
+        for (; i < count; i++) {
+            new (result + i) Padded<T>();
+        }
+    } catch (...) {
+        while (i > 0) {
+            result[--i].~Padded<T>();
+        }
+        std::free(memory);
+        throw;
+    }
+    return result;
+}
+
+/**
+ * Destroys array created by make_padded
+ */
+template <typename T> void free_padded(Padded<T> *values, std::size_t count = 1) {
+    if (values == nullptr) {
+        return;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        values[i].~Padded<T>();
+    }
+    std::free(values);
+}
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_PADDED_H
@@ -0,0 +1,131 @@
+#ifndef AFINA_CONCURRENCY_PARALLEL_FOR_H
+#define AFINA_CONCURRENCY_PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+
+namespace Afina {
+namespace Concurrency {
+
+namespace detail {
+
+/**
+ * Shared by caller of parallel_for and helper tasks. Chunks are not bound to tasks: everybody claims the next
+ * one until range is exhausted, so tasks that start late simply find nothing to do
+ */
+template <typename F> class ParallelForState {
+public:
+    ParallelForState(std::size_t begin, std::size_t end, std::size_t chunk, F *body)
+        : _next(begin), _end(end), _chunk(chunk), _remaining(end - begin), _body(body) {}
+
+    /**
+     * Processes chunks while there are any
+     */
+    void work() {
+        while (true) {
+            std::size_t from = _next.fetch_add(_chunk);
+            if (from >= _end) {
+                return;
+            }
+            std::size_t to = std::min(_end, from + _chunk);
+
+            try {
+                for (std::size_t i = from; i < to; i++) {
+                    (*_body)(i);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_error) {
+                    _error = std::current_exception();
+                }
+            }
+
+            if (_remaining.fetch_sub(to - from) == to - from) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _done.notify_all();
+            }
+        }
+    }
+
+    /**
+     * Waits until every index is processed and rethrows first exception thrown by body
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_remaining.load() != 0) {
+            _done.wait(lock);
+        }
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+    }
+
+private:
+    std::atomic<std::size_t> _next;
+    const std::size_t _end, _chunk;
+
+    // Number of indexes not processed yet
+    std::atomic<std::size_t> _remaining;
+
+    // Valid until _remaining drops to zero, nobody touches it afterwards
+    F *_body;
+
+    std::mutex _mutex;
+    std::condition_variable _done;
+    std::exception_ptr _error;
+};
+
+template <typename F> struct ParallelForTask {
+    void operator()() { state->work(); }
+
+    std::shared_ptr<ParallelForState<F>> state;
+};
+
+} // namespace detail
+
+/**
+ * Calls body(i) for every i in [begin, end) using executor threads, indexes are handed out in chunks of the
+ * given size, 0 means about four chunks per thread. Returns once all calls are done.
+ *
+ * Calling thread takes part in the work as well, so function completes even if executor is stopped, has full
+ * queue or it is called from one of executor tasks. If body throws, remaining indexes are processed anyway and
+ * the first exception is rethrown to the caller
+ */
+template <typename F> void parallel_for(Executor &executor, std::size_t begin, std::size_t end, std::size_t chunk,
+                                       F &&body) {
+    if (begin >= end) {
+        return;
+    }
+
+    std::size_t threads = std::max<std::size_t>(1, executor.MaxThreads());
+    if (chunk == 0) {
+        chunk = std::max<std::size_t>(1, (end - begin) / (threads * 4));
+    }
+
+    typedef typename std::remove_reference<F>::type Body;
+    auto state = std::make_shared<detail::ParallelForState<Body>>(begin, end, chunk, &body);
+
+    // One chunk is always left for the caller
+    std::size_t chunks = (end - begin - 1) / chunk + 1;
+    std::size_t helpers = std::min(chunks - 1, threads);
+    if (helpers != 0) {
+        std::vector<detail::ParallelForTask<Body>> tasks(helpers, detail::ParallelForTask<Body>{state});
+        executor.ExecuteBatch(tasks.begin(), tasks.end());
+    }
+
+    state->work();
+    state->wait();
+}
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_PARALLEL_FOR_H
@@ -1,10 +1,177 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <afina/concurrency/Padded.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Per thread value
+ * Unlike thread_local variable it is a regular object: there could be many instances, each thread gets its
+ * own value in every instance it touches and all values could be iterated, for example to sum up counters.
+ * Every value lives in its own cache lines, so writes of one thread never slow down others.
+ *
+ * Values are never destroyed before the container: once thread exits its value is adopted by the next new
+ * thread as is. So counters don't lose increments of exited threads and free lists keep cached objects.
+ *
+ * for_each could run concurrently with owners updating their values, so T must be safe for that if container
+ * is iterated from other threads, e.g consist of relaxed atomics written only by the owner
+ */
+template <typename T> class ThreadLocal {
+public:
+    ThreadLocal() : _core(std::make_shared<Core>()) {}
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    ~ThreadLocal() {
+        // Threads that used container hold its core until they exit, tell them it is gone
+        _core->dead.store(true, std::memory_order_release);
+    }
+
+    /**
+     * Value of the calling thread, created on first use
+     */
+    T &local() {
+        // Last container used by this thread, this check is all that is done on the hot path
+        if (tls_last_core == _core.get()) {
+            return tls_last_entry->value;
+        }
+        return lookup();
+    }
+
+    /**
+     * Calls func(T &) for every value, including ones of exited threads
+     */
+    template <typename F> void for_each(F &&func) {
+        for (Entry *entry = _core->head.load(std::memory_order_acquire); entry != nullptr; entry = entry->next) {
+            func(entry->value);
+        }
+    }
+
+    /**
+     * Folds all values: result = func(result, value) starting with initial
+     */
+    template <typename R, typename F> R aggregate(R initial, F &&func) {
+        for_each([&initial, &func](T &value) { initial = func(initial, value); });
+        return initial;
+    }
+
+private:
+    struct Entry {
+        Entry() : owned(true), next(nullptr) {}
+
+        T value;
+
+        // Some thread is using this value at the moment
+        std::atomic<bool> owned;
+
+        // Entries are never removed from the list, so next pointer never changes once entry is published
+        Entry *next;
+    };
+
+    /**
+     * Shared between container and threads using it, so that thread exit never touches freed memory
+     */
+    struct Core {
+        Core() : head(nullptr), dead(false) {}
+
+        ~Core() {
+            for (Entry *entry = head.load(); entry != nullptr;) {
+                Entry *next = entry->next;
+                free_padded(reinterpret_cast<Padded<Entry> *>(entry));
+                entry = next;
+            }
+        }
+
+        std::atomic<Entry *> head;
+        std::atomic<bool> dead;
+    };
+
+    /**
+     * Thread's entry in some container, releases it on thread exit
+     */
+    struct Ref {
+        Ref(std::shared_ptr<Core> core, Entry *entry) : core(std::move(core)), entry(entry) {}
+        Ref(Ref &&other) : core(std::move(other.core)), entry(other.entry) { other.entry = nullptr; }
+        Ref &operator=(Ref &&other) {
+            std::swap(core, other.core);
+            std::swap(entry, other.entry);
+            return *this;
+        }
+
+        ~Ref() {
+            if (entry != nullptr) {
+                entry->owned.store(false, std::memory_order_release);
+            }
+        }
+
+        std::shared_ptr<Core> core;
+        Entry *entry;
+    };
+
+    T &lookup() {
+        Core *core = _core.get();
+        for (auto &ref : tls_refs) {
+            if (ref.core.get() == core) {
+                remember(ref);
+                return ref.entry->value;
+            }
+        }
+
+        // Thread meets this container for the first time, good time to forget dead ones
+        tls_last_core = nullptr;
+        tls_refs.erase(std::remove_if(tls_refs.begin(), tls_refs.end(),
+                                      [](const Ref &ref) { return ref.core->dead.load(std::memory_order_acquire); }),
+                       tls_refs.end());
+
+        tls_refs.emplace_back(_core, acquire());
+        remember(tls_refs.back());
+        return tls_refs.back().entry->value;
+    }
+
+    /**
+     * Takes over entry left by some exited thread or creates a new one
+     */
+    Entry *acquire() {
+        for (Entry *entry = _core->head.load(std::memory_order_acquire); entry != nullptr; entry = entry->next) {
+            bool expected = false;
+            if (!entry->owned.load(std::memory_order_relaxed) &&
+                entry->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return entry;
+            }
+        }
+
+        Entry *entry = &make_padded<Entry>()->value;
+        Entry *head = _core->head.load(std::memory_order_relaxed);
+        do {
+            entry->next = head;
+        } while (!_core->head.compare_exchange_weak(head, entry, std::memory_order_release, std::memory_order_relaxed));
+        return entry;
+    }
+
+    static void remember(Ref &ref) {
+        tls_last_core = ref.core.get();
+        tls_last_entry = ref.entry;
+    }
+
+    std::shared_ptr<Core> _core;
+
+    // Entries of the current thread in all containers of this type. Core pointers are unique there because
+    // refs keep cores alive
+    static thread_local std::vector<Ref> tls_refs;
+    static thread_local Core *tls_last_core;
+    static thread_local Entry *tls_last_entry;
+};
+
+template <typename T> thread_local std::vector<typename ThreadLocal<T>::Ref> ThreadLocal<T>::tls_refs;
+template <typename T> thread_local typename ThreadLocal<T>::Core *ThreadLocal<T>::tls_last_core = nullptr;
+template <typename T> thread_local typename ThreadLocal<T>::Entry *ThreadLocal<T>::tls_last_entry = nullptr;
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,161 @@
+#ifndef AFINA_CONCURRENCY_WORK_STEALING_QUEUE_H
+#define AFINA_CONCURRENCY_WORK_STEALING_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Chase-Lev work stealing deque
+ * Single owner thread pushes and pops elements at the bottom end, any other thread could steal elements
+ * from the top end. Buffer grows on demand, retired buffers are kept until queue destruction since
+ * thieves may still read from them.
+ *
+ * Memory orders follow "Correct and Efficient Work-Stealing for Weak Memory Models" by Le et al.
+ *
+ * T must be trivially copyable, usually it is a pointer to the task
+ */
+template <typename T> class WorkStealingQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingQueue elements must be trivially copyable");
+
+public:
+    explicit WorkStealingQueue(std::size_t capacity = 256) : _top(0), _bottom(0) {
+        std::size_t cap = 1;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        _array.store(new Array(cap), std::memory_order_relaxed);
+    }
+
+    WorkStealingQueue(const WorkStealingQueue &) = delete;
+    WorkStealingQueue &operator=(const WorkStealingQueue &) = delete;
+
+    ~WorkStealingQueue() {
+        for (auto a : _garbage) {
+            delete a;
+        }
+        delete _array.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Adds element to the bottom of the queue. Must be called by owner thread only
+     */
+    void push(T item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        Array *a = _array.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            Array *bigger = a->grow(t, b);
+            _garbage.push_back(a);
+            a = bigger;
+            _array.store(a, std::memory_order_release);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Takes element from the bottom of the queue. Must be called by owner thread only. Returns false
+     * if queue is empty
+     */
+    bool pop(T &item) {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        Array *a = _array.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Queue was empty
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = a->get(b);
+        if (t == b) {
+            // Last element, race with thieves for it
+            bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * Takes element from the top of the queue. Could be called by any thread, including owner. Returns
+     * false if queue is empty or if some other thread took element first
+     */
+    bool steal(T &item) {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        Array *a = _array.load(std::memory_order_acquire);
+        T result = a->get(t);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        item = result;
+        return true;
+    }
+
+    /**
+     * Approximate number of elements in the queue
+     */
+    std::size_t size() const {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Array {
+        explicit Array(std::size_t cap) : capacity(cap), mask(cap - 1), buffer(new std::atomic<T>[cap]) {}
+        ~Array() { delete[] buffer; }
+
+        T get(int64_t i) const { return buffer[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T item) { buffer[i & mask].store(item, std::memory_order_relaxed); }
+
+        Array *grow(int64_t t, int64_t b) const {
+            Array *result = new Array(capacity * 2);
+            for (int64_t i = t; i < b; i++) {
+                result->put(i, get(i));
+            }
+            return result;
+        }
+
+        const std::size_t capacity;
+        const int64_t mask;
+        std::atomic<T> *buffer;
+    };
+
+    // Index of the next element to be stolen, shared between owner and thieves
+    std::atomic<int64_t> _top;
+    char _top_padding[64 - sizeof(std::atomic<int64_t>)];
+
+    // Index of the next free slot, written by owner only. Kept on its own cache line so that
+    // owner pushes don't invalidate line thieves are spinning on
+    std::atomic<int64_t> _bottom;
+    char _bottom_padding[64 - sizeof(std::atomic<int64_t>)];
+
+    std::atomic<Array *> _array;
+
+    // Buffers replaced by bigger ones, owner only
+    std::vector<Array *> _garbage;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_WORK_STEALING_QUEUE_H
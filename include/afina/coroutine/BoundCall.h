@@ -0,0 +1,33 @@
+#ifndef AFINA_COROUTINE_BOUND_CALL_H
+#define AFINA_COROUTINE_BOUND_CALL_H
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace Afina {
+namespace Coroutine {
+
+namespace detail {
+
+// C++11 replacement for std::index_sequence
+template <std::size_t...> struct index_sequence {};
+template <std::size_t N, std::size_t... Is> struct make_index_sequence : make_index_sequence<N - 1, N - 1, Is...> {};
+template <std::size_t... Is> struct make_index_sequence<0, Is...> : index_sequence<Is...> {};
+
+// Coroutine body together with its arguments. Unlike std::bind it keeps reference arguments as references
+template <typename... Ta> struct bound_call {
+    void (*func)(Ta...);
+    std::tuple<Ta...> args;
+
+    void operator()() { call(make_index_sequence<sizeof...(Ta)>()); }
+
+    template <std::size_t... Is> void call(index_sequence<Is...>) { func(std::forward<Ta>(std::get<Is>(args))...); }
+};
+
+} // namespace detail
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_BOUND_CALL_H
@@ -0,0 +1,124 @@
+#ifndef AFINA_COROUTINE_CHANNEL_H
+#define AFINA_COROUTINE_CHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Sync.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Bounded channel between coroutines
+ * Senders are suspended while channel is full, receivers while it is empty. Once channel is closed
+ * pending elements could still be received, but new ones are rejected. Not threadsafe, all coroutines
+ * must belong to the same engine
+ */
+template <typename T> class Channel {
+public:
+    Channel(Engine &engine, std::size_t capacity)
+        : _capacity(capacity), _closed(false), _not_empty(engine), _not_full(engine) {
+        if (capacity == 0) {
+            throw std::runtime_error("Channel capacity must be positive");
+        }
+    }
+
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    /**
+     * Adds element to the channel, suspends current coroutine while channel is full. Returns false if
+     * channel is closed
+     */
+    bool push(T value) {
+        while (!_closed && _items.size() >= _capacity) {
+            _not_full.wait();
+        }
+        return try_push(std::move(value));
+    }
+
+    /**
+     * Adds element to the channel if there is a free slot, never suspends
+     */
+    bool try_push(T value) {
+        if (_closed || _items.size() >= _capacity) {
+            return false;
+        }
+        _items.push_back(std::move(value));
+        _not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * Takes element from the channel, suspends current coroutine while channel is empty. Returns false
+     * if channel is closed and there is nothing left in it
+     */
+    bool pop(T &value) {
+        while (!_closed && _items.empty()) {
+            _not_empty.wait();
+        }
+        return try_pop(value);
+    }
+
+    /**
+     * Same as pop, but waits no longer than given number of milliseconds. Returns false on timeout
+     */
+    bool pop_for(T &value, uint32_t ms) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        while (!_closed && _items.empty()) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                return false;
+            }
+
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+            _not_empty.wait_for(static_cast<uint32_t>(left > 0 ? left : 1));
+        }
+        return try_pop(value);
+    }
+
+    /**
+     * Takes element from the channel if there is any, never suspends
+     */
+    bool try_pop(T &value) {
+        if (_items.empty()) {
+            return false;
+        }
+        value = std::move(_items.front());
+        _items.pop_front();
+        _not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * Rejects all further pushes and wakes up everyone waiting on the channel
+     */
+    void close() {
+        _closed = true;
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+
+    bool closed() const { return _closed; }
+
+    std::size_t size() const { return _items.size(); }
+
+private:
+    const std::size_t _capacity;
+    bool _closed;
+    std::deque<T> _items;
+
+    CondVar _not_empty;
+    CondVar _not_full;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_CHANNEL_H
@@ -1,14 +1,20 @@
 #ifndef AFINA_COROUTINE_ENGINE_H
 #define AFINA_COROUTINE_ENGINE_H
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <new>
 #include <tuple>
+#include <utility>
 
 #include <csetjmp>
 
+#include <afina/coroutine/BoundCall.h>
+#include <afina/coroutine/StackPool.h>
+
 namespace Afina {
 namespace Coroutine {
 
@@ -20,11 +26,29 @@ class Engine final {
 public:
     using unblocker_func = std::function<void()>;
 
+    /**
+     * How coroutine stacks are managed
+     */
+    enum class StackMode {
+        // All coroutines run on the stack of the thread that called start(). On each switch live part of
+        // the stack is copied out of and back into place, so switch cost grows with stack depth
+        kCopy,
+
+        // Each coroutine owns a guarded stack taken from the pool, switch only saves and restores registers
+        kDedicated
+    };
+
     /**
      * A single coroutine instance which could be scheduled for execution
      * should be allocated on heap
      */
     struct context;
+
+    /**
+     * Pending timers ordered by deadline
+     */
+    typedef std::multimap<std::chrono::steady_clock::time_point, context *> timers_t;
+
     typedef struct context {
         // coroutine stack start address
         char *Low = nullptr;
@@ -41,6 +65,23 @@ public:
         // is coroutine in blocked list
         bool isBlocked = false;
 
+        // Own stack of the coroutine and saved stack pointer into it, kDedicated mode only
+        StackPool::Stack OwnStack;
+        void *SP = nullptr;
+
+        // Coroutine body to be called once it gets control for the first time, kDedicated mode only. Body
+        // object itself lives at the top of the own stack, so that spawn doesn't allocate. Body is destroyed
+        // without being run if the second argument is false
+        void (*Body)(void *, bool) = nullptr;
+        void *BodyArg = nullptr;
+
+        // Timer that wakes coroutine up, valid only if HasTimer is set
+        timers_t::iterator Timer;
+        bool HasTimer = false;
+
+        // Set if coroutine was woken up by timer rather than by unblock
+        bool TimedOut = false;
+
         // To include routine in the different lists, such as "alive", "blocked", e.t.c
         struct context *prev = nullptr;
         struct context *next = nullptr;
@@ -58,9 +99,12 @@ private:
     context *cur_routine;
 
     /**
-     * List of routines ready to be scheduled. Note that suspended routine ends up here as well
+     * List of routines ready to be scheduled. Note that suspended routine ends up here as well. Works as
+     * FIFO queue: new and yielded routines go to the tail, control passes to the head. Unblocked routines
+     * are put to the head since they have been waiting already
      */
     context *alive;
+    context *alive_tail;
 
     /**
      * List of coroutines that sleep and can't be executed
@@ -77,6 +121,43 @@ private:
      */
     unblocker_func _unblocker;
 
+    /**
+     * Stack management mode, see StackMode
+     */
+    const StackMode _mode;
+
+    /**
+     * Stacks for coroutines in kDedicated mode
+     */
+    StackPool _stacks;
+
+    /**
+     * Finished coroutine whose stack can't be released until control leaves it
+     */
+    context *_zombie;
+
+    /**
+     * Blocked coroutines waiting for timeout
+     */
+    timers_t _timers;
+
+    /**
+     * Contexts of finished coroutines ready for reuse, linked through next. They keep stack copy buffer
+     * (kCopy) or own stack (kDedicated), so that steady flow of short-lived coroutines allocates nothing
+     */
+    context *_free_contexts;
+    std::size_t _free_count;
+
+    /**
+     * Set while destructor unwinds coroutines left unfinished, kDedicated mode only
+     */
+    bool _unwinding;
+
+    /**
+     * Thrown out of block/yield of a coroutine being unwound, caught at the bottom of its stack
+     */
+    struct forced_unwind {};
+
 protected:
     /**
      * Save stack of the current coroutine in the given context
@@ -90,14 +171,128 @@ protected:
 
     void Enter(context *ctx);
 
+    /**
+     * Creates coroutine with its own stack, kDedicated mode only
+     */
+    template <typename F> void *_spawn(F body) {
+        static_assert(alignof(F) <= 16, "Coroutine body must fit stack alignment");
+
+        context *pc = _new_context();
+        auto top = reinterpret_cast<std::uintptr_t>(_acquire_stack(pc) - sizeof(F)) & ~std::uintptr_t(15);
+        pc->BodyArg = new (reinterpret_cast<void *>(top)) F(std::move(body));
+        pc->Body = &Engine::_call_body<F>;
+        _launch(pc, reinterpret_cast<char *>(top));
+        return pc;
+    }
+
+    template <typename F> static void _call_body(void *body, bool run) {
+        struct destroy {
+            F *f;
+            ~destroy() { f->~F(); }
+        } guard{static_cast<F *>(body)};
+        if (run) {
+            (*guard.f)();
+        }
+    }
+
+    /**
+     * Makes sure context has its own stack and returns top of it, kDedicated mode only
+     */
+    char *_acquire_stack(context *ctx);
+
+    /**
+     * Prepares coroutine to be started on its own stack right below stack_top and puts it into alive queue
+     */
+    void _launch(context *ctx, char *stack_top);
+
+    /**
+     * Runs scheduling loop on the caller stack until there are no alive coroutines, kDedicated mode only
+     */
+    void _idle_loop(void *main);
+
+    /**
+     * Unlinks finished coroutine from the alive list and never returns, kDedicated mode only
+     */
+    void _finish(context *ctx);
+
+    /**
+     * Releases coroutine that has finished execution, if any
+     */
+    void _reap();
+
+    /**
+     * Passes control to every unfinished coroutine so that it unwinds its stack, kDedicated mode only
+     */
+    void _unwind_all();
+
+    /**
+     * Appends coroutine to the tail of the alive queue
+     */
+    void _enqueue(context *ctx);
+
+    /**
+     * Puts coroutine to the head of the alive queue, so that it gets control next
+     */
+    void _enqueue_front(context *ctx);
+
+    /**
+     * Removes coroutine from the alive queue
+     */
+    void _dequeue(context *ctx);
+
+    /**
+     * Takes context from the pool or allocates a new one
+     */
+    context *_new_context();
+
+    /**
+     * Returns context of the finished coroutine into the pool
+     */
+    void _release_context(context *ctx);
+
+    /**
+     * Frees context with everything it owns
+     */
+    void _destroy_context(context *ctx);
+
+    /**
+     * Unblocks coroutines whose timers have expired
+     */
+    void _fire_timers();
+
+    /**
+     * Called from idle context once there is nothing to run: fires timers, calls unblocker and sleeps
+     * until the nearest timer if needed. Returns false if there are no alive coroutines and nothing
+     * could wake them up anymore
+     */
+    bool _wait_alive();
+
+    /**
+     * Removes pending timer of the given coroutine, if any
+     */
+    void _cancel_timer(context *ctx);
+
+    /**
+     * First function executed on a fresh dedicated stack
+     */
+    static void _trampoline(void *engine);
+
     static void null_unblocker() {}
 
 public:
-    explicit Engine(unblocker_func unblocker = null_unblocker)
-            : StackBottom(nullptr), cur_routine(nullptr), alive(nullptr), _unblocker(std::move(unblocker)),
-              blocked(nullptr), idle_ctx(nullptr) {}
+    explicit Engine(unblocker_func unblocker = null_unblocker, StackMode mode = StackMode::kCopy,
+                    std::size_t stack_size = 256 * 1024)
+            : StackBottom(nullptr), cur_routine(nullptr), alive(nullptr), alive_tail(nullptr), blocked(nullptr),
+              idle_ctx(nullptr), _unblocker(std::move(unblocker)), _mode(mode), _stacks(stack_size),
+              _zombie(nullptr), _free_contexts(nullptr), _free_count(0), _unwinding(false) {}
     Engine(Engine &&) = delete;
     Engine(const Engine &) = delete;
+
+    /**
+     * Frees coroutines left blocked. In kDedicated mode each of them gets control once more: block or yield
+     * it is suspended in throws an internal exception, so that objects on its stack, body arguments included,
+     * are destroyed. Coroutine must let that exception through
+     */
     ~Engine();
 
     void unblock_all() {
@@ -142,6 +337,23 @@ public:
      */
     void unblock(void *coro);
 
+    /**
+     * Blocks current coroutine for at least given number of milliseconds. Sleep ends earlier if someone
+     * unblocks coroutine explicitly
+     */
+    void sleep(uint32_t ms);
+
+    /**
+     * Blocks current coroutine until it gets unblocked or timeout expires. Returns false on timeout
+     */
+    bool block_for(uint32_t ms);
+
+    /**
+     * Number of milliseconds until the nearest timer expires, -1 if there are no timers. Intended to be
+     * used by unblocker as a timeout for epoll_wait & co
+     */
+    int next_timeout() const;
+
     /**
      * Entry point into the engine. Prepare all internal mechanics and starts given function which is
      * considered as main.
@@ -157,18 +369,24 @@ public:
         char StackStartsHere;
         this->StackBottom = &StackStartsHere;
 
-        // Start routine execution
+        if (_mode == StackMode::kDedicated) {
+            _idle_loop(run(main, std::forward<Ta>(args)...));
+            return;
+        }
+
+        // Start routine execution. Idle context is kept between runs along with its stack copy buffer
         void *pc = run(main, std::forward<Ta>(args)...);
-        idle_ctx = new context();
+        if (idle_ctx == nullptr) {
+            idle_ctx = new context();
+        }
         idle_ctx->Low = idle_ctx->Hight = StackBottom;
         if (setjmp(idle_ctx->Environment) > 0) {
-            if (alive == nullptr) {
-                _unblocker();
-            }
             cur_routine = idle_ctx;
 
             // Here: correct finish of the coroutine section
-            yield();
+            if (_wait_alive()) {
+                yield();
+            }
         } else if (pc != nullptr) {
             Store(*idle_ctx);
             cur_routine = idle_ctx;
@@ -176,13 +394,19 @@ public:
         }
 
         // Shutdown runtime
-        delete[] std::get<0> (idle_ctx->Stack);
-        delete idle_ctx;
+        cur_routine = nullptr;
         this->StackBottom = nullptr;
     }
 
     // Wrapper of _run. Allows to save coroutine bottom address
     template <typename... Ta> void *run(void (*func)(Ta...), Ta &&... args) {
+        if (_mode == StackMode::kDedicated) {
+            if (this->StackBottom == nullptr) {
+                return nullptr;
+            }
+            return _spawn(detail::bound_call<Ta...>{func, std::tuple<Ta...>(std::forward<Ta>(args)...)});
+        }
+
         char coroutine_start = 0;
         return _run(&coroutine_start, func, std::forward<Ta>(args)...);
 
@@ -199,7 +423,7 @@ public:
         }
 
         // New coroutine context that carries around all information enough to call function
-        auto *pc = new context();
+        auto *pc = _new_context();
         pc->Low = pc->Hight = bottom;
         // Store current state right here, i.e just before enter new coroutine, later, once it gets scheduled
         // execution starts here. Note that we have to acquire stack of the current function call to ensure
@@ -215,23 +439,12 @@ public:
             // to pass control after that. We never want to go backward by stack as that would mean to go backward in
             // time. Function run() has already return once (when setjmp returns 0), so return second return from run
             // would looks a bit awkward
-            if (pc->prev != nullptr) {
-                pc->prev->next = pc->next;
-            }
-
-            if (pc->next != nullptr) {
-                pc->next->prev = pc->prev;
-            }
+            _dequeue(pc);
 
-            if (alive == cur_routine) {
-                alive = alive->next;
-            }
-
-            // current coroutine finished, and the pointer is not relevant now
+            // current coroutine finished, and the pointer is not relevant now. Its stack copy isn't needed
+            // anymore either, so context could go back to the pool right away
             cur_routine = idle_ctx;
-            pc->prev = pc->next = nullptr;
-            delete std::get<0>(pc->Stack);
-            delete pc;
+            _release_context(pc);
             // We cannot return here, as this function "returned" once already, so here we must select some other
             // coroutine to run. As current coroutine is completed and can't be scheduled anymore, it is safe to
             // just give up and ask scheduler code to select someone else, control will never returns to this one
@@ -242,13 +455,8 @@ public:
         // save stack.
         Store(*pc);
 
-        // Add routine as alive double-linked list
-        pc->next = alive;
-        alive = pc;
-        if (pc->next != nullptr) {
-            pc->next->prev = pc;
-        }
-
+        // Add routine to the tail of alive queue
+        _enqueue(pc);
         return pc;
     }
 };
@@ -0,0 +1,140 @@
+#ifndef AFINA_COROUTINE_SCHEDULER_H
+#define AFINA_COROUTINE_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <afina/coroutine/BoundCall.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # M:N coroutine scheduler
+ * Runs coroutines on a pool of worker threads, one per core by default. Each coroutine has its own
+ * stack, so it could be suspended on one worker and resumed on another one.
+ *
+ * Every worker owns a Chase-Lev deque of ready coroutines. Coroutines created or woken up on a worker
+ * go to its deque, the worker takes them in FIFO order so yield gives round-robin. Once own deque is
+ * empty worker checks the injection queue filled by non-worker threads, then tries to steal from other
+ * workers and parks if there is nothing to do.
+ *
+ * Unlike Engine this class is threadsafe: unblock could be called from any thread, for example from
+ * I/O completion callbacks.
+ */
+class Scheduler final {
+public:
+    /**
+     * @param workers number of worker threads, 0 means one per core
+     * @param stack_size usable size of each coroutine stack
+     */
+    explicit Scheduler(std::size_t workers = 0, std::size_t stack_size = 256 * 1024);
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+    ~Scheduler();
+
+    /**
+     * Entry point into the scheduler. Starts worker threads and given function as first coroutine.
+     *
+     * Function doesn't return control until all coroutines, including ones created later, are done
+     */
+    template <typename... Ta> void start(void (*main)(Ta...), Ta &&... args) {
+        _start(_spawn(detail::bound_call<Ta...>{main, std::tuple<Ta...>(std::forward<Ta>(args)...)}));
+    }
+
+    /**
+     * Register new coroutine, it will be executed by some worker later on. Could be called from any thread
+     * while scheduler is running. Returns handle to be used with unblock
+     */
+    template <typename... Ta> void *run(void (*func)(Ta...), Ta &&... args) {
+        void *result = _spawn(detail::bound_call<Ta...>{func, std::tuple<Ta...>(std::forward<Ta>(args)...)});
+        _schedule(result);
+        return result;
+    }
+
+    /**
+     * Gives up current coroutine execution and puts it at the end of the worker queue. Must be called
+     * from inside of a coroutine
+     */
+    static void yield();
+
+    /**
+     * Suspends current coroutine until someone calls unblock for it. If unblock was called already
+     * since the last block then method returns immediately. Must be called from inside of a coroutine
+     */
+    static void block();
+
+    /**
+     * Wakes up blocked coroutine. If coroutine isn't blocked at the moment, then its next block()
+     * call will return immediately. Could be called from any thread
+     */
+    void unblock(void *coro);
+
+    /**
+     * Handle of the coroutine calling this method, nullptr outside of coroutines
+     */
+    static void *current();
+
+private:
+    struct task;
+    struct Worker;
+
+    void *_spawn(std::function<void()> body);
+    void _start(void *main);
+
+    // Put ready coroutine into some run queue
+    void _schedule(void *coro);
+
+    // Method executing by worker threads
+    void _worker_loop(Worker *worker);
+
+    // Finds ready coroutine for the given worker, nullptr if there is none
+    task *_find_task(Worker *worker);
+
+    // Runs coroutine until it yields, blocks or finishes
+    void _run_task(Worker *worker, task *t);
+
+    // Checks whether some work might be available without taking anything
+    bool _has_work() const;
+
+    // Wakes up single parked worker if there is any
+    void _notify_one();
+
+    static void _trampoline(void *t);
+
+    const std::size_t _workers_count;
+    const std::size_t _stack_size;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    /**
+     * Number of coroutines created but not yet finished
+     */
+    std::atomic<std::size_t> _live;
+
+    /**
+     * Ready coroutines from threads that are not scheduler workers
+     */
+    std::mutex _inject_mutex;
+    std::deque<task *> _injected;
+    std::atomic<std::size_t> _injected_size;
+
+    /**
+     * Parking lot for idle workers
+     */
+    std::mutex _park_mutex;
+    std::condition_variable _park_condition;
+    std::atomic<std::size_t> _parked;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_SCHEDULER_H
@@ -0,0 +1,63 @@
+#ifndef AFINA_COROUTINE_STACK_POOL_H
+#define AFINA_COROUTINE_STACK_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Pool of coroutine stacks
+ * Each stack is a separate anonymous mapping with a PROT_NONE guard page below it, so that overflow
+ * crashes instead of silently corrupting neighbour memory. Released stacks are cached and handed out
+ * again, so steady state spawn/exit of coroutines doesn't touch mmap at all.
+ *
+ * Not threadsafe
+ */
+class StackPool {
+public:
+    struct Stack {
+        // Lowest usable address of the stack
+        char *Low = nullptr;
+
+        // Address right after the end of the stack, stack grows down from here
+        char *Hight = nullptr;
+    };
+
+    /**
+     * @param stack_size usable size of each stack, rounded up to the page size
+     * @param max_cached how many released stacks to keep around for reuse
+     */
+    explicit StackPool(std::size_t stack_size = 256 * 1024, std::size_t max_cached = 64);
+    StackPool(const StackPool &) = delete;
+    StackPool &operator=(const StackPool &) = delete;
+    ~StackPool();
+
+    /**
+     * Returns stack either from the cache or freshly mapped one, throws std::runtime_error if mapping fails
+     */
+    Stack Acquire();
+
+    /**
+     * Gives stack back to the pool
+     */
+    void Release(Stack stack);
+
+    std::size_t StackSize() const { return _stack_size; }
+
+private:
+    void Unmap(Stack stack);
+
+    std::size_t _page_size;
+    std::size_t _stack_size;
+    std::size_t _max_cached;
+
+    // Stacks ready to be reused
+    std::vector<Stack> _free;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_STACK_POOL_H
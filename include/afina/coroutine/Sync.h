@@ -0,0 +1,95 @@
+#ifndef AFINA_COROUTINE_SYNC_H
+#define AFINA_COROUTINE_SYNC_H
+
+#include <cstdint>
+#include <list>
+
+#include <afina/coroutine/Engine.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Condition variable for coroutines
+ * Suspends coroutines of the given engine using block/unblock, so waiting doesn't consume CPU. Like the
+ * engine itself it isn't threadsafe.
+ *
+ * Wait could return spuriously, for example if someone unblocks coroutine directly, so it should always
+ * be called in a loop checking the condition
+ */
+class CondVar {
+public:
+    explicit CondVar(Engine &engine) : _engine(engine) {}
+    CondVar(const CondVar &) = delete;
+    CondVar &operator=(const CondVar &) = delete;
+
+    /**
+     * Suspends current coroutine until notified
+     */
+    void wait();
+
+    /**
+     * Suspends current coroutine until notified or timeout expires. Returns false on timeout
+     */
+    bool wait_for(uint32_t ms);
+
+    /**
+     * Wakes up the longest waiting coroutine, if any
+     */
+    void notify_one();
+
+    /**
+     * Wakes up all waiting coroutines
+     */
+    void notify_all();
+
+private:
+    struct Waiter {
+        void *coro;
+        bool notified;
+    };
+
+    bool _wait(uint32_t ms, bool timed);
+
+    Engine &_engine;
+
+    // Coroutines waiting for notification, oldest first. Nodes are owned by waiting coroutines: they
+    // can't live on coroutine stack since in kCopy mode it isn't addressable while coroutine is suspended
+    std::list<Waiter> _waiters;
+
+    // Notified coroutines that haven't got control yet
+    std::list<Waiter> _notified;
+};
+
+/**
+ * # Mutex for coroutines
+ * Needed to protect state which must stay consistent across yields, for example while coroutine does
+ * I/O in the middle of an update. Not recursive, not threadsafe
+ */
+class Mutex {
+public:
+    explicit Mutex(Engine &engine) : _locked(false), _released(engine) {}
+    Mutex(const Mutex &) = delete;
+    Mutex &operator=(const Mutex &) = delete;
+
+    /**
+     * Suspends current coroutine until mutex is free and takes it
+     */
+    void lock();
+
+    /**
+     * Takes mutex if it is free, never suspends
+     */
+    bool try_lock();
+
+    void unlock();
+
+private:
+    bool _locked;
+    CondVar _released;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_SYNC_H
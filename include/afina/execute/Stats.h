@@ -2,17 +2,26 @@
 #define AFINA_EXECUTE_STATS_H
 
 #include <string>
+#include <vector>
 
 #include "Command.h"
 
 namespace Afina {
 namespace Execute {
 
+/**
+ * Without arguments reports general counters, "stats latency" reports p50/p99/p999/max latency in nanoseconds
+ * of every stage for every command type seen so far. Other groups, like "slabs", are up to the storage
+ */
 class Stats : public Command {
 public:
     Stats() {}
+    Stats(const std::vector<std::string> &args) : _args(args) {}
     ~Stats() {}
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::vector<std::string> _args;
 };
 
 } // namespace Execute
@@ -0,0 +1,112 @@
+#ifndef AFINA_LOGGING_LOG_H
+#define AFINA_LOGGING_LOG_H
+
+#include <memory>
+#include <utility>
+
+#include <spdlog/logger.h>
+
+#include <afina/logging/RingLogger.h>
+
+/**
+ * Least level compiled in, numbered as spdlog::level: 0 trace, 1 debug, 2 info, 3 warn, 4 err, 5 critical,
+ * 6 off. Set by cmake -DAFINA_LOG_LEVEL=<name>
+ */
+#ifndef AFINA_LOG_LEVEL
+#define AFINA_LOG_LEVEL 0
+#endif
+
+namespace Afina {
+namespace Logging {
+
+/**
+ * Whether records of the level are compiled in with Min as the least one. Constant expression, so a disabled
+ * call is thrown away by compiler as a whole, arguments included, whatever optimization level is. Min is a
+ * parameter rather than AFINA_LOG_LEVEL itself, so files built with different levels don't clash
+ */
+template <int Min, spdlog::level::level_enum Level> struct Compiled {
+    static constexpr bool value = static_cast<int>(Level) >= Min;
+};
+
+/**
+ * # Logger selected once and kept by its user
+ * Whether the logger writes through rings is found out here, once, rather than on every call: AFINA_LOG_*
+ * given a Handle pass arguments of RingLogger as binary record without a cast on the way. Converts from
+ * the shared_ptr Service::select returns and could be used just like it
+ */
+class Handle {
+public:
+    Handle() : _ring(nullptr) {}
+    Handle(std::shared_ptr<spdlog::logger> logger)
+        : _logger(std::move(logger)), _ring(dynamic_cast<RingLogger *>(_logger.get())) {}
+
+    spdlog::logger *operator->() const { return _logger.get(); }
+    spdlog::logger &operator*() const { return *_logger; }
+    explicit operator bool() const { return _logger != nullptr; }
+
+    /**
+     * Same logger if it writes through rings, nullptr otherwise
+     */
+    RingLogger *ring() const { return _ring; }
+
+private:
+    std::shared_ptr<spdlog::logger> _logger;
+    RingLogger *_ring;
+};
+
+inline RingLogger *RingOf(RingLogger &logger) { return &logger; }
+inline RingLogger *RingOf(spdlog::logger &logger) { return dynamic_cast<RingLogger *>(&logger); }
+inline RingLogger *RingOf(const Handle &logger) { return logger.ring(); }
+template <typename Pointer> RingLogger *RingOf(const Pointer &logger) { return RingOf(*logger); }
+
+/**
+ * Loggers writing through rings take arguments as binary record, others format in place. Logger is anything
+ * AFINA_LOG_* accepts: a Handle or a pointer to logger, whatever its static type is
+ */
+template <typename Logger, typename... Args>
+void Write(const Logger &logger, spdlog::level::level_enum lvl, const char *fmt, const Args &... args) {
+    RingLogger *ring = RingOf(logger);
+    if (ring != nullptr) {
+        ring->record(lvl, fmt, args...);
+    } else {
+        (*logger).log(lvl, fmt, args...);
+    }
+}
+
+template <typename Logger> void Write(const Logger &logger, spdlog::level::level_enum lvl, const char *msg) {
+    RingLogger *ring = RingOf(logger);
+    if (ring != nullptr) {
+        ring->record(lvl, "{}", msg);
+    } else {
+        (*logger).log(lvl, msg);
+    }
+}
+
+} // namespace Logging
+} // namespace Afina
+
+/**
+ * True if logger writes records of the level, guards preparation of arguments that costs something by itself
+ */
+#define AFINA_LOG_ENABLED(logger, lvl)                                                                                 \
+    (::Afina::Logging::Compiled<AFINA_LOG_LEVEL, lvl>::value && (logger)->should_log(lvl))
+
+/**
+ * Logs fmt with arguments, which are evaluated only if the level is enabled. Levels below AFINA_LOG_LEVEL
+ * don't leave a single instruction
+ */
+#define AFINA_LOG(logger, lvl, ...)                                                                                    \
+    do {                                                                                                               \
+        if (AFINA_LOG_ENABLED(logger, lvl)) {                                                                          \
+            ::Afina::Logging::Write((logger), lvl, __VA_ARGS__);                                                       \
+        }                                                                                                              \
+    } while (false)
+
+#define AFINA_LOG_TRACE(logger, ...) AFINA_LOG(logger, spdlog::level::trace, __VA_ARGS__)
+#define AFINA_LOG_DEBUG(logger, ...) AFINA_LOG(logger, spdlog::level::debug, __VA_ARGS__)
+#define AFINA_LOG_INFO(logger, ...) AFINA_LOG(logger, spdlog::level::info, __VA_ARGS__)
+#define AFINA_LOG_WARN(logger, ...) AFINA_LOG(logger, spdlog::level::warn, __VA_ARGS__)
+#define AFINA_LOG_ERROR(logger, ...) AFINA_LOG(logger, spdlog::level::err, __VA_ARGS__)
+#define AFINA_LOG_CRITICAL(logger, ...) AFINA_LOG(logger, spdlog::level::critical, __VA_ARGS__)
+
+#endif // AFINA_LOGGING_LOG_H
@@ -0,0 +1,296 @@
+#ifndef AFINA_LOGGING_RING_LOGGER_H
+#define AFINA_LOGGING_RING_LOGGER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <spdlog/logger.h>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Logging {
+
+class RingLogger;
+
+/**
+ * # Per thread log rings
+ * Every thread writes log records into its own ring of bytes with a single producer and a single consumer,
+ * the background flusher takes them out, formats and passes to sinks. So logging thread never takes a lock,
+ * never makes a syscall and never waits for others: once its ring is full new records are dropped and
+ * counted in log_dropped metric. Rings share no cache lines, so latency doesn't depend on how much other
+ * threads log.
+ *
+ * Records of a thread keep their order, but rings are drained one after another, so records of different
+ * threads could be interleaved differently than they happened, time stamps tell the real order.
+ */
+class LogRings {
+public:
+    /**
+     * Header of a record, arguments follow it
+     */
+    struct Record {
+        // Formats arguments stored after header into out, nullptr for padding at the end of ring
+        void (*format)(const char *fmt, const char *args, fmt::MemoryWriter &out);
+        const char *fmt;
+        RingLogger *logger;
+
+        // spdlog::log_clock ticks
+        int64_t time;
+        std::size_t thread_id;
+
+        // Whole record along with arguments and alignment
+        uint32_t size;
+        uint32_t level;
+    };
+
+    // Records start at cache line boundary, so header never gets split by the end of ring
+    static constexpr std::size_t alignment = 64;
+
+    /**
+     * @param ring_size bytes in ring of every thread, rounded up to power of two
+     * @param interval time flusher sleeps once rings are empty
+     */
+    explicit LogRings(std::size_t ring_size = 256 * 1024,
+                      std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+    ~LogRings();
+
+    LogRings(const LogRings &) = delete;
+    LogRings &operator=(const LogRings &) = delete;
+
+    /**
+     * Runs flusher thread until Stop, that writes out everything logged so far
+     */
+    void Start();
+    void Stop();
+
+    /**
+     * Writes out everything logged so far, could be called by any thread
+     */
+    void Flush();
+
+    /**
+     * Records dropped so far because rings were full
+     */
+    std::size_t dropped();
+
+    /**
+     * Space for record of size bytes in ring of the calling thread, nullptr if ring is full. Flusher sees
+     * record once it is committed, nothing else could be reserved meanwhile
+     */
+    Record *reserve(std::size_t size);
+    void commit(Record *record);
+
+private:
+    struct Ring {
+        Ring() : buffer(nullptr), head(0), tail(0), head_cache(0), reserved(0), dropped(0) {}
+        ~Ring() { std::free(buffer.load(std::memory_order_relaxed)); }
+
+        // Allocated by producer on first record
+        std::atomic<char *> buffer;
+
+        // Positions grow forever, offsets are taken modulo size. Head is moved by consumer, tail by producer
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+
+        // Producer only: head seen last time, so that consumer cache line is read only once ring looks full
+        uint64_t head_cache;
+
+        // Position after the reserved record
+        uint64_t reserved;
+
+        std::atomic<std::size_t> dropped;
+    };
+
+    /**
+     * Writes out records of every ring, drain lock must be held. Returns false if there were none
+     */
+    bool drain();
+
+    void run();
+
+    std::size_t _ring_size;
+    std::chrono::milliseconds _interval;
+
+    Concurrency::ThreadLocal<Ring> _rings;
+
+    // Consumer side of rings: flusher and Flush callers
+    std::mutex _drain_lock;
+
+    std::mutex _lock;
+    std::condition_variable _stop;
+    bool _running;
+    std::thread _thread;
+};
+
+namespace detail {
+
+/**
+ * Argument of binary record: numbers and pointers are copied as is
+ */
+template <typename T> struct RecordArg {
+    static_assert(std::is_trivially_copyable<T>::value, "Log record argument must be a number, pointer or string");
+
+    typedef T Value;
+
+    static std::size_t size(const T &) { return sizeof(T); }
+
+    static char *store(char *to, const T &value) {
+        std::memcpy(to, &value, sizeof(T));
+        return to + sizeof(T);
+    }
+
+    static T load(const char *&from) {
+        T value;
+        std::memcpy(&value, from, sizeof(T));
+        from += sizeof(T);
+        return value;
+    }
+};
+
+/**
+ * Strings are copied along with their length, flusher formats them right from the ring
+ */
+struct StringArg {
+    typedef fmt::StringRef Value;
+
+    static std::size_t size(const char *, std::size_t len) { return sizeof(uint32_t) + len; }
+
+    static char *store(char *to, const char *data, std::size_t len) {
+        uint32_t size = len;
+        std::memcpy(to, &size, sizeof(size));
+        std::memcpy(to + sizeof(size), data, len);
+        return to + sizeof(size) + len;
+    }
+
+    static Value load(const char *&from) {
+        uint32_t size;
+        std::memcpy(&size, from, sizeof(size));
+        Value value(from + sizeof(size), size);
+        from += sizeof(size) + size;
+        return value;
+    }
+};
+
+template <> struct RecordArg<std::string> : StringArg {
+    static std::size_t size(const std::string &value) { return StringArg::size(value.data(), value.size()); }
+    static char *store(char *to, const std::string &value) { return StringArg::store(to, value.data(), value.size()); }
+};
+
+template <> struct RecordArg<const char *> : StringArg {
+    static std::size_t size(const char *value) { return StringArg::size(value, std::strlen(value)); }
+    static char *store(char *to, const char *value) { return StringArg::store(to, value, std::strlen(value)); }
+};
+
+template <> struct RecordArg<char *> : RecordArg<const char *> {};
+
+// Arguments are taken by value, so arrays become pointers
+template <typename T> using RecordArgOf = RecordArg<typename std::decay<T>::type>;
+
+template <std::size_t...> struct Indices {};
+template <std::size_t N, std::size_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <std::size_t... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+/**
+ * Format function of records with arguments of given types, its address along with fmt identifies the call
+ */
+template <typename... Args> struct RecordFormat {
+    static void format(const char *fmt, const char *args, fmt::MemoryWriter &out) {
+        apply(fmt, args, out, typename MakeIndices<sizeof...(Args)>::type());
+    }
+
+    template <std::size_t... I>
+    static void apply(const char *fmt, const char *args, fmt::MemoryWriter &out, Indices<I...>) {
+        // Braced initialization loads arguments left to right
+        std::tuple<typename RecordArgOf<Args>::Value...> values{RecordArgOf<Args>::load(args)...};
+        (void)args;
+        out.write(fmt, std::get<I>(values)...);
+    }
+};
+
+inline std::size_t ArgsSize() { return 0; }
+
+template <typename T, typename... Args> std::size_t ArgsSize(const T &value, const Args &... args) {
+    return RecordArgOf<T>::size(value) + ArgsSize(args...);
+}
+
+inline char *StoreArgs(char *to) { return to; }
+
+template <typename T, typename... Args> char *StoreArgs(char *to, const T &value, const Args &... args) {
+    return StoreArgs(RecordArgOf<T>::store(to, value), args...);
+}
+
+} // namespace detail
+
+/**
+ * # Logger writing through per thread rings
+ * Regular spdlog calls format message in the calling thread and pass it to the ring as text. record()
+ * goes further: it copies arguments to the ring as they are, so that formatting happens in the flusher.
+ * AFINA_LOG_* calls record() whatever pointer the logger is held by, see Logging::Handle in Log.h
+ */
+class RingLogger : public spdlog::logger {
+public:
+    RingLogger(const std::string &name, const std::vector<spdlog::sink_ptr> &sinks, std::shared_ptr<LogRings> rings);
+
+    /**
+     * Writes out records pending in rings, so none of them refers to the logger
+     */
+    ~RingLogger() override;
+
+    /**
+     * Logs binary record: fmt by pointer, so it must be a literal, and arguments as they are. Arguments could
+     * be numbers, pointers and strings
+     */
+    template <typename... Args> void record(spdlog::level::level_enum lvl, const char *fmt, const Args &... args) {
+        if (!should_log(lvl)) {
+            return;
+        }
+
+        LogRings::Record *record = _rings->reserve(sizeof(LogRings::Record) + detail::ArgsSize(args...));
+        if (record == nullptr) {
+            return;
+        }
+        detail::StoreArgs(reinterpret_cast<char *>(record + 1), args...);
+        record->format = &detail::RecordFormat<Args...>::format;
+        record->fmt = fmt;
+        record->logger = this;
+        record->time = spdlog::details::os::now().time_since_epoch().count();
+        record->thread_id = spdlog::details::os::thread_id();
+        record->level = lvl;
+        _rings->commit(record);
+    }
+
+    /**
+     * Waits until everything logged so far is written and flushes sinks
+     */
+    void flush() override;
+
+protected:
+    // Message formatted by spdlog goes to the ring as text, only direct spdlog calls get here
+    void _sink_it(spdlog::details::log_msg &msg) override;
+
+private:
+    friend class LogRings;
+
+    /**
+     * Passes record to sinks, called by flusher
+     */
+    void write(const LogRings::Record &record);
+
+    std::shared_ptr<LogRings> _rings;
+};
+
+} // namespace Logging
+} // namespace Afina
+
+#endif // AFINA_LOGGING_RING_LOGGER_H
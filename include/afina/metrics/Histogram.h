@@ -0,0 +1,144 @@
+#ifndef AFINA_METRICS_HISTOGRAM_H
+#define AFINA_METRICS_HISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Metrics {
+
+/**
+ * # Log-linear histogram
+ * Bucketing is the same as in HdrHistogram: values below sub_buckets get a bucket each, every next power of two
+ * range is split into sub_buckets equal parts. So reported value is never off by more than 1/sub_buckets of
+ * itself, whether it is a few nanoseconds or a few seconds, while the whole histogram fits in a few KB.
+ *
+ * Record is a couple of shifts and a bucket increment. Only the owner thread records, others could read
+ * buckets at the same time to build a Snapshot
+ */
+class Histogram {
+public:
+    // Every power of two range is split into 2^sub_bucket_bits buckets, that is about 6% precision
+    static constexpr unsigned sub_bucket_bits = 4;
+    static constexpr uint64_t sub_buckets = uint64_t(1) << sub_bucket_bits;
+
+    // Values of 2^max_bits and above are counted as 2^max_bits - 1, about 18 minutes for nanoseconds
+    static constexpr unsigned max_bits = 40;
+    static constexpr uint64_t max_value = (uint64_t(1) << max_bits) - 1;
+
+    static constexpr std::size_t bucket_count = (max_bits - sub_bucket_bits + 1) * sub_buckets;
+
+    Histogram() : _max(0) {
+        for (auto &count : _counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Counts value, must be called by owner only
+     */
+    void Record(uint64_t value) {
+        if (value > max_value) {
+            value = max_value;
+        }
+        std::atomic<uint64_t> &count = _counts[BucketOf(value)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > _max.load(std::memory_order_relaxed)) {
+            _max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Bucket where value goes
+     */
+    static std::size_t BucketOf(uint64_t value) {
+        if (value < sub_buckets) {
+            return value;
+        }
+        unsigned shift = 63 - __builtin_clzll(value) - sub_bucket_bits;
+        return (shift + 1) * sub_buckets + ((value >> shift) - sub_buckets);
+    }
+
+    /**
+     * The largest value that goes into bucket
+     */
+    static uint64_t UpperBound(std::size_t bucket) {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        unsigned shift = bucket / sub_buckets - 1;
+        uint64_t sub = bucket % sub_buckets + sub_buckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    /**
+     * Sum of several histograms taken at some moment
+     */
+    class Snapshot {
+    public:
+        Snapshot() : _counts(bucket_count, 0), _total(0), _max(0) {}
+
+        /**
+         * Adds current state of the histogram, could run concurrently with Record
+         */
+        void Add(const Histogram &histogram) {
+            for (std::size_t i = 0; i < bucket_count; i++) {
+                uint64_t count = histogram._counts[i].load(std::memory_order_relaxed);
+                _counts[i] += count;
+                _total += count;
+            }
+            _max = std::max(_max, histogram._max.load(std::memory_order_relaxed));
+        }
+
+        /**
+         * Number of recorded values
+         */
+        uint64_t Count() const { return _total; }
+
+        /**
+         * The largest recorded value, exact
+         */
+        uint64_t Max() const { return _max; }
+
+        /**
+         * Value that is not less than the given fraction of recorded values, 0.99 for p99.
+         * Rounded up to the bucket bound, but never above Max. Zero if nothing was recorded
+         */
+        uint64_t Percentile(double fraction) const {
+            if (_total == 0) {
+                return 0;
+            }
+
+            // Rank of the value we are looking for, 1-based
+            uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * _total));
+            rank = std::max<uint64_t>(1, std::min(rank, _total));
+
+            uint64_t seen = 0;
+            for (std::size_t i = 0; i < bucket_count; i++) {
+                seen += _counts[i];
+                if (seen >= rank) {
+                    return std::min(UpperBound(i), _max);
+                }
+            }
+            return _max;
+        }
+
+    private:
+        std::vector<uint64_t> _counts;
+        uint64_t _total;
+        uint64_t _max;
+    };
+
+private:
+    std::atomic<uint64_t> _counts[bucket_count];
+    std::atomic<uint64_t> _max;
+};
+
+} // namespace Metrics
+} // namespace Afina
+
+#endif // AFINA_METRICS_HISTOGRAM_H
@@ -0,0 +1,86 @@
+#ifndef AFINA_METRICS_LATENCY_H
+#define AFINA_METRICS_LATENCY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <afina/concurrency/ThreadLocal.h>
+#include <afina/metrics/Histogram.h>
+
+namespace Afina {
+namespace Metrics {
+
+/**
+ * Command types latency is tracked for
+ */
+enum class Op : std::size_t { kGet, kSet, kAdd, kAppend, kReplace, kDelete, kStats, kOther, kCount };
+
+/**
+ * Steps of request processing
+ */
+enum class Stage : std::size_t {
+    // Parser work on command line, summed over all reads it took
+    kParse,
+
+    // Command::Execute
+    kExecute,
+
+    // From the moment response is ready till it is written to socket
+    kWrite,
+
+    kCount
+};
+
+/**
+ * Names used in "stats latency" output
+ */
+const char *Name(Op op);
+const char *Name(Stage stage);
+
+/**
+ * Type of command by its name in memcached protocol
+ */
+Op OpOf(const std::string &command);
+
+/**
+ * Monotonic time in nanoseconds for latency measurements
+ */
+inline uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+namespace detail {
+
+/**
+ * Latency histograms of a single thread, one per command type and stage
+ */
+struct LatencyShard {
+    Histogram histograms[static_cast<std::size_t>(Op::kCount)][static_cast<std::size_t>(Stage::kCount)];
+};
+
+Concurrency::ThreadLocal<LatencyShard> &LatencyShards();
+
+} // namespace detail
+
+/**
+ * Records duration of the stage in nanoseconds into histogram of the calling thread
+ */
+inline void Record(Op op, Stage stage, uint64_t nanoseconds) {
+    detail::LatencyShards()
+        .local()
+        .histograms[static_cast<std::size_t>(op)][static_cast<std::size_t>(stage)]
+        .Record(nanoseconds);
+}
+
+/**
+ * Histograms of the given command type and stage summed over all threads
+ */
+Histogram::Snapshot Latency(Op op, Stage stage);
+
+} // namespace Metrics
+} // namespace Afina
+
+#endif // AFINA_METRICS_LATENCY_H
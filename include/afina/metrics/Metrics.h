@@ -0,0 +1,98 @@
+#ifndef AFINA_METRICS_METRICS_H
+#define AFINA_METRICS_METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Metrics {
+
+/**
+ * Process wide counters reported by memcached "stats" command
+ */
+enum class Id : std::size_t {
+    // Storage: items and their key + value sizes currently stored, items dropped to free space
+    kCurrItems,
+    kBytes,
+    kEvictions,
+
+    // Commands: retrieval requests per key and their outcome, storage requests, requests answered with ERROR
+    kCmdGet,
+    kGetHits,
+    kGetMisses,
+    kCmdSet,
+    kProtocolErrors,
+
+    // Network
+    kCurrConnections,
+    kTotalConnections,
+    kBytesRead,
+    kBytesWritten,
+
+    // Backpressure: responses waiting to be sent, connections not reading requests because of them, and how
+    // many times connections stopped reading
+    kOutputBytes,
+    kThrottledConnections,
+    kTotalThrottles,
+
+    // Logging: records dropped because the ring of the thread was full
+    kLogDropped,
+
+    // Journal: attempts to write out or sync journal that failed
+    kJournalErrors,
+
+    kCount
+};
+
+/**
+ * Name of counter as memcached reports it
+ */
+const char *Name(Id id);
+
+namespace detail {
+
+/**
+ * Counters of a single thread. Only owner writes them, so increment is a plain load and store without
+ * lock prefix and without cache line ping-pong. Others read them while collecting stats
+ */
+struct Shard {
+    Shard() {
+        for (auto &value : values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<int64_t> values[static_cast<std::size_t>(Id::kCount)];
+};
+
+Concurrency::ThreadLocal<Shard> &Shards();
+
+} // namespace detail
+
+/**
+ * Changes counter by delta, could be negative for gauges such as kCurrItems. Costs about as much as
+ * increment of a thread_local variable
+ */
+inline void Add(Id id, int64_t delta = 1) {
+    std::atomic<int64_t> &value = detail::Shards().local().values[static_cast<std::size_t>(id)];
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/**
+ * Current value of counter summed over all threads. Gauges could be updated by different threads in
+ * increment and decrement, so only the total makes sense
+ */
+int64_t Value(Id id);
+
+/**
+ * Seconds since process start
+ */
+int64_t Uptime();
+
+} // namespace Metrics
+} // namespace Afina
+
+#endif // AFINA_METRICS_METRICS_H
@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -18,9 +19,28 @@ namespace Network {
 class Server {
 public:
     Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-        : pStorage(ps), pLogging(pl) {}
+        : pStorage(ps), pLogging(pl), connection_output_limit(4 * 1024 * 1024),
+          total_output_limit(256 * 1024 * 1024), inherited_socket(-1) {}
     virtual ~Server() {}
 
+    /**
+     * Makes the next Start serve given socket, bound and listening already, instead of opening a new one.
+     * That is how new process takes over socket of the one it replaces, see Handover.h. Server owns the
+     * socket from now on
+     */
+    void Inherit(int socket) { inherited_socket = socket; }
+
+    /**
+     * Bytes of responses waiting to be sent that make the next Start stop reading requests: from a single
+     * connection that has connection_output of them, from any connection while all together have total_output.
+     * Memory of slow or not reading clients is bounded so, see OutputLimits.h. Servers that block on send
+     * keep a single response per connection and don't need the limits
+     */
+    void Limit(std::size_t connection_output, std::size_t total_output) {
+        connection_output_limit = connection_output;
+        total_output_limit = total_output;
+    }
+
     /**
      * Starts network service. After method returns process should
      * listen on the given interface/port pair to process  incomming
@@ -35,6 +55,9 @@ public:
      *
      * After existing connections drain each should be closed and once worker has no more connection
      * its thread should be exit
+     *
+     * Listening socket itself is only closed, never shut down, as it may be shared with the process that
+     * took it over
      */
     virtual void Stop() = 0;
 
@@ -44,7 +67,21 @@ public:
      */
     virtual void Join() = 0;
 
+    /**
+     * Socket server accepts connections on, valid from Start till Join
+     */
+    virtual int Socket() const = 0;
+
 protected:
+    /**
+     * Socket given to Inherit, or -1 if Start has to open its own one. Caller owns the socket
+     */
+    int TakeInherited() {
+        int socket = inherited_socket;
+        inherited_socket = -1;
+        return socket;
+    }
+
     /**
      * Instance of backing storeage on which current server should execute
      * each command
@@ -55,6 +92,15 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Output limits given to Limit
+     */
+    std::size_t connection_output_limit;
+    std::size_t total_output_limit;
+
+private:
+    int inherited_socket;
 };
 
 } // namespace Network
@@ -0,0 +1,127 @@
+#ifndef AFINA_TRACE_TRACE_H
+#define AFINA_TRACE_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <afina/metrics/Latency.h>
+
+namespace Afina {
+namespace Trace {
+
+/**
+ * # Request trace file
+ * Header followed by fixed size records, one per key of a request. Keys aren't kept, only their hash and
+ * size, so trace carries no user data and still could be replayed against a storage: key of the same size
+ * is built from the hash
+ */
+struct Header {
+    char magic[8];
+    uint32_t version;
+
+    // One of sample keys is traced, see Start
+    uint32_t sample;
+
+    // Wall clock time of the first record, nanoseconds since epoch
+    uint64_t start_time;
+};
+
+struct Record {
+    // Nanoseconds since start of the trace
+    uint64_t time;
+    uint64_t key_hash;
+
+    // Of the data block of storage commands, zero for the rest
+    uint32_t value_size;
+    uint16_t key_size;
+
+    // Metrics::Op
+    uint8_t op;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(Record) == 24, "Record layout is a part of file format");
+
+/**
+ * Hash of the key as it goes into trace, the same between builds and runs
+ */
+uint64_t Hash(const std::string &key);
+
+namespace detail {
+
+extern std::atomic<bool> enabled;
+
+void Add(Metrics::Op op, const std::vector<std::string> &keys, std::size_t value_size);
+
+} // namespace detail
+
+/**
+ * Starts tracing requests into file at path, overwriting it. Only one of sample keys is traced, chosen by
+ * key hash, so sampled trace keeps every request to the keys it has. Records go to buffer of the calling
+ * thread and background thread writes them out every 100 ms, if thread buffered more than buffer_limit
+ * bytes since then, its records are dropped rather than slow requests down. Records of every write are
+ * sorted by time, so file is ordered by time rather than by thread. If write fails, file is cut back to the
+ * last complete record and tracing stops, the rest of records count as dropped.
+ *
+ * Throws std::runtime_error if file couldn't be created or trace is running already
+ */
+void Start(const std::string &path, uint32_t sample = 1, std::size_t buffer_limit = 4 * 1024 * 1024);
+
+/**
+ * Writes out everything buffered and closes the file
+ */
+void Stop();
+
+/**
+ * Traces request with given keys, value_size is the size of data block for storage commands. Costs a
+ * single load of a flag while trace is off
+ */
+inline void Request(Metrics::Op op, const std::vector<std::string> &keys, std::size_t value_size) {
+    if (detail::enabled.load(std::memory_order_relaxed)) {
+        detail::Add(op, keys, value_size);
+    }
+}
+
+/**
+ * Records written to the file and dropped because buffer was full, since the last Start
+ */
+uint64_t Written();
+uint64_t Dropped();
+
+/**
+ * # Sequential reader of trace file
+ */
+class Reader {
+public:
+    /**
+     * Throws std::runtime_error if file couldn't be opened or isn't a trace
+     */
+    explicit Reader(const std::string &path);
+    ~Reader();
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    /**
+     * Reads the next record, returns false at the end of file. Torn record at the end is ignored
+     */
+    bool Next(Record &record);
+
+    const Header &header() const { return _header; }
+
+private:
+    std::FILE *_file;
+    Header _header;
+
+    std::vector<Record> _records;
+    std::size_t _position;
+};
+
+} // namespace Trace
+} // namespace Afina
+
+#endif // AFINA_TRACE_TRACE_H
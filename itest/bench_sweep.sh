@@ -0,0 +1,87 @@
+#!/bin/bash
+# Runs afina-bench against every network and storage pair and prints a CSV table.
+#
+# Usage: bench_sweep.sh <build dir> [afina-bench options...]
+# Environment: NETWORKS, STORAGES override lists below. Afina listens on 8080, it must be free
+set -u
+
+if [ $# -lt 1 ] || [ ! -x "$1/src/afina" ] || [ ! -x "$1/src/bench/afina-bench" ]; then
+    echo "Usage: $0 <build dir> [afina-bench options...]" >&2
+    echo "Build dir must have src/afina and src/bench/afina-bench built" >&2
+    exit 1
+fi
+
+build=$1
+shift
+
+if (exec 3<>/dev/tcp/127.0.0.1/8080) 2>/dev/null; then
+    echo "Port 8080 is already taken" >&2
+    exit 1
+fi
+
+networks=${NETWORKS:-"st_block st_nonblock st_coroutine mt_block mt_threadpool mt_nonblock"}
+storages=${STORAGES:-"st_lru st_arena_lru st_slab_lru st_mapped_lru mt_lru mt_slru mt_fclru mt_arena_lru mt_slab_lru mt_mapped_lru"}
+port=8080
+
+workdir=$(mktemp -d)
+trap 'kill $afina 2>/dev/null; rm -rf "$workdir"' EXIT
+afina=
+
+# Waits for afina to accept connections, fails if it exited
+wait_port() {
+    for _ in $(seq 100); do
+        if ! kill -0 "$afina" 2>/dev/null; then
+            return 1
+        fi
+        if (exec 3<>"/dev/tcp/127.0.0.1/$port") 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+# Stops afina, kills it if it doesn't exit in 5 seconds
+stop() {
+    kill "$afina" 2>/dev/null
+    for _ in $(seq 50); do
+        if ! kill -0 "$afina" 2>/dev/null; then
+            break
+        fi
+        sleep 0.1
+    done
+    kill -9 "$afina" 2>/dev/null
+    wait "$afina" 2>/dev/null
+    rm -f "$workdir/afina.storage"
+}
+
+echo "network,storage,ops_per_sec,p50_us,p90_us,p99_us,p999_us,max_us,hits,misses,errors"
+for network in $networks; do
+    for storage in $storages; do
+        # Single threaded storages are safe only behind single threaded networks
+        if [[ $storage == st_* && $network == mt_* ]]; then
+            continue
+        fi
+
+        "$build/src/afina" -n "$network" -s "$storage" --storage-file "$workdir/afina.storage" \
+            >"$workdir/afina.log" 2>&1 &
+        afina=$!
+
+        if ! wait_port; then
+            echo "$network,$storage,failed to start"
+            stop
+            continue
+        fi
+
+        # Exit code 2 means some requests failed, the row still has numbers
+        output=$("$build/src/bench/afina-bench" --port "$port" --csv "$@" 2>&1)
+        code=$?
+        if [ $code -eq 0 ] || [ $code -eq 2 ]; then
+            echo "$network,$storage,$(tail -n 1 <<<"$output")"
+        else
+            echo "$network,$storage,failed: $(tail -n 1 <<<"$output")"
+        fi
+
+        stop
+    done
+done
@@ -1,40 +1,262 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
 /**
- * TODO: semantics
- * @param N size_t
+ * Header in front of every block
  */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
+struct Simple::Block {
+    // Payload size, multiple of alignment
+    size_t size;
 
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
+    // Descriptor pointing to the payload, nullptr for free block
+    void **desc;
+
+    char *payload() { return reinterpret_cast<char *>(this + 1); }
+    char *end() { return payload() + size; }
+
+    // Next block in the free list, kept in the payload of free block
+    Block *&next_free() { return *reinterpret_cast<Block **>(payload()); }
+
+    static Block *of(void *payload) { return reinterpret_cast<Block *>(payload) - 1; }
+};
+
+namespace {
+
+// Payload alignment, the same malloc provides
+const size_t alignment = 16;
+
+// Smallest payload, free block must be able to keep free list link
+const size_t min_payload = alignment;
+
+size_t align_up(size_t value) { return (value + alignment - 1) & ~(alignment - 1); }
+
+} // namespace
+
+Simple::Simple(void *base, size_t size)
+    : _base(base), _base_len(size), _free_desc(nullptr), _free_blocks(nullptr), _free_bytes(0) {
+    static_assert(sizeof(Block) % alignment == 0, "Header must keep payload aligned");
+
+    uintptr_t begin = align_up(reinterpret_cast<uintptr_t>(base));
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~(sizeof(void *) - 1);
+    if (begin > end) {
+        begin = end;
+    }
+
+    _begin = _top = reinterpret_cast<char *>(begin);
+    _desc_low = _desc_end = reinterpret_cast<void **>(end);
+}
 
 /**
- * TODO: semantics
- * @param p Pointer
+ * Reuses released descriptor and block if possible, otherwise takes both from the space between
+ * last block and descriptors table
  */
-void Simple::free(Pointer &p) {}
+Pointer Simple::alloc(size_t N) {
+    size_t size = align_up(std::max(N, min_payload));
+    void **desc = new_descriptor();
+
+    Block *block = find_block(size);
+    if (block == nullptr) {
+        if (size + sizeof(Block) > static_cast<size_t>(reinterpret_cast<char *>(_desc_low) - _top)) {
+            // Give descriptor back, nothing changes on failure
+            *desc = _free_desc;
+            _free_desc = desc;
+            throw AllocError(AllocErrorType::NoMemory, "No free chunk of " + std::to_string(N) + " bytes");
+        }
+
+        block = reinterpret_cast<Block *>(_top);
+        block->size = size;
+        _top = block->end();
+    }
+
+    block->desc = desc;
+    *desc = block->payload();
+    return Pointer(desc);
+}
 
 /**
- * TODO: semantics
+ * Tries in order: shrink in place, grow into the free space at the top or into the next free block and only
+ * then moves block to a new place
  */
-void Simple::defrag() {}
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._desc == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    Block *block = block_of(p);
+    size_t size = align_up(std::max(N, min_payload));
+    if (size <= block->size) {
+        shrink(block, size);
+        return;
+    }
+
+    if (block->end() == _top) {
+        if (size - block->size <= static_cast<size_t>(reinterpret_cast<char *>(_desc_low) - _top)) {
+            block->size = size;
+            _top = block->end();
+            return;
+        }
+    } else {
+        Block *next = reinterpret_cast<Block *>(block->end());
+        if (next->desc == nullptr && block->size + sizeof(Block) + next->size >= size) {
+            unlink(next);
+            block->size += sizeof(Block) + next->size;
+            shrink(block, size);
+            return;
+        }
+    }
+
+    // Copy data to the new block and swap descriptors, so that copies of p refer to the new place
+    Pointer fresh = alloc(N);
+    Block *moved = block_of(fresh);
+    std::memcpy(moved->payload(), block->payload(), block->size);
+
+    std::swap(block->desc, moved->desc);
+    *block->desc = block->payload();
+    *moved->desc = moved->payload();
+    free(fresh);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    Block *block = block_of(p);
+    void **desc = block->desc;
+    release(block);
+
+    *desc = _free_desc;
+    _free_desc = desc;
+    p._desc = nullptr;
+}
 
 /**
- * TODO: semantics
+ * Single pass over all blocks: live ones are moved down right after the previous live block, free ones
+ * are skipped
  */
-std::string Simple::dump() const { return ""; }
+void Simple::defrag() {
+    char *dst = _begin;
+    for (char *cur = _begin; cur < _top;) {
+        Block *block = reinterpret_cast<Block *>(cur);
+        size_t span = sizeof(Block) + block->size;
+        if (block->desc != nullptr) {
+            if (cur != dst) {
+                std::memmove(dst, cur, span);
+                block = reinterpret_cast<Block *>(dst);
+                *block->desc = block->payload();
+            }
+            dst += span;
+        }
+        cur += span;
+    }
+
+    _top = dst;
+    _free_blocks = nullptr;
+    _free_bytes = 0;
+}
+
+// See Simple.h
+size_t Simple::free_space() const {
+    size_t space = static_cast<size_t>(reinterpret_cast<char *>(_desc_low) - _top) + _free_bytes;
+    size_t overhead = sizeof(Block) + (_free_desc == nullptr ? sizeof(void *) : 0);
+    return space > overhead ? (space - overhead) & ~(alignment - 1) : 0;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::stringstream out;
+    out << "area " << _base_len << " bytes, blocks " << (_top - _begin) << " bytes, descriptors "
+        << (_desc_end - _desc_low) << ", free " << free_space() << " bytes" << std::endl;
+    for (char *cur = _begin; cur < _top;) {
+        Block *block = reinterpret_cast<Block *>(cur);
+        out << "  +" << (cur - _begin) << (block->desc != nullptr ? " used " : " free ") << block->size << std::endl;
+        cur = block->end();
+    }
+    return out.str();
+}
+
+void **Simple::new_descriptor() {
+    if (_free_desc != nullptr) {
+        void **desc = _free_desc;
+        _free_desc = reinterpret_cast<void **>(*desc);
+        return desc;
+    }
+
+    if (static_cast<size_t>(reinterpret_cast<char *>(_desc_low) - _top) < sizeof(void *)) {
+        throw AllocError(AllocErrorType::NoMemory, "No space for descriptor");
+    }
+    return --_desc_low;
+}
+
+Simple::Block *Simple::find_block(size_t size) {
+    for (Block *block = _free_blocks; block != nullptr; block = block->next_free()) {
+        if (block->size >= size) {
+            unlink(block);
+            shrink(block, size);
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+Simple::Block *Simple::block_of(const Pointer &p) const {
+    if (p._desc < _desc_low || p._desc >= _desc_end) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to allocator");
+    }
+
+    // Released descriptor points either to another descriptor or nowhere
+    char *payload = reinterpret_cast<char *>(*p._desc);
+    if (payload < _begin + sizeof(Block) || payload >= _top) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer refers to released block");
+    }
+
+    Block *block = Block::of(payload);
+    if (block->desc != p._desc) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer refers to released block");
+    }
+    return block;
+}
+
+void Simple::shrink(Block *block, size_t size) {
+    if (block->size - size < sizeof(Block) + min_payload) {
+        return;
+    }
+
+    Block *rest = reinterpret_cast<Block *>(block->payload() + size);
+    rest->size = block->size - size - sizeof(Block);
+    block->size = size;
+    release(rest);
+}
+
+void Simple::release(Block *block) {
+    block->desc = nullptr;
+    if (block->end() == _top) {
+        _top = reinterpret_cast<char *>(block);
+        return;
+    }
+
+    block->next_free() = _free_blocks;
+    _free_blocks = block;
+    _free_bytes += sizeof(Block) + block->size;
+}
+
+void Simple::unlink(Block *block) {
+    for (Block **link = &_free_blocks; *link != nullptr; link = &(*link)->next_free()) {
+        if (*link == block) {
+            *link = block->next_free();
+            _free_bytes -= sizeof(Block) + block->size;
+            return;
+        }
+    }
+}
 
 } // namespace Allocator
 } // namespace Afina
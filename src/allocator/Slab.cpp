@@ -0,0 +1,606 @@
+#include <afina/allocator/Slab.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/mman.h>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+constexpr std::size_t Slab::max_classes;
+constexpr std::size_t Slab::alignment;
+
+namespace {
+
+// Region is aligned to transparent huge page, so that kernel could back it with 2MB pages
+const std::size_t huge_page = 2 * 1024 * 1024;
+
+// Magazine holds at most that many chunks and bytes, so thread caches at most twice as much of a class
+const std::size_t magazine_chunks = 16;
+const std::size_t magazine_bytes = 32 * 1024;
+
+// Depot head: chunk offset in alignment units plus one in the low bits, zero for empty stack, change
+// counter in the rest
+const unsigned offset_bits = 40;
+const uint64_t offset_mask = (uint64_t(1) << offset_bits) - 1;
+
+// Mark of slab that belongs to no class yet
+const uint8_t no_class = 0xff;
+
+std::size_t align_up(std::size_t value, std::size_t to) { return (value + to - 1) / to * to; }
+
+// Next chunk of the same magazine, only the owner of magazine touches it
+void *&next_of(void *chunk) { return *reinterpret_cast<void **>(chunk); }
+
+// Next magazine in depot, could be read by a thread that lost the race for the chunk, so accessed atomically
+void *next_magazine(void *chunk) { return __atomic_load_n(reinterpret_cast<void **>(chunk) + 1, __ATOMIC_RELAXED); }
+void set_next_magazine(void *chunk, void *next) {
+    __atomic_store_n(reinterpret_cast<void **>(chunk) + 1, next, __ATOMIC_RELAXED);
+}
+
+// Holds busy flag of thread cache
+class CacheLock {
+public:
+    explicit CacheLock(std::atomic<bool> &busy) : _busy(busy) {
+        while (_busy.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+    ~CacheLock() { _busy.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> &_busy;
+};
+
+} // namespace
+
+Slab::Slab(std::size_t memory_limit, std::size_t slab_size, std::size_t min_chunk, double factor)
+    : _region(nullptr), _region_len(0), _hugetlb(false), _next_slab(0), _move_start(0), _class_count(0) {
+    if (factor <= 1.0) {
+        throw std::runtime_error("Slab growth factor must be greater than 1");
+    }
+
+    _slab_shift = 0;
+    while ((std::size_t(1) << _slab_shift) < std::max(slab_size, alignment)) {
+        _slab_shift++;
+    }
+    _slab_size = std::size_t(1) << _slab_shift;
+    _slab_count = std::max<std::size_t>(1, memory_limit / _slab_size);
+    if ((_slab_count * _slab_size) / alignment >= offset_mask) {
+        throw std::runtime_error("Slab memory limit is too large");
+    }
+
+    // Geometric sizes up to slab_size / factor, the last class takes whole slab
+    std::vector<std::size_t> sizes;
+    std::size_t size = align_up(std::max(min_chunk, 2 * sizeof(void *)), alignment);
+    while (sizes.size() < max_classes - 1 && size <= _slab_size / factor) {
+        sizes.push_back(size);
+        size = std::max(align_up(static_cast<std::size_t>(size * factor), alignment), size + alignment);
+    }
+    sizes.push_back(_slab_size);
+
+    _class_count = sizes.size();
+    _classes.reset(new Class[_class_count]);
+    for (std::size_t i = 0; i < _class_count; i++) {
+        Class &cls = _classes[i];
+        cls.size = sizes[i];
+        cls.per_slab = _slab_size / cls.size;
+        cls.magazine = std::min(magazine_chunks, magazine_bytes / cls.size);
+        cls.cached = cls.magazine > 0;
+        if (!cls.cached) {
+            cls.magazine = 1;
+        }
+        cls.carve = cls.carve_end = nullptr;
+        cls.spare = nullptr;
+        cls.spare_count = 0;
+        cls.slabs = 0;
+        cls.failures.store(0, std::memory_order_relaxed);
+    }
+
+    _slab_class.reset(new std::atomic<uint8_t>[_slab_count]);
+    for (std::size_t i = 0; i < _slab_count; i++) {
+        _slab_class[i].store(no_class, std::memory_order_relaxed);
+    }
+    _moving_slab.store(_slab_count, std::memory_order_relaxed);
+    _slabs_moved.store(0, std::memory_order_relaxed);
+    map_region(_slab_count * _slab_size);
+}
+
+Slab::~Slab() { munmap(_region, _region_len); }
+
+// See Slab.h
+std::size_t Slab::class_of(std::size_t size) const {
+    std::size_t lo = 0, hi = _class_count - 1;
+    while (lo < hi) {
+        std::size_t mid = (lo + hi) / 2;
+        if (_classes[mid].size < size) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// See Slab.h
+void *Slab::alloc(std::size_t cls) {
+    while (true) {
+        void *chunk = take(cls);
+        if (chunk == nullptr) {
+            _classes[cls].failures.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // Chunks of the moving slab are put aside on the way out
+        if (!is_moving(chunk) || !divert(chunk)) {
+            return chunk;
+        }
+    }
+}
+
+// See Slab.h
+void Slab::free(void *ptr) {
+    char *chunk = static_cast<char *>(ptr);
+    if (chunk < _region || chunk >= _region + _slab_count * _slab_size) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to allocator");
+    }
+
+    std::size_t offset = chunk - _region;
+    uint8_t id = _slab_class[offset >> _slab_shift].load(std::memory_order_relaxed);
+    if (id == no_class) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer refers to unused slab");
+    }
+
+    Class &c = _classes[id];
+    std::size_t in_slab = offset & (_slab_size - 1);
+    if (in_slab % c.size != 0 || in_slab / c.size >= c.per_slab) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer is not a chunk start");
+    }
+
+    if (is_moving(ptr) && divert(ptr)) {
+        return;
+    }
+
+    if (!c.cached) {
+        next_of(ptr) = nullptr;
+        push(c.depot, ptr);
+        return;
+    }
+
+    Cache &cache = _caches.local();
+    CacheLock lock(cache.busy);
+    Cache::Bin &bin = cache.bins[id];
+    std::size_t count = bin.loaded_count.load(std::memory_order_relaxed);
+    if (count == c.magazine) {
+        // Loaded one is full, previous one goes to depot if it is full too and then takes its place
+        if (bin.previous_count.load(std::memory_order_relaxed) > 0) {
+            push(c.depot, bin.previous);
+        }
+        bin.previous = bin.loaded;
+        bin.previous_count.store(count, std::memory_order_relaxed);
+        bin.loaded = nullptr;
+        count = 0;
+    }
+
+    next_of(ptr) = bin.loaded;
+    bin.loaded = ptr;
+    bin.loaded_count.store(count + 1, std::memory_order_relaxed);
+}
+
+/**
+ * Slab counters are taken under class locks, depot and thread caches are summed up without any lock, so
+ * numbers could be slightly off while threads are running
+ */
+std::vector<Slab::ClassStats> Slab::stats() const {
+    std::vector<ClassStats> result(_class_count);
+    for (std::size_t i = 0; i < _class_count; i++) {
+        Class &c = _classes[i];
+        std::lock_guard<std::mutex> lock(c.lock);
+        result[i].chunk_size = c.size;
+        result[i].chunks_per_slab = c.per_slab;
+        result[i].slabs = c.slabs;
+        result[i].free_chunks = c.depot.magazines.load(std::memory_order_relaxed) * c.magazine + c.spare_count;
+        result[i].free_chunks_end = (c.carve_end - c.carve) / c.size;
+        result[i].failures = c.failures.load(std::memory_order_relaxed);
+
+        // Chunks put aside by move are free as well
+        std::size_t slab = _moving_slab.load(std::memory_order_relaxed);
+        if (slab != _slab_count && _slab_class[slab].load(std::memory_order_relaxed) == i) {
+            result[i].free_chunks += _move.reclaimed;
+        }
+    }
+
+    _caches.for_each([this, &result](Cache &cache) {
+        for (std::size_t i = 0; i < _class_count; i++) {
+            result[i].free_chunks += cache.bins[i].loaded_count.load(std::memory_order_relaxed) +
+                                     cache.bins[i].previous_count.load(std::memory_order_relaxed);
+        }
+    });
+
+    for (auto &cls : result) {
+        std::size_t total = cls.slabs * cls.chunks_per_slab;
+        std::size_t unused = cls.free_chunks + cls.free_chunks_end;
+        cls.used_chunks = total > unused ? total - unused : 0;
+    }
+    return result;
+}
+
+// See Slab.h
+std::size_t Slab::used_slabs() const { return std::min(_next_slab.load(std::memory_order_relaxed), _slab_count); }
+
+/**
+ * Chunks of the chosen slab that are free at the moment, in the carve area or spare list, are put aside right
+ * away, the rest are caught by alloc, free and finish_move
+ */
+bool Slab::begin_move(std::size_t from, std::size_t to) {
+    if (from == to || from >= _class_count || to >= _class_count ||
+        _moving_slab.load(std::memory_order_relaxed) != _slab_count) {
+        return false;
+    }
+
+    Class &c = _classes[from];
+    std::lock_guard<std::mutex> lock(c.lock);
+    if (c.slabs < 2) {
+        return false;
+    }
+
+    // Slab being carved is the last choice, the others have been used up already. Search starts after the
+    // slab of the last cancelled move, so the same slab isn't evicted round after round
+    std::size_t carving = c.carve != c.carve_end ? (c.carve - _region) >> _slab_shift : _slab_count;
+    std::size_t slab = carving;
+    for (std::size_t k = 0; k < _slab_count; k++) {
+        std::size_t i = (_move_start + k) % _slab_count;
+        if (i != carving && _slab_class[i].load(std::memory_order_relaxed) == from) {
+            slab = i;
+            break;
+        }
+    }
+
+    _move.slab = slab;
+    _move.from = from;
+    _move.to = to;
+    _move.reclaimed = 0;
+    _move.bitmap.assign((c.per_slab + 63) / 64, 0);
+    _moving_slab.store(slab, std::memory_order_relaxed);
+
+    if (slab == carving) {
+        for (char *chunk = c.carve; chunk < c.carve_end; chunk += c.size) {
+            reclaim(chunk);
+        }
+        c.carve = c.carve_end = nullptr;
+    }
+
+    void *spare = c.spare;
+    c.spare = nullptr;
+    c.spare_count = 0;
+    while (spare != nullptr) {
+        void *next = next_of(spare);
+        if (is_moving(spare)) {
+            reclaim(spare);
+        } else {
+            next_of(spare) = c.spare;
+            c.spare = spare;
+            c.spare_count++;
+        }
+        spare = next;
+    }
+    return true;
+}
+
+// See Slab.h
+bool Slab::moving_range(std::size_t &cls, char *&begin, char *&end) const {
+    std::size_t slab = _moving_slab.load(std::memory_order_relaxed);
+    if (slab == _slab_count) {
+        return false;
+    }
+    cls = _move.from;
+    begin = _region + slab * _slab_size;
+    end = begin + _slab_size;
+    return true;
+}
+
+/**
+ * Depot is emptied and sorted out under class lock: other threads could still push and pop magazines, but
+ * chunks of the slab never get back there once its move has started. Thread caches are drained before, they
+ * are locked by owners ahead of class lock
+ */
+bool Slab::finish_move() {
+    std::size_t slab = _moving_slab.load(std::memory_order_relaxed);
+    if (slab == _slab_count) {
+        return false;
+    }
+
+    Class &c = _classes[_move.from];
+    std::vector<void *> chunks;
+    if (c.cached) {
+        drain(_move.from, chunks);
+    }
+    {
+        std::lock_guard<std::mutex> lock(c.lock);
+        for (void *magazine = pop(c.depot); magazine != nullptr; magazine = pop(c.depot)) {
+            void *chunk = magazine;
+            for (std::size_t i = 0; i < c.magazine; i++) {
+                chunks.push_back(chunk);
+                chunk = next_of(chunk);
+            }
+        }
+
+        for (void *chunk : chunks) {
+            if (is_moving(chunk)) {
+                reclaim(chunk);
+            } else {
+                add_spare(c, chunk);
+            }
+        }
+
+        if (_move.reclaimed < c.per_slab) {
+            return false;
+        }
+        c.slabs--;
+        _moving_slab.store(_slab_count, std::memory_order_relaxed);
+    }
+
+    // Nobody has chunks of the slab anymore, it could be split for the new class
+    Class &to = _classes[_move.to];
+    std::lock_guard<std::mutex> lock(to.lock);
+    _slab_class[slab].store(static_cast<uint8_t>(_move.to), std::memory_order_relaxed);
+    to.slabs++;
+    char *begin = _region + slab * _slab_size;
+    for (std::size_t i = 0; i < to.per_slab; i++) {
+        add_spare(to, begin + i * to.size);
+    }
+    _slabs_moved.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// See Slab.h
+std::size_t Slab::moving_left() const {
+    if (_moving_slab.load(std::memory_order_relaxed) == _slab_count) {
+        return 0;
+    }
+    Class &c = _classes[_move.from];
+    std::lock_guard<std::mutex> lock(c.lock);
+    return c.per_slab - _move.reclaimed;
+}
+
+// See Slab.h
+void Slab::cancel_move() {
+    std::size_t slab = _moving_slab.load(std::memory_order_relaxed);
+    if (slab == _slab_count) {
+        return;
+    }
+
+    Class &c = _classes[_move.from];
+    std::lock_guard<std::mutex> lock(c.lock);
+    _moving_slab.store(_slab_count, std::memory_order_relaxed);
+    _move_start = slab + 1;
+
+    char *begin = _region + slab * _slab_size;
+    for (std::size_t i = 0; i < c.per_slab; i++) {
+        if (_move.bitmap[i / 64] & (uint64_t(1) << (i % 64))) {
+            add_spare(c, begin + i * c.size);
+        }
+    }
+}
+
+void *Slab::take(std::size_t cls) {
+    Class &c = _classes[cls];
+    if (!c.cached) {
+        void *chunk = pop(c.depot);
+        if (chunk == nullptr) {
+            std::size_t count = 1;
+            chunk = carve(c, cls, count);
+        }
+        return chunk;
+    }
+
+    Cache &cache = _caches.local();
+    CacheLock lock(cache.busy);
+    Cache::Bin &bin = cache.bins[cls];
+    std::size_t count = bin.loaded_count.load(std::memory_order_relaxed);
+    if (count == 0) {
+        if (bin.previous_count.load(std::memory_order_relaxed) > 0) {
+            // Previous one is full
+            std::swap(bin.loaded, bin.previous);
+            count = c.magazine;
+            bin.previous_count.store(0, std::memory_order_relaxed);
+        } else if ((bin.loaded = pop(c.depot)) != nullptr) {
+            count = c.magazine;
+        } else {
+            count = c.magazine;
+            bin.loaded = carve(c, cls, count);
+            if (bin.loaded == nullptr) {
+                return nullptr;
+            }
+        }
+    }
+
+    void *chunk = bin.loaded;
+    bin.loaded = next_of(chunk);
+    bin.loaded_count.store(count - 1, std::memory_order_relaxed);
+    return chunk;
+}
+
+void Slab::push(Depot &depot, void *magazine) {
+    uint64_t desired = (static_cast<char *>(magazine) - _region) / alignment + 1;
+    uint64_t head = depot.head.load(std::memory_order_relaxed);
+    do {
+        uint64_t top = head & offset_mask;
+        set_next_magazine(magazine, top == 0 ? nullptr : _region + (top - 1) * alignment);
+        desired = (desired & offset_mask) | ((head & ~offset_mask) + (offset_mask + 1));
+    } while (!depot.head.compare_exchange_weak(head, desired, std::memory_order_release, std::memory_order_relaxed));
+    depot.magazines.fetch_add(1, std::memory_order_relaxed);
+}
+
+void *Slab::pop(Depot &depot) {
+    uint64_t head = depot.head.load(std::memory_order_acquire);
+    while (true) {
+        uint64_t top = head & offset_mask;
+        if (top == 0) {
+            return nullptr;
+        }
+
+        // Chunk could be taken and reused by another thread right now, then next is garbage but CAS fails as
+        // counter has changed. Memory is there anyway, region lives as long as allocator
+        char *magazine = _region + (top - 1) * alignment;
+        char *next = static_cast<char *>(next_magazine(magazine));
+        uint64_t desired = (next == nullptr ? 0 : (next - _region) / alignment + 1) |
+                           ((head & ~offset_mask) + (offset_mask + 1));
+        if (depot.head.compare_exchange_weak(head, desired, std::memory_order_acquire, std::memory_order_acquire)) {
+            depot.magazines.fetch_sub(1, std::memory_order_relaxed);
+            return magazine;
+        }
+    }
+}
+
+/**
+ * Magazine without chunks of the slab stays with its thread, so move doesn't empty every cache of the class
+ */
+void Slab::drain(std::size_t cls, std::vector<void *> &chunks) {
+    _caches.for_each([this, cls, &chunks](Cache &cache) {
+        CacheLock lock(cache.busy);
+        Cache::Bin &bin = cache.bins[cls];
+        std::pair<void **, std::atomic<std::size_t> *> magazines[] = {{&bin.loaded, &bin.loaded_count},
+                                                                       {&bin.previous, &bin.previous_count}};
+        for (auto &magazine : magazines) {
+            std::size_t count = magazine.second->load(std::memory_order_relaxed);
+            bool moving = false;
+            void *chunk = *magazine.first;
+            for (std::size_t i = 0; i < count && !moving; i++, chunk = next_of(chunk)) {
+                moving = is_moving(chunk);
+            }
+            if (!moving) {
+                continue;
+            }
+
+            chunk = *magazine.first;
+            for (std::size_t i = 0; i < count; i++, chunk = next_of(chunk)) {
+                chunks.push_back(chunk);
+            }
+            *magazine.first = nullptr;
+            magazine.second->store(0, std::memory_order_relaxed);
+        }
+    });
+}
+
+bool Slab::divert(void *chunk) {
+    std::size_t slab = (static_cast<char *>(chunk) - _region) >> _slab_shift;
+    Class &c = _classes[_slab_class[slab].load(std::memory_order_relaxed)];
+    std::lock_guard<std::mutex> lock(c.lock);
+    if (_moving_slab.load(std::memory_order_relaxed) != slab) {
+        return false;
+    }
+    reclaim(chunk);
+    return true;
+}
+
+void Slab::reclaim(void *chunk) {
+    std::size_t index = (static_cast<char *>(chunk) - (_region + _move.slab * _slab_size)) / _classes[_move.from].size;
+    uint64_t bit = uint64_t(1) << (index % 64);
+    if ((_move.bitmap[index / 64] & bit) == 0) {
+        _move.bitmap[index / 64] |= bit;
+        _move.reclaimed++;
+    }
+}
+
+void Slab::add_spare(Class &cls, void *chunk) {
+    next_of(chunk) = cls.spare;
+    cls.spare = chunk;
+    cls.spare_count++;
+    if (cls.spare_count < cls.magazine) {
+        return;
+    }
+
+    void *last = cls.spare;
+    for (std::size_t i = 1; i < cls.magazine; i++) {
+        last = next_of(last);
+    }
+    void *magazine = cls.spare;
+    cls.spare = next_of(last);
+    cls.spare_count -= cls.magazine;
+    next_of(last) = nullptr;
+    push(cls.depot, magazine);
+}
+
+void *Slab::carve(Class &cls, std::size_t id, std::size_t &count) {
+    std::lock_guard<std::mutex> lock(cls.lock);
+    void *first = nullptr;
+    std::size_t carved = 0;
+    while (carved < count) {
+        if (cls.spare != nullptr) {
+            void *chunk = cls.spare;
+            cls.spare = next_of(chunk);
+            cls.spare_count--;
+            next_of(chunk) = first;
+            first = chunk;
+            carved++;
+            continue;
+        }
+
+        if (cls.carve == cls.carve_end) {
+            std::size_t slab = _next_slab.load(std::memory_order_relaxed);
+            do {
+                if (slab >= _slab_count) {
+                    count = carved;
+                    return first;
+                }
+            } while (!_next_slab.compare_exchange_weak(slab, slab + 1, std::memory_order_relaxed));
+
+            _slab_class[slab].store(static_cast<uint8_t>(id), std::memory_order_relaxed);
+            cls.carve = _region + slab * _slab_size;
+            cls.carve_end = cls.carve + cls.per_slab * cls.size;
+            cls.slabs++;
+        }
+
+        // Magazine order doesn't matter, so chunks are linked in reverse
+        next_of(cls.carve) = first;
+        first = cls.carve;
+        cls.carve += cls.size;
+        carved++;
+    }
+    return first;
+}
+
+/**
+ * Reserved huge pages are tried first, they are never split nor swapped. Mapping reserves them up front, so
+ * it fails rather than crashes later if the pool is too small. Then region is aligned to huge page and
+ * kernel is asked to use transparent ones there
+ */
+void Slab::map_region(std::size_t size) {
+    std::size_t len = align_up(size, huge_page);
+    void *area = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (area != MAP_FAILED) {
+        _region = static_cast<char *>(area);
+        _region_len = len;
+        _hugetlb = true;
+        return;
+    }
+
+    area = mmap(nullptr, size + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (area == MAP_FAILED) {
+        throw AllocError(AllocErrorType::NoMemory, "Failed to map " + std::to_string(size) + " bytes for slabs");
+    }
+
+    char *begin = static_cast<char *>(area);
+    char *aligned = reinterpret_cast<char *>(align_up(reinterpret_cast<uintptr_t>(begin), huge_page));
+    if (aligned != begin) {
+        munmap(begin, aligned - begin);
+    }
+    std::size_t tail = (begin + size + huge_page) - (aligned + size);
+    if (tail > 0) {
+        munmap(aligned + size, tail);
+    }
+
+    _region = aligned;
+    _region_len = size;
+#ifdef MADV_HUGEPAGE
+    madvise(_region, _region_len, MADV_HUGEPAGE);
+#endif
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,158 @@
+#include "Workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace Afina {
+namespace Bench {
+
+namespace {
+
+class UniformKeys : public KeyDistribution {
+public:
+    UniformKeys(uint64_t keys, uint64_t seed) : _random(seed), _keys(keys) {}
+
+    uint64_t Next() override { return _random.Next() % _keys; }
+
+private:
+    Random _random;
+    uint64_t _keys;
+};
+
+// Threads start at different points, so they don't hit the same key at once
+class ScanKeys : public KeyDistribution {
+public:
+    ScanKeys(uint64_t keys, uint64_t seed) : _keys(keys), _cursor(Random(seed).Next() % keys) {}
+
+    uint64_t Next() override {
+        uint64_t key = _cursor;
+        _cursor = _cursor + 1 == _keys ? 0 : _cursor + 1;
+        return key;
+    }
+
+private:
+    uint64_t _keys;
+    uint64_t _cursor;
+};
+
+// Spreads ranks over key space. Odd multiplier keeps it a bijection for key spaces that are powers of two,
+// otherwise a few keys could collide which doesn't matter for load generation
+uint64_t Scatter(uint64_t rank, uint64_t keys) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(rank) * prime) % keys);
+}
+
+} // namespace
+
+// See Workload.h
+std::unique_ptr<KeyDistribution> KeyDistribution::Build(const std::string &name, uint64_t keys,
+                                                        double zipf_theta, uint64_t seed) {
+    if (keys == 0) {
+        throw std::runtime_error("Key space is empty");
+    }
+    if (name == "uniform") {
+        return std::unique_ptr<KeyDistribution>(new UniformKeys(keys, seed));
+    } else if (name == "zipf") {
+        return std::unique_ptr<KeyDistribution>(new ZipfKeys(keys, zipf_theta, seed));
+    } else if (name == "scan") {
+        return std::unique_ptr<KeyDistribution>(new ScanKeys(keys, seed));
+    }
+    throw std::runtime_error("Unknown key distribution " + name);
+}
+
+// See Workload.h
+ZipfKeys::ZipfKeys(uint64_t keys, double theta, uint64_t seed) : _random(seed), _keys(keys) {
+    if (theta <= 0 || theta >= 1) {
+        throw std::runtime_error("Zipf skew must be in (0, 1)");
+    }
+
+    _zeta = 0;
+    for (uint64_t i = 1; i <= keys; i++) {
+        _zeta += 1.0 / std::pow(double(i), theta);
+    }
+    double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+    _alpha = 1.0 / (1.0 - theta);
+    _eta = (1.0 - std::pow(2.0 / keys, 1.0 - theta)) / (1.0 - zeta2 / _zeta);
+    _half_pow_theta = 1.0 + std::pow(0.5, theta);
+}
+
+// See Workload.h
+uint64_t ZipfKeys::Next() { return Scatter(NextRank(), _keys); }
+
+// See Workload.h
+uint64_t ZipfKeys::NextRank() {
+    double u = _random.NextDouble();
+    double uz = u * _zeta;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < _half_pow_theta) {
+        return std::min<uint64_t>(1, _keys - 1);
+    }
+    uint64_t rank = static_cast<uint64_t>(_keys * std::pow(_eta * u - _eta + 1.0, _alpha));
+    return std::min(rank, _keys - 1);
+}
+
+// See Workload.h
+ValueSizes::ValueSizes(const std::string &spec) {
+    char *end = nullptr;
+    _min = _max = std::strtoull(spec.c_str(), &end, 10);
+    if (end != spec.c_str() && *end == '-') {
+        const char *max = end + 1;
+        _max = std::strtoull(max, &end, 10);
+        if (end == max) {
+            end = nullptr;
+        }
+    }
+    if (end == nullptr || end == spec.c_str() || *end != '\0' || _max < _min) {
+        throw std::runtime_error("Value size must be N or MIN-MAX, got " + spec);
+    }
+}
+
+// See Workload.h
+std::size_t ResponseParser::Parse(const char *data, std::size_t size, Counts &counts) {
+    std::size_t pos = 0;
+    for (;;) {
+        const char *line = data + pos;
+        const char *eol = static_cast<const char *>(std::memchr(line, '\n', size - pos));
+        if (eol == nullptr) {
+            return pos;
+        }
+        std::size_t line_size = eol + 1 - line;
+
+        if (line_size >= 6 && std::memcmp(line, "VALUE ", 6) == 0) {
+            // VALUE <key> <flags> <bytes>, then data block and END
+            const char *bytes = static_cast<const char *>(memrchr(line, ' ', line_size));
+            std::size_t value_size = std::strtoull(bytes + 1, nullptr, 10);
+            std::size_t end = pos + line_size + value_size + 2;
+            if (end + 5 > size) {
+                return pos;
+            }
+            if (std::memcmp(data + end, "END\r\n", 5) != 0) {
+                counts.errors++;
+            } else {
+                counts.hits++;
+            }
+            counts.responses++;
+            pos = end + 5;
+            continue;
+        }
+
+        if (line_size == 5 && std::memcmp(line, "END\r\n", 5) == 0) {
+            counts.misses++;
+        } else if (!(line_size == 8 && std::memcmp(line, "STORED\r\n", 8) == 0) &&
+                   !(line_size == 12 && std::memcmp(line, "NOT_STORED\r\n", 12) == 0) &&
+                   !(line_size == 9 && std::memcmp(line, "DELETED\r\n", 9) == 0) &&
+                   !(line_size == 11 && std::memcmp(line, "NOT_FOUND\r\n", 11) == 0)) {
+            counts.errors++;
+        }
+        counts.responses++;
+        pos += line_size;
+    }
+}
+
+} // namespace Bench
+} // namespace Afina
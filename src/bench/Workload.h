@@ -0,0 +1,130 @@
+#ifndef AFINA_BENCH_WORKLOAD_H
+#define AFINA_BENCH_WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Afina {
+namespace Bench {
+
+/**
+ * xorshift64*: cheap enough to be drawn for every request, good enough for load generation
+ */
+class Random {
+public:
+    explicit Random(uint64_t seed) : _state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    uint64_t Next() {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 0x2545F4914F6CDD1Dull;
+    }
+
+    /**
+     * Uniform in [0, 1)
+     */
+    double NextDouble() { return (Next() >> 11) * (1.0 / (uint64_t(1) << 53)); }
+
+private:
+    uint64_t _state;
+};
+
+/**
+ * # Keys requests go to
+ * Every generator thread has its own instance, so Next is never shared
+ */
+class KeyDistribution {
+public:
+    virtual ~KeyDistribution() {}
+
+    /**
+     * Index of the next key, in [0, keys)
+     */
+    virtual uint64_t Next() = 0;
+
+    /**
+     * Builds distribution by name: "uniform", "zipf" with given skew or "scan" going through all keys in
+     * order. Throws std::runtime_error for unknown name
+     */
+    static std::unique_ptr<KeyDistribution> Build(const std::string &name, uint64_t keys, double zipf_theta,
+                                                  uint64_t seed);
+};
+
+/**
+ * Zipf distribution as in YCSB, from "Quickly Generating Billion-Record Synthetic Databases" by Gray et al.
+ * Constants take O(keys) to compute once, every key is O(1) then. Key 0 is the hottest one, so ranks are
+ * scattered over key space to keep hot keys from being neighbours
+ */
+class ZipfKeys : public KeyDistribution {
+public:
+    ZipfKeys(uint64_t keys, double theta, uint64_t seed);
+
+    uint64_t Next() override;
+
+    /**
+     * Popularity rank of the next key, 0 is the most popular, before ranks are scattered over key space
+     */
+    uint64_t NextRank();
+
+private:
+    Random _random;
+    uint64_t _keys;
+    double _alpha;
+    double _zeta;
+    double _eta;
+    double _half_pow_theta;
+};
+
+/**
+ * Value sizes, either fixed "N" or uniform in "MIN-MAX"
+ */
+class ValueSizes {
+public:
+    /**
+     * Throws std::runtime_error if spec is malformed
+     */
+    explicit ValueSizes(const std::string &spec);
+
+    std::size_t Next(Random &random) const {
+        return _min == _max ? _min : _min + random.Next() % (_max - _min + 1);
+    }
+
+    std::size_t Max() const { return _max; }
+
+private:
+    std::size_t _min;
+    std::size_t _max;
+};
+
+/**
+ * # memcached text protocol responses
+ * Counts complete responses at the start of the buffer, partial one is left for the next call
+ */
+class ResponseParser {
+public:
+    struct Counts {
+        Counts() : responses(0), hits(0), misses(0), errors(0) {}
+
+        std::size_t responses;
+
+        // Of get requests
+        std::size_t hits;
+        std::size_t misses;
+
+        // ERROR, CLIENT_ERROR and SERVER_ERROR, along with anything not understood
+        std::size_t errors;
+    };
+
+    /**
+     * Consumes complete responses from data, adding them to counts. Returns number of bytes consumed
+     */
+    static std::size_t Parse(const char *data, std::size_t size, Counts &counts);
+};
+
+} // namespace Bench
+} // namespace Afina
+
+#endif // AFINA_BENCH_WORKLOAD_H
@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+
+#include <afina/metrics/Histogram.h>
+#include <afina/metrics/Latency.h>
+
+#include "Workload.h"
+
+using namespace Afina;
+using namespace Afina::Bench;
+
+namespace {
+
+struct Config {
+    std::string host;
+    int port;
+    std::size_t threads;
+    std::size_t connections;
+    std::size_t pipeline;
+    double duration;
+    double warmup;
+    uint64_t keys;
+    std::string distribution;
+    double zipf_theta;
+    std::string value_size;
+    double get_ratio;
+    bool prefill;
+    bool csv;
+};
+
+/**
+ * Results of a single thread, read by main thread once the thread is joined
+ */
+struct Result {
+    Result() : requests(0) {}
+
+    Metrics::Histogram latency;
+    ResponseParser::Counts counts;
+    uint64_t requests;
+};
+
+/**
+ * Connection with requests in flight, responses come in order requests were sent
+ */
+struct Connection {
+    Connection() : fd(-1), written(0), writing(false), alive(true) {}
+
+    int fd;
+
+    std::string out;
+    std::size_t written;
+    bool writing;
+
+    std::string in;
+
+    // Time every request in flight was generated at
+    std::deque<uint64_t> sent;
+
+    bool alive;
+};
+
+int Connect(const Config &config) {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *addrs = nullptr;
+    int rc = getaddrinfo(config.host.c_str(), std::to_string(config.port).c_str(), &hints, &addrs);
+    if (rc != 0) {
+        throw std::runtime_error("Failed to resolve " + config.host + ": " + gai_strerror(rc));
+    }
+
+    int fd = -1;
+    for (struct addrinfo *addr = addrs; addr != nullptr && fd == -1; addr = addr->ai_next) {
+        fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (fd == -1) {
+            continue;
+        }
+        if (connect(fd, addr->ai_addr, addr->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addrs);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to connect to " + config.host + ":" + std::to_string(config.port) + ": " +
+                                 std::strerror(errno));
+    }
+
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+void MakeNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        throw std::runtime_error(std::string("Failed to make socket non blocking: ") + std::strerror(errno));
+    }
+}
+
+void AppendGet(std::string &out, uint64_t key) {
+    char line[64];
+    int size = std::snprintf(line, sizeof(line), "get key%llu\r\n", static_cast<unsigned long long>(key));
+    out.append(line, size);
+}
+
+void AppendSet(std::string &out, uint64_t key, const std::string &values, std::size_t value_size) {
+    char line[96];
+    int size = std::snprintf(line, sizeof(line), "set key%llu 0 0 %zu\r\n", static_cast<unsigned long long>(key),
+                             value_size);
+    out.append(line, size);
+    out.append(values, 0, value_size);
+    out.append("\r\n", 2);
+}
+
+std::string MakeValues(std::size_t size) {
+    std::string values(size, 'x');
+    Random random(size);
+    for (auto &c : values) {
+        c = 'a' + random.Next() % 26;
+    }
+    return values;
+}
+
+/**
+ * Stores every key once over a blocking connection, so that gets don't miss. Sets are pipelined in batches
+ */
+void Prefill(const Config &config, const ValueSizes &sizes) {
+    const uint64_t batch = 256;
+    std::string values = MakeValues(sizes.Max());
+    Random random(0);
+
+    int fd = Connect(config);
+    std::string out, in;
+    char buffer[16384];
+    for (uint64_t first = 0; first < config.keys; first += batch) {
+        uint64_t last = std::min(config.keys, first + batch);
+        out.clear();
+        for (uint64_t key = first; key < last; key++) {
+            AppendSet(out, key, values, sizes.Next(random));
+        }
+        for (std::size_t written = 0; written < out.size();) {
+            ssize_t n = write(fd, out.data() + written, out.size() - written);
+            if (n <= 0) {
+                close(fd);
+                throw std::runtime_error(std::string("Failed to prefill: ") + std::strerror(errno));
+            }
+            written += n;
+        }
+
+        ResponseParser::Counts counts;
+        while (counts.responses < last - first) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                close(fd);
+                throw std::runtime_error("Server closed connection during prefill");
+            }
+            in.append(buffer, n);
+            in.erase(0, ResponseParser::Parse(in.data(), in.size(), counts));
+        }
+        if (counts.errors > 0) {
+            close(fd);
+            throw std::runtime_error("Server failed to store keys during prefill");
+        }
+    }
+    close(fd);
+}
+
+/**
+ * Generator thread: keeps pipeline of every connection full and records latency of responses that arrive
+ * between start and end
+ */
+void Run(const Config &config, const ValueSizes &sizes, std::vector<int> fds, std::size_t seed, uint64_t start,
+         uint64_t end, std::atomic<bool> &failed, Result &result) {
+    std::unique_ptr<KeyDistribution> keys =
+        KeyDistribution::Build(config.distribution, config.keys, config.zipf_theta, seed);
+    Random random(seed);
+    std::string values = MakeValues(sizes.Max());
+
+    int epoll = epoll_create1(0);
+    if (epoll == -1) {
+        failed = true;
+        return;
+    }
+
+    std::vector<Connection> connections(fds.size());
+    for (std::size_t i = 0; i < fds.size(); i++) {
+        connections[i].fd = fds[i];
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fds[i], &event);
+    }
+
+    auto refill = [&](Connection &conn) {
+        while (conn.sent.size() < config.pipeline) {
+            uint64_t key = keys->Next();
+            if (random.NextDouble() < config.get_ratio) {
+                AppendGet(conn.out, key);
+            } else {
+                AppendSet(conn.out, key, values, sizes.Next(random));
+            }
+            conn.sent.push_back(Metrics::Now());
+            result.requests++;
+        }
+    };
+
+    auto flush = [&](std::size_t i) {
+        Connection &conn = connections[i];
+        while (conn.written < conn.out.size()) {
+            ssize_t n = write(conn.fd, conn.out.data() + conn.written, conn.out.size() - conn.written);
+            if (n > 0) {
+                conn.written += n;
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else {
+                conn.alive = false;
+                return;
+            }
+        }
+        if (conn.written == conn.out.size()) {
+            conn.out.clear();
+            conn.written = 0;
+        }
+
+        // Wait for the socket to become writable only while something is left to write
+        bool writing = !conn.out.empty();
+        if (writing != conn.writing) {
+            struct epoll_event event;
+            event.events = EPOLLIN | (writing ? EPOLLOUT : 0);
+            event.data.u64 = i;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, conn.fd, &event);
+            conn.writing = writing;
+        }
+    };
+
+    for (std::size_t i = 0; i < connections.size(); i++) {
+        refill(connections[i]);
+        flush(i);
+    }
+
+    char buffer[65536];
+    std::vector<struct epoll_event> events(connections.size());
+    std::size_t alive = connections.size();
+    for (uint64_t now = Metrics::Now(); now < end && alive > 0; now = Metrics::Now()) {
+        int timeout = static_cast<int>(std::min<uint64_t>((end - now) / 1000000 + 1, 100));
+        int n = epoll_wait(epoll, events.data(), events.size(), timeout);
+        if (n == -1 && errno != EINTR) {
+            failed = true;
+            break;
+        }
+
+        for (int e = 0; e < n; e++) {
+            std::size_t i = events[e].data.u64;
+            Connection &conn = connections[i];
+            if (!conn.alive) {
+                continue;
+            }
+
+            if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                ssize_t got;
+                while ((got = read(conn.fd, buffer, sizeof(buffer))) > 0) {
+                    conn.in.append(buffer, got);
+                }
+                if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    conn.alive = false;
+                }
+
+                ResponseParser::Counts counts;
+                conn.in.erase(0, ResponseParser::Parse(conn.in.data(), conn.in.size(), counts));
+
+                uint64_t received = Metrics::Now();
+                for (std::size_t r = 0; r < counts.responses && !conn.sent.empty(); r++) {
+                    if (received >= start && received < end) {
+                        result.latency.Record(received - conn.sent.front());
+                    }
+                    conn.sent.pop_front();
+                }
+                if (received >= start && received < end) {
+                    result.counts.responses += counts.responses;
+                    result.counts.hits += counts.hits;
+                    result.counts.misses += counts.misses;
+                    result.counts.errors += counts.errors;
+                }
+            }
+
+            if (conn.alive) {
+                refill(conn);
+                flush(i);
+            }
+            if (!conn.alive) {
+                // Requests left in flight will never be answered
+                result.counts.errors += conn.sent.size();
+                epoll_ctl(epoll, EPOLL_CTL_DEL, conn.fd, nullptr);
+                alive--;
+            }
+        }
+    }
+
+    close(epoll);
+    for (auto &conn : connections) {
+        close(conn.fd);
+    }
+}
+
+double Micros(uint64_t nanos) { return nanos / 1000.0; }
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Config config;
+
+    cxxopts::Options options("afina-bench", "Load generator for memcached protocol servers");
+    try {
+        options.add_options()("host", "Server address", cxxopts::value<std::string>()->default_value("127.0.0.1"));
+        options.add_options()("p,port", "Server port", cxxopts::value<int>()->default_value("8080"));
+        options.add_options()("t,threads", "Generator threads, each runs its own epoll loop",
+                              cxxopts::value<std::size_t>()->default_value("1"));
+        options.add_options()("c,connections", "Connections in total, spread over threads",
+                              cxxopts::value<std::size_t>()->default_value("16"));
+        options.add_options()("pipeline", "Requests in flight on every connection",
+                              cxxopts::value<std::size_t>()->default_value("1"));
+        options.add_options()("d,duration", "Seconds to measure for", cxxopts::value<double>()->default_value("10"));
+        options.add_options()("warmup", "Seconds to run before measuring", cxxopts::value<double>()->default_value("1"));
+        options.add_options()("k,keys", "Number of distinct keys", cxxopts::value<uint64_t>()->default_value("100000"));
+        options.add_options()("distribution", "Key distribution: uniform, zipf or scan",
+                              cxxopts::value<std::string>()->default_value("uniform"));
+        options.add_options()("zipf-theta", "Skew of zipf distribution, in (0, 1)",
+                              cxxopts::value<double>()->default_value("0.99"));
+        options.add_options()("value-size", "Value size in bytes, N or MIN-MAX",
+                              cxxopts::value<std::string>()->default_value("32"));
+        options.add_options()("get-ratio", "Fraction of get requests, the rest are sets",
+                              cxxopts::value<double>()->default_value("0.9"));
+        options.add_options()("no-prefill", "Don't store every key before the run");
+        options.add_options()("csv", "Print a single line: ops/s, p50, p90, p99, p99.9, max latency in us, hits, "
+                                     "misses, errors");
+        options.add_options()("h,help", "Print usage info");
+        options.parse(argc, argv);
+
+        if (options.count("help") > 0) {
+            std::cerr << options.help() << std::endl;
+            return 0;
+        }
+
+        config.host = options["host"].as<std::string>();
+        config.port = options["port"].as<int>();
+        config.threads = options["threads"].as<std::size_t>();
+        config.connections = options["connections"].as<std::size_t>();
+        config.pipeline = options["pipeline"].as<std::size_t>();
+        config.duration = options["duration"].as<double>();
+        config.warmup = options["warmup"].as<double>();
+        config.keys = options["keys"].as<uint64_t>();
+        config.distribution = options["distribution"].as<std::string>();
+        config.zipf_theta = options["zipf-theta"].as<double>();
+        config.value_size = options["value-size"].as<std::string>();
+        config.get_ratio = options["get-ratio"].as<double>();
+        config.prefill = options.count("no-prefill") == 0;
+        config.csv = options.count("csv") > 0;
+    } catch (cxxopts::OptionException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    if (config.threads == 0 || config.connections < config.threads || config.pipeline == 0) {
+        std::cerr << "Error: need at least one thread, connection per thread and request in flight" << std::endl;
+        return 1;
+    }
+
+    // Server closing connection must not kill the generator
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Result> results(config.threads);
+    std::atomic<bool> failed(false);
+    uint64_t start, end;
+    try {
+        ValueSizes sizes(config.value_size);
+        // Fail on bad distribution parameters before anything is sent
+        KeyDistribution::Build(config.distribution, config.keys, config.zipf_theta, 0);
+
+        if (config.prefill) {
+            Prefill(config, sizes);
+        }
+
+        std::vector<std::vector<int>> fds(config.threads);
+        for (std::size_t i = 0; i < config.connections; i++) {
+            int fd = Connect(config);
+            MakeNonBlocking(fd);
+            fds[i % config.threads].push_back(fd);
+        }
+
+        start = Metrics::Now() + static_cast<uint64_t>(config.warmup * 1e9);
+        end = start + static_cast<uint64_t>(config.duration * 1e9);
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < config.threads; i++) {
+            threads.emplace_back(Run, std::cref(config), std::cref(sizes), fds[i], i + 1, start, end,
+                                 std::ref(failed), std::ref(results[i]));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    if (failed) {
+        std::cerr << "Error: generator thread failed" << std::endl;
+        return 1;
+    }
+
+    Metrics::Histogram::Snapshot latency;
+    ResponseParser::Counts counts;
+    for (auto &result : results) {
+        latency.Add(result.latency);
+        counts.responses += result.counts.responses;
+        counts.hits += result.counts.hits;
+        counts.misses += result.counts.misses;
+        counts.errors += result.counts.errors;
+    }
+
+    double seconds = (end - start) / 1e9;
+    double throughput = counts.responses / seconds;
+    if (config.csv) {
+        std::printf("%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%zu,%zu,%zu\n", throughput, Micros(latency.Percentile(0.5)),
+                    Micros(latency.Percentile(0.9)), Micros(latency.Percentile(0.99)),
+                    Micros(latency.Percentile(0.999)), Micros(latency.Max()), counts.hits, counts.misses,
+                    counts.errors);
+    } else {
+        std::printf("%zu threads, %zu connections, pipeline %zu, %s keys, %.0f%% gets\n", config.threads,
+                    config.connections, config.pipeline, config.distribution.c_str(), config.get_ratio * 100);
+        std::printf("throughput: %.0f ops/s, %zu responses in %.1f s\n", throughput, counts.responses, seconds);
+        std::printf("latency us: p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+                    Micros(latency.Percentile(0.5)), Micros(latency.Percentile(0.9)),
+                    Micros(latency.Percentile(0.99)), Micros(latency.Percentile(0.999)), Micros(latency.Max()));
+        std::printf("gets: %zu hits, %zu misses; errors: %zu\n", counts.hits, counts.misses, counts.errors);
+    }
+    return counts.errors > 0 ? 2 : 0;
+}
@@ -1,5 +1,401 @@
 #include <afina/concurrency/Executor.h>
 
 namespace Afina {
-namespace Concurrency {}
+namespace Concurrency {
+
+namespace {
+
+// Pool the current thread belongs to and its slot there, kWorkStealing mode only
+thread_local Executor *tls_executor = nullptr;
+thread_local std::size_t tls_index = 0;
+
+// How many times idle thread looks for work before going to sleep
+const int spins_before_park = 128;
+
+} // namespace
+
+/**
+ * Thread slot of kWorkStealing mode
+ */
+struct Executor::Worker {
+    Worker() : active(false), seed(0) {}
+
+    // Tasks submitted from inside of this thread, the thread takes them from the bottom, others steal from the top
+    WorkStealingQueue<Task *> queue;
+
+    // Whether slot is occupied by a thread, protected by mutex
+    bool active;
+
+    // State of xorshift generator used to select steal victims
+    uint64_t seed;
+};
+
+Executor::Executor(std::size_t low_watermark, std::size_t high_watermark, std::size_t max_queue_size,
+                   std::chrono::milliseconds idle_time, Mode mode)
+    : low_watermark(low_watermark), high_watermark(high_watermark), max_queue_size(max_queue_size),
+      idle_time(idle_time), mode(mode), tasks_head(0), tasks_size(0), state(State::kStopped), threads_cnt(0),
+      free_threads(0), free_slots(mode == Mode::kWorkStealing ? max_queue_size : 0),
+      injected(mode == Mode::kWorkStealing ? max_queue_size : 0), queued(0), submitting(0), running(0), idle(0),
+      parked(0) {
+    if (mode == Mode::kWorkStealing) {
+        workers.reset(new Worker[high_watermark]);
+        for (std::size_t i = 0; i < high_watermark; i++) {
+            workers[i].seed = i * 2654435761u + 1;
+        }
+
+        slots.reset(new Task[max_queue_size]);
+        for (std::size_t i = 0; i < max_queue_size; i++) {
+            free_slots.push(&slots[i]);
+        }
+    }
+}
+
+Executor::~Executor() { Stop(true); }
+
+void Executor::Start() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (state != State::kStopped) {
+        return;
+    }
+
+    if (mode == Mode::kWorkStealing) {
+        state = State::kRun;
+        for (size_t i = 0; i < low_watermark; i++) {
+            spawn_stealing();
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < low_watermark; i++) {
+        std::thread new_thread(&Executor::perform, this);
+        new_thread.detach();
+    }
+    threads_cnt = low_watermark;
+    free_threads = low_watermark;
+    state = State::kRun;
+}
+
+void Executor::Stop(bool await) {
+    if (mode == Mode::kWorkStealing) {
+        State expected = State::kRun;
+        if (state.compare_exchange_strong(expected, State::kStopping)) {
+            // Let Execute calls that saw kRun finish publishing their tasks, so threads don't leave them behind
+            while (submitting.load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (state == State::kStopped) {
+            return;
+        }
+
+        if (mode == Mode::kWorkStealing) {
+            if (running.load() == 0) {
+                state = State::kStopped;
+                return;
+            }
+            empty_condition.notify_all();
+        } else if (state == State::kRun) {
+            state = State::kStopping;
+            if (threads_cnt != 0) {
+                empty_condition.notify_all();
+            } else {
+                state = State::kStopped;
+                return;
+            }
+        }
+
+        if (await) {
+            while (state != State::kStopped) {
+                stop_condition.wait(lock);
+            }
+        }
+    }
+}
+
+std::size_t Executor::execute_shared(Task *batch, std::size_t count) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (state != State::kRun or tasks_size >= max_queue_size) {
+        return 0;
+    }
+
+    // Enqueue new tasks
+    std::size_t accepted = std::min(count, max_queue_size - tasks_size);
+    reserve_tasks(tasks_size + accepted);
+    for (std::size_t i = 0; i < accepted; i++) {
+        tasks[(tasks_head + tasks_size) % tasks.size()] = std::move(batch[i]);
+        tasks_size++;
+    }
+
+    // Wake up free threads and start new ones for tasks left
+    if (free_threads >= 1) {
+        if (accepted == 1) {
+            empty_condition.notify_one();
+        } else {
+            empty_condition.notify_all();
+        }
+    }
+    for (std::size_t i = free_threads; i < accepted && threads_cnt < high_watermark; i++) {
+        spawn_shared();
+    }
+    return accepted;
+}
+
+void Executor::reserve_tasks(std::size_t size) {
+    if (size <= tasks.size()) {
+        return;
+    }
+
+    // Ring grows only until queue reaches its maximum size for the first time
+    std::size_t capacity = std::max<std::size_t>(16, tasks.size() * 2);
+    capacity = std::min(max_queue_size, std::max(capacity, size));
+
+    std::vector<Task> bigger(capacity);
+    for (std::size_t i = 0; i < tasks_size; i++) {
+        bigger[i] = std::move(tasks[(tasks_head + i) % tasks.size()]);
+    }
+    tasks.swap(bigger);
+    tasks_head = 0;
+}
+
+void Executor::spawn_shared() {
+    threads_cnt++;
+    free_threads++;
+    std::thread new_thread(&Executor::perform, this);
+    new_thread.detach();
+}
+
+void Executor::perform() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (tasks_size == 0) {
+            if (state == State::kStopping) {
+                // stopping thread after while
+                break;
+            } else {
+                auto now = std::chrono::system_clock::now();
+                if (empty_condition.wait_until(lock, now + idle_time) == std::cv_status::timeout &&
+                    threads_cnt > low_watermark) {
+                    // too much free threads
+                    // stopping thread after while
+                    break;
+                } else {
+                    // timeout in low_watermark threads or thread was notified
+                    // (we'll check why it was notified at the next iteration of while
+                    continue;
+                }
+            }
+        } else {
+            // there is a task
+            Task task(std::move(tasks[tasks_head]));
+            tasks_head = (tasks_head + 1) % tasks.size();
+            tasks_size--;
+            free_threads--;
+            lock.unlock();
+            try {
+                task();
+            } catch (const std::exception &ex) {
+                std::cerr << "Error in executing function :" << ex.what() << std::endl;
+            }
+            lock.lock();
+            free_threads++;
+        }
+    }
+    // stopping thread
+    if (--threads_cnt == 0 && state == State::kStopping) {
+        state = State::kStopped;
+        stop_condition.notify_all();
+    }
+    free_threads--;
+}
+
+std::size_t Executor::execute_stealing(Task *batch, std::size_t count) {
+    // See Stop: once it observed no submitters, every accepted task is visible through queued counter
+    submitting.fetch_add(1);
+    if (state.load() != State::kRun) {
+        submitting.fetch_sub(1);
+        return 0;
+    }
+
+    // Reserve space for the whole batch at once
+    std::size_t accepted;
+    std::size_t was_queued = queued.load();
+    do {
+        if (was_queued >= max_queue_size) {
+            submitting.fetch_sub(1);
+            return 0;
+        }
+        accepted = std::min(count, max_queue_size - was_queued);
+    } while (!queued.compare_exchange_weak(was_queued, was_queued + accepted));
+
+    for (std::size_t i = 0; i < accepted; i++) {
+        // There is a free slot for sure since space is reserved, but it might be on the way back yet
+        Task *task;
+        while (!free_slots.pop(task)) {
+            std::this_thread::yield();
+        }
+        *task = std::move(batch[i]);
+
+        if (tls_executor == this) {
+            // Task spawned by another task stays on this thread unless somebody steals it
+            workers[tls_index].queue.push(task);
+        } else {
+            // There are at most max_queue_size tasks in all queues, still push could fail for a moment if
+            // the cell is being released by a consumer that took its element already
+            while (!injected.push(task)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    submitting.fetch_sub(1);
+
+    // Every call wakes up or starts at most one thread, there is no point in doing more calls than threads
+    for (std::size_t i = 0; i < accepted && i < high_watermark; i++) {
+        wake_or_spawn();
+    }
+    return accepted;
+}
+
+void Executor::wake_or_spawn() {
+    // Somebody is looking for work already, it is enough to make sure it isn't sleeping
+    if (idle.load() > 0) {
+        if (parked.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            empty_condition.notify_one();
+        }
+        return;
+    }
+
+    // All threads are busy
+    if (running.load() < high_watermark) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running.load() < high_watermark && idle.load() == 0 && state.load() == State::kRun) {
+            spawn_stealing();
+        }
+    }
+}
+
+void Executor::spawn_stealing() {
+    for (std::size_t i = 0; i < high_watermark; i++) {
+        if (!workers[i].active) {
+            workers[i].active = true;
+            running.fetch_add(1);
+
+            // New thread is idle until it takes first task
+            idle.fetch_add(1);
+            std::thread new_thread(&Executor::perform_stealing, this, i);
+            new_thread.detach();
+            return;
+        }
+    }
+}
+
+Executor::Task *Executor::find_task(std::size_t index) {
+    Task *task = nullptr;
+    Worker &self = workers[index];
+    if (self.queue.pop(task) || injected.pop(task)) {
+        return task;
+    }
+
+    // Steal from others starting at random victim
+    self.seed ^= self.seed << 13;
+    self.seed ^= self.seed >> 7;
+    self.seed ^= self.seed << 17;
+    std::size_t start = self.seed % high_watermark;
+    for (std::size_t i = 0; i < high_watermark; i++) {
+        std::size_t victim = (start + i) % high_watermark;
+        if (victim == index) {
+            continue;
+        }
+        while (!workers[victim].queue.empty()) {
+            if (workers[victim].queue.steal(task)) {
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void Executor::perform_stealing(std::size_t index) {
+    tls_executor = this;
+    tls_index = index;
+
+    // Thread is counted in idle from the very start, see spawn_stealing
+    bool is_idle = true;
+    int spins = 0;
+    while (true) {
+        Task *slot = find_task(index);
+        if (slot != nullptr) {
+            if (is_idle) {
+                idle.fetch_sub(1);
+                is_idle = false;
+            }
+
+            // Release slot before running task, so that slots in use never outnumber queued tasks
+            Task task(std::move(*slot));
+            while (!free_slots.push(slot)) {
+                std::this_thread::yield();
+            }
+            queued.fetch_sub(1);
+            spins = 0;
+
+            try {
+                task();
+            } catch (const std::exception &ex) {
+                std::cerr << "Error in executing function :" << ex.what() << std::endl;
+            }
+            continue;
+        }
+
+        if (!is_idle) {
+            idle.fetch_add(1);
+            is_idle = true;
+        }
+
+        if (state.load() != State::kRun && submitting.load() == 0 && queued.load() == 0) {
+            break;
+        }
+
+        if (spins++ < spins_before_park) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        parked.fetch_add(1);
+        bool timeout = false;
+        if (queued.load() == 0 && state.load() == State::kRun) {
+            timeout = empty_condition.wait_for(lock, idle_time) == std::cv_status::timeout;
+        }
+        parked.fetch_sub(1);
+        spins = 0;
+
+        if (timeout && running.load() > low_watermark) {
+            // Too many free threads. Leave idle set first and only then check for work: submitter does it
+            // in the opposite order, so either it sees this thread is gone or the thread sees its task
+            idle.fetch_sub(1);
+            is_idle = false;
+            if (queued.load() == 0) {
+                break;
+            }
+        }
+    }
+
+    // stopping thread
+    std::lock_guard<std::mutex> lock(mutex);
+    if (is_idle) {
+        idle.fetch_sub(1);
+    }
+    workers[index].active = false;
+    tls_executor = nullptr;
+    if (running.fetch_sub(1) == 1 && state.load() == State::kStopping) {
+        state = State::kStopped;
+        stop_condition.notify_all();
+    }
+}
+
+} // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,91 @@
+#include "Context.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__x86_64__)
+
+// System V AMD64 ABI: rbx, rbp, r12-r15, MXCSR control bits and x87 control word are callee-saved, everything
+// else is already spilled by the caller. Frame pushed by the switch (from higher to lower addresses):
+//   [return address] [rbp] [rbx] [r12] [r13] [r14] [r15] [mxcsr, x87 cw]
+asm(R"(
+    .text
+    .globl afina_coroutine_switch
+    .type afina_coroutine_switch, @function
+afina_coroutine_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    xorl %eax, %eax
+    ret
+    .size afina_coroutine_switch, .-afina_coroutine_switch
+
+    .globl afina_coroutine_trampoline
+    .type afina_coroutine_trampoline, @function
+afina_coroutine_trampoline:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size afina_coroutine_trampoline, .-afina_coroutine_trampoline
+)");
+
+extern "C" void afina_coroutine_trampoline();
+
+namespace Afina {
+namespace Coroutine {
+
+void *PrepareStack(char *stack_top, void (*entry)(void *), void *arg) {
+    // Stack must be 16 bytes aligned right after ret jumps into trampoline, so that call inside of it
+    // leaves callee with the canonical rsp % 16 == 8
+    auto top = reinterpret_cast<uintptr_t>(stack_top) & ~uintptr_t(15);
+    auto *frame = reinterpret_cast<uint64_t *>(top);
+
+    *--frame = reinterpret_cast<uint64_t>(&afina_coroutine_trampoline); // return address
+    *--frame = 0;                                                      // rbp
+    *--frame = 0;                                                      // rbx
+    *--frame = reinterpret_cast<uint64_t>(arg);                        // r12
+    *--frame = reinterpret_cast<uint64_t>(entry);                      // r13
+    *--frame = 0;                                                      // r14
+    *--frame = 0;                                                      // r15
+
+    // Default MXCSR (all exceptions masked, round to nearest) and x87 control word
+    *--frame = (uint64_t(0x037F) << 32) | uint64_t(0x1F80);
+    return frame;
+}
+
+} // namespace Coroutine
+} // namespace Afina
+
+#else
+
+namespace Afina {
+namespace Coroutine {
+
+// Exception must not cross C linkage, caller reports the failure
+extern "C" int afina_coroutine_switch(void **, void *) { return -1; }
+
+void *PrepareStack(char *, void (*)(void *), void *) {
+    throw std::runtime_error("Dedicated coroutine stacks are not supported on this platform");
+}
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef AFINA_COROUTINE_CONTEXT_H
+#define AFINA_COROUTINE_CONTEXT_H
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * Saves callee-saved registers of the running code on its own stack, writes resulting stack pointer
+ * into *from_sp and resumes execution that was suspended with stack pointer to_sp.
+ *
+ * Function returns 0 once someone switches back to the saved stack pointer, or -1 right away if platform
+ * has no support for dedicated stacks
+ */
+extern "C" int afina_coroutine_switch(void **from_sp, void *to_sp);
+
+/**
+ * Prepares fresh stack ending at stack_top so that first afina_coroutine_switch to the returned stack
+ * pointer calls entry(arg). Function entry must never return
+ */
+void *PrepareStack(char *stack_top, void (*entry)(void *), void *arg);
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_CONTEXT_H
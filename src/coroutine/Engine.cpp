@@ -3,36 +3,48 @@
 #include <cassert>
 #include <csetjmp>
 #include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "Context.h"
 
 namespace Afina {
 namespace Coroutine {
 
+namespace {
+
+// Upper bound of contexts kept for reuse
+const std::size_t max_free_contexts = 1024;
+
+// Distance from the stack area being restored that Restore frame must keep
+const std::ptrdiff_t restore_frame_margin = 256;
+
+} // namespace
+
 Engine::~Engine() {
-    for (auto coro = alive; coro != nullptr;) {
-        auto tmp = coro;
-        coro = coro->next;
-        delete [] std::get<0> (tmp->Stack);
-        delete tmp;
+    if (_mode == StackMode::kDedicated) {
+        _unwind_all();
     }
 
-    for (auto coro = blocked; coro != nullptr;) {
-        auto tmp = coro;
-        coro = coro->next;
-        delete [] std::get<0> (tmp->Stack);
-        delete tmp;
+    for (auto list : {alive, blocked, _free_contexts}) {
+        for (auto coro = list; coro != nullptr;) {
+            auto tmp = coro;
+            coro = coro->next;
+            _destroy_context(tmp);
+        }
+    }
+
+    if (idle_ctx != nullptr) {
+        _destroy_context(idle_ctx);
     }
 }
 
 void Engine::Store(context &ctx) {
     char storeBeginAddress;
     assert(ctx.Hight != nullptr && ctx.Low != nullptr);
-    // this condition used for different architectures,
-    // where stack low addresses can be greater than high addresses
-    if (&storeBeginAddress > ctx.Low) {
-        ctx.Hight = &storeBeginAddress;
-    } else {
-        ctx.Low = &storeBeginAddress;
-    }
+    // Stack grows down, so coroutine bottom (Hight) stays where it was on creation and only the top follows
+    // current depth. Note that routine could be suspended at a shallower depth than the previous time
+    ctx.Low = &storeBeginAddress;
     auto stackSize = ctx.Hight - ctx.Low;
     // we should allocate memory for new stack copy if it was't allocated yet
     // or current stack size isn't big enough or current stack size is too big
@@ -46,8 +58,10 @@ void Engine::Store(context &ctx) {
 
 void Engine::Restore(context &ctx) {
     char restoreBeginAddress;
-    // used for saving stack of restored coroutine
-    while (&restoreBeginAddress <= ctx.Hight && &restoreBeginAddress >= ctx.Low) {
+    // used for saving stack of restored coroutine. Checking the local variable alone isn't enough: the rest
+    // of the frame, such as spilled arguments, lies around it and must not be overwritten by memcpy either
+    while (&restoreBeginAddress <= ctx.Hight + restore_frame_margin &&
+           &restoreBeginAddress >= ctx.Low - restore_frame_margin) {
         Restore(ctx);
     }
     // now we can restore coroutine's stack without changing our stack
@@ -59,6 +73,21 @@ void Engine::Restore(context &ctx) {
 
 void Engine::Enter(Engine::context *ctx) {
     assert(cur_routine != nullptr);
+    if (_mode == StackMode::kDedicated) {
+        // Nothing to copy: just save registers of the current routine on its own stack and jump to another one.
+        // Returns once somebody switches back to us
+        context *from = cur_routine;
+        cur_routine = ctx;
+        if (afina_coroutine_switch(&from->SP, ctx->SP) != 0) {
+            cur_routine = from;
+            throw std::runtime_error("Dedicated coroutine stacks are not supported on this platform");
+        }
+        if (_unwinding && cur_routine != idle_ctx) {
+            throw forced_unwind();
+        }
+        return;
+    }
+
     if (cur_routine != idle_ctx) {
         if (setjmp(cur_routine->Environment) > 0) {
             return;
@@ -70,22 +99,21 @@ void Engine::Enter(Engine::context *ctx) {
 
 void Engine::yield() {
     // we have no alive coroutines or we have only one alive coroutine, that is current
-    if (!alive || (cur_routine == alive && !alive->next)) return;
-    // choose the next coroutine
-    context *nextCoro;
-    if (cur_routine == alive) {
-        nextCoro = alive->next;
-    } else {
-        nextCoro = alive;
+    if (!alive || cur_routine == nullptr || (cur_routine == alive && !alive->next)) return;
+    // current coroutine goes to the end of the queue, so everyone gets control in turn
+    if (cur_routine != idle_ctx && !cur_routine->isBlocked) {
+        _dequeue(cur_routine);
+        _enqueue(cur_routine);
     }
     // run the next alive coroutine
-    Enter(nextCoro);
+    Enter(alive);
 }
 
 void Engine::sched(void *coro) {
     auto nextCoro = static_cast<context *>(coro);
     if (nextCoro == nullptr) {
         yield();
+        return;
     }
     // we will do nothing if the next coroutine is blocked
     if (nextCoro == cur_routine || nextCoro->isBlocked) {
@@ -109,15 +137,7 @@ void Engine::block(void *coro) {
     }
     blockedCoro->isBlocked = true;
     // delete coroutine from the list of alive coroutines
-    if (alive == blockedCoro) {
-        alive = alive->next;
-    }
-    if (blockedCoro->prev) {
-        blockedCoro->prev->next = blockedCoro->next;
-    }
-    if (blockedCoro->next) {
-        blockedCoro->next->prev = blockedCoro->prev;
-    }
+    _dequeue(blockedCoro);
     // add coroutine to the list of blocked coroutines
     blockedCoro->prev = nullptr;
     blockedCoro->next = blocked;
@@ -137,6 +157,7 @@ void Engine::unblock(void *coro) {
         return;
     }
     unblockedCoro->isBlocked = false;
+    _cancel_timer(unblockedCoro);
     // delete coroutine from the list of blocked coroutines
     if (blocked == unblockedCoro) {
         blocked = blocked->next;
@@ -147,13 +168,242 @@ void Engine::unblock(void *coro) {
     if (unblockedCoro->next) {
         unblockedCoro->next->prev = unblockedCoro->prev;
     }
-    // add coroutine to the list of alive coroutines
-    unblockedCoro->prev = nullptr;
-    unblockedCoro->next = alive;
-    alive = unblockedCoro;
-    if (alive->next) {
-        alive->next->prev = unblockedCoro;
+    // add coroutine to the head of alive queue: it has been waiting already, so it runs next
+    _enqueue_front(unblockedCoro);
+}
+
+void Engine::_enqueue_front(context *ctx) {
+    ctx->prev = nullptr;
+    ctx->next = alive;
+    if (alive != nullptr) {
+        alive->prev = ctx;
+    } else {
+        alive_tail = ctx;
+    }
+    alive = ctx;
+}
+
+void Engine::_enqueue(context *ctx) {
+    ctx->next = nullptr;
+    ctx->prev = alive_tail;
+    if (alive_tail != nullptr) {
+        alive_tail->next = ctx;
+    } else {
+        alive = ctx;
+    }
+    alive_tail = ctx;
+}
+
+void Engine::_dequeue(context *ctx) {
+    if (ctx->prev != nullptr) {
+        ctx->prev->next = ctx->next;
+    } else if (alive == ctx) {
+        alive = ctx->next;
+    }
+
+    if (ctx->next != nullptr) {
+        ctx->next->prev = ctx->prev;
+    } else if (alive_tail == ctx) {
+        alive_tail = ctx->prev;
+    }
+    ctx->prev = ctx->next = nullptr;
+}
+
+Engine::context *Engine::_new_context() {
+    if (_free_contexts == nullptr) {
+        return new context();
+    }
+
+    context *result = _free_contexts;
+    _free_contexts = result->next;
+    _free_count--;
+    result->next = nullptr;
+    return result;
+}
+
+void Engine::_release_context(context *ctx) {
+    if (_free_count >= max_free_contexts) {
+        _destroy_context(ctx);
+        return;
+    }
+
+    // Reset everything but buffers that are the reason to keep context around
+    ctx->Low = ctx->Hight = nullptr;
+    ctx->isBlocked = false;
+    ctx->SP = nullptr;
+    ctx->Body = nullptr;
+    ctx->BodyArg = nullptr;
+    ctx->HasTimer = false;
+    ctx->TimedOut = false;
+    ctx->prev = nullptr;
+    ctx->next = _free_contexts;
+    _free_contexts = ctx;
+    _free_count++;
+}
+
+void Engine::_destroy_context(context *ctx) {
+    delete[] std::get<0>(ctx->Stack);
+    _stacks.Release(ctx->OwnStack);
+    delete ctx;
+}
+
+void Engine::sleep(uint32_t ms) { block_for(ms); }
+
+bool Engine::block_for(uint32_t ms) {
+    context *ctx = cur_routine;
+    assert(ctx != nullptr && ctx != idle_ctx);
+
+    ctx->TimedOut = false;
+    ctx->Timer = _timers.emplace(std::chrono::steady_clock::now() + std::chrono::milliseconds(ms), ctx);
+    ctx->HasTimer = true;
+    block(ctx);
+
+    // Here we are once timer fired or somebody unblocked us
+    return !ctx->TimedOut;
+}
+
+int Engine::next_timeout() const {
+    if (_timers.empty()) {
+        return -1;
+    }
+
+    auto left = _timers.begin()->first - std::chrono::steady_clock::now();
+    if (left <= std::chrono::steady_clock::duration::zero()) {
+        return 0;
+    }
+
+    // Round up, otherwise epoll_wait would return a bit before timer expiration
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(left + std::chrono::milliseconds(1) -
+                                                                    std::chrono::nanoseconds(1));
+    return static_cast<int>(ms.count());
+}
+
+void Engine::_cancel_timer(context *ctx) {
+    if (ctx->HasTimer) {
+        _timers.erase(ctx->Timer);
+        ctx->HasTimer = false;
+    }
+}
+
+void Engine::_fire_timers() {
+    auto now = std::chrono::steady_clock::now();
+    while (!_timers.empty() && _timers.begin()->first <= now) {
+        context *ctx = _timers.begin()->second;
+        _cancel_timer(ctx);
+        ctx->TimedOut = true;
+        unblock(ctx);
+    }
+}
+
+bool Engine::_wait_alive() {
+    while (true) {
+        _fire_timers();
+        if (alive != nullptr) {
+            return true;
+        }
+
+        _unblocker();
+        if (alive != nullptr) {
+            return true;
+        }
+
+        // Nobody could be woken up anymore
+        if (_timers.empty()) {
+            return false;
+        }
+
+        // Unblocker had nothing to do, so just wait for the nearest timer
+        std::this_thread::sleep_until(_timers.begin()->first);
+    }
+}
+
+char *Engine::_acquire_stack(context *ctx) {
+    // Pooled contexts keep stack of the previous coroutine
+    if (ctx->OwnStack.Low == nullptr) {
+        ctx->OwnStack = _stacks.Acquire();
     }
+    return ctx->OwnStack.Hight;
+}
+
+void Engine::_launch(context *ctx, char *stack_top) {
+    ctx->SP = PrepareStack(stack_top, &Engine::_trampoline, this);
+
+    // Add routine to the tail of alive queue
+    _enqueue(ctx);
+}
+
+void Engine::_trampoline(void *engine) {
+    auto *self = static_cast<Engine *>(engine);
+    context *ctx = self->cur_routine;
+    try {
+        ctx->Body(ctx->BodyArg, !self->_unwinding);
+    } catch (const forced_unwind &) {
+        // Stack is unwound, body is destroyed along with it
+    }
+    self->_finish(ctx);
+}
+
+void Engine::_finish(context *ctx) {
+    _dequeue(ctx);
+
+    // We are still running on the coroutine stack, so it could be released only once idle loop gets control
+    _zombie = ctx;
+    Enter(idle_ctx);
+    assert(false && "finished coroutine got control back");
+}
+
+void Engine::_reap() {
+    if (_zombie != nullptr) {
+        _release_context(_zombie);
+        _zombie = nullptr;
+    }
+}
+
+void Engine::_unwind_all() {
+    if (alive == nullptr && blocked == nullptr) {
+        return;
+    }
+    if (idle_ctx == nullptr) {
+        idle_ctx = new context();
+    }
+
+    // Each coroutine throws out of the point it is suspended at, or destroys its body if it has never run,
+    // and finishes as usual, so that control gets back here
+    _unwinding = true;
+    cur_routine = idle_ctx;
+    while (alive != nullptr || blocked != nullptr) {
+        if (alive == nullptr) {
+            unblock(blocked);
+        }
+        Enter(alive);
+        _reap();
+    }
+    cur_routine = nullptr;
+    _unwinding = false;
+}
+
+void Engine::_idle_loop(void *main) {
+    // Idle context is the caller thread itself, its stack pointer gets saved on the first switch away
+    if (idle_ctx == nullptr) {
+        idle_ctx = new context();
+    }
+    cur_routine = idle_ctx;
+    if (main != nullptr) {
+        Enter(static_cast<context *>(main));
+    }
+
+    // Control gets back here each time some coroutine finishes or blocks itself
+    while (true) {
+        _reap();
+        if (!_wait_alive()) {
+            break;
+        }
+        yield();
+    }
+
+    // Shutdown runtime
+    cur_routine = nullptr;
+    this->StackBottom = nullptr;
 }
 
 } // namespace Coroutine
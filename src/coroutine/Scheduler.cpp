@@ -0,0 +1,360 @@
+#include <afina/coroutine/Scheduler.h>
+
+#include <cassert>
+#include <stdexcept>
+
+#include <afina/concurrency/WorkStealingQueue.h>
+#include <afina/coroutine/StackPool.h>
+
+#include "Context.h"
+
+namespace Afina {
+namespace Coroutine {
+
+namespace {
+
+// Worker the current thread belongs to. Coroutines migrate between threads, so the variable must never be
+// cached across a switch: always read it through the non-inlined accessor below
+thread_local void *tls_worker = nullptr;
+
+__attribute__((noinline)) void *current_worker() { return tls_worker; }
+
+// How many times idle worker looks for work before going to sleep
+const int spins_before_park = 64;
+
+} // namespace
+
+/**
+ * Single coroutine instance
+ */
+struct Scheduler::task {
+    // Bits of state word
+    enum : int {
+        // Sits in some run queue
+        kRunnable = 0,
+
+        // Executed by some worker right now
+        kRunning = 1,
+
+        // Suspended until unblock
+        kBlocked = 2,
+
+        // Unblock was called while coroutine wasn't blocked, next block returns immediately
+        kNotified = 4
+    };
+
+    // Why coroutine gave control back to the worker
+    enum class Action { kYield, kBlock, kFinish };
+
+    std::function<void()> body;
+
+    // Own stack, acquired from the worker pool on first run
+    StackPool::Stack stack;
+    void *sp = nullptr;
+
+    std::atomic<int> state{kRunnable};
+    Action action = Action::kYield;
+};
+
+/**
+ * Thread running coroutines
+ */
+struct Scheduler::Worker {
+    Worker(Scheduler *owner, std::size_t idx, std::size_t stack_size)
+        : scheduler(owner), index(idx), stacks(stack_size), current(nullptr), sp(nullptr), seed(idx * 2654435761u + 1) {}
+
+    Scheduler *scheduler;
+    std::size_t index;
+
+    // Ready coroutines, pushed by this worker only, taken by anyone
+    Concurrency::WorkStealingQueue<task *> queue;
+
+    // Stacks for coroutines started on this worker
+    StackPool stacks;
+
+    // Coroutine running at the moment
+    task *current;
+
+    // Saved worker stack pointer while some coroutine is running
+    void *sp;
+
+    // State of xorshift generator used to select steal victims
+    uint64_t seed;
+
+    std::thread thread;
+};
+
+// See Scheduler.h
+Scheduler::Scheduler(std::size_t workers, std::size_t stack_size)
+    : _workers_count(workers != 0 ? workers : std::max(1u, std::thread::hardware_concurrency())),
+      _stack_size(stack_size), _live(0), _injected_size(0), _parked(0) {}
+
+// See Scheduler.h
+Scheduler::~Scheduler() {
+    // Coroutines that were created but never started
+    for (auto t : _injected) {
+        delete t;
+    }
+}
+
+// See Scheduler.h
+void *Scheduler::_spawn(std::function<void()> body) {
+    auto *t = new task();
+    t->body = std::move(body);
+    _live.fetch_add(1);
+    return t;
+}
+
+// See Scheduler.h
+void Scheduler::_start(void *main) {
+    _workers.reserve(_workers_count);
+    for (std::size_t i = 0; i < _workers_count; i++) {
+        _workers.emplace_back(new Worker(this, i, _stack_size));
+    }
+
+    _schedule(main);
+    for (auto &w : _workers) {
+        w->thread = std::thread(&Scheduler::_worker_loop, this, w.get());
+    }
+    for (auto &w : _workers) {
+        w->thread.join();
+    }
+    _workers.clear();
+}
+
+// See Scheduler.h
+void Scheduler::_schedule(void *coro) {
+    auto *t = static_cast<task *>(coro);
+    auto *w = static_cast<Worker *>(current_worker());
+    if (w != nullptr && w->scheduler == this) {
+        w->queue.push(t);
+    } else {
+        std::lock_guard<std::mutex> lock(_inject_mutex);
+        _injected.push_back(t);
+        _injected_size.fetch_add(1);
+    }
+    _notify_one();
+}
+
+// See Scheduler.h
+void Scheduler::_notify_one() {
+    // Pairs with the increment of _parked in _worker_loop: either we see parked worker here or it
+    // sees our task before falling asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_parked.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(_park_mutex);
+        _park_condition.notify_one();
+    }
+}
+
+// See Scheduler.h
+bool Scheduler::_has_work() const {
+    if (_injected_size.load() > 0) {
+        return true;
+    }
+    for (auto &w : _workers) {
+        if (!w->queue.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// See Scheduler.h
+Scheduler::task *Scheduler::_find_task(Worker *worker) {
+    task *result = nullptr;
+
+    // Own queue first, taken from the top so that coroutines are served in FIFO order. Steal could fail
+    // because of a race with thieves, so retry while there is something
+    while (!worker->queue.empty()) {
+        if (worker->queue.steal(result)) {
+            return result;
+        }
+    }
+
+    // Coroutines woken up by foreign threads
+    if (_injected_size.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(_inject_mutex);
+        if (!_injected.empty()) {
+            result = _injected.front();
+            _injected.pop_front();
+            _injected_size.fetch_sub(1);
+            return result;
+        }
+    }
+
+    // Steal from others starting at random victim
+    worker->seed ^= worker->seed << 13;
+    worker->seed ^= worker->seed >> 7;
+    worker->seed ^= worker->seed << 17;
+    std::size_t n = _workers.size();
+    std::size_t start = worker->seed % n;
+    for (std::size_t i = 0; i < n; i++) {
+        Worker *victim = _workers[(start + i) % n].get();
+        if (victim == worker) {
+            continue;
+        }
+        while (!victim->queue.empty()) {
+            if (victim->queue.steal(result)) {
+                return result;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// See Scheduler.h
+void Scheduler::_worker_loop(Worker *worker) {
+    tls_worker = worker;
+
+    int spins = 0;
+    while (true) {
+        task *t = _find_task(worker);
+        if (t != nullptr) {
+            spins = 0;
+            _run_task(worker, t);
+            continue;
+        }
+
+        if (_live.load() == 0) {
+            break;
+        }
+
+        if (spins++ < spins_before_park) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Fence pairs with the one in _notify_one: queues are read with relaxed loads, so without it the
+        // check below could miss a push whose author hasn't seen us in _parked yet. Last finished coroutine
+        // notifies under the mutex, so checking _live here is enough to not sleep through shutdown
+        std::unique_lock<std::mutex> lock(_park_mutex);
+        _parked.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_has_work() && _live.load() != 0) {
+            _park_condition.wait(lock);
+        }
+        _parked.fetch_sub(1);
+        spins = 0;
+    }
+
+    tls_worker = nullptr;
+}
+
+// See Scheduler.h
+void Scheduler::_run_task(Worker *worker, task *t) {
+    if (t->sp == nullptr) {
+        t->stack = worker->stacks.Acquire();
+        t->sp = PrepareStack(t->stack.Hight, &Scheduler::_trampoline, t);
+    }
+
+    // Keep pending wakeup, if any, so that next block() returns immediately
+    int state = t->state.load();
+    while (!t->state.compare_exchange_weak(state, task::kRunning | (state & task::kNotified))) {
+    }
+
+    worker->current = t;
+    if (afina_coroutine_switch(&worker->sp, t->sp) != 0) {
+        worker->current = nullptr;
+        throw std::runtime_error("Dedicated coroutine stacks are not supported on this platform");
+    }
+    worker->current = nullptr;
+
+    switch (t->action) {
+    case task::Action::kYield: {
+        state = t->state.load();
+        while (!t->state.compare_exchange_weak(state, task::kRunnable | (state & task::kNotified))) {
+        }
+        worker->queue.push(t);
+        _notify_one();
+        break;
+    }
+
+    case task::Action::kBlock: {
+        // Once coroutine is published as blocked it could be woken up, executed and even destroyed by
+        // other threads, so don't touch it after successful exchange
+        int expected = task::kRunning;
+        if (!t->state.compare_exchange_strong(expected, task::kBlocked)) {
+            // unblock came while coroutine was on the way out
+            t->state.store(task::kRunnable);
+            worker->queue.push(t);
+        }
+        break;
+    }
+
+    case task::Action::kFinish: {
+        worker->stacks.Release(t->stack);
+        delete t;
+        if (_live.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(_park_mutex);
+            _park_condition.notify_all();
+        }
+        break;
+    }
+    }
+}
+
+// See Scheduler.h
+void Scheduler::_trampoline(void *arg) {
+    auto *t = static_cast<task *>(arg);
+    t->body();
+    t->body = nullptr;
+
+    // Coroutine might have migrated, so worker must be read right here
+    t->action = task::Action::kFinish;
+    auto *w = static_cast<Worker *>(current_worker());
+    afina_coroutine_switch(&t->sp, w->sp);
+    assert(false && "finished coroutine got control back");
+}
+
+// See Scheduler.h
+void Scheduler::yield() {
+    auto *w = static_cast<Worker *>(current_worker());
+    assert(w != nullptr && w->current != nullptr);
+    task *t = w->current;
+    t->action = task::Action::kYield;
+    afina_coroutine_switch(&t->sp, w->sp);
+}
+
+// See Scheduler.h
+void Scheduler::block() {
+    auto *w = static_cast<Worker *>(current_worker());
+    assert(w != nullptr && w->current != nullptr);
+    task *t = w->current;
+
+    // Wakeup arrived already, consume it
+    if (t->state.load() & task::kNotified) {
+        t->state.fetch_and(~task::kNotified);
+        return;
+    }
+
+    t->action = task::Action::kBlock;
+    afina_coroutine_switch(&t->sp, w->sp);
+}
+
+// See Scheduler.h
+void Scheduler::unblock(void *coro) {
+    auto *t = static_cast<task *>(coro);
+    int state = t->state.load();
+    while (true) {
+        if (state == task::kBlocked) {
+            if (t->state.compare_exchange_weak(state, task::kRunnable)) {
+                _schedule(t);
+                return;
+            }
+        } else if (state & task::kNotified) {
+            return;
+        } else if (t->state.compare_exchange_weak(state, state | task::kNotified)) {
+            return;
+        }
+    }
+}
+
+// See Scheduler.h
+void *Scheduler::current() {
+    auto *w = static_cast<Worker *>(current_worker());
+    return w != nullptr ? w->current : nullptr;
+}
+
+} // namespace Coroutine
+} // namespace Afina
@@ -0,0 +1,70 @@
+#include <afina/coroutine/StackPool.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Coroutine {
+
+// See StackPool.h
+StackPool::StackPool(std::size_t stack_size, std::size_t max_cached) : _max_cached(max_cached) {
+    _page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    _stack_size = (stack_size + _page_size - 1) / _page_size * _page_size;
+    _free.reserve(max_cached);
+}
+
+// See StackPool.h
+StackPool::~StackPool() {
+    for (auto &stack : _free) {
+        Unmap(stack);
+    }
+}
+
+// See StackPool.h
+StackPool::Stack StackPool::Acquire() {
+    if (!_free.empty()) {
+        Stack result = _free.back();
+        _free.pop_back();
+        return result;
+    }
+
+    std::size_t total = _stack_size + _page_size;
+    void *mem = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mem == MAP_FAILED) {
+        throw std::runtime_error("Failed to map coroutine stack: " + std::string(strerror(errno)));
+    }
+
+    // Lowest page is a guard, stack grows down towards it
+    if (mprotect(mem, _page_size, PROT_NONE) != 0) {
+        munmap(mem, total);
+        throw std::runtime_error("Failed to protect coroutine stack guard page: " + std::string(strerror(errno)));
+    }
+
+    Stack result;
+    result.Low = static_cast<char *>(mem) + _page_size;
+    result.Hight = result.Low + _stack_size;
+    return result;
+}
+
+// See StackPool.h
+void StackPool::Release(Stack stack) {
+    if (stack.Low == nullptr) {
+        return;
+    }
+
+    if (_free.size() < _max_cached) {
+        _free.push_back(stack);
+    } else {
+        Unmap(stack);
+    }
+}
+
+void StackPool::Unmap(Stack stack) { munmap(stack.Low - _page_size, _stack_size + _page_size); }
+
+} // namespace Coroutine
+} // namespace Afina
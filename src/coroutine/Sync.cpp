@@ -0,0 +1,73 @@
+#include <afina/coroutine/Sync.h>
+
+namespace Afina {
+namespace Coroutine {
+
+// See Sync.h
+void CondVar::wait() { _wait(0, false); }
+
+// See Sync.h
+bool CondVar::wait_for(uint32_t ms) { return _wait(ms, true); }
+
+// See Sync.h
+void CondVar::notify_one() {
+    if (_waiters.empty()) {
+        return;
+    }
+
+    auto it = _waiters.begin();
+    it->notified = true;
+    _notified.splice(_notified.end(), _waiters, it);
+    _engine.unblock(it->coro);
+}
+
+// See Sync.h
+void CondVar::notify_all() {
+    while (!_waiters.empty()) {
+        notify_one();
+    }
+}
+
+bool CondVar::_wait(uint32_t ms, bool timed) {
+    auto it = _waiters.insert(_waiters.end(), Waiter{_engine.get_cur_routine(), false});
+    bool in_time = true;
+    if (timed) {
+        in_time = _engine.block_for(ms);
+    } else {
+        _engine.block();
+    }
+
+    // Whatever woke us up, the node must go away
+    if (it->notified) {
+        _notified.erase(it);
+        return true;
+    }
+    _waiters.erase(it);
+    return in_time;
+}
+
+// See Sync.h
+void Mutex::lock() {
+    while (_locked) {
+        _released.wait();
+    }
+    _locked = true;
+}
+
+// See Sync.h
+bool Mutex::try_lock() {
+    if (_locked) {
+        return false;
+    }
+    _locked = true;
+    return true;
+}
+
+// See Sync.h
+void Mutex::unlock() {
+    _locked = false;
+    _released.notify_one();
+}
+
+} // namespace Coroutine
+} // namespace Afina
@@ -1,5 +1,6 @@
 #include <afina/Storage.h>
 #include <afina/execute/Add.h>
+#include <afina/metrics/Metrics.h>
 
 #include <iostream>
 
@@ -9,6 +10,7 @@ namespace Execute {
 // memcached protocol:  "add" means "store this data, but only if the server *doesn't* already
 // hold data for this key".
 void Add::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Metrics::Add(Metrics::Id::kCmdSet);
     std::cout << "Add(" << _key << ")" << args << std::endl;
     out = storage.PutIfAbsent(_key, args) ? "STORED" : "NOT_STORED";
 }
@@ -1,5 +1,6 @@
 #include <afina/Storage.h>
 #include <afina/execute/Append.h>
+#include <afina/metrics/Metrics.h>
 
 #include <iostream>
 
@@ -8,6 +9,7 @@ namespace Execute {
 
 // memcached protocol: "append" means "add this data to an existing key after existing data".
 void Append::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Metrics::Add(Metrics::Id::kCmdSet);
     std::cout << "Append(" << _key << ")" << args << std::endl;
     std::string value;
     if (!storage.Get(_key, value)) {
@@ -1,5 +1,6 @@
 #include <afina/Storage.h>
 #include <afina/execute/Get.h>
+#include <afina/metrics/Metrics.h>
 
 #include <iostream>
 #include <iterator>
@@ -29,9 +30,13 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     std::stringstream outStream;
 
     std::string value;
+    Metrics::Add(Metrics::Id::kCmdGet, _keys.size());
     for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+        if (!storage.Get(key, value)) {
+            Metrics::Add(Metrics::Id::kGetMisses);
             continue;
+        }
+        Metrics::Add(Metrics::Id::kGetHits);
         if (value[value.size() - 1] == '\n') {
             value.erase(value.end() - 2, value.end());
         }
@@ -1,5 +1,6 @@
 #include <afina/Storage.h>
 #include <afina/execute/Replace.h>
+#include <afina/metrics/Metrics.h>
 
 #include <iostream>
 
@@ -10,6 +11,7 @@ namespace Execute {
 // already hold data for this key".
 
 void Replace::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Metrics::Add(Metrics::Id::kCmdSet);
     std::cout << "Replace(" << _key << "): " << args << std::endl;
     std::string value;
     if (storage.Get(_key, value)) {
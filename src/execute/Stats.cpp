@@ -1,14 +1,116 @@
 #include <afina/Storage.h>
 #include <afina/execute/Stats.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+namespace {
+
+void AppendStat(std::string &out, const char *name, const char *value) {
+    out.append("STAT ");
+    out.append(name);
+    out.append(" ");
+    out.append(value);
+    out.append("\r\n");
+}
+
+void AppendStat(std::string &out, const char *name, long long value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%lld", value);
+    AppendStat(out, name, buf);
+}
+
+void AppendStat(std::string &out, const char *name, const struct timeval &value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%ld.%06ld", static_cast<long>(value.tv_sec), static_cast<long>(value.tv_usec));
+    AppendStat(out, name, buf);
+}
+
+void AppendLatency(std::string &out) {
+    for (std::size_t op = 0; op < static_cast<std::size_t>(Metrics::Op::kCount); op++) {
+        for (std::size_t stage = 0; stage < static_cast<std::size_t>(Metrics::Stage::kCount); stage++) {
+            Metrics::Histogram::Snapshot latency =
+                Metrics::Latency(static_cast<Metrics::Op>(op), static_cast<Metrics::Stage>(stage));
+            if (latency.Count() == 0) {
+                continue;
+            }
+
+            std::string prefix = Metrics::Name(static_cast<Metrics::Op>(op));
+            prefix += "_";
+            prefix += Metrics::Name(static_cast<Metrics::Stage>(stage));
+            AppendStat(out, (prefix + "_count").c_str(), static_cast<long long>(latency.Count()));
+            AppendStat(out, (prefix + "_p50").c_str(), static_cast<long long>(latency.Percentile(0.5)));
+            AppendStat(out, (prefix + "_p99").c_str(), static_cast<long long>(latency.Percentile(0.99)));
+            AppendStat(out, (prefix + "_p999").c_str(), static_cast<long long>(latency.Percentile(0.999)));
+            AppendStat(out, (prefix + "_max").c_str(), static_cast<long long>(latency.Max()));
+        }
+    }
+}
+
+} // namespace
+
+/* memcached protocol:
+
+Upon receiving the "stats" command without arguments, the server sends a number of lines which look like this:
+
+STAT <name> <value>\r\n
+
+The server terminates this list with the line
+
+END\r\n
+
+*/
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    out.clear();
+    if (!_args.empty()) {
+        if (_args.size() != 1) {
+            throw std::runtime_error("Unknown stats group");
+        }
+
+        if (_args[0] == "latency") {
+            AppendLatency(out);
+        } else {
+            // Groups such as "slabs" describe storage internals, only storage knows them
+            std::vector<std::pair<std::string, std::string>> stats;
+            if (!storage.Stats(_args[0], stats)) {
+                throw std::runtime_error("Unknown stats group");
+            }
+            for (auto &stat : stats) {
+                AppendStat(out, stat.first.c_str(), stat.second.c_str());
+            }
+        }
+        out.append("END");
+        return;
+    }
+
+    AppendStat(out, "pid", static_cast<long long>(getpid()));
+    AppendStat(out, "uptime", static_cast<long long>(Metrics::Uptime()));
+    AppendStat(out, "time", static_cast<long long>(std::time(nullptr)));
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        AppendStat(out, "rusage_user", usage.ru_utime);
+        AppendStat(out, "rusage_system", usage.ru_stime);
+    }
+
+    // Counters are summed over all threads right here, nobody pays for that on the hot path
+    for (std::size_t i = 0; i < static_cast<std::size_t>(Metrics::Id::kCount); i++) {
+        Metrics::Id id = static_cast<Metrics::Id>(i);
+        AppendStat(out, Metrics::Name(id), static_cast<long long>(Metrics::Value(id)));
+    }
+    out.append("END");
+}
 
 } // namespace Execute
 } // namespace Afina
@@ -0,0 +1,223 @@
+#include <afina/logging/RingLogger.h>
+
+#include <stdexcept>
+
+#include <spdlog/formatter.h>
+#include <spdlog/sinks/sink.h>
+
+#include <afina/metrics/Metrics.h>
+
+namespace Afina {
+namespace Logging {
+
+constexpr std::size_t LogRings::alignment;
+
+// See RingLogger.h
+LogRings::LogRings(std::size_t ring_size, std::chrono::milliseconds interval)
+    : _ring_size(alignment * 2), _interval(interval), _running(false) {
+    while (_ring_size < ring_size) {
+        _ring_size *= 2;
+    }
+}
+
+// See RingLogger.h
+LogRings::~LogRings() {
+    Stop();
+    Flush();
+}
+
+// See RingLogger.h
+void LogRings::Start() {
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _thread = std::thread(&LogRings::run, this);
+}
+
+// See RingLogger.h
+void LogRings::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _stop.notify_all();
+    _thread.join();
+    Flush();
+}
+
+// See RingLogger.h
+void LogRings::Flush() {
+    std::lock_guard<std::mutex> lock(_drain_lock);
+    drain();
+}
+
+// See RingLogger.h
+std::size_t LogRings::dropped() {
+    return _rings.aggregate(std::size_t(0), [](std::size_t sum, Ring &ring) {
+        return sum + ring.dropped.load(std::memory_order_relaxed);
+    });
+}
+
+/**
+ * Record that doesn't fit before the end of ring starts over from the beginning, the rest is marked as
+ * padding. Head is read from consumer's side only when cached copy says ring is full
+ */
+LogRings::Record *LogRings::reserve(std::size_t size) {
+    Ring &ring = _rings.local();
+    char *buffer = ring.buffer.load(std::memory_order_relaxed);
+    if (buffer == nullptr) {
+        void *memory = nullptr;
+        if (posix_memalign(&memory, alignment, _ring_size) != 0) {
+            return nullptr;
+        }
+        buffer = static_cast<char *>(memory);
+        ring.buffer.store(buffer, std::memory_order_release);
+    }
+
+    size = (size + alignment - 1) / alignment * alignment;
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    std::size_t offset = tail & (_ring_size - 1);
+    std::size_t padding = offset + size > _ring_size ? _ring_size - offset : 0;
+    if (size > _ring_size / 2 ||
+        (tail + padding + size - ring.head_cache > _ring_size &&
+         tail + padding + size - (ring.head_cache = ring.head.load(std::memory_order_acquire)) > _ring_size)) {
+        ring.dropped.store(ring.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        Metrics::Add(Metrics::Id::kLogDropped);
+        return nullptr;
+    }
+
+    if (padding > 0) {
+        Record *pad = reinterpret_cast<Record *>(buffer + offset);
+        pad->format = nullptr;
+        pad->size = padding;
+        tail += padding;
+        offset = 0;
+    }
+
+    Record *record = reinterpret_cast<Record *>(buffer + offset);
+    record->size = size;
+    ring.reserved = tail + size;
+    return record;
+}
+
+// See RingLogger.h
+void LogRings::commit(Record *) {
+    Ring &ring = _rings.local();
+    ring.tail.store(ring.reserved, std::memory_order_release);
+}
+
+bool LogRings::drain() {
+    bool found = false;
+    std::size_t mask = _ring_size - 1;
+    _rings.for_each([&found, mask](Ring &ring) {
+        char *buffer = ring.buffer.load(std::memory_order_acquire);
+        if (buffer == nullptr) {
+            return;
+        }
+
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        found |= head != tail;
+        while (head != tail) {
+            const Record *record = reinterpret_cast<const Record *>(buffer + (head & mask));
+            if (record->format != nullptr) {
+                record->logger->write(*record);
+            }
+            head += record->size;
+        }
+        ring.head.store(head, std::memory_order_release);
+    });
+    return found;
+}
+
+void LogRings::run() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_running) {
+        lock.unlock();
+        bool found;
+        {
+            std::lock_guard<std::mutex> drain_lock(_drain_lock);
+            found = drain();
+        }
+        lock.lock();
+
+        if (!found) {
+            _stop.wait_for(lock, _interval);
+        }
+    }
+}
+
+// See RingLogger.h
+RingLogger::RingLogger(const std::string &name, const std::vector<spdlog::sink_ptr> &sinks,
+                       std::shared_ptr<LogRings> rings)
+    : spdlog::logger(name, sinks.begin(), sinks.end()), _rings(std::move(rings)) {}
+
+// See RingLogger.h
+RingLogger::~RingLogger() { _rings->Flush(); }
+
+// See RingLogger.h
+void RingLogger::flush() {
+    _rings->Flush();
+    for (auto &sink : _sinks) {
+        if (sink != nullptr) {
+            sink->flush();
+        }
+    }
+}
+
+// See RingLogger.h
+void RingLogger::_sink_it(spdlog::details::log_msg &msg) {
+    std::size_t size = msg.raw.size();
+    LogRings::Record *record = _rings->reserve(sizeof(LogRings::Record) + detail::StringArg::size(msg.raw.data(), size));
+    if (record == nullptr) {
+        return;
+    }
+    detail::StringArg::store(reinterpret_cast<char *>(record + 1), msg.raw.data(), size);
+    record->format = &detail::RecordFormat<std::string>::format;
+    record->fmt = "{}";
+    record->logger = this;
+    record->time = msg.time.time_since_epoch().count();
+    record->thread_id = msg.thread_id;
+    record->level = msg.level;
+    _rings->commit(record);
+}
+
+/**
+ * Same as spdlog::logger does with message in the calling thread
+ */
+void RingLogger::write(const LogRings::Record &record) {
+    try {
+        spdlog::details::log_msg msg;
+        msg.logger_name = &_name;
+        msg.level = static_cast<spdlog::level::level_enum>(record.level);
+        msg.time = spdlog::log_clock::time_point(spdlog::log_clock::duration(record.time));
+        msg.thread_id = record.thread_id;
+        record.format(record.fmt, reinterpret_cast<const char *>(&record + 1), msg.raw);
+
+        _formatter->format(msg);
+        for (auto &sink : _sinks) {
+            if (sink != nullptr && sink->should_log(msg.level)) {
+                sink->log(msg);
+            }
+        }
+        if (_should_flush_on(msg)) {
+            for (auto &sink : _sinks) {
+                if (sink != nullptr) {
+                    sink->flush();
+                }
+            }
+        }
+    } catch (const std::exception &ex) {
+        _err_handler(ex.what());
+    } catch (...) {
+        _err_handler("Unknown exception");
+    }
+}
+
+} // namespace Logging
+} // namespace Afina
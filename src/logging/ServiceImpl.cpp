@@ -64,8 +64,9 @@ ServiceImpl::~ServiceImpl() = default;
 
 // See ServiceImpl.h
 void ServiceImpl::Start() {
-    // Setup spdlog
-    spdlog::set_async_mode(512, spdlog::async_overflow_policy::block_retry, nullptr, std::chrono::seconds(2));
+    // Messages are written by flusher thread, logging threads never wait for appenders
+    _rings = std::make_shared<LogRings>();
+    _rings->Start();
 
     // First build appenders
     std::map<std::string, spdlog::sink_ptr> results;
@@ -165,7 +166,8 @@ void ServiceImpl::Start() {
         }
 
         // Create logger
-        std::shared_ptr<spdlog::logger> logger = std::make_shared<spdlog::logger>(name, ptr);
+        std::shared_ptr<spdlog::logger> logger =
+            std::make_shared<RingLogger>(name, std::vector<spdlog::sink_ptr>{ptr}, _rings);
         logger->set_level(lvl);
         logger->set_pattern(pLogger.format);
         logger->flush_on(spdlog::level::err);
@@ -180,7 +182,11 @@ void ServiceImpl::Start() {
 }
 
 // See ServiceImpl.h
-void ServiceImpl::Stop() {}
+void ServiceImpl::Stop() {
+    if (_rings != nullptr) {
+        _rings->Stop();
+    }
+}
 
 // See ServiceImpl.h
 std::shared_ptr<spdlog::logger> ServiceImpl::select(const std::string &name) noexcept {
@@ -252,7 +258,7 @@ std::unique_ptr<spdlog::logger> ServiceImpl::create(const std::string &name,
     }
 
     // Done, create formatter
-    auto result = std::unique_ptr<spdlog::logger>(new spdlog::logger(base->name(), sinks.begin(), sinks.end()));
+    auto result = std::unique_ptr<spdlog::logger>(new RingLogger(base->name(), sinks, _rings));
     result->set_level(base->level());
     result->set_pattern(ss.str());
     result->flush_on(spdlog::level::err);
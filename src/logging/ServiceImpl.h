@@ -2,6 +2,7 @@
 #define AFINA_LOGGING_SERVICE_IMPL_H
 
 #include <afina/logging/Config.h>
+#include <afina/logging/RingLogger.h>
 #include <afina/logging/Service.h>
 
 namespace Afina {
@@ -9,7 +10,7 @@ namespace Logging {
 
 /**
  * # Provides loggers for rest of the system
- *
+ * Loggers write through per thread rings, a background thread passes messages to appenders
  */
 class ServiceImpl : public Service {
 public:
@@ -35,6 +36,8 @@ public:
 private:
     std::shared_ptr<Config> _cfg;
 
+    std::shared_ptr<LogRings> _rings;
+
     // TODO: bug: if service not started all select return _root, which is nullptr
     std::shared_ptr<spdlog::logger> _root;
 };
@@ -1,21 +1,30 @@
+#include <algorithm>
 #include <chrono>
+#include <functional>
 #include <iostream>
 #include <memory>
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <semaphore.h>
 #include <signal.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 #include <cxxopts.hpp>
 
+#include <afina/Snapshot.h>
 #include <afina/Storage.h>
 #include <afina/Version.h>
 #include <afina/logging/Service.h>
 #include <afina/network/Server.h>
+#include <afina/trace/Trace.h>
 #include <storage/StripedLRU.h>
 
 #include "logging/ServiceImpl.h"
+#include "network/Handover.h"
 #include "network/mt_blocking/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
@@ -23,8 +32,16 @@
 #include "network/st_nonblocking/ServerImpl.h"
 #include "network/mt_threadpool/ServerImpl.h"
 
+#include "storage/ArenaLRU.h"
+#include "storage/FlatCombineLRU.h"
+#include "storage/JournaledStorage.h"
+#include "storage/MappedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+#include "storage/ThreadSafeArenaLRU.h"
+#include "storage/ThreadSafeMappedLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/ThreadSafeSlabLRU.h"
 #include "storage/StripedLRU.h"
 
 using namespace Afina;
@@ -54,16 +71,90 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Step 1.0: take listening socket over from running server. Storage file, snapshot or journal of the
+        // previous process are left as they are till it stops, so wait for that if storage goes on with them
+        inherited_socket = -1;
+        if (options.count("handover") > 0) {
+            handover.reset(new Network::Handover(options["handover"].as<std::string>()));
+            inherited_socket = handover->Takeover();
+            bool shared = options.count("snapshot") > 0 || options.count("journal") > 0 ||
+                          storage_type.find("mapped") != std::string::npos;
+            if (inherited_socket != -1 && shared) {
+                handover->WaitPredecessor();
+            }
+        }
+
         if (storage_type == "st_lru") {
             storage = std::make_shared<Afina::Backend::SimpleLRU>();
         } else if (storage_type == "mt_slru") {
             storage.reset(Afina::Backend::BuildStripedLRU(1024*1024*333, 1000));
         } else if (storage_type == "mt_lru") {
                 storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+        } else if (storage_type == "mt_fclru") {
+            storage = std::make_shared<Afina::Backend::FlatCombineLRU>();
+        } else if (storage_type == "st_arena_lru") {
+            storage = std::make_shared<Afina::Backend::ArenaLRU>();
+        } else if (storage_type == "mt_arena_lru") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeArenaLRU>();
+        } else if (storage_type == "st_slab_lru") {
+            storage = std::make_shared<Afina::Backend::SlabLRU>();
+        } else if (storage_type == "mt_slab_lru") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeSlabLRU>();
+        } else if (storage_type == "st_mapped_lru") {
+            storage = std::make_shared<Afina::Backend::MappedLRU>(storage_file(options));
+        } else if (storage_type == "mt_mapped_lru") {
+            storage = std::make_shared<Afina::Backend::ThreadSafeMappedLRU>(storage_file(options));
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
+        // Step 1.1: journal of changes, replayed at start on top of snapshot if any
+        if (options.count("journal") > 0) {
+            std::chrono::milliseconds sync_interval(10);
+            if (options.count("journal-sync") > 0) {
+                sync_interval = std::chrono::milliseconds(options["journal-sync"].as<int>());
+            }
+            storage = std::make_shared<Afina::Backend::JournaledStorage>(storage, options["journal"].as<std::string>(),
+                                                                         sync_interval);
+        }
+
+        // Step 1.2: snapshots, loaded at start and saved at stop, optionally in background as well
+        if (options.count("snapshot") > 0) {
+            // Others can't save items, that would turn up only at stop
+            const std::vector<std::string> snapshot_storages = {"st_lru", "mt_lru", "mt_slru", "st_slab_lru",
+                                                                "mt_slab_lru"};
+            if (std::find(snapshot_storages.begin(), snapshot_storages.end(), storage_type) ==
+                snapshot_storages.end()) {
+                throw std::runtime_error("Storage " + storage_type + " doesn't support snapshots");
+            }
+            snapshot_path = options["snapshot"].as<std::string>();
+        }
+        snapshot_interval = std::chrono::seconds(0);
+        if (options.count("snapshot-interval") > 0) {
+            snapshot_interval = std::chrono::seconds(options["snapshot-interval"].as<int>());
+        }
+        if (snapshot_interval.count() > 0) {
+            if (snapshot_path.empty()) {
+                throw std::runtime_error("Snapshot interval needs snapshot file");
+            }
+            // Background thread works with storage concurrently to network
+            if (storage_type.compare(0, 3, "mt_") != 0) {
+                throw std::runtime_error("Background snapshots need thread safe storage");
+            }
+        }
+
+        // Step 1.3: trace of requests for offline simulation, recorded from the start of network
+        if (options.count("trace") > 0) {
+            trace_path = options["trace"].as<std::string>();
+            trace_sample = 1;
+            if (options.count("trace-sample") > 0) {
+                trace_sample = options["trace-sample"].as<int>();
+            }
+            if (trace_sample < 1) {
+                throw std::runtime_error("Trace sample must be positive");
+            }
+        }
+
         // Step 2: Configure network
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
@@ -85,10 +176,25 @@ public:
         } else {
             throw std::runtime_error("Unknown network type");
         }
+
+        // Step 2.1: memory of responses waiting for slow clients, in kilobytes
+        if (options.count("output-limit") > 0 || options.count("output-memory") > 0) {
+            int connection_output = 4 * 1024, total_output = 256 * 1024;
+            if (options.count("output-limit") > 0) {
+                connection_output = options["output-limit"].as<int>();
+            }
+            if (options.count("output-memory") > 0) {
+                total_output = options["output-memory"].as<int>();
+            }
+            if (connection_output < 1 || total_output < 1) {
+                throw std::runtime_error("Output limits must be positive");
+            }
+            server->Limit(std::size_t(connection_output) * 1024, std::size_t(total_output) * 1024);
+        }
     }
 
-    // Start services in correct order
-    void Start() {
+    // Start services in correct order, on_handover is called once the next process took server over
+    void Start(std::function<void()> on_handover) {
         logService->Start();
         auto log = logService->select("root");
         log->warn("Start afina server {}", Afina::get_version());
@@ -96,29 +202,168 @@ public:
         log->warn("Start storage");
         storage->Start();
 
+        auto journaled = std::dynamic_pointer_cast<Afina::Backend::JournaledStorage>(storage);
+        auto mapped = std::dynamic_pointer_cast<Afina::Backend::MappedLRU>(journaled ? journaled->Wrapped() : storage);
+        if (mapped != nullptr) {
+            static const char *modes[] = {"created", "attached", "recovered"};
+            log->warn("Storage file {} {} with {} items", mapped_file, modes[static_cast<int>(mapped->Mode())],
+                      mapped->Items());
+        }
+
+        if (!snapshot_path.empty() && access(snapshot_path.c_str(), F_OK) == 0) {
+            LoadSnapshot();
+        }
+        if (journaled != nullptr) {
+            auto start = std::chrono::steady_clock::now();
+            std::size_t records = journaled->Recover();
+            auto elapsed =
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            log->warn("Replayed {} journal records in {} ms", records, elapsed.count());
+        }
+        if (snapshot_interval.count() > 0) {
+            snapshot_running = true;
+            snapshot_thread = std::thread(&Application::RunSnapshots, this);
+        }
+
         // TODO: configure network service
         const uint16_t port = 8080;
-        log->warn("Start network on {}", port);
+        if (inherited_socket != -1) {
+            log->warn("Start network on socket taken over from previous process");
+            server->Inherit(inherited_socket);
+        } else {
+            log->warn("Start network on {}", port);
+        }
+        if (!trace_path.empty()) {
+            log->warn("Trace 1 of {} keys into {}", trace_sample, trace_path);
+            Afina::Trace::Start(trace_path, trace_sample);
+        }
         server->Start(port, 2, 2);
+
+        if (handover != nullptr) {
+            handover->Serve(server->Socket(), std::move(on_handover));
+        }
     }
 
     // Stop services in correct order
     void Stop() {
         auto log = logService->select("root");
         log->warn("Stop application");
+        if (snapshot_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(snapshot_lock);
+                snapshot_running = false;
+            }
+            snapshot_stop.notify_all();
+            snapshot_thread.join();
+        }
+
         server->Stop();
         server->Join();
 
+        if (!trace_path.empty()) {
+            Afina::Trace::Stop();
+            log->warn("Traced {} requests, {} dropped", Afina::Trace::Written(), Afina::Trace::Dropped());
+        }
+
+        // Failed snapshot must not leave storage, handover and logs unfinished
+        if (!snapshot_path.empty()) {
+            try {
+                SaveSnapshot();
+            } catch (std::exception &e) {
+                log->error("Failed to save snapshot: {}", e.what());
+            }
+        }
         storage->Stop();
+
+        if (handover != nullptr && handover->HandedOver()) {
+            // Next process waits for storage to be closed
+            server.reset();
+            storage.reset();
+            handover->Release();
+            log->warn("Handed over to the next process");
+        }
         logService->Stop();
     }
 
 private:
+    // File of mapped storage, in working directory by default
+    const std::string &storage_file(const cxxopts::Options &options) {
+        mapped_file = "afina.storage";
+        if (options.count("storage-file") > 0) {
+            mapped_file = options["storage-file"].as<std::string>();
+        }
+        return mapped_file;
+    }
+
+    // Fills storage from snapshot using all cores
+    void LoadSnapshot() {
+        auto log = logService->select("root");
+        log->warn("Load snapshot {}", snapshot_path);
+
+        auto start = std::chrono::steady_clock::now();
+        SnapshotReader snapshot(snapshot_path);
+        std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        if (!storage->Load(snapshot, threads)) {
+            throw std::runtime_error("Storage doesn't support snapshots");
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        log->warn("Loaded {} items by {} threads in {} ms", snapshot.Records(), threads, elapsed.count());
+    }
+
+    // Writes snapshot next to the old one and replaces it once complete
+    void SaveSnapshot() {
+        auto log = logService->select("root");
+        auto start = std::chrono::steady_clock::now();
+        SnapshotWriter snapshot(snapshot_path);
+        if (!storage->Save(snapshot)) {
+            throw std::runtime_error("Storage doesn't support snapshots");
+        }
+        snapshot.Commit();
+
+        // Journal keeps only changes the snapshot may lack
+        auto journaled = std::dynamic_pointer_cast<Afina::Backend::JournaledStorage>(storage);
+        if (journaled != nullptr) {
+            journaled->Compact();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        log->warn("Saved snapshot of {} items, {} bytes in {} ms", snapshot.Records(), snapshot.Bytes(),
+                  elapsed.count());
+    }
+
+    // Saves snapshot every snapshot_interval until Stop, requests are served meanwhile
+    void RunSnapshots() {
+        std::unique_lock<std::mutex> lock(snapshot_lock);
+        while (!snapshot_stop.wait_for(lock, snapshot_interval, [this] { return !snapshot_running; })) {
+            lock.unlock();
+            try {
+                SaveSnapshot();
+            } catch (std::exception &e) {
+                logService->select("root")->error("Failed to save snapshot: {}", e.what());
+            }
+            lock.lock();
+        }
+    }
+
     std::shared_ptr<Logging::Config> logConfig;
     std::shared_ptr<Logging::Service> logService;
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Network::Server> server;
+
+    std::unique_ptr<Network::Handover> handover;
+    int inherited_socket;
+
+    std::string mapped_file;
+    std::string snapshot_path;
+
+    // Request trace, empty if it's off
+    std::string trace_path;
+    int trace_sample;
+    std::chrono::seconds snapshot_interval;
+    std::thread snapshot_thread;
+    std::mutex snapshot_lock;
+    std::condition_variable snapshot_stop;
+    bool snapshot_running;
 };
 
 // Signal set that to notify application about time to stop
@@ -139,6 +384,24 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("storage-file", "File of mapped storage", cxxopts::value<std::string>());
+        options.add_options()("snapshot", "Snapshot file to load storage from at start and save to at stop",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot-interval", "Seconds between snapshots saved in background",
+                              cxxopts::value<int>());
+        options.add_options()("journal", "File to log changes to and replay them from at start",
+                              cxxopts::value<std::string>());
+        options.add_options()("journal-sync", "Milliseconds between journal syncs", cxxopts::value<int>());
+        options.add_options()("trace", "File to record trace of requests to, see afina-sim", cxxopts::value<std::string>());
+        options.add_options()("trace-sample", "Trace one of that many keys", cxxopts::value<int>());
+        options.add_options()("output-limit", "Kilobytes of unsent responses that stop connection from reading",
+                              cxxopts::value<int>());
+        options.add_options()("output-memory", "Kilobytes of unsent responses of all connections that stop them "
+                                               "from reading",
+                              cxxopts::value<int>());
+        options.add_options()("handover", "Unix socket to take server over from running process at, and to hand it "
+                                          "over to the next one",
+                              cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -176,7 +439,7 @@ int main(int argc, char **argv) {
     // Run app
     try {
         // Start services
-        app.Start();
+        app.Start([] { sem_post(&stop_semaphore); });
 
         // Freeze main thread until one of signals arrive
         while (stop_reason == 0 && ((sem_wait(&stop_semaphore) == -1) && (errno == EINTR))) {
@@ -0,0 +1,14 @@
+#include <afina/metrics/Histogram.h>
+
+namespace Afina {
+namespace Metrics {
+
+// Definitions for odr-used constants, see Histogram.h
+constexpr unsigned Histogram::sub_bucket_bits;
+constexpr uint64_t Histogram::sub_buckets;
+constexpr unsigned Histogram::max_bits;
+constexpr uint64_t Histogram::max_value;
+constexpr std::size_t Histogram::bucket_count;
+
+} // namespace Metrics
+} // namespace Afina
@@ -0,0 +1,69 @@
+#include <afina/metrics/Latency.h>
+
+namespace Afina {
+namespace Metrics {
+
+namespace {
+
+// Indexed by Op
+const char *op_names[] = {"get", "set", "add", "append", "replace", "delete", "stats", "other"};
+
+static_assert(sizeof(op_names) / sizeof(op_names[0]) == static_cast<std::size_t>(Op::kCount),
+              "Every command type must have a name");
+
+// Indexed by Stage
+const char *stage_names[] = {"parse", "execute", "write"};
+
+static_assert(sizeof(stage_names) / sizeof(stage_names[0]) == static_cast<std::size_t>(Stage::kCount),
+              "Every stage must have a name");
+
+} // namespace
+
+namespace detail {
+
+// See Latency.h
+Concurrency::ThreadLocal<LatencyShard> &LatencyShards() {
+    // Never destroyed for the same reason as counters, see Metrics.cpp
+    static Concurrency::ThreadLocal<LatencyShard> *shards = new Concurrency::ThreadLocal<LatencyShard>();
+    return *shards;
+}
+
+} // namespace detail
+
+// See Latency.h
+const char *Name(Op op) { return op_names[static_cast<std::size_t>(op)]; }
+
+// See Latency.h
+const char *Name(Stage stage) { return stage_names[static_cast<std::size_t>(stage)]; }
+
+// See Latency.h
+Op OpOf(const std::string &command) {
+    if (command == "get" || command == "gets") {
+        return Op::kGet;
+    } else if (command == "set") {
+        return Op::kSet;
+    } else if (command == "add") {
+        return Op::kAdd;
+    } else if (command == "append" || command == "prepend") {
+        return Op::kAppend;
+    } else if (command == "replace") {
+        return Op::kReplace;
+    } else if (command == "delete") {
+        return Op::kDelete;
+    } else if (command == "stats") {
+        return Op::kStats;
+    }
+    return Op::kOther;
+}
+
+// See Latency.h
+Histogram::Snapshot Latency(Op op, Stage stage) {
+    Histogram::Snapshot result;
+    detail::LatencyShards().for_each([&result, op, stage](detail::LatencyShard &shard) {
+        result.Add(shard.histograms[static_cast<std::size_t>(op)][static_cast<std::size_t>(stage)]);
+    });
+    return result;
+}
+
+} // namespace Metrics
+} // namespace Afina
@@ -0,0 +1,52 @@
+#include <afina/metrics/Metrics.h>
+
+#include <chrono>
+
+namespace Afina {
+namespace Metrics {
+
+namespace {
+
+// Indexed by Id
+const char *names[] = {
+    "curr_items", "bytes", "evictions", "cmd_get", "get_hits", "get_misses", "cmd_set", "protocol_errors",
+    "curr_connections", "total_connections", "bytes_read", "bytes_written", "output_bytes",
+    "curr_throttled_connections", "total_throttles", "log_dropped", "journal_errors",
+};
+
+static_assert(sizeof(names) / sizeof(names[0]) == static_cast<std::size_t>(Id::kCount),
+              "Every counter must have a name");
+
+const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+} // namespace
+
+namespace detail {
+
+// See Metrics.h
+Concurrency::ThreadLocal<Shard> &Shards() {
+    // Never destroyed: detached threads might still count something while process exits
+    static Concurrency::ThreadLocal<Shard> *shards = new Concurrency::ThreadLocal<Shard>();
+    return *shards;
+}
+
+} // namespace detail
+
+// See Metrics.h
+const char *Name(Id id) { return names[static_cast<std::size_t>(id)]; }
+
+// See Metrics.h
+int64_t Value(Id id) {
+    std::size_t index = static_cast<std::size_t>(id);
+    return detail::Shards().aggregate(int64_t(0), [index](int64_t sum, detail::Shard &shard) {
+        return sum + shard.values[index].load(std::memory_order_relaxed);
+    });
+}
+
+// See Metrics.h
+int64_t Uptime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+} // namespace Metrics
+} // namespace Afina
@@ -0,0 +1,49 @@
+#include "Accept.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+
+namespace Afina {
+namespace Network {
+
+// See Accept.h
+bool WaitConnection(int server_socket, int wake_fd) {
+    struct pollfd fds[2];
+    fds[0].fd = server_socket;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        fds[0].revents = fds[1].revents = 0;
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to wait for connection: " + std::string(strerror(errno)));
+        }
+
+        if (fds[1].revents != 0) {
+            return false;
+        }
+        if (fds[0].revents != 0) {
+            return true;
+        }
+    }
+}
+
+// See Accept.h
+void MakeNonBlocking(int socket) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1 || fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1) {
+        throw std::runtime_error("Failed to make socket non blocking: " + std::string(strerror(errno)));
+    }
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,22 @@
+#ifndef AFINA_NETWORK_ACCEPT_H
+#define AFINA_NETWORK_ACCEPT_H
+
+namespace Afina {
+namespace Network {
+
+/**
+ * Waits until connection is pending on server socket or wake_fd gets readable. Returns false in the latter
+ * case, that is once server stops. Server socket must be non blocking, as pending connection could be taken
+ * by another process serving the same socket before accept is called
+ */
+bool WaitConnection(int server_socket, int wake_fd);
+
+/**
+ * Sets O_NONBLOCK on socket, throws std::runtime_error on failure
+ */
+void MakeNonBlocking(int socket);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ACCEPT_H
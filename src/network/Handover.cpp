@@ -0,0 +1,276 @@
+#include "Handover.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Accept.h"
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+const char magic[8] = {'A', 'F', 'I', 'N', 'A', 'H', 'N', 'D'};
+
+// Messages processes exchange, socket comes along with kSocket
+enum class Type : uint32_t { kSocket = 1, kAck = 2, kReleased = 3 };
+
+struct Message {
+    char magic[8];
+    Type type;
+    uint32_t reserved;
+};
+
+bool Send(int channel, Type type, int fd = -1) {
+    Message message;
+    std::memcpy(message.magic, magic, sizeof(message.magic));
+    message.type = type;
+    message.reserved = 0;
+
+    struct iovec iov;
+    iov.iov_base = &message;
+    iov.iov_len = sizeof(message);
+
+    struct msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    if (fd != -1) {
+        std::memset(&control, 0, sizeof(control));
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    for (;;) {
+        if (sendmsg(channel, &header, MSG_NOSIGNAL) == sizeof(message)) {
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+// Returns false on end of channel, error or malformed message. Socket passed along is put to fd, -1 if none
+bool Receive(int channel, Type &type, int &fd) {
+    Message message;
+    struct iovec iov;
+    iov.iov_base = &message;
+    iov.iov_len = sizeof(message);
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+
+    ssize_t n;
+    while ((n = recvmsg(channel, &header, MSG_CMSG_CLOEXEC)) == -1 && errno == EINTR) {
+        continue;
+    }
+
+    fd = -1;
+    struct cmsghdr *cmsg = n > 0 ? CMSG_FIRSTHDR(&header) : nullptr;
+    if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+        std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+
+    if (n != sizeof(message) || std::memcmp(message.magic, magic, sizeof(magic)) != 0) {
+        if (fd != -1) {
+            close(fd);
+            fd = -1;
+        }
+        return false;
+    }
+    type = message.type;
+    return true;
+}
+
+struct sockaddr_un Address(const std::string &path) {
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Handover path is too long: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return addr;
+}
+
+std::runtime_error Error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::string(strerror(errno)));
+}
+
+} // namespace
+
+// See Handover.h
+Handover::Handover(const std::string &path)
+    : _path(path), _listener(-1), _event_fd(-1), _predecessor(-1), _successor(-1), _handed_over(false) {}
+
+// See Handover.h
+Handover::~Handover() {
+    if (_thread.joinable()) {
+        eventfd_write(_event_fd, 1);
+        _thread.join();
+    }
+    if (_listener != -1) {
+        close(_listener);
+        close(_event_fd);
+        if (!_handed_over.load()) {
+            unlink(_path.c_str());
+        }
+    }
+    if (_predecessor != -1) {
+        close(_predecessor);
+    }
+    if (_successor != -1) {
+        close(_successor);
+    }
+}
+
+// See Handover.h
+int Handover::Takeover() {
+    struct sockaddr_un addr = Address(_path);
+    _predecessor = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (_predecessor == -1) {
+        throw Error("Failed to open socket for", _path);
+    }
+
+    if (connect(_predecessor, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        int error = errno;
+        close(_predecessor);
+        _predecessor = -1;
+
+        // Nobody serves path, or process that did has died
+        if (error == ENOENT || error == ECONNREFUSED) {
+            return -1;
+        }
+        errno = error;
+        throw Error("Failed to connect to", _path);
+    }
+
+    Type type;
+    int fd;
+    if (!Receive(_predecessor, type, fd) || type != Type::kSocket || fd == -1) {
+        if (fd != -1) {
+            close(fd);
+        }
+        throw std::runtime_error("Process at " + _path + " failed to hand socket over");
+    }
+
+    // Predecessor stops accepting once it knows socket is taken
+    if (!Send(_predecessor, Type::kAck)) {
+        close(fd);
+        throw Error("Failed to confirm handover to", _path);
+    }
+    return fd;
+}
+
+// See Handover.h
+void Handover::WaitPredecessor() {
+    if (_predecessor == -1) {
+        return;
+    }
+
+    // Either released message or end of channel, once predecessor is gone
+    Type type;
+    int fd;
+    while (Receive(_predecessor, type, fd) && type != Type::kReleased) {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+    close(_predecessor);
+    _predecessor = -1;
+}
+
+// See Handover.h
+void Handover::Serve(int server_socket, std::function<void()> on_handover) {
+    struct sockaddr_un addr = Address(_path);
+    _listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_listener == -1) {
+        throw Error("Failed to open socket for", _path);
+    }
+
+    // Path is left by predecessor, either the one socket was taken from or a crashed one
+    unlink(_path.c_str());
+    if (bind(_listener, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(_listener, 1) == -1) {
+        close(_listener);
+        _listener = -1;
+        throw Error("Failed to listen on", _path);
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        close(_listener);
+        _listener = -1;
+        throw Error("Failed to create eventfd for", _path);
+    }
+    _thread = std::thread(&Handover::OnRun, this, server_socket, std::move(on_handover));
+}
+
+// See Handover.h
+void Handover::Release() {
+    if (_handed_over.load() && _successor != -1) {
+        Send(_successor, Type::kReleased);
+        close(_successor);
+        _successor = -1;
+    }
+}
+
+// See Handover.h
+void Handover::OnRun(int server_socket, std::function<void()> on_handover) {
+    while (WaitConnection(_listener, _event_fd)) {
+        int channel = accept4(_listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (channel == -1) {
+            continue;
+        }
+
+        // Successor that doesn't confirm in time is dropped, server goes on
+        struct timeval tv;
+        tv.tv_sec = 5;
+        tv.tv_usec = 0;
+        setsockopt(channel, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof(tv));
+
+        Type type;
+        int fd = -1;
+        if (Send(channel, Type::kSocket, server_socket) && Receive(channel, type, fd) && type == Type::kAck) {
+            _successor = channel;
+            _handed_over.store(true);
+            on_handover();
+            return;
+        }
+
+        if (fd != -1) {
+            close(fd);
+        }
+        close(channel);
+    }
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,88 @@
+#ifndef AFINA_NETWORK_HANDOVER_H
+#define AFINA_NETWORK_HANDOVER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Listening socket handover between processes
+ * Lets new process of the server take over listening socket of the running one, so that restart neither
+ * refuses connections nor needs the port to be free. Processes meet at unix socket path: running process
+ * serves it, new one connects and gets listening socket passed as SCM_RIGHTS. Once new process confirmed
+ * it got the socket, old one stops accepting, drains its connections and exits, connections arriving
+ * meanwhile wait in the listen queue whoever of two accepts them.
+ *
+ * Storage can't be shared while both processes run, so if new process goes on with storage of the old
+ * one, file of mapped storage or snapshot, it waits until old process released it.
+ */
+class Handover {
+public:
+    /**
+     * Processes meet at unix socket path
+     */
+    explicit Handover(const std::string &path);
+
+    /**
+     * Stops serving path. Path is removed unless socket was handed over, successor serves it then
+     */
+    ~Handover();
+
+    Handover(const Handover &) = delete;
+    Handover &operator=(const Handover &) = delete;
+
+    /**
+     * Takes listening socket over from process serving path. Returns -1 if there is no such process, throws
+     * std::runtime_error if there is one but it failed to hand socket over
+     */
+    int Takeover();
+
+    /**
+     * Blocks until process socket was taken over from has released storage or exited
+     */
+    void WaitPredecessor();
+
+    /**
+     * Starts serving path in background thread. Once successor has taken server_socket over on_handover is
+     * called from that thread, process is expected to stop then and call Release at the end
+     */
+    void Serve(int server_socket, std::function<void()> on_handover);
+
+    /**
+     * Whether socket was handed over to successor
+     */
+    bool HandedOver() const { return _handed_over.load(); }
+
+    /**
+     * Lets successor go on with storage, call once storage is stopped and destroyed
+     */
+    void Release();
+
+private:
+    /**
+     * Runs in background thread, hands socket over to the first successor that confirms it
+     */
+    void OnRun(int server_socket, std::function<void()> on_handover);
+
+    std::string _path;
+
+    // Unix socket successors connect to, and eventfd waking the thread that serves it
+    int _listener;
+    int _event_fd;
+    std::thread _thread;
+
+    // Channels to processes socket was taken over from and handed over to, -1 if there is none
+    int _predecessor;
+    int _successor;
+
+    std::atomic<bool> _handed_over;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_HANDOVER_H
@@ -0,0 +1,75 @@
+#ifndef AFINA_NETWORK_OUTPUT_LIMITS_H
+#define AFINA_NETWORK_OUTPUT_LIMITS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <afina/metrics/Metrics.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Memory budget of responses waiting to be sent
+ * Connection that has more than connection_limit bytes of responses unsent, or any unsent bytes while all
+ * connections of the server together have more than total_limit, stops reading requests until client
+ * takes enough of them. Reading resumes once connection's backlog falls to half of its limit and the total
+ * is back under its limit, or once connection sent everything: that one can't be the reason of the pressure
+ * and has to be let go, or it would never get an event again.
+ *
+ * Connections account bytes once per read and write, not per response, so that workers touch shared total
+ * as rarely as they make syscalls
+ */
+class OutputLimits {
+public:
+    OutputLimits(std::size_t connection_limit, std::size_t total_limit)
+        : _connection_limit(connection_limit), _total_limit(total_limit), _total(0) {}
+
+    /**
+     * Bytes of responses connection put into its queue
+     */
+    void Queued(std::size_t bytes) {
+        if (bytes > 0) {
+            _total.fetch_add(bytes, std::memory_order_relaxed);
+            Metrics::Add(Metrics::Id::kOutputBytes, bytes);
+        }
+    }
+
+    /**
+     * Bytes written to socket or dropped along with closed connection
+     */
+    void Sent(std::size_t bytes) {
+        if (bytes > 0) {
+            _total.fetch_sub(bytes, std::memory_order_relaxed);
+            Metrics::Add(Metrics::Id::kOutputBytes, -int64_t(bytes));
+        }
+    }
+
+    /**
+     * Whether connection with given unsent bytes has to stop reading requests
+     */
+    bool Exceeded(std::size_t pending) const {
+        return pending >= _connection_limit || (pending > 0 && Total() >= _total_limit);
+    }
+
+    /**
+     * Whether stopped connection with given unsent bytes could read requests again
+     */
+    bool Drained(std::size_t pending) const {
+        return pending == 0 || (pending <= _connection_limit / 2 && Total() < _total_limit);
+    }
+
+    std::size_t Total() const { return _total.load(std::memory_order_relaxed); }
+
+private:
+    const std::size_t _connection_limit;
+    const std::size_t _total_limit;
+
+    std::atomic<std::size_t> _total;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_OUTPUT_LIMITS_H
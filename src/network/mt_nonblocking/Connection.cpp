@@ -1,14 +1,34 @@
 #include "Connection.h"
 
 #include <cassert>
+#include <cerrno>
 #include <exception>
 #include <iostream>
 #include <unistd.h>
 
+#include <afina/metrics/Latency.h>
+#include <afina/trace/Trace.h>
+#include <afina/metrics/Metrics.h>
+
+#include "ServerImpl.h"
+
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+// See Connection.h
+Connection::~Connection() {
+    if (is_started) {
+        Metrics::Add(Metrics::Id::kCurrConnections, -1);
+    }
+
+    // Responses never sent leave the budget along with connection
+    _server->Limits().Sent(pending);
+    if (throttled) {
+        Metrics::Add(Metrics::Id::kThrottledConnections, -1);
+    }
+}
+
 // See Connection.h
 void Connection::Start() {
     //std::lock_guard<std::mutex> lock(con_mutex);
@@ -17,8 +37,11 @@ void Connection::Start() {
     }
     is_alive = true;
     is_started = true;
+    Metrics::Add(Metrics::Id::kTotalConnections);
+    Metrics::Add(Metrics::Id::kCurrConnections);
     read_begin = read_end = 0;
     shift = 0;
+    parse_time = 0;
     _event.events = EPOLLIN|EPOLLERR|EPOLLRDHUP;
     _event.data.fd = _socket;
     _event.data.ptr = this;
@@ -48,77 +71,119 @@ void Connection::Close() {
 void Connection::DoRead() {
     std::atomic_thread_fence(std::memory_order_acquire);
 
-    try {
-        if ((readed_bytes = read(_socket, read_buf + read_end, buf_size - read_end)) > 0) {
-            read_end += readed_bytes;
-            while (read_end - read_begin > 0) {
-                // There is no command yet
-                if (!command_to_execute) {
-                    std::size_t parsed = 0;
-                    if (parser.Parse(read_buf + read_begin, read_end - read_begin, parsed)) {
-                        // There is no command to be launched, continue to parse input stream
-                        // Here we are, current chunk finished some command, process it
-                        command_to_execute = parser.Build(arg_remains);
-                        if (arg_remains > 0) {
-                            arg_remains += 2;
-                        }
-                    }
+    if ((readed_bytes = read(_socket, read_buf + read_end, buf_size - read_end)) > 0) {
+        read_end += readed_bytes;
+        Metrics::Add(Metrics::Id::kBytesRead, readed_bytes);
+        Process();
+    } else if (readed_bytes == -1) {
+        is_alive.store(false, std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+}
 
-                    // Parsed might fails to consume any bytes from input stream. In real life that could happens,
-                    // for example, because we are working with UTF-16 chars and only 1 byte left in stream
-                    if (parsed == 0) {
-                        break;
-                    } else {
-                        read_begin += parsed;
+// See Connection.h
+void Connection::Process() {
+    OutputLimits &limits = _server->Limits();
+    std::size_t queued = pending;
+    try {
+        while (read_end - read_begin > 0 && !throttled) {
+            // There is no command yet
+            if (!command_to_execute) {
+                std::size_t parsed = 0;
+                uint64_t parse_start = Metrics::Now();
+                if (parser.Parse(read_buf + read_begin, read_end - read_begin, parsed)) {
+                    // There is no command to be launched, continue to parse input stream
+                    // Here we are, current chunk finished some command, process it
+                    command_to_execute = parser.Build(arg_remains);
+                    if (arg_remains > 0) {
+                        arg_remains += 2;
                     }
                 }
-                // There is command, but we still wait for argument to arrive...
-                if (command_to_execute && arg_remains > 0) {
-                    // There is some parsed command, and now we are reading argument
-                    std::size_t to_read = std::min(arg_remains, read_end - read_begin);
-                    argument_for_command.append(read_buf + read_begin, to_read);
-
-                    arg_remains -= to_read;
-                    read_begin += to_read;
-                }
-                // There are command & argument - RUN!
-                if (command_to_execute && arg_remains == 0) {
-                    std::string result;
-                    if (argument_for_command.size()) {
-                        argument_for_command.resize(argument_for_command.size() - 2);
-                    }
-                    command_to_execute->Execute(*pStorage, argument_for_command, result);
 
-                    // Put response in the queue
-                    result += "\r\n";
-                    responses.push_back(std::move(result));
-                    if (!(_event.events & EPOLLOUT)) {
-                        _event.events |= EPOLLOUT;
-                    }
+                parse_time += Metrics::Now() - parse_start;
 
-                    // Prepare for the next command
-                    command_to_execute.reset();
-                    argument_for_command.resize(0);
-                    parser.Reset();
+                // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+                // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+                if (parsed == 0) {
+                    break;
+                } else {
+                    read_begin += parsed;
                 }
             }
-            if (read_begin == read_end) {
-                read_begin = read_end = 0;
-            } else if (read_end == buf_size) {
-                std::memmove(read_buf, read_buf + read_begin, read_end - read_begin);
+            // There is command, but we still wait for argument to arrive...
+            if (command_to_execute && arg_remains > 0) {
+                // There is some parsed command, and now we are reading argument
+                std::size_t to_read = std::min(arg_remains, read_end - read_begin);
+                argument_for_command.append(read_buf + read_begin, to_read);
+
+                arg_remains -= to_read;
+                read_begin += to_read;
+            }
+            // There are command & argument - RUN!
+            if (command_to_execute && arg_remains == 0) {
+                std::string result = _server->AcquireBuffer();
+                if (argument_for_command.size()) {
+                    argument_for_command.resize(argument_for_command.size() - 2);
+                }
+                Metrics::Op op = Metrics::OpOf(parser.Name());
+                Trace::Request(op, parser.Keys(), argument_for_command.size());
+                Metrics::Record(op, Metrics::Stage::kParse, parse_time);
+                uint64_t execute_start = Metrics::Now();
+                command_to_execute->Execute(*pStorage, argument_for_command, result);
+                uint64_t ready = Metrics::Now();
+                Metrics::Record(op, Metrics::Stage::kExecute, ready - execute_start);
+
+                // Put response in the queue
+                result += "\r\n";
+                pending += result.size();
+                responses.push_back(std::move(result));
+                response_times.emplace_back(op, ready);
+                if (limits.Exceeded(pending)) {
+                    Throttle();
+                }
+                if (!(_event.events & EPOLLOUT)) {
+                    _event.events |= EPOLLOUT;
+                }
+
+                // Prepare for the next command
+                command_to_execute.reset();
+                argument_for_command.resize(0);
+                parser.Reset();
+                parse_time = 0;
             }
-        } else if (readed_bytes == -1){
-            is_alive.store(false, std::memory_order_relaxed);
         }
-        std::atomic_thread_fence(std::memory_order_release);
+        if (read_begin == read_end) {
+            read_begin = read_end = 0;
+        } else if (read_end == buf_size) {
+            std::memmove(read_buf, read_buf + read_begin, read_end - read_begin);
+            read_end -= read_begin;
+            read_begin = 0;
+        }
     } catch (std::runtime_error &ex) {
+        Metrics::Add(Metrics::Id::kProtocolErrors);
         responses.push_back("ERROR\r\n");
+        response_times.emplace_back(Metrics::Op::kOther, Metrics::Now());
+        pending += responses.back().size();
+        parse_time = 0;
         if (!(_event.events & EPOLLOUT)) {
             _event.events |= EPOLLOUT;
-            std::atomic_thread_fence(std::memory_order_release);
         }
     }
 
+    // Shared total is updated once per batch, so connection may overshoot the global limit by a batch
+    limits.Queued(pending - queued);
+    if (!throttled && limits.Exceeded(pending)) {
+        Throttle();
+    }
+}
+
+// See Connection.h
+void Connection::Throttle() {
+    throttled = true;
+    _event.events &= ~EPOLLIN;
+    Metrics::Add(Metrics::Id::kThrottledConnections);
+    Metrics::Add(Metrics::Id::kTotalThrottles);
 }
 
 // See Connection.h
@@ -147,24 +212,36 @@ void Connection::DoWrite() {
 
     int writed;
     if ((writed = writev(_socket, write_vec, write_vec_v)) > 0) {
+        Metrics::Add(Metrics::Id::kBytesWritten, writed);
+        pending -= writed;
+        _server->Limits().Sent(writed);
+        uint64_t now = Metrics::Now();
         size_t i = 0;
         while (i < write_vec_v && writed >= write_vec[i].iov_len) {
+            Metrics::Record(response_times.front().first, Metrics::Stage::kWrite, now - response_times.front().second);
+            response_times.pop_front();
             assert(responses.front().c_str() <= write_vec[i].iov_base &&
                    write_vec[i].iov_base < responses.front().c_str() + responses.front().size());
+            _server->ReleaseBuffer(std::move(responses.front()));
             responses.pop_front();
             writed -= write_vec[i].iov_len;
             i++;
         }
         shift = writed;
-    }  else if (writed < 0 && writed != EAGAIN){
+    } else if (writed < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
         is_alive.store(false, std::memory_order_relaxed);
     }
 
     if (responses.empty()) {
         _event.events &= ~EPOLLOUT;
     }
-    if (responses.size() <= N){
+
+    // Commands read while connection was stopped go first, they may stop it again
+    if (throttled && _server->Limits().Drained(pending)) {
+        throttled = false;
         _event.events |= EPOLLIN;
+        Metrics::Add(Metrics::Id::kThrottledConnections, -1);
+        Process();
     }
 
     std::atomic_thread_fence(std::memory_order_release);
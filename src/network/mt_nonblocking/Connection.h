@@ -10,21 +10,28 @@
 
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/metrics/Latency.h>
 #include <atomic>
 
+#include "network/OutputLimits.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+// Forward declaration, see ServerImpl.h
+class ServerImpl;
+
 class Connection {
 public:
-    Connection(int s, std::shared_ptr<Afina::Storage> ps)
-            : _socket(s), pStorage(ps), is_alive(false), is_started(false) {
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, ServerImpl *server)
+            : _socket(s), pStorage(ps), _server(server), is_alive(false), is_started(false), pending(0),
+              throttled(false) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
+    ~Connection();
 
     inline bool isAlive() const { return is_alive; }
 
@@ -37,6 +44,16 @@ protected:
     void DoRead();
     void DoWrite();
 
+    /**
+     * Executes commands read so far until input runs out or output limits stop connection
+     */
+    void Process();
+
+    /**
+     * Stops reading requests until client takes responses, see OutputLimits
+     */
+    void Throttle();
+
 private:
     friend class Worker;
     friend class ServerImpl;
@@ -55,15 +72,29 @@ private:
     std::unique_ptr<Execute::Command> command_to_execute;
     int readed_bytes;
 
+    // Parser time spent on the current command so far
+    uint64_t parse_time;
+
     std::deque<std::string> responses;
     size_t shift;
 
+    // Command type and the moment response got ready for each element of responses, to measure write latency
+    std::deque<std::pair<Metrics::Op, uint64_t>> response_times;
+
     bool is_started;
     std::atomic<bool> is_alive;
     std::shared_ptr<Afina::Storage> pStorage;
 
+    // Owner of statistics and response buffers shared by all connections
+    ServerImpl *_server;
+
     //std::mutex con_mutex;
-    size_t N = 512;
+
+    // Bytes of responses not sent yet, accounted in the server's OutputLimits
+    std::size_t pending;
+
+    // Connection doesn't read requests until responses drain, input read already waits in read_buf
+    bool throttled;
 };
 
 } // namespace MTnonblock
@@ -19,7 +19,10 @@
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
+#include <afina/logging/Log.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
 
 #include "Connection.h"
 #include "Utils.h"
@@ -29,6 +32,14 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+namespace {
+
+// Response buffers cached per thread, and the largest buffer worth keeping
+const std::size_t max_pooled_buffers = 256;
+const std::size_t max_pooled_capacity = 4096;
+
+} // namespace
+
 // See Server.h
 ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
 
@@ -41,7 +52,7 @@ ServerImpl::~ServerImpl() {
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
     _logger = pLogging->select("network");
-    _logger->info("Start mt_nonblocking network service");
+    AFINA_LOG_INFO(_logger, "Start mt_nonblocking network service");
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -50,34 +61,38 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    // Socket of the previous process if it is taken over, see Handover.h
+    _server_socket = TakeInherited();
     if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
+        // Create server socket
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+        }
 
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+        }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+        }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        }
     }
+    make_socket_non_blocking(_server_socket);
 
     // Start IO workers
     _data_epoll_fd = epoll_create1(0);
@@ -97,6 +112,8 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Failed to add eventfd descriptor to epoll");
     }
 
+    _limits.reset(new OutputLimits(connection_output_limit, total_output_limit));
+    _served_at_start = Collect();
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
         _workers.emplace_back(pStorage, pLogging, this);
@@ -112,7 +129,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
 
 // See Server.h
 void ServerImpl::Stop() {
-    _logger->warn("Stop network service");
+    AFINA_LOG_WARN(_logger, "Stop network service");
     // Said workers to stop
     for (auto &w : _workers) {
         w.Stop();
@@ -127,7 +144,7 @@ void ServerImpl::Stop() {
             shutdown(connection->_socket, SHUT_RD);
         }
     }
-    shutdown(_server_socket, SHUT_RDWR);
+    // Acceptors are woken up by eventfd too, listening socket is left intact
 }
 
 // See Server.h
@@ -141,6 +158,12 @@ void ServerImpl::Join() {
         w.Join();
     }
     _workers.clear();
+
+    Served served = Collect();
+    AFINA_LOG_INFO(_logger, "Served {} connections, {} commands, {} errors, read {} bytes, written {} bytes",
+                   served.connections - _served_at_start.connections, served.commands - _served_at_start.commands,
+                   served.errors - _served_at_start.errors, served.bytes_read - _served_at_start.bytes_read,
+                   served.bytes_written - _served_at_start.bytes_written);
     {
         std::lock_guard<std::mutex> lock(m);
         for (auto connection : connections) {
@@ -154,7 +177,7 @@ void ServerImpl::Join() {
 
 // See ServerImpl.h
 void ServerImpl::OnRun() {
-    _logger->info("Start acceptor");
+    AFINA_LOG_INFO(_logger, "Start acceptor");
     int acceptor_epoll = epoll_create1(0);
     if (acceptor_epoll == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
@@ -178,12 +201,12 @@ void ServerImpl::OnRun() {
     std::array<struct epoll_event, 64> mod_list{};
     while (run) {
         int nmod = epoll_wait(acceptor_epoll, &mod_list[0], mod_list.size(), -1);
-        _logger->debug("Acceptor wokeup: {} events", nmod);
+        AFINA_LOG_DEBUG(_logger, "Acceptor wokeup: {} events", nmod);
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
             if (current_event.data.fd == _event_fd) {
-                _logger->debug("Break acceptor due to stop signal");
+                AFINA_LOG_DEBUG(_logger, "Break acceptor due to stop signal");
                 run = false;
                 continue;
             }
@@ -199,16 +222,18 @@ void ServerImpl::OnRun() {
                     break;
                 }
 
-                // Print host and service info.
-                char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-                int retval = getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
-                                         NI_NUMERICHOST | NI_NUMERICSERV);
-                if (retval == 0) {
-                    _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
+                // Print host and service info, resolving address only if it is going to be logged
+                if (AFINA_LOG_ENABLED(_logger, spdlog::level::info)) {
+                    char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+                    if (getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                                    NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+                        AFINA_LOG_INFO(_logger, "Accepted connection on descriptor {} (host={}, port={})", infd, hbuf,
+                                       sbuf);
+                    }
                 }
 
                 // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd, pStorage);
+                Connection *pc = new Connection(infd, pStorage, this);
                 if (pc == nullptr) {
                     throw std::runtime_error("Failed to allocate connection");
                 }
@@ -219,7 +244,7 @@ void ServerImpl::OnRun() {
                     pc->_event.events |= EPOLLONESHOT;
                     int epoll_ctl_retval;
                     if ((epoll_ctl_retval = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
-                        _logger->debug("epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
+                        AFINA_LOG_DEBUG(_logger, "epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
                         pc->OnError();
                         delete pc;
                     }
@@ -230,7 +255,43 @@ void ServerImpl::OnRun() {
             }
         }
     }
-    _logger->warn("Acceptor stopped");
+    AFINA_LOG_WARN(_logger, "Acceptor stopped");
+}
+
+// See ServerImpl.h
+ServerImpl::Served ServerImpl::Collect() {
+    Served served;
+    served.connections = Metrics::Value(Metrics::Id::kTotalConnections);
+    served.errors = Metrics::Value(Metrics::Id::kProtocolErrors);
+    served.bytes_read = Metrics::Value(Metrics::Id::kBytesRead);
+    served.bytes_written = Metrics::Value(Metrics::Id::kBytesWritten);
+
+    // Every executed command has its latency recorded, so there is no separate counter to pay for
+    served.commands = 0;
+    for (std::size_t op = 0; op < static_cast<std::size_t>(Metrics::Op::kCount); op++) {
+        served.commands += Metrics::Latency(static_cast<Metrics::Op>(op), Metrics::Stage::kExecute).Count();
+    }
+    return served;
+}
+
+// See ServerImpl.h
+std::string ServerImpl::AcquireBuffer() {
+    std::string result;
+    auto &pool = _buffers.local();
+    if (!pool.empty()) {
+        result = std::move(pool.back());
+        pool.pop_back();
+        result.clear();
+    }
+    return result;
+}
+
+// See ServerImpl.h
+void ServerImpl::ReleaseBuffer(std::string &&buffer) {
+    auto &pool = _buffers.local();
+    if (pool.size() < max_pooled_buffers && buffer.capacity() <= max_pooled_capacity) {
+        pool.push_back(std::move(buffer));
+    }
 }
 
 void ServerImpl::delete_connection(Connection* conn){
@@ -1,11 +1,14 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 
+#include <memory>
 #include <thread>
 #include <vector>
 #include <set>
 #include <mutex>
 
+#include <afina/concurrency/ThreadLocal.h>
+#include <afina/logging/Log.h>
 #include <afina/network/Server.h>
 #include "Connection.h"
 
@@ -39,15 +42,33 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    int Socket() const override { return _server_socket; }
+
     void delete_connection(Connection * conn);
 
+    /**
+     * Empty string to build response in, reuses memory of responses sent before by the calling thread
+     */
+    std::string AcquireBuffer();
+
+    /**
+     * Gives memory of sent response back to the calling thread's pool
+     */
+    void ReleaseBuffer(std::string &&buffer);
+
+    /**
+     * Budget of unsent responses of all connections, see Server::Limit
+     */
+    OutputLimits &Limits() { return *_limits; }
+
 protected:
     void OnRun();
     void OnNewConnection();
 
 private:
     // logger to use
-    std::shared_ptr<spdlog::logger> _logger;
+    Logging::Handle _logger;
 
     // Port to listen for new connections, permits access only from
     // inside of accept_thread
@@ -72,6 +93,24 @@ private:
 
     std::set<Connection*> connections;
     std::mutex m;
+
+    /**
+     * Process wide metrics the shutdown log line reports, taken at Start to log what this server served
+     */
+    struct Served {
+        int64_t connections;
+        int64_t commands;
+        int64_t errors;
+        int64_t bytes_read;
+        int64_t bytes_written;
+    };
+    static Served Collect();
+    Served _served_at_start;
+
+    // Strings of sent responses, each worker thread has its own pool so no locking is needed
+    Concurrency::ThreadLocal<std::vector<std::string>> _buffers;
+
+    std::unique_ptr<OutputLimits> _limits;
 };
 
 } // namespace MTnonblock
@@ -11,6 +11,7 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/logging/Log.h>
 #include <afina/logging/Service.h>
 #include "Connection.h"
 #include "Utils.h"
@@ -70,7 +71,7 @@ void Worker::Join() {
 // See Worker.h
 void Worker::OnRun() {
     assert(_epoll_fd >= 0);
-    _logger->trace("OnRun");
+    AFINA_LOG_TRACE(_logger, "OnRun");
 
     // Process connection events
     //
@@ -80,7 +81,7 @@ void Worker::OnRun() {
     std::array<struct epoll_event, 64> mod_list;
     while (isRunning) {
         int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), timeout);
-        _logger->debug("Worker wokeup: {} events", nmod);
+        AFINA_LOG_DEBUG(_logger, "Worker wokeup: {} events", nmod);
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
@@ -95,19 +96,19 @@ void Worker::OnRun() {
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                _logger->debug("Got EPOLLERR or EPOLLHUP, value of returned events: {}", current_event.events);
+                AFINA_LOG_DEBUG(_logger, "Got EPOLLERR or EPOLLHUP, value of returned events: {}", current_event.events);
                 pconn->OnError();
             } else if (current_event.events & EPOLLRDHUP) {
-                _logger->debug("Got EPOLLRDHUP, value of returned events: {}", current_event.events);
+                AFINA_LOG_DEBUG(_logger, "Got EPOLLRDHUP, value of returned events: {}", current_event.events);
                 pconn->OnClose();
             } else {
                 // Depends on what connection wants...
                 if (current_event.events & EPOLLIN) {
-                    _logger->trace("Got EPOLLIN");
+                    AFINA_LOG_TRACE(_logger, "Got EPOLLIN");
                     pconn->DoRead();
                 }
                 if (current_event.events & EPOLLOUT) {
-                    _logger->trace("Got EPOLLOUT");
+                    AFINA_LOG_TRACE(_logger, "Got EPOLLOUT");
                     pconn->DoWrite();
                 }
             }
@@ -117,7 +118,7 @@ void Worker::OnRun() {
                 pconn->_event.events |= EPOLLONESHOT;
                 int epoll_ctl_retval;
                 if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
+                    AFINA_LOG_DEBUG(_logger, "epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
                     pconn->OnError();
                     _server->delete_connection(pconn);
 
@@ -133,7 +134,7 @@ void Worker::OnRun() {
         }
         // TODO: Select timeout...
     }
-    _logger->warn("Worker stopped");
+    AFINA_LOG_WARN(_logger, "Worker stopped");
 }
 
 } // namespace MTnonblock
@@ -73,7 +73,7 @@ private:
     std::shared_ptr<Afina::Logging::Service> _pLogging;
 
     // Logger to be used
-    std::shared_ptr<spdlog::logger> _logger;
+    Logging::Handle _logger;
 
     // Flag signals that thread should continue to operate
     std::atomic<bool> isRunning;
@@ -11,6 +11,7 @@
 #include <netinet/in.h>
 #include <pthread.h>
 #include <signal.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -20,8 +21,13 @@
 #include <afina/Storage.h>
 #include <afina/concurrency/Executor.h>
 #include <afina/execute/Command.h>
+#include <afina/logging/Log.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Latency.h>
+#include <afina/trace/Trace.h>
+#include <afina/metrics/Metrics.h>
 
+#include "network/Accept.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -37,7 +43,7 @@ ServerImpl::~ServerImpl() {}
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     _logger = pLogging->select("network");
-    _logger->info("Start mt_blocking network service");
+    AFINA_LOG_INFO(_logger, "Start mt_blocking network service");
 
     max_workers = n_workers;
 
@@ -48,31 +54,42 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    // Socket of the previous process if it is taken over, see Handover.h
+    _server_socket = TakeInherited();
     if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket");
-    }
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket");
+        }
 
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed");
-    }
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed");
+        }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed");
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed");
+        }
+
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed");
+        }
     }
+    MakeNonBlocking(_server_socket);
 
-    if (listen(_server_socket, 5) == -1) {
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
         close(_server_socket);
-        throw std::runtime_error("Socket listen() failed");
+        throw std::runtime_error("Failed to create eventfd: " + std::string(strerror(errno)));
     }
 
     running.store(true);
@@ -82,32 +99,45 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 // See Server.h
 void ServerImpl::Stop() {
     running.store(false);
-    shutdown(_server_socket, SHUT_RDWR);
+
+    // Wakeup acceptor sleeping in poll, listening socket is left intact
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup acceptor");
+    }
 }
 
 // See Server.h
 void ServerImpl::Join() {
     assert(_thread.joinable());
     _thread.join();
+    close(_event_fd);
 }
 
 // See Server.h
 void ServerImpl::OnRun() {
-    Afina::Concurrency::Executor executor(1, max_workers, 3, std::chrono::milliseconds(5000));
+    Afina::Concurrency::Executor executor(1, max_workers, 3, std::chrono::milliseconds(5000),
+                                          Afina::Concurrency::Executor::Mode::kWorkStealing);
     executor.Start();
     while (running.load()) {
-        _logger->debug("waiting for connection...");
+        AFINA_LOG_DEBUG(_logger, "waiting for connection...");
+
+        // Listening socket is non blocking, as it could be shared with another process, so wait for
+        // connection first
+        if (!WaitConnection(_server_socket, _event_fd)) {
+            break;
+        }
 
-        // The call to accept() blocks until the incoming connection arrives
         int client_socket;
         struct sockaddr client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
         if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
             continue;
         }
+        Metrics::Add(Metrics::Id::kTotalConnections);
+        Metrics::Add(Metrics::Id::kCurrConnections);
 
         // Got new connection
-        if (_logger->should_log(spdlog::level::debug)) {
+        if (AFINA_LOG_ENABLED(_logger, spdlog::level::debug)) {
             std::string host = "unknown", port = "-1";
 
             char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
@@ -116,7 +146,7 @@ void ServerImpl::OnRun() {
                 host = hbuf;
                 port = sbuf;
             }
-            _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
+            AFINA_LOG_DEBUG(_logger, "Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
         // Configure read timeout
@@ -133,6 +163,7 @@ void ServerImpl::OnRun() {
         }
         if (!executor.Execute(&ServerImpl::Worker, this, client_socket)) {
             close(client_socket);
+            Metrics::Add(Metrics::Id::kCurrConnections, -1);
             std::unique_lock<std::mutex> _lock(sockets_mutex);
             _sockets.erase(client_socket);
         }
@@ -147,7 +178,7 @@ void ServerImpl::OnRun() {
         }
     }
     executor.Stop(true);
-    _logger->warn("Network stopped");
+    AFINA_LOG_WARN(_logger, "Network stopped");
 }
 
 void ServerImpl::Worker(int client_socket) {
@@ -160,6 +191,7 @@ void ServerImpl::Worker(int client_socket) {
     Protocol::Parser parser;
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
+    uint64_t parse_time = 0;
     bool stopped = false;
 
     // Process connection:
@@ -172,7 +204,8 @@ void ServerImpl::Worker(int client_socket) {
         char client_buffer[4096] = {};
         while ((readed_bytes = read(client_socket, client_buffer + all_readed_bytes,
                                     sizeof(client_buffer) - all_readed_bytes)) > 0) {
-            _logger->debug("Got {} bytes from socket", readed_bytes);
+            AFINA_LOG_DEBUG(_logger, "Got {} bytes from socket", readed_bytes);
+        Metrics::Add(Metrics::Id::kBytesRead, readed_bytes);
             all_readed_bytes += readed_bytes;
 
             // Single block of data readed from the socket could trigger inside actions a multiple times,
@@ -180,20 +213,23 @@ void ServerImpl::Worker(int client_socket) {
             // - read#0: [<command1 start>]
             // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
             while (all_readed_bytes > 0) {
-                _logger->debug("Process {} bytes", all_readed_bytes);
+                AFINA_LOG_DEBUG(_logger, "Process {} bytes", all_readed_bytes);
                 // There is no command yet
                 if (!command_to_execute) {
                     std::size_t parsed = 0;
+                    uint64_t parse_start = Metrics::Now();
                     if (parser.Parse(client_buffer, all_readed_bytes, parsed)) {
                         // There is no command to be launched, continue to parse input stream
                         // Here we are, current chunk finished some command, process it
-                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                        AFINA_LOG_DEBUG(_logger, "Found new command: {} in {} bytes", parser.Name(), parsed);
                         command_to_execute = parser.Build(arg_remains);
                         if (arg_remains > 0) {
                             arg_remains += 2;
                         }
                     }
 
+                    parse_time += Metrics::Now() - parse_start;
+
                     // Parsed might fails to consume any bytes from input stream. In real life that could happens,
                     // for example, because we are working with UTF-16 chars and only 1 byte left in stream
                     if (parsed == 0) {
@@ -206,7 +242,7 @@ void ServerImpl::Worker(int client_socket) {
 
                 // There is command, but we still wait for argument to arrive...
                 if (command_to_execute && arg_remains > 0) {
-                    _logger->debug("Fill argument: {} bytes of {}", all_readed_bytes, arg_remains);
+                    AFINA_LOG_DEBUG(_logger, "Fill argument: {} bytes of {}", all_readed_bytes, arg_remains);
                     // There is some parsed command, and now we are reading argument
                     std::size_t to_read = std::min(arg_remains, std::size_t(all_readed_bytes));
                     argument_for_command.append(client_buffer, to_read);
@@ -218,20 +254,28 @@ void ServerImpl::Worker(int client_socket) {
 
                 // There are command & argument - RUN!
                 if (command_to_execute && arg_remains == 0) {
-                    _logger->debug("Start command execution");
+                    AFINA_LOG_DEBUG(_logger, "Start command execution");
 
                     if (argument_for_command.size() > 0) {
                         assert(argument_for_command.size() > 2);
                         argument_for_command.resize(argument_for_command.size() - 2);
                     }
                     std::string result;
+                    Metrics::Op op = Metrics::OpOf(parser.Name());
+                    Trace::Request(op, parser.Keys(), argument_for_command.size());
+                    Metrics::Record(op, Metrics::Stage::kParse, parse_time);
+                    uint64_t execute_start = Metrics::Now();
                     command_to_execute->Execute(*pStorage, argument_for_command, result);
+                    uint64_t ready = Metrics::Now();
+                    Metrics::Record(op, Metrics::Stage::kExecute, ready - execute_start);
 
                     // Send response
                     result += "\r\n";
                     if (send(client_socket, result.data(), result.size(), 0) <= 0) {
                         throw std::runtime_error("Failed to send response");
                     }
+                    Metrics::Add(Metrics::Id::kBytesWritten, result.size());
+                    Metrics::Record(op, Metrics::Stage::kWrite, Metrics::Now() - ready);
 
                     // Check whether network is still running
                     if (!running.load()) {
@@ -243,6 +287,7 @@ void ServerImpl::Worker(int client_socket) {
                     command_to_execute.reset();
                     argument_for_command.resize(0);
                     parser.Reset();
+                    parse_time = 0;
                 }
             } // while (all_readed_bytes > 0)
             if (stopped) {
@@ -251,20 +296,21 @@ void ServerImpl::Worker(int client_socket) {
         }
 
         if (stopped) {
-            _logger->debug("Closing connection, because server is stopped");
+            AFINA_LOG_DEBUG(_logger, "Closing connection, because server is stopped");
         } else if (readed_bytes == 0) {
-            _logger->debug("Connection closed");
+            AFINA_LOG_DEBUG(_logger, "Connection closed");
         } else {
             throw std::runtime_error(std::string(strerror(errno)));
         }
     } catch (std::runtime_error &ex) {
-        _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+        AFINA_LOG_ERROR(_logger, "Failed to process connection on descriptor {}: {}", client_socket, ex.what());
     }
 
     // We are done with this connection
     std::unique_lock<std::mutex> _lock(sockets_mutex);
     close(client_socket);
     _sockets.erase(client_socket);
+    Metrics::Add(Metrics::Id::kCurrConnections, -1);
 }
 
 } // namespace MTthreadpool
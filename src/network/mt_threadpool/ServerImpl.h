@@ -7,6 +7,7 @@
 #include <thread>
 #include <unordered_set>
 
+#include <afina/logging/Log.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -35,6 +36,9 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    int Socket() const override { return _server_socket; }
+
 protected:
     /**
      * Method is running in the connection acceptor thread
@@ -45,7 +49,7 @@ protected:
 
 private:
     // Logger instance
-    std::shared_ptr<spdlog::logger> _logger;
+    Logging::Handle _logger;
 
     // Atomic flag to notify threads when it is time to stop. Note that
     // flag must be atomic in order to safely publish changes cross thread
@@ -55,6 +59,9 @@ private:
     // Server socket to accept connections on
     int _server_socket;
 
+    // Wakes acceptor up once server stops
+    int _event_fd;
+
     // Thread to run network on
     std::thread _thread;
 
@@ -11,6 +11,7 @@
 #include <netinet/in.h>
 #include <pthread.h>
 #include <signal.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -19,8 +20,13 @@
 
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/logging/Log.h>
 #include <afina/logging/Service.h>
+#include <afina/metrics/Latency.h>
+#include <afina/trace/Trace.h>
+#include <afina/metrics/Metrics.h>
 
+#include "network/Accept.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -36,7 +42,7 @@ ServerImpl::~ServerImpl() {}
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     _logger = pLogging->select("network");
-    _logger->info("Start st_blocking network service");
+    AFINA_LOG_INFO(_logger, "Start st_blocking network service");
 
     // If a client closes a connection, this will generally produce a SIGPIPE
     // signal that will kill the process. We want to ignore this signal, so send()
@@ -57,48 +63,59 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     // };
     //
     // Note we need to convert the port to network order
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    // Arguments are:
-    // - Family: IPv4
-    // - Type: Full-duplex stream (reliable)
-    // - Protocol: TCP
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    // Socket of the previous process if it is taken over, see Handover.h
+    _server_socket = TakeInherited();
     if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket");
-    }
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        // Arguments are:
+        // - Family: IPv4
+        // - Type: Full-duplex stream (reliable)
+        // - Protocol: TCP
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket");
+        }
 
-    // when the server closes the socket,the connection must stay in the TIME_WAIT state to
-    // make sure the client received the acknowledgement that the connection has been terminated.
-    // During this time, this port is unavailable to other processes, unless we specify this option
-    //
-    // This option let kernel knows that we are OK that multiple threads/processes are listen on the
-    // same port. In a such case kernel will balance input traffic between all listeners (except those who
-    // are closed already)
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed");
-    }
+        // when the server closes the socket,the connection must stay in the TIME_WAIT state to
+        // make sure the client received the acknowledgement that the connection has been terminated.
+        // During this time, this port is unavailable to other processes, unless we specify this option
+        //
+        // This option let kernel knows that we are OK that multiple threads/processes are listen on the
+        // same port. In a such case kernel will balance input traffic between all listeners (except those who
+        // are closed already)
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed");
+        }
 
-    // Bind the socket to the address. In other words let kernel know data for what address we'd
-    // like to see in the socket
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed");
+        // Bind the socket to the address. In other words let kernel know data for what address we'd
+        // like to see in the socket
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed");
+        }
+
+        // Start listening. The second parameter is the "backlog", or the maximum number of
+        // connections that we'll allow to queue up. Note that listen() doesn't block until
+        // incoming connections arrive. It just makesthe OS aware that this process is willing
+        // to accept connections on this socket (which is bound to a specific IP and port)
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed");
+        }
     }
+    MakeNonBlocking(_server_socket);
 
-    // Start listening. The second parameter is the "backlog", or the maximum number of
-    // connections that we'll allow to queue up. Note that listen() doesn't block until
-    // incoming connections arrive. It just makesthe OS aware that this process is willing
-    // to accept connections on this socket (which is bound to a specific IP and port)
-    if (listen(_server_socket, 5) == -1) {
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
         close(_server_socket);
-        throw std::runtime_error("Socket listen() failed");
+        throw std::runtime_error("Failed to create eventfd: " + std::string(strerror(errno)));
     }
 
     running.store(true);
@@ -108,7 +125,11 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 // See Server.h
 void ServerImpl::Stop() {
     running.store(false);
-    shutdown(_server_socket, SHUT_RDWR);
+
+    // Wakeup acceptor sleeping in poll, listening socket is left intact
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup acceptor");
+    }
 }
 
 // See Server.h
@@ -116,6 +137,7 @@ void ServerImpl::Join() {
     assert(_thread.joinable());
     _thread.join();
     close(_server_socket);
+    close(_event_fd);
 }
 
 // See Server.h
@@ -129,19 +151,27 @@ void ServerImpl::OnRun() {
     Protocol::Parser parser;
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
+    uint64_t parse_time = 0;
     while (running.load()) {
-        _logger->debug("waiting for connection...");
+        AFINA_LOG_DEBUG(_logger, "waiting for connection...");
+
+        // Listening socket is non blocking, as it could be shared with another process, so wait for
+        // connection first
+        if (!WaitConnection(_server_socket, _event_fd)) {
+            break;
+        }
 
-        // The call to accept() blocks until the incoming connection arrives
         int client_socket;
         struct sockaddr client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
         if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
             continue;
         }
+        Metrics::Add(Metrics::Id::kTotalConnections);
+        Metrics::Add(Metrics::Id::kCurrConnections);
 
         // Got new connection
-        if (_logger->should_log(spdlog::level::debug)) {
+        if (AFINA_LOG_ENABLED(_logger, spdlog::level::debug)) {
             std::string host = "unknown", port = "-1";
 
             char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
@@ -150,7 +180,7 @@ void ServerImpl::OnRun() {
                 host = hbuf;
                 port = sbuf;
             }
-            _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
+            AFINA_LOG_DEBUG(_logger, "Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
         // Configure read timeout
@@ -169,27 +199,31 @@ void ServerImpl::OnRun() {
             int readed_bytes = -1;
             char client_buffer[4096];
             while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
-                _logger->debug("Got {} bytes from socket", readed_bytes);
+                AFINA_LOG_DEBUG(_logger, "Got {} bytes from socket", readed_bytes);
+                Metrics::Add(Metrics::Id::kBytesRead, readed_bytes);
 
                 // Single block of data readed from the socket could trigger inside actions a multiple times,
                 // for example:
                 // - read#0: [<command1 start>]
                 // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
                 while (readed_bytes > 0) {
-                    _logger->debug("Process {} bytes", readed_bytes);
+                    AFINA_LOG_DEBUG(_logger, "Process {} bytes", readed_bytes);
                     // There is no command yet
                     if (!command_to_execute) {
                         std::size_t parsed = 0;
+                        uint64_t parse_start = Metrics::Now();
                         if (parser.Parse(client_buffer, readed_bytes, parsed)) {
                             // There is no command to be launched, continue to parse input stream
                             // Here we are, current chunk finished some command, process it
-                            _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                            AFINA_LOG_DEBUG(_logger, "Found new command: {} in {} bytes", parser.Name(), parsed);
                             command_to_execute = parser.Build(arg_remains);
                             if (arg_remains > 0) {
                                 arg_remains += 2;
                             }
                         }
 
+                        parse_time += Metrics::Now() - parse_start;
+
                         // Parsed might fails to consume any bytes from input stream. In real life that could happens,
                         // for example, because we are working with UTF-16 chars and only 1 byte left in stream
                         if (parsed == 0) {
@@ -202,7 +236,7 @@ void ServerImpl::OnRun() {
 
                     // There is command, but we still wait for argument to arrive...
                     if (command_to_execute && arg_remains > 0) {
-                        _logger->debug("Fill argument: {} bytes of {}", readed_bytes, arg_remains);
+                        AFINA_LOG_DEBUG(_logger, "Fill argument: {} bytes of {}", readed_bytes, arg_remains);
                         // There is some parsed command, and now we are reading argument
                         std::size_t to_read = std::min(arg_remains, std::size_t(readed_bytes));
                         argument_for_command.append(client_buffer, to_read);
@@ -214,48 +248,59 @@ void ServerImpl::OnRun() {
 
                     // Thre is command & argument - RUN!
                     if (command_to_execute && arg_remains == 0) {
-                        _logger->debug("Start command execution");
+                        AFINA_LOG_DEBUG(_logger, "Start command execution");
 
                         std::string result;
                         if (argument_for_command.size()) {
                             argument_for_command.resize(argument_for_command.size() - 2);
                         }
+                        Metrics::Op op = Metrics::OpOf(parser.Name());
+                        Trace::Request(op, parser.Keys(), argument_for_command.size());
+                        Metrics::Record(op, Metrics::Stage::kParse, parse_time);
+                        uint64_t execute_start = Metrics::Now();
                         command_to_execute->Execute(*pStorage, argument_for_command, result);
+                        uint64_t ready = Metrics::Now();
+                        Metrics::Record(op, Metrics::Stage::kExecute, ready - execute_start);
 
                         // Send response
                         result += "\r\n";
                         if (send(client_socket, result.data(), result.size(), 0) <= 0) {
                             throw std::runtime_error("Failed to send response");
                         }
+                        Metrics::Add(Metrics::Id::kBytesWritten, result.size());
+                        Metrics::Record(op, Metrics::Stage::kWrite, Metrics::Now() - ready);
 
                         // Prepare for the next command
                         command_to_execute.reset();
                         argument_for_command.resize(0);
                         parser.Reset();
+                        parse_time = 0;
                     }
                 } // while (readed_bytes)
             }
 
             if (readed_bytes == 0) {
-                _logger->debug("Connection closed");
+                AFINA_LOG_DEBUG(_logger, "Connection closed");
             } else {
                 throw std::runtime_error(std::string(strerror(errno)));
             }
         } catch (std::runtime_error &ex) {
-            _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+            AFINA_LOG_ERROR(_logger, "Failed to process connection on descriptor {}: {}", client_socket, ex.what());
         }
 
         // We are done with this connection
         close(client_socket);
+        Metrics::Add(Metrics::Id::kCurrConnections, -1);
 
         // Prepare for the next command: just in case if connection was closed in the middle of executing something
         command_to_execute.reset();
         argument_for_command.resize(0);
         parser.Reset();
+        parse_time = 0;
     }
 
     // Cleanup on exit...
-    _logger->warn("Network stopped");
+    AFINA_LOG_WARN(_logger, "Network stopped");
 }
 
 } // namespace STblocking
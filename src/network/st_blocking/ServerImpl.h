@@ -4,6 +4,7 @@
 #include <atomic>
 #include <thread>
 
+#include <afina/logging/Log.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -32,6 +33,9 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    int Socket() const override { return _server_socket; }
+
 protected:
     /**
      * Method is running in the connection acceptor thread
@@ -40,7 +44,7 @@ protected:
 
 private:
     // Logger instance
-    std::shared_ptr<spdlog::logger> _logger;
+    Logging::Handle _logger;
 
     // Atomic flag to notify threads when it is time to stop. Note that
     // flag must be atomic in order to safely publisj changes cross thread
@@ -50,6 +54,9 @@ private:
     // Server socket to accept connections on
     int _server_socket;
 
+    // Wakes acceptor up once server stops
+    int _event_fd;
+
     // Thread to run network on
     std::thread _thread;
 };
@@ -19,6 +19,7 @@
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
+#include <afina/logging/Log.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -37,7 +38,7 @@ ServerImpl::~ServerImpl() {}
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
     _logger = pLogging->select("network");
-    _logger->info("Start st_nonblocking network service");
+    AFINA_LOG_INFO(_logger, "Start st_nonblocking network service");
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -46,34 +47,38 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    // Socket of the previous process if it is taken over, see Handover.h
+    _server_socket = TakeInherited();
     if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
+        // Create server socket
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+        }
 
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+        }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+        }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        }
     }
+    make_socket_non_blocking(_server_socket);
 
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
@@ -85,7 +90,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
 
 // See Server.h
 void ServerImpl::Stop() {
-    _logger->warn("Stop network service");
+    AFINA_LOG_WARN(_logger, "Stop network service");
 
     // Wakeup threads that are sleep on epoll_wait
     if (eventfd_write(_event_fd, 1)) {
@@ -101,7 +106,7 @@ void ServerImpl::Join() {
 
 // See ServerImpl.h
 void ServerImpl::OnRun() {
-    _logger->info("Start acceptor");
+    AFINA_LOG_INFO(_logger, "Start acceptor");
     int epoll_descr = epoll_create1(0);
     if (epoll_descr == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
@@ -125,12 +130,12 @@ void ServerImpl::OnRun() {
     std::array<struct epoll_event, 64> mod_list;
     while (run) {
         int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), -1);
-        _logger->debug("Acceptor wokeup: {} events", nmod);
+        AFINA_LOG_DEBUG(_logger, "Acceptor wokeup: {} events", nmod);
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
             if (current_event.data.fd == _event_fd) {
-                _logger->debug("Break acceptor due to stop signal");
+                AFINA_LOG_DEBUG(_logger, "Break acceptor due to stop signal");
                 run = false;
                 continue;
             } else if (current_event.data.fd == _server_socket) {
@@ -159,7 +164,7 @@ void ServerImpl::OnRun() {
             // Does it alive?
             if (!pc->isAlive()) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
+                    AFINA_LOG_ERROR(_logger, "Failed to delete connection from epoll");
                 }
 
                 close(pc->_socket);
@@ -168,7 +173,7 @@ void ServerImpl::OnRun() {
                 delete pc;
             } else if (pc->_event.events != old_mask) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to change connection event mask");
+                    AFINA_LOG_ERROR(_logger, "Failed to change connection event mask");
 
                     close(pc->_socket);
                     pc->OnClose();
@@ -178,7 +183,7 @@ void ServerImpl::OnRun() {
             }
         }
     }
-    _logger->warn("Acceptor stopped");
+    AFINA_LOG_WARN(_logger, "Acceptor stopped");
 }
 
 void ServerImpl::OnNewConnection(int epoll_descr) {
@@ -193,17 +198,18 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
             if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
                 break; // We have processed all incoming connections.
             } else {
-                _logger->error("Failed to accept socket");
+                AFINA_LOG_ERROR(_logger, "Failed to accept socket");
                 break;
             }
         }
 
-        // Print host and service info.
-        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-        int retval =
-            getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
-        if (retval == 0) {
-            _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
+        // Print host and service info, resolving address only if it is going to be logged
+        if (AFINA_LOG_ENABLED(_logger, spdlog::level::info)) {
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            if (getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV) ==
+                0) {
+                AFINA_LOG_INFO(_logger, "Accepted connection on descriptor {} (host={}, port={})", infd, hbuf, sbuf);
+            }
         }
 
         // Register the new FD to be monitored by epoll.
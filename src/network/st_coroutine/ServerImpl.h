@@ -4,6 +4,7 @@
 #include <thread>
 #include <vector>
 
+#include <afina/logging/Log.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -35,13 +36,16 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    int Socket() const override { return _server_socket; }
+
 protected:
     void OnRun();
     void OnNewConnection(int);
 
 private:
     // logger to use
-    std::shared_ptr<spdlog::logger> _logger;
+    Logging::Handle _logger;
 
     // Port to listen for new connections, permits access only from
     // inside of accept_thread
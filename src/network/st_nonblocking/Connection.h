@@ -10,7 +10,9 @@
 
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/metrics/Latency.h>
 
+#include "network/OutputLimits.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -19,10 +21,12 @@ namespace STnonblock {
 
 class Connection {
 public:
-    Connection(int s, std::shared_ptr<Afina::Storage> ps) : _socket(s), pStorage(ps) {
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, OutputLimits *limits)
+        : _socket(s), pStorage(ps), _limits(limits), pending(0), throttled(false) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
+    ~Connection();
 
     inline bool isAlive() const { return is_alive; }
 
@@ -35,6 +39,16 @@ protected:
     void DoRead();
     void DoWrite();
 
+    /**
+     * Executes commands read so far until input runs out or output limits stop connection
+     */
+    void Process();
+
+    /**
+     * Stops reading requests until client takes responses, see OutputLimits
+     */
+    void Throttle();
+
 private:
     friend class ServerImpl;
 
@@ -52,14 +66,25 @@ private:
     std::unique_ptr<Execute::Command> command_to_execute;
     int readed_bytes;
 
+    // Parser time spent on the current command so far
+    uint64_t parse_time;
+
     std::deque<std::string> responses;
     size_t shift;
 
+    // Command type and the moment response got ready for each element of responses, to measure write latency
+    std::deque<std::pair<Metrics::Op, uint64_t>> response_times;
+
     bool is_alive;
 
     std::shared_ptr<Afina::Storage> pStorage;
 
-    size_t N = 512;
+    // Server wide budget of unsent responses, pending bytes of this connection are accounted in it
+    OutputLimits *_limits;
+    std::size_t pending;
+
+    // Connection doesn't read requests until responses drain, input read already waits in read_buf
+    bool throttled;
 };
 
 } // namespace STnonblock
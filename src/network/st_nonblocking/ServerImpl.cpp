@@ -19,6 +19,7 @@
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
+#include <afina/logging/Log.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -41,10 +42,7 @@ ServerImpl::~ServerImpl() {
 
 // See Server.h
 void ServerImpl::Stop() {
-    _logger->warn("Stop network service");
-    for (auto c : connection_storage){
-        shutdown(c->_socket, SHUT_WR);
-    }
+    AFINA_LOG_WARN(_logger, "Stop network service");
     // Wakeup threads that are sleep on epoll_wait
     if (eventfd_write(_event_fd, 1)) {
         throw std::runtime_error("Failed to wakeup workers");
@@ -55,7 +53,7 @@ void ServerImpl::Stop() {
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
     _logger = pLogging->select("network");
-    _logger->info("Start st_nonblocking network service");
+    AFINA_LOG_INFO(_logger, "Start st_nonblocking network service");
 
     sigset_t sig_mask;
     sigemptyset(&sig_mask);
@@ -64,40 +62,45 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    // Socket of the previous process if it is taken over, see Handover.h
+    _server_socket = TakeInherited();
     if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
+        // Create server socket
+        struct sockaddr_in server_addr;
+        std::memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;         // IPv4
+        server_addr.sin_port = htons(port);       // TCP port number
+        server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+        _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (_server_socket == -1) {
+            throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+        }
 
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
+        int opts = 1;
+        if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+        }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
+        if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+        }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        if (listen(_server_socket, 5) == -1) {
+            close(_server_socket);
+            throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        }
     }
+    make_socket_non_blocking(_server_socket);
 
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
+    _limits.reset(new OutputLimits(connection_output_limit, total_output_limit));
     _work_thread = std::thread(&ServerImpl::OnRun, this);
 }
 
@@ -109,7 +112,7 @@ void ServerImpl::Join() {
 
 // See ServerImpl.h
 void ServerImpl::OnRun() {
-    _logger->info("Start acceptor");
+    AFINA_LOG_INFO(_logger, "Start acceptor");
     int epoll_descr = epoll_create1(0);
     if (epoll_descr == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
@@ -133,12 +136,16 @@ void ServerImpl::OnRun() {
     std::array<struct epoll_event, 64> mod_list{};
     while (run) {
         int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), -1);
-        _logger->debug("Acceptor wokeup: {} events", nmod);
+        AFINA_LOG_DEBUG(_logger, "Acceptor wokeup: {} events", nmod);
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
             if (current_event.data.fd == _event_fd) {
-                _logger->debug("Break acceptor due to stop signal");
+                AFINA_LOG_DEBUG(_logger, "Break acceptor due to stop signal");
+                // Connections belong to this thread, Stop must not walk them while they change
+                for (auto c : connection_storage) {
+                    shutdown(c->_socket, SHUT_WR);
+                }
                 run = false;
                 continue;
             } else if (current_event.data.fd == _server_socket) {
@@ -151,18 +158,19 @@ void ServerImpl::OnRun() {
 
             auto old_mask = pc->_event.events;
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                _logger->error("Error on socket {}", pc->_socket);
+                AFINA_LOG_ERROR(_logger, "Error on socket {}", pc->_socket);
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
+                    AFINA_LOG_ERROR(_logger, "Failed to delete connection from epoll");
                 }
 
+                connection_storage.erase(pc);
                 close(pc->_socket);
                 pc->OnError();
 
                 delete pc;
                 continue;
             } else if (current_event.events & EPOLLRDHUP) {
-                _logger->debug("Epolldrhup");
+                AFINA_LOG_DEBUG(_logger, "Epolldrhup");
                 pc->Close();
             } else {
                 // Depends on what connection wants...
@@ -178,7 +186,7 @@ void ServerImpl::OnRun() {
             // Does it alive?
             if (pc->isAlive() == false) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
+                    AFINA_LOG_ERROR(_logger, "Failed to delete connection from epoll");
                 }
                 connection_storage.erase(pc);
                 close(pc->_socket);
@@ -187,7 +195,7 @@ void ServerImpl::OnRun() {
                 delete pc;
             } else if (pc->_event.events != old_mask) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to change connection event mask");
+                    AFINA_LOG_ERROR(_logger, "Failed to change connection event mask");
                     connection_storage.erase(pc);
                     close(pc->_socket);
                     pc->OnClose();
@@ -203,7 +211,7 @@ void ServerImpl::OnRun() {
         delete single_connection;
     }
     connection_storage.clear();
-    _logger->warn("Acceptor stopped");
+    AFINA_LOG_WARN(_logger, "Acceptor stopped");
 }
 
 void ServerImpl::OnNewConnection(int epoll_descr) {
@@ -218,21 +226,22 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
             if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
                 break; // We have processed all incoming connections.
             } else {
-                _logger->error("Failed to accept socket");
+                AFINA_LOG_ERROR(_logger, "Failed to accept socket");
                 break;
             }
         }
 
-        // Print host and service info.
-        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-        int retval =
-                getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
-        if (retval == 0) {
-            _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
+        // Print host and service info, resolving address only if it is going to be logged
+        if (AFINA_LOG_ENABLED(_logger, spdlog::level::info)) {
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            if (getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV) ==
+                0) {
+                AFINA_LOG_INFO(_logger, "Accepted connection on descriptor {} (host={}, port={})", infd, hbuf, sbuf);
+            }
         }
 
         // Register the new FD to be monitored by epoll.
-        Connection *pc = new Connection(infd, pStorage);
+        Connection *pc = new Connection(infd, pStorage, _limits.get());
         if (pc == nullptr) {
             throw std::runtime_error("Failed to allocate connection");
         }
@@ -1,11 +1,13 @@
 #ifndef AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 
+#include <memory>
 #include <thread>
 #include <vector>
 #include "Connection.h"
 #include <set>
 
+#include <afina/logging/Log.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -37,13 +39,16 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    int Socket() const override { return _server_socket; }
+
 protected:
     void OnRun();
     void OnNewConnection(int);
 
 private:
     // logger to use
-    std::shared_ptr<spdlog::logger> _logger;
+    Logging::Handle _logger;
 
     // Port to listen for new connections, permits access only from
     // inside of accept_thread
@@ -59,6 +64,9 @@ private:
     // IO thread
     std::thread _work_thread;
     std::set<Connection *> connection_storage;
+
+    // Budget of unsent responses of all connections, see Server::Limit
+    std::unique_ptr<OutputLimits> _limits;
 };
 
 } // namespace STnonblock
@@ -33,7 +33,8 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 } else if (name == "get" || name == "gets") {
                     state = State::sgKey;
                 } else if (name == "stats") {
-                    state = State::sLF;
+                    // Optional arguments are parsed the same way as keys of get
+                    state = c == ' ' ? State::sgKey : State::sLF;
                     continue;
                 } else {
                     throw std::runtime_error("Unknown command name: " + name);
@@ -177,7 +178,7 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
     } else if (name == "get") {
         return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
     } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
+        return std::unique_ptr<Execute::Command>(new Execute::Stats(keys));
     } else {
         throw std::runtime_error("Unsupported command");
     }
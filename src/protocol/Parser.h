@@ -55,6 +55,11 @@ public:
 
     inline const std::string &Name() const { return name; }
 
+    /**
+     * Keys of the parsed command, valid until Reset
+     */
+    inline const std::vector<std::string> &Keys() const { return keys; }
+
 private:
     /**
      * State of the command parser. Prefixes are:
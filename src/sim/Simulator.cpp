@@ -0,0 +1,142 @@
+#include "Simulator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <afina/metrics/Latency.h>
+
+#include "storage/ArenaLRU.h"
+#include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+#include "storage/StripedLRU.h"
+
+namespace Afina {
+namespace Sim {
+
+namespace {
+
+const std::size_t megabyte = 1024 * 1024;
+
+// Key of the recorded size made of its hash, so distinct keys stay distinct unless they are shorter than hash
+void MakeKey(const Trace::Record &record, std::string &key) {
+    key.assign(record.key_size, '\0');
+    std::memcpy(&key[0], &record.key_hash, std::min<std::size_t>(record.key_size, sizeof(record.key_hash)));
+}
+
+// Applies storage command the way Execute does
+bool Store(Metrics::Op op, Afina::Storage &storage, const std::string &key, const std::string &value,
+           std::string &found) {
+    switch (op) {
+    case Metrics::Op::kSet:
+        return storage.Put(key, value);
+    case Metrics::Op::kAdd:
+        return storage.PutIfAbsent(key, value);
+    case Metrics::Op::kReplace:
+        return storage.Set(key, value);
+    default:
+        return storage.Get(key, found) && storage.Put(key, found + value);
+    }
+}
+
+} // namespace
+
+// See Simulator.h
+const std::vector<std::string> &Engines() {
+    static const std::vector<std::string> engines = {"st_lru", "st_arena_lru", "st_slab_lru", "mt_slru"};
+    return engines;
+}
+
+// See Simulator.h
+std::unique_ptr<Afina::Storage> Build(const std::string &engine, std::size_t memory) {
+    if (engine == "st_lru") {
+        return std::unique_ptr<Afina::Storage>(new Backend::SimpleLRU(memory));
+    } else if (engine == "st_arena_lru") {
+        return std::unique_ptr<Afina::Storage>(new Backend::ArenaLRU(memory));
+    } else if (engine == "st_slab_lru") {
+        return std::unique_ptr<Afina::Storage>(new Backend::SlabLRU(memory));
+    } else if (engine == "mt_slru") {
+        // As many stripes as server uses as long as each gets the megabyte it needs
+        std::size_t stripes = std::min<std::size_t>(16, memory / megabyte);
+        if (stripes == 0) {
+            throw std::runtime_error("mt_slru needs at least 1M");
+        }
+        return std::unique_ptr<Afina::Storage>(Backend::BuildStripedLRU(memory, stripes));
+    }
+    throw std::runtime_error("Unknown storage engine " + engine);
+}
+
+// See Simulator.h
+Result Replay(Trace::Reader &trace, Afina::Storage &storage, bool demand_fill) {
+    Result result;
+    std::unordered_map<uint64_t, uint32_t> sizes;
+    std::string key, value, found;
+
+    Trace::Record record;
+    while (trace.Next(record)) {
+        MakeKey(record, key);
+        switch (static_cast<Metrics::Op>(record.op)) {
+        case Metrics::Op::kGet:
+            result.gets++;
+            if (storage.Get(key, found)) {
+                result.hits++;
+            } else if (demand_fill) {
+                auto size = sizes.find(record.key_hash);
+                if (size != sizes.end()) {
+                    value.assign(size->second, 'v');
+                    storage.Put(key, value);
+                }
+            }
+            break;
+
+        case Metrics::Op::kSet:
+        case Metrics::Op::kAdd:
+        case Metrics::Op::kReplace:
+        case Metrics::Op::kAppend:
+            result.sets++;
+            value.assign(record.value_size, 'v');
+            if (Store(static_cast<Metrics::Op>(record.op), storage, key, value, found)) {
+                result.stored++;
+            }
+            if (demand_fill) {
+                sizes[record.key_hash] = record.value_size;
+            }
+            break;
+
+        case Metrics::Op::kDelete:
+            result.deletes++;
+            storage.Delete(key);
+            break;
+
+        default:
+            break;
+        }
+    }
+    return result;
+}
+
+// See Simulator.h
+std::size_t ParseSize(const std::string &size) {
+    char *end = nullptr;
+    unsigned long long value = std::strtoull(size.c_str(), &end, 10);
+    if (end == size.c_str()) {
+        throw std::runtime_error("Malformed size " + size);
+    }
+
+    std::string suffix(end);
+    if (suffix == "K" || suffix == "k") {
+        value <<= 10;
+    } else if (suffix == "M" || suffix == "m") {
+        value <<= 20;
+    } else if (suffix == "G" || suffix == "g") {
+        value <<= 30;
+    } else if (!suffix.empty()) {
+        throw std::runtime_error("Malformed size " + size);
+    }
+    return value;
+}
+
+} // namespace Sim
+} // namespace Afina
@@ -0,0 +1,61 @@
+#ifndef AFINA_SIM_SIMULATOR_H
+#define AFINA_SIM_SIMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/trace/Trace.h>
+
+namespace Afina {
+namespace Sim {
+
+/**
+ * Outcome of a trace replayed against a storage
+ */
+struct Result {
+    Result() : gets(0), hits(0), sets(0), stored(0), deletes(0) {}
+
+    double HitRatio() const { return gets == 0 ? 0 : double(hits) / gets; }
+
+    // Keys looked up and found
+    uint64_t gets;
+    uint64_t hits;
+
+    // Storage commands and how many of them storage accepted
+    uint64_t sets;
+    uint64_t stored;
+
+    uint64_t deletes;
+};
+
+/**
+ * Names of storage engines trace could be replayed against
+ */
+const std::vector<std::string> &Engines();
+
+/**
+ * Builds storage engine by name with memory limit in bytes. Throws std::runtime_error for unknown engine or
+ * memory the engine can't work with
+ */
+std::unique_ptr<Afina::Storage> Build(const std::string &engine, std::size_t memory);
+
+/**
+ * Replays every record of the trace against storage. Keys are rebuilt from their hash and size, values are
+ * of recorded size. With demand_fill a missed get is followed by a set of the key with the last value size
+ * seen for it, as look-aside clients do; keys never set in the trace aren't filled
+ */
+Result Replay(Trace::Reader &trace, Afina::Storage &storage, bool demand_fill);
+
+/**
+ * Parses size in bytes with optional K, M or G suffix. Throws std::runtime_error if it's malformed
+ */
+std::size_t ParseSize(const std::string &size);
+
+} // namespace Sim
+} // namespace Afina
+
+#endif // AFINA_SIM_SIMULATOR_H
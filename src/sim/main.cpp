@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include <afina/trace/Trace.h>
+
+#include "Simulator.h"
+
+using namespace Afina;
+
+namespace {
+
+std::vector<std::string> Split(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Single engine and memory size, jobs run on a pool of threads and each reads the trace on its own
+struct Job {
+    std::string engine;
+    std::size_t memory;
+
+    bool done;
+    std::string error;
+    Sim::Result result;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("afina-sim", "Replays request trace against storage engines of different sizes");
+    std::string trace_path;
+    std::vector<std::string> sizes, engines;
+    bool demand_fill, csv;
+    std::size_t threads;
+    try {
+        options.add_options()("trace", "Trace recorded by afina --trace", cxxopts::value<std::string>());
+        options.add_options()("m,memory", "Memory sizes of the whole server, comma separated, with K, M or G suffix",
+                              cxxopts::value<std::string>()->default_value("1M,2M,4M,8M,16M,32M,64M,128M,256M"));
+        options.add_options()("e,engines", "Storage engines, comma separated",
+                              cxxopts::value<std::string>()->default_value("st_lru,st_arena_lru,st_slab_lru,mt_slru"));
+        options.add_options()("demand-fill", "Set the key after a missed get, as look-aside clients do");
+        options.add_options()("t,threads", "Simulations run at once",
+                              cxxopts::value<std::size_t>()->default_value(
+                                  std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+        options.add_options()("csv", "Print hit ratios as CSV");
+        options.add_options()("h,help", "Print usage info");
+        options.parse_positional("trace");
+        options.parse(argc, argv);
+
+        if (options.count("help") > 0 || options.count("trace") == 0) {
+            std::cerr << options.help() << std::endl;
+            return options.count("help") > 0 ? 0 : 1;
+        }
+
+        trace_path = options["trace"].as<std::string>();
+        sizes = Split(options["memory"].as<std::string>());
+        engines = Split(options["engines"].as<std::string>());
+        demand_fill = options.count("demand-fill") > 0;
+        threads = std::max<std::size_t>(1, options["threads"].as<std::size_t>());
+        csv = options.count("csv") > 0;
+    } catch (cxxopts::OptionException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    // Sampled trace has only one of sample keys, so it fits into as much less memory
+    std::vector<Job> jobs;
+    uint32_t sample;
+    try {
+        Trace::Reader trace(trace_path);
+        sample = trace.header().sample;
+        for (auto &size : sizes) {
+            for (auto &engine : engines) {
+                Job job;
+                job.engine = engine;
+                job.memory = Sim::ParseSize(size);
+                job.done = false;
+                jobs.push_back(job);
+            }
+        }
+    } catch (std::runtime_error &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (jobs.empty()) {
+        std::cerr << "Error: no memory sizes or engines to simulate" << std::endl;
+        return 1;
+    }
+
+    std::atomic<std::size_t> next(0);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < std::min(threads, jobs.size()); t++) {
+        pool.emplace_back([&] {
+            for (std::size_t i = next++; i < jobs.size(); i = next++) {
+                Job &job = jobs[i];
+                try {
+                    Trace::Reader trace(trace_path);
+                    auto storage = Sim::Build(job.engine, job.memory / sample);
+                    job.result = Sim::Replay(trace, *storage, demand_fill);
+                    job.done = true;
+                } catch (std::exception &ex) {
+                    job.error = ex.what();
+                }
+            }
+        });
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    // Rows are memory sizes, columns are engines
+    if (csv) {
+        std::printf("memory");
+        for (auto &engine : engines) {
+            std::printf(",%s", engine.c_str());
+        }
+        std::printf("\n");
+    } else {
+        // Every simulation sees the same requests
+        Sim::Result any;
+        for (auto &job : jobs) {
+            if (job.done) {
+                any = job.result;
+                break;
+            }
+        }
+        std::printf("trace %s: 1 of %u keys, %llu gets, %llu sets, %llu deletes\n", trace_path.c_str(), sample,
+                    static_cast<unsigned long long>(any.gets), static_cast<unsigned long long>(any.sets),
+                    static_cast<unsigned long long>(any.deletes));
+        std::printf("%10s", "memory");
+        for (auto &engine : engines) {
+            std::printf(" %14s", engine.c_str());
+        }
+        std::printf("\n");
+    }
+
+    for (std::size_t s = 0; s < sizes.size(); s++) {
+        std::printf(csv ? "%s" : "%10s", sizes[s].c_str());
+        for (std::size_t e = 0; e < engines.size(); e++) {
+            const Job &job = jobs[s * engines.size() + e];
+            if (job.done) {
+                std::printf(csv ? ",%.4f" : " %13.2f%%", csv ? job.result.HitRatio() : job.result.HitRatio() * 100);
+            } else {
+                std::printf(csv ? "," : " %14s", "-");
+            }
+        }
+        std::printf("\n");
+    }
+
+    int failed = 0;
+    for (auto &job : jobs) {
+        if (!job.done) {
+            std::cerr << job.engine << " with " << job.memory << " bytes: " << job.error << std::endl;
+            failed++;
+        }
+    }
+    return failed == static_cast<int>(jobs.size()) ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+#include "ArenaLRU.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <afina/allocator/Error.h>
+#include <afina/metrics/Metrics.h>
+
+namespace Afina {
+namespace Backend {
+
+ArenaLRU::ArenaLRU(size_t max_size)
+    : _memory(new char[max_size]), _arena(_memory.get(), max_size), _capacity(_arena.free_space()),
+      _compact_reserve(max_size / 16), _cur_size(0), _lru_head(nullptr), _lru_tail(nullptr) {}
+
+ArenaLRU::~ArenaLRU() {
+    // Items die together with the storage, arena memory is released as a whole
+    Metrics::Add(Metrics::Id::kCurrItems, -int64_t(_lru_index.size()));
+    Metrics::Add(Metrics::Id::kBytes, -int64_t(_cur_size));
+}
+
+// See afina/Storage.h
+bool ArenaLRU::Put(const std::string &key, const std::string &value) {
+    auto search = _lru_index.find(probe(key));
+    if (search == _lru_index.end()) {
+        return put_new_node(key, value);
+    }
+    return set_node_value(*search->second, value);
+}
+
+// See afina/Storage.h
+bool ArenaLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    if (_lru_index.find(probe(key)) != _lru_index.end()) {
+        return false;
+    }
+    return put_new_node(key, value);
+}
+
+// See afina/Storage.h
+bool ArenaLRU::Set(const std::string &key, const std::string &value) {
+    auto search = _lru_index.find(probe(key));
+    if (search == _lru_index.end()) {
+        return false;
+    }
+    return set_node_value(*search->second, value);
+}
+
+// See afina/Storage.h
+bool ArenaLRU::Delete(const std::string &key) {
+    auto search = _lru_index.find(probe(key));
+    if (search == _lru_index.end()) {
+        return false;
+    }
+
+    lru_node &node = *search->second;
+    unlink(node);
+    _cur_size -= node.key_size + node.size;
+    Metrics::Add(Metrics::Id::kCurrItems, -1);
+    Metrics::Add(Metrics::Id::kBytes, -int64_t(node.key_size + node.size));
+    Allocator::Pointer data = node.data;
+    _lru_index.erase(search);
+    _arena.free(data);
+    return true;
+}
+
+// See afina/Storage.h
+bool ArenaLRU::Get(const std::string &key, std::string &value) {
+    auto search = _lru_index.find(probe(key));
+    if (search == _lru_index.end()) {
+        return false;
+    }
+
+    lru_node &node = *search->second;
+    value.assign(node.value(), node.size);
+    unlink(node);
+    push_back(node);
+    return true;
+}
+
+bool ArenaLRU::put_new_node(const std::string &key, const std::string &value) {
+    std::size_t size = key.size() + value.size();
+    if (size > _capacity) {
+        return false;
+    }
+
+    Allocator::Pointer data;
+    if (!with_room(size, nullptr, [this, &data, size]() { data = _arena.alloc(size); })) {
+        return false;
+    }
+
+    std::unique_ptr<lru_node> node(new lru_node{data, key.size(), value.size(), nullptr, nullptr});
+    std::memcpy(node->key(), key.data(), key.size());
+    std::memcpy(node->value(), value.data(), value.size());
+    push_back(*node);
+    index_key entry{node.get(), nullptr};
+    _lru_index.emplace(entry, std::move(node));
+
+    _cur_size += key.size() + value.size();
+    Metrics::Add(Metrics::Id::kCurrItems);
+    Metrics::Add(Metrics::Id::kBytes, key.size() + value.size());
+    return true;
+}
+
+bool ArenaLRU::set_node_value(lru_node &node, const std::string &value) {
+    std::size_t size = node.key_size + value.size();
+    if (size > _capacity) {
+        return false;
+    }
+
+    // Node becomes the most recently used one, so it is the last candidate for eviction. Key stays in place
+    // as realloc keeps contents
+    unlink(node);
+    push_back(node);
+    if (!with_room(size, &node, [this, &node, size]() { _arena.realloc(node.data, size); })) {
+        return false;
+    }
+    std::memcpy(node.value(), value.data(), value.size());
+
+    _cur_size = _cur_size + value.size() - node.size;
+    Metrics::Add(Metrics::Id::kBytes, int64_t(value.size()) - int64_t(node.size));
+    node.size = value.size();
+    return true;
+}
+
+template <typename F> bool ArenaLRU::with_room(std::size_t size, const lru_node *keep, F &&alloc) {
+    while (true) {
+        try {
+            alloc();
+            return true;
+        } catch (Allocator::AllocError &) {
+        }
+
+        // Nothing to evict, compaction is the last chance
+        bool last_chance = _lru_head == nullptr || _lru_head == keep;
+        if (_arena.free_space() >= size + (last_chance ? 0 : _compact_reserve)) {
+            _arena.defrag();
+            try {
+                alloc();
+                return true;
+            } catch (Allocator::AllocError &) {
+            }
+        }
+
+        if (last_chance) {
+            return false;
+        }
+        evict();
+    }
+}
+
+void ArenaLRU::evict() {
+    lru_node &node = *_lru_head;
+    unlink(node);
+
+    _cur_size -= node.key_size + node.size;
+    Metrics::Add(Metrics::Id::kCurrItems, -1);
+    Metrics::Add(Metrics::Id::kBytes, -int64_t(node.key_size + node.size));
+    Metrics::Add(Metrics::Id::kEvictions);
+
+    // Key is needed to find the node, so its block is freed last
+    Allocator::Pointer data = node.data;
+    _lru_index.erase(_lru_index.find(index_key{&node, nullptr}));
+    _arena.free(data);
+}
+
+bool ArenaLRU::index_less::operator()(const index_key &a, const index_key &b) const {
+    const char *a_data = a.node != nullptr ? a.node->key() : a.probe->data();
+    std::size_t a_size = a.node != nullptr ? a.node->key_size : a.probe->size();
+    const char *b_data = b.node != nullptr ? b.node->key() : b.probe->data();
+    std::size_t b_size = b.node != nullptr ? b.node->key_size : b.probe->size();
+
+    std::size_t common = std::min(a_size, b_size);
+    int cmp = common == 0 ? 0 : std::memcmp(a_data, b_data, common);
+    return cmp < 0 || (cmp == 0 && a_size < b_size);
+}
+
+void ArenaLRU::unlink(lru_node &node) {
+    if (node.prev != nullptr) {
+        node.prev->next = node.next;
+    } else {
+        _lru_head = node.next;
+    }
+
+    if (node.next != nullptr) {
+        node.next->prev = node.prev;
+    } else {
+        _lru_tail = node.prev;
+    }
+    node.prev = node.next = nullptr;
+}
+
+void ArenaLRU::push_back(lru_node &node) {
+    node.prev = _lru_tail;
+    node.next = nullptr;
+    if (_lru_tail != nullptr) {
+        _lru_tail->next = &node;
+    } else {
+        _lru_head = &node;
+    }
+    _lru_tail = &node;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,118 @@
+#ifndef AFINA_STORAGE_ARENA_LRU_H
+#define AFINA_STORAGE_ARENA_LRU_H
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU with entries in compacting arena
+ * Keys and values live in a single preallocated area managed by Allocator::Simple instead of the heap, so no
+ * matter how sizes of entries change over time memory they take stays within max_size bytes and doesn't get
+ * fragmented: once free space is scattered over many small holes, arena slides live entries together.
+ *
+ * Compaction costs time proportional to the arena size, so it is done only if it frees noticeably more than
+ * requested, otherwise least recently used entries are evicted. Only index and nodes, of fixed size per
+ * entry, live on the heap.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class ArenaLRU : public Afina::Storage {
+public:
+    explicit ArenaLRU(size_t max_size = 1024 * 1024);
+    ~ArenaLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    /**
+     * Map of the arena, see Allocator::Simple::dump
+     */
+    std::string Dump() const { return _arena.dump(); }
+
+private:
+    // LRU cache node, key followed by value is stored in the arena
+    struct lru_node {
+        Allocator::Pointer data;
+        std::size_t key_size;
+        std::size_t size;
+        lru_node *prev;
+        lru_node *next;
+
+        // Valid until arena is compacted or entry is resized
+        char *key() const { return static_cast<char *>(data.get()); }
+        char *value() const { return key() + key_size; }
+    };
+
+    // Key of the index: either a node, whose key is read from the arena, or the key being looked up
+    struct index_key {
+        const lru_node *node;
+        const std::string *probe;
+    };
+
+    struct index_less {
+        bool operator()(const index_key &a, const index_key &b) const;
+    };
+
+    static index_key probe(const std::string &key) { return index_key{nullptr, &key}; }
+
+    bool put_new_node(const std::string &key, const std::string &value);
+
+    bool set_node_value(lru_node &node, const std::string &value);
+
+    /**
+     * Runs alloc until it stops throwing AllocError, compacting arena or evicting entries in between.
+     * Node keep is never evicted. Returns false if there is nothing to evict anymore
+     */
+    template <typename F> bool with_room(std::size_t size, const lru_node *keep, F &&alloc);
+
+    void evict();
+
+    void unlink(lru_node &node);
+
+    void push_back(lru_node &node);
+
+    // Area of the arena and the allocator on top of it
+    std::unique_ptr<char[]> _memory;
+    Allocator::Simple _arena;
+
+    // The largest value that fits into empty arena
+    std::size_t _capacity;
+
+    // Arena is compacted only if that gives this much space in addition to the requested
+    std::size_t _compact_reserve;
+
+    // Sum of key and value sizes of all entries
+    std::size_t _cur_size;
+
+    // Recency list, head is the least recently used entry
+    lru_node *_lru_head;
+    lru_node *_lru_tail;
+
+    // Index owns all nodes
+    std::map<index_key, std::unique_ptr<lru_node>, index_less> _lru_index;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ARENA_LRU_H
@@ -0,0 +1,35 @@
+#ifndef AFINA_STORAGE_CHECKSUM_H
+#define AFINA_STORAGE_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Hash of bytes that stays the same between builds and runs, so it could be kept in files. Takes 8 bytes
+ * a step, that is much faster than data could come from disk
+ */
+inline uint64_t Checksum(const char *data, std::size_t size, uint64_t seed = 0) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = (seed + size) * prime;
+    std::size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    hash = (hash ^ tail) * prime;
+    return hash ^ (hash >> 32);
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CHECKSUM_H
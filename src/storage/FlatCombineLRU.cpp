@@ -0,0 +1,74 @@
+#include "FlatCombineLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+FlatCombineLRU::FlatCombineLRU(size_t max_size)
+    : _storage(max_size), _combiner([this](Operation **ops, std::size_t count) { combine(ops, count); }) {}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Put(const std::string &key, const std::string &value) {
+    return execute(Operation::Type::kPut, key, &value, nullptr);
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return execute(Operation::Type::kPutIfAbsent, key, &value, nullptr);
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Set(const std::string &key, const std::string &value) {
+    return execute(Operation::Type::kSet, key, &value, nullptr);
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Delete(const std::string &key) { return execute(Operation::Type::kDelete, key, nullptr, nullptr); }
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Get(const std::string &key, std::string &value) {
+    return execute(Operation::Type::kGet, key, nullptr, &value);
+}
+
+bool FlatCombineLRU::execute(Operation::Type type, const std::string &key, const std::string *value,
+                             std::string *out) {
+    Operation op{type, &key, value, out, false, nullptr};
+    _combiner.Execute(op);
+    if (op.error) {
+        std::rethrow_exception(op.error);
+    }
+    return op.result;
+}
+
+void FlatCombineLRU::combine(Operation **ops, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        Operation &op = *ops[i];
+        try {
+            apply(op);
+        } catch (...) {
+            op.error = std::current_exception();
+        }
+    }
+}
+
+void FlatCombineLRU::apply(Operation &op) {
+    switch (op.type) {
+    case Operation::Type::kPut:
+        op.result = _storage.Put(*op.key, *op.value);
+        break;
+    case Operation::Type::kPutIfAbsent:
+        op.result = _storage.PutIfAbsent(*op.key, *op.value);
+        break;
+    case Operation::Type::kSet:
+        op.result = _storage.Set(*op.key, *op.value);
+        break;
+    case Operation::Type::kDelete:
+        op.result = _storage.Delete(*op.key);
+        break;
+    case Operation::Type::kGet:
+        op.result = _storage.Get(*op.key, *op.out);
+        break;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,71 @@
+#ifndef AFINA_STORAGE_FLAT_COMBINE_LRU_H
+#define AFINA_STORAGE_FLAT_COMBINE_LRU_H
+
+#include <exception>
+#include <string>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/FlatCombine.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleLRU shared through flat combining
+ * Every access to LRU changes recency list, so operations can't run in parallel anyway. Instead of fighting
+ * for a mutex threads publish operations and one of them applies whole batch, see Concurrency::FlatCombine
+ */
+class FlatCombineLRU : public Afina::Storage {
+public:
+    explicit FlatCombineLRU(size_t max_size = 1024);
+    ~FlatCombineLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+private:
+    // Storage operation waiting for combiner
+    struct Operation {
+        enum class Type { kPut, kPutIfAbsent, kSet, kDelete, kGet };
+
+        Type type;
+        const std::string *key;
+
+        // Argument of Put/PutIfAbsent/Set and output of Get
+        const std::string *value;
+        std::string *out;
+
+        bool result;
+
+        // Exception thrown by the operation, such as std::bad_alloc, rethrown in the thread that owns it
+        std::exception_ptr error;
+    };
+
+    bool execute(Operation::Type type, const std::string &key, const std::string *value, std::string *out);
+
+    void combine(Operation **ops, std::size_t count);
+
+    void apply(Operation &op);
+
+    SimpleLRU _storage;
+    Concurrency::FlatCombine<Operation> _combiner;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FLAT_COMBINE_LRU_H
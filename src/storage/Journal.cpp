@@ -0,0 +1,384 @@
+#include "Journal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/metrics/Metrics.h>
+
+#include "Checksum.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char magic[8] = {'A', 'F', 'I', 'N', 'A', 'J', 'N', 'L'};
+const uint32_t version = 2;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+
+    // Records below it have been dropped by compaction, the snapshot has them
+    uint64_t base;
+};
+
+// Key and value follow record header
+struct Record {
+    uint64_t seq;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint8_t op;
+    uint8_t reserved[7];
+
+    // Of header fields above, key and value
+    uint64_t checksum;
+};
+
+uint64_t RecordChecksum(const Record &record, const char *key, const char *value) {
+    uint64_t sum = Checksum(reinterpret_cast<const char *>(&record), offsetof(Record, checksum));
+    sum = Checksum(key, record.key_size, sum);
+    return Checksum(value, record.value_size, sum);
+}
+
+std::runtime_error Error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::string(strerror(errno)));
+}
+
+// Takes record at pos of the file, returns false at the end of file or at the torn tail
+bool NextRecord(const char *data, std::size_t size, std::size_t &pos, Record &record, const char *&key) {
+    if (size - pos < sizeof(Record)) {
+        return false;
+    }
+    std::memcpy(&record, data + pos, sizeof(record));
+    key = data + pos + sizeof(record);
+    if (record.key_size > size - pos - sizeof(record) || record.value_size > size - pos - sizeof(record) - record.key_size ||
+        RecordChecksum(record, key, key + record.key_size) != record.checksum) {
+        return false;
+    }
+    pos += sizeof(record) + record.key_size + record.value_size;
+    return true;
+}
+
+bool WriteAll(int fd, const char *data, std::size_t size) {
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(fd, data + done, size - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+Header MakeHeader(uint64_t base) {
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.reserved = 0;
+    header.base = base;
+    return header;
+}
+
+} // namespace
+
+// See Journal.h
+Journal::Journal(const std::string &path, std::chrono::milliseconds sync_interval)
+    : _path(path), _fd(-1), _sync_interval(sync_interval), _replayed(false), _seq(0), _batch_records(0),
+      _sync_failed(false), _failing(false), _records(0), _batches(0), _running(false) {
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (_fd == -1) {
+        throw Error("Failed to open journal", path);
+    }
+}
+
+// See Journal.h
+Journal::~Journal() {
+    try {
+        Stop();
+    } catch (std::exception &) {
+        // Nothing could be done about it at this point
+    }
+    close(_fd);
+}
+
+// See Journal.h
+std::size_t Journal::Replay(const std::function<void(Op op, const std::string &key, const std::string &value)> &fn) {
+    struct stat st;
+    if (fstat(_fd, &st) != 0) {
+        throw Error("Failed to open journal", _path);
+    }
+
+    std::size_t size = st.st_size;
+    if (size < sizeof(Header)) {
+        // New file, or one that crashed before header got written
+        Header header = MakeHeader(0);
+        if (ftruncate(_fd, 0) != 0 || write(_fd, &header, sizeof(header)) != sizeof(header) || fsync(_fd) != 0) {
+            throw Error("Failed to create journal", _path);
+        }
+        _replayed = true;
+        return 0;
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (mapped == MAP_FAILED) {
+        throw Error("Failed to read journal", _path);
+    }
+    const char *data = static_cast<const char *>(mapped);
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+        munmap(mapped, size);
+        throw std::runtime_error("File " + _path + " is not a journal");
+    }
+
+    // Sequence number of the operation applied last to every key, older ones reaching file later are skipped
+    std::unordered_map<std::string, uint64_t> applied;
+    std::size_t records = 0;
+    std::size_t pos = sizeof(Header);
+    uint64_t next_seq = header.base;
+    std::string key, value;
+    try {
+        Record record;
+        const char *key_data;
+        while (NextRecord(data, size, pos, record, key_data)) {
+            records++;
+            next_seq = std::max(next_seq, record.seq + 1);
+
+            // Covered by the snapshot journal was compacted for
+            if (!fn || record.seq < header.base) {
+                continue;
+            }
+
+            key.assign(key_data, record.key_size);
+            auto it = applied.emplace(key, record.seq).first;
+            if (it->second > record.seq) {
+                continue;
+            }
+            it->second = record.seq;
+            value.assign(key_data + record.key_size, record.value_size);
+            fn(static_cast<Op>(record.op), key, value);
+        }
+    } catch (...) {
+        munmap(mapped, size);
+        throw;
+    }
+    munmap(mapped, size);
+
+    // Torn record is cut off, so that new ones follow the last valid one
+    if (pos != size && (ftruncate(_fd, pos) != 0 || fsync(_fd) != 0)) {
+        throw Error("Failed to truncate journal", _path);
+    }
+
+    _seq.store(next_seq);
+    _replayed = true;
+    return records;
+}
+
+// See Journal.h
+void Journal::Start() {
+    if (!_replayed) {
+        Replay(nullptr);
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _thread = std::thread(&Journal::run, this);
+}
+
+// See Journal.h
+void Journal::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _stop.notify_all();
+    _thread.join();
+    Sync();
+}
+
+// See Journal.h
+void Journal::Add(Op op, const std::string &key, const std::string &value) {
+    Record record;
+    record.seq = _seq.fetch_add(1, std::memory_order_relaxed);
+    record.key_size = key.size();
+    record.value_size = value.size();
+    record.op = static_cast<uint8_t>(op);
+    std::memset(record.reserved, 0, sizeof(record.reserved));
+    record.checksum = RecordChecksum(record, key.data(), value.data());
+
+    // Lock is taken by commit only once per sync interval, so it is almost never contended
+    Buffer &buffer = _buffers.local();
+    std::lock_guard<std::mutex> lock(buffer.lock);
+    buffer.data.append(reinterpret_cast<const char *>(&record), sizeof(record));
+    buffer.data.append(key);
+    buffer.data.append(value);
+    buffer.records++;
+}
+
+// See Journal.h
+void Journal::Sync() {
+    std::lock_guard<std::mutex> lock(_commit_lock);
+    commit();
+    if (!_error.empty()) {
+        throw std::runtime_error(_error);
+    }
+}
+
+// See Journal.h
+void Journal::Check() const {
+    if (_failing.load(std::memory_order_relaxed)) {
+        throw std::runtime_error("Journal " + _path + " is failing to write, operation couldn't be logged");
+    }
+}
+
+/**
+ * Records logged meanwhile stay in buffers, commit lock keeps them from the file being replaced
+ */
+void Journal::Compact(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(_commit_lock);
+    commit();
+    if (!_error.empty()) {
+        throw std::runtime_error(_error);
+    }
+
+    struct stat st;
+    if (fstat(_fd, &st) != 0) {
+        throw Error("Failed to read journal", _path);
+    }
+    std::size_t size = st.st_size;
+    std::string kept;
+    if (size > sizeof(Header)) {
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (mapped == MAP_FAILED) {
+            throw Error("Failed to read journal", _path);
+        }
+        const char *data = static_cast<const char *>(mapped);
+        std::size_t pos = sizeof(Header);
+        Record record;
+        const char *key;
+        for (std::size_t start = pos; NextRecord(data, size, pos, record, key); start = pos) {
+            if (record.seq >= seq) {
+                kept.append(data + start, pos - start);
+            }
+        }
+        munmap(mapped, size);
+    }
+
+    std::string tmp_path = _path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        throw Error("Failed to create journal", tmp_path);
+    }
+    Header header = MakeHeader(seq);
+    if (!WriteAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) ||
+        !WriteAll(fd, kept.data(), kept.size()) || fsync(fd) != 0 || rename(tmp_path.c_str(), _path.c_str()) != 0) {
+        std::runtime_error error = Error("Failed to compact journal", _path);
+        close(fd);
+        unlink(tmp_path.c_str());
+        throw error;
+    }
+    close(_fd);
+    _fd = fd;
+
+    // Rename is durable only once directory is synced too
+    std::size_t slash = _path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : _path.substr(0, std::max<std::size_t>(slash, 1));
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd != -1) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+}
+
+void Journal::commit() {
+    // Nothing written after failed sync could be trusted, records stay in buffers
+    if (_sync_failed) {
+        return;
+    }
+
+    // Appended to what is left of the previous batch, if it failed
+    std::size_t records = _batch_records;
+    _buffers.for_each([this, &records](Buffer &buffer) {
+        std::lock_guard<std::mutex> lock(buffer.lock);
+        _batch.append(buffer.data);
+        buffer.data.clear();
+        records += buffer.records;
+        buffer.records = 0;
+    });
+    _batch_records = records;
+    if (_batch.empty()) {
+        return;
+    }
+
+    std::size_t done = 0;
+    while (done < _batch.size()) {
+        ssize_t n = write(_fd, _batch.data() + done, _batch.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            // Part written is in file already, the rest is retried next time
+            _batch.erase(0, done);
+            fail(Error("Failed to write journal", _path).what());
+            return;
+        }
+        done += n;
+    }
+    _batch.clear();
+    if (fdatasync(_fd) != 0) {
+        _sync_failed = true;
+        fail(Error("Failed to sync journal", _path).what());
+        return;
+    }
+
+    _batch_records = 0;
+    _error.clear();
+    _failing.store(false, std::memory_order_relaxed);
+    _records.fetch_add(records, std::memory_order_relaxed);
+    _batches.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Journal::fail(const std::string &error) {
+    _error = error;
+    _failing.store(true, std::memory_order_relaxed);
+    Metrics::Add(Metrics::Id::kJournalErrors, 1);
+}
+
+void Journal::run() {
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_running) {
+        _stop.wait_for(lock, _sync_interval);
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> commit_lock(_commit_lock);
+            commit();
+        }
+        lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,161 @@
+#ifndef AFINA_STORAGE_JOURNAL_H
+#define AFINA_STORAGE_JOURNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Append-only log of storage operations
+ * Every thread appends records to its own buffer in memory, so logging an operation costs neither a syscall
+ * nor a shared lock. Background thread takes out whatever all buffers have every sync interval, writes it
+ * with a single write and syncs the file: that is a group commit, one fsync covers every operation of the
+ * interval. So operation is durable within sync interval after it returned.
+ *
+ * Records carry global sequence number and checksum. Buffers are drained one after another, so records of
+ * different threads could reach the file out of order, replay orders operations on the same key by sequence
+ * number. Crash could leave a torn record at the end, replay stops there and cuts it off.
+ *
+ * Records are never dropped on failure. Batch that failed to be written is kept and goes first on the next
+ * attempt, meanwhile journal is failing: Check throws and every failed attempt counts in journal_errors. Failed
+ * sync is final, as kernel could have thrown away pages it failed to write, so journal stops writing at all.
+ *
+ * Records a snapshot already has are dropped by Compact: file is rewritten starting from the snapshot's
+ * sequence number, that is kept in file header, so journal grows only between snapshots.
+ */
+class Journal {
+public:
+    enum class Op : uint8_t { kPut = 1, kDelete = 2 };
+
+    /**
+     * Opens journal at path, creates it if there is none. Throws std::runtime_error if file couldn't be
+     * opened or isn't a journal
+     *
+     * @param path file to append records to
+     * @param sync_interval how often records are written out and synced
+     */
+    explicit Journal(const std::string &path,
+                     std::chrono::milliseconds sync_interval = std::chrono::milliseconds(10));
+
+    /**
+     * Writes out and syncs everything logged so far
+     */
+    ~Journal();
+
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    /**
+     * Calls fn for every operation in the file that is the latest for its key at the moment, in order they
+     * were logged, and cuts off torn tail. Must be called before anything is logged, returns number of
+     * valid records
+     */
+    std::size_t Replay(const std::function<void(Op op, const std::string &key, const std::string &value)> &fn);
+
+    /**
+     * Runs group commit thread until Stop, that writes out everything logged so far. Replays file without
+     * applying it, unless Replay was called already
+     */
+    void Start();
+    void Stop();
+
+    /**
+     * Logs operation into buffer of the calling thread. Operations on the same key must be logged in order
+     * they are applied, e.g. under lock of the key. Never fails because journal is failing: record waits in
+     * buffer till it could be written, so operation that passed Check is logged once it is applied
+     */
+    void Add(Op op, const std::string &key, const std::string &value);
+
+    /**
+     * Throws std::runtime_error if the last attempt to write out or sync journal failed, so that operation
+     * isn't applied when it can't be logged
+     */
+    void Check() const;
+
+    /**
+     * Sequence number the next operation gets, everything logged so far is below it
+     */
+    uint64_t Seq() const { return _seq.load(std::memory_order_relaxed); }
+
+    /**
+     * Drops records below seq, e.g. ones a committed snapshot has. Everything logged so far is written out, then
+     * the rest of file is copied next to it and replaces it, so crash leaves either one. Throws
+     * std::runtime_error on failure, journal goes on with the old file then
+     */
+    void Compact(uint64_t seq);
+
+    /**
+     * Writes out and syncs everything logged so far, could be called by any thread. Throws
+     * std::runtime_error if journal failed to write
+     */
+    void Sync();
+
+    /**
+     * Records written so far and writes they took, each write is followed by a sync
+     */
+    uint64_t Records() const { return _records.load(std::memory_order_relaxed); }
+    uint64_t Batches() const { return _batches.load(std::memory_order_relaxed); }
+
+private:
+    struct Buffer {
+        Buffer() : records(0) {}
+
+        std::mutex lock;
+        std::string data;
+        std::size_t records;
+    };
+
+    /**
+     * Writes out buffers and syncs, commit lock must be held
+     */
+    void commit();
+
+    /**
+     * Keeps error of the failed attempt and reports it, commit lock must be held
+     */
+    void fail(const std::string &error);
+
+    void run();
+
+    std::string _path;
+    int _fd;
+    std::chrono::milliseconds _sync_interval;
+    bool _replayed;
+
+    std::atomic<uint64_t> _seq;
+    Concurrency::ThreadLocal<Buffer> _buffers;
+
+    // Taken by commit, batch is kept between commits to reuse memory. Batch that failed to be written stays
+    // along with number of records in it
+    std::mutex _commit_lock;
+    std::string _batch;
+    std::size_t _batch_records;
+    std::string _error;
+    bool _sync_failed;
+
+    // Whether _error is set, read by Add without commit lock
+    std::atomic<bool> _failing;
+
+    std::atomic<uint64_t> _records;
+    std::atomic<uint64_t> _batches;
+
+    std::mutex _lock;
+    std::condition_variable _stop;
+    bool _running;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_JOURNAL_H
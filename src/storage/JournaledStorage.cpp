@@ -0,0 +1,110 @@
+#include "JournaledStorage.h"
+
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+// See JournaledStorage.h
+JournaledStorage::JournaledStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+                                   std::chrono::milliseconds sync_interval)
+    : _storage(std::move(storage)), _journal(path, sync_interval),
+      _locks(Concurrency::make_padded<std::mutex>(stripes)), _saved_seq(0) {}
+
+// See JournaledStorage.h
+JournaledStorage::~JournaledStorage() { Concurrency::free_padded(_locks, stripes); }
+
+// See JournaledStorage.h
+void JournaledStorage::Stop() {
+    _journal.Stop();
+    _storage->Stop();
+}
+
+// See JournaledStorage.h
+std::size_t JournaledStorage::Recover() {
+    std::size_t records = _journal.Replay([this](Journal::Op op, const std::string &key, const std::string &value) {
+        if (op == Journal::Op::kPut) {
+            _storage->Put(key, value);
+        } else {
+            _storage->Delete(key);
+        }
+    });
+    _journal.Start();
+    return records;
+}
+
+/**
+ * Changes are logged under stripe locks, so once every lock has been taken all changes below the mark are applied
+ * and the snapshot has them. Changes after the mark could get into it as well, replaying them on top is harmless
+ */
+bool JournaledStorage::Save(SnapshotWriter &snapshot) {
+    uint64_t mark;
+    {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(stripes);
+        for (std::size_t i = 0; i < stripes; i++) {
+            locks.emplace_back(_locks[i].value);
+        }
+        mark = _journal.Seq();
+    }
+    if (!_storage->Save(snapshot)) {
+        return false;
+    }
+    _saved_seq = mark;
+    return true;
+}
+
+// See JournaledStorage.h
+void JournaledStorage::Compact() {
+    if (_saved_seq > 0) {
+        _journal.Compact(_saved_seq);
+    }
+}
+
+// See JournaledStorage.h
+bool JournaledStorage::Put(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(lock_of(key));
+    _journal.Check();
+    if (!_storage->Put(key, value)) {
+        return false;
+    }
+    _journal.Add(Journal::Op::kPut, key, value);
+    return true;
+}
+
+// See JournaledStorage.h
+bool JournaledStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(lock_of(key));
+    _journal.Check();
+    if (!_storage->PutIfAbsent(key, value)) {
+        return false;
+    }
+    _journal.Add(Journal::Op::kPut, key, value);
+    return true;
+}
+
+// See JournaledStorage.h
+bool JournaledStorage::Set(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(lock_of(key));
+    _journal.Check();
+    if (!_storage->Set(key, value)) {
+        return false;
+    }
+    _journal.Add(Journal::Op::kPut, key, value);
+    return true;
+}
+
+// See JournaledStorage.h
+bool JournaledStorage::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> lock(lock_of(key));
+    _journal.Check();
+    if (!_storage->Delete(key)) {
+        return false;
+    }
+    _journal.Add(Journal::Op::kDelete, key, std::string());
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,115 @@
+#ifndef AFINA_STORAGE_JOURNALED_STORAGE_H
+#define AFINA_STORAGE_JOURNALED_STORAGE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/Padded.h>
+
+#include "Journal.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage with operations journal
+ * Passes operations to the wrapped storage and logs every change that took effect into Journal, so that
+ * storage could be restored after crash. Journal must see changes of a key in order they were applied,
+ * so every change is done under lock of the key's stripe, operations on different keys don't wait for each
+ * other more than wrapped storage makes them to. While journal is failing to write, changes throw
+ * std::runtime_error and leave wrapped storage as it is, rather than be acknowledged and lost. Journal is
+ * checked under the stripe lock, and once change is applied logging it can't fail.
+ *
+ * Save marks the journal: every change logged before the mark is in the snapshot. Compact drops those changes
+ * from journal once the snapshot is committed, so that recovery replays only what came after it.
+ *
+ * Thread safe as much as wrapped storage is
+ */
+class JournaledStorage : public Afina::Storage {
+public:
+    /**
+     * @param storage to pass operations to
+     * @param path journal file
+     * @param sync_interval how often journal is synced, see Journal
+     */
+    JournaledStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+                     std::chrono::milliseconds sync_interval = std::chrono::milliseconds(10));
+    ~JournaledStorage();
+
+    // Implements Afina::Storage interface
+    void Start() override { _storage->Start(); }
+
+    // Implements Afina::Storage interface, syncs journal
+    void Stop() override;
+
+    /**
+     * Applies journal to wrapped storage and starts logging, must be called before anything is changed.
+     * Call it after storage is loaded from snapshot, if any: journal goes on top of it. Returns number of
+     * records in journal
+     */
+    std::size_t Recover();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Stats(const std::string &group, std::vector<std::pair<std::string, std::string>> &stats) override {
+        return _storage->Stats(group, stats);
+    }
+
+    // Implements Afina::Storage interface, remembers journal position the snapshot covers
+    bool Save(SnapshotWriter &snapshot) override;
+
+    /**
+     * Drops journal records covered by the last saved snapshot, call it once that snapshot is committed.
+     * Throws std::runtime_error if journal couldn't be rewritten, it is kept whole then
+     */
+    void Compact();
+
+    // Implements Afina::Storage interface
+    bool Load(SnapshotReader &snapshot, std::size_t threads) override { return _storage->Load(snapshot, threads); }
+
+    /**
+     * Storage operations are passed to
+     */
+    const std::shared_ptr<Afina::Storage> &Wrapped() const { return _storage; }
+
+    /**
+     * Journal changes are logged to
+     */
+    Journal &Log() { return _journal; }
+
+private:
+    static const std::size_t stripes = 64;
+
+    std::mutex &lock_of(const std::string &key) { return _locks[std::hash<std::string>()(key) % stripes].value; }
+
+    std::shared_ptr<Afina::Storage> _storage;
+    Journal _journal;
+    Concurrency::Padded<std::mutex> *_locks;
+
+    // Journal position covered by the last saved snapshot, Save and Compact are called by one thread
+    uint64_t _saved_seq;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_JOURNALED_STORAGE_H
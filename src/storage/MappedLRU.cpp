@@ -0,0 +1,613 @@
+#include "MappedLRU.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/metrics/Metrics.h>
+
+#include "Checksum.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char file_magic[8] = {'A', 'F', 'I', 'N', 'A', 'M', 'A', 'P'};
+
+// Bumped whenever layout or class sizes change, file of another version is created anew
+const uint32_t file_version = 1;
+
+// Chunk holding an item, freed chunks have zero there
+const uint32_t live_mark = 0x4d455449;
+
+const std::size_t max_classes = 64;
+const std::size_t min_chunk = 64;
+const double factor = 1.25;
+const std::size_t alignment = 8;
+const std::size_t page_size = 4096;
+
+std::size_t RoundUp(std::size_t value, std::size_t to) { return (value + to - 1) / to * to; }
+
+std::runtime_error Error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::string(strerror(errno)));
+}
+
+} // namespace
+
+struct MappedLRU::Class {
+    uint64_t size;
+    uint64_t per_slab;
+
+    // Free chunks linked through their first word
+    uint64_t free;
+
+    // Recency list, head is the least recently used item
+    uint64_t head;
+    uint64_t tail;
+
+    // Unused tail of the newest slab
+    uint64_t carve;
+    uint64_t carve_end;
+
+    uint64_t slabs;
+};
+
+struct MappedLRU::SlabEntry {
+    // Class plus one, zero for slabs not given out
+    uint32_t cls;
+    uint32_t reserved;
+    uint64_t checksum;
+};
+
+struct MappedLRU::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t clean;
+
+    // Layout
+    uint64_t region_size;
+    uint64_t slab_size;
+    uint64_t slab_count;
+    uint64_t buckets;
+    uint64_t slab_table;
+    uint64_t index;
+    uint64_t data;
+    uint64_t classes;
+
+    // State
+    uint64_t next_slab;
+    uint64_t clock;
+    uint64_t count;
+    uint64_t cur_size;
+    Class cls[max_classes];
+
+    // Of everything above, slab table and index, valid while clean
+    uint64_t checksum;
+};
+
+struct MappedLRU::Item {
+    // Recency list of the class, the first word links free chunks
+    uint64_t prev;
+    uint64_t next;
+
+    // Next item in the same hash bucket
+    uint64_t chain;
+
+    // Clock value of the last access, orders items on recovery
+    uint64_t stamp;
+
+    uint64_t hash;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint32_t cls;
+    uint32_t live;
+
+    // Of key and value, seeded by hash and key size
+    uint64_t checksum;
+
+    char *key() { return reinterpret_cast<char *>(this + 1); }
+    const char *key() const { return reinterpret_cast<const char *>(this + 1); }
+    char *value() { return key() + key_size; }
+};
+
+// See MappedLRU.h
+MappedLRU::MappedLRU(const std::string &path, std::size_t max_size, std::size_t slab_size)
+    : _path(path), _fd(-1), _region(nullptr) {
+    _slab_size = page_size;
+    while (_slab_size < slab_size) {
+        _slab_size *= 2;
+    }
+    _slab_count = std::max<std::size_t>(1, max_size / _slab_size);
+
+    // Two buckets for an average item of the smallest class
+    _buckets = 1024;
+    while (_buckets < _slab_count * _slab_size / min_chunk / 2) {
+        _buckets *= 2;
+    }
+
+    _slab_table = RoundUp(sizeof(Header), alignment);
+    _index = RoundUp(_slab_table + _slab_count * sizeof(SlabEntry), page_size);
+    _data = RoundUp(_index + _buckets * sizeof(uint64_t), page_size);
+    _region_size = _data + _slab_count * _slab_size;
+
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd == -1) {
+        throw Error("Failed to open storage", path);
+    }
+
+    try {
+        // Two storages on the same file would corrupt each other, the lock goes away along with descriptor
+        if (flock(_fd, LOCK_EX | LOCK_NB) != 0) {
+            throw Error(errno == EWOULDBLOCK ? "Storage is used by another process, failed to lock"
+                                             : "Failed to lock storage",
+                        path);
+        }
+
+        // Header is checked before mapping, file of another layout is truncated so that it is all zeroes
+        struct stat st;
+        Header old;
+        bool reuse = fstat(_fd, &st) == 0 && std::size_t(st.st_size) == _region_size &&
+                     pread(_fd, &old, sizeof(old), 0) == ssize_t(sizeof(old)) && compatible(old);
+        if (!reuse && (ftruncate(_fd, 0) != 0 || ftruncate(_fd, _region_size) != 0)) {
+            throw Error("Failed to allocate storage", path);
+        }
+
+        void *region = mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (region == MAP_FAILED) {
+            throw Error("Failed to map storage", path);
+        }
+        _region = static_cast<char *>(region);
+
+        // Checksums are about to read metadata and every slab given out, those are read ahead at once. Slabs
+        // never given out stay untouched
+        if (reuse) {
+            std::size_t used = _data + std::min<std::size_t>(old.next_slab, _slab_count) * _slab_size;
+            madvise(_region, used, MADV_WILLNEED);
+        }
+
+        if (!reuse) {
+            format();
+            _mode = OpenMode::kCreated;
+        } else if (clean()) {
+            _mode = OpenMode::kAttached;
+        } else {
+            recover();
+            _mode = OpenMode::kRecovered;
+        }
+
+        // From now on file is consistent only after close
+        header().clean = 0;
+        if (msync(_region, page_size, MS_SYNC) != 0) {
+            throw Error("Failed to sync storage", path);
+        }
+    } catch (...) {
+        if (_region != nullptr) {
+            munmap(_region, _region_size);
+        }
+        close(_fd);
+        throw;
+    }
+
+    Metrics::Add(Metrics::Id::kCurrItems, header().count);
+    Metrics::Add(Metrics::Id::kBytes, header().cur_size);
+}
+
+// See MappedLRU.h
+MappedLRU::~MappedLRU() {
+    Header &h = header();
+    Metrics::Add(Metrics::Id::kCurrItems, -int64_t(h.count));
+    Metrics::Add(Metrics::Id::kBytes, -int64_t(h.cur_size));
+
+    for (std::size_t i = 0; i < h.next_slab; i++) {
+        SlabEntry &entry = at<SlabEntry>(_slab_table)[i];
+        if (entry.cls != 0) {
+            entry.checksum = slab_checksum(i);
+        }
+    }
+
+    // Flag is set only once everything else is on disk
+    if (msync(_region, _region_size, MS_SYNC) == 0) {
+        h.clean = 1;
+        h.checksum = meta_checksum();
+        msync(_region, page_size, MS_SYNC);
+    }
+    munmap(_region, _region_size);
+    close(_fd);
+}
+
+// See afina/Storage.h
+bool MappedLRU::Put(const std::string &key, const std::string &value) {
+    uint64_t hash = Checksum(key.data(), key.size());
+    uint64_t *slot = lookup(key.data(), key.size(), hash);
+    if (*slot == 0) {
+        return put_new_item(key, hash, value);
+    }
+    return set_item_value(slot, value);
+}
+
+// See afina/Storage.h
+bool MappedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    uint64_t hash = Checksum(key.data(), key.size());
+    if (*lookup(key.data(), key.size(), hash) != 0) {
+        return false;
+    }
+    return put_new_item(key, hash, value);
+}
+
+// See afina/Storage.h
+bool MappedLRU::Set(const std::string &key, const std::string &value) {
+    uint64_t *slot = lookup(key.data(), key.size(), Checksum(key.data(), key.size()));
+    if (*slot == 0) {
+        return false;
+    }
+    return set_item_value(slot, value);
+}
+
+// See afina/Storage.h
+bool MappedLRU::Delete(const std::string &key) {
+    uint64_t *slot = lookup(key.data(), key.size(), Checksum(key.data(), key.size()));
+    if (*slot == 0) {
+        return false;
+    }
+    remove(slot);
+    return true;
+}
+
+// See afina/Storage.h
+bool MappedLRU::Get(const std::string &key, std::string &value) {
+    uint64_t offset = *lookup(key.data(), key.size(), Checksum(key.data(), key.size()));
+    if (offset == 0) {
+        return false;
+    }
+
+    Item *item = at<Item>(offset);
+    value.assign(item->value(), item->value_size);
+    unlink(item);
+    push_back(item);
+    return true;
+}
+
+// See MappedLRU.h
+std::size_t MappedLRU::Items() const { return header().count; }
+
+uint64_t &MappedLRU::bucket(uint64_t hash) const { return at<uint64_t>(_index)[hash & (_buckets - 1)]; }
+
+void MappedLRU::format() {
+    Header &h = header();
+    std::memcpy(h.magic, file_magic, sizeof(h.magic));
+    h.version = file_version;
+    h.region_size = _region_size;
+    h.slab_size = _slab_size;
+    h.slab_count = _slab_count;
+    h.buckets = _buckets;
+    h.slab_table = _slab_table;
+    h.index = _index;
+    h.data = _data;
+
+    // Same classes as Slab has
+    std::size_t size = min_chunk;
+    for (h.classes = 0; h.classes < max_classes; h.classes++) {
+        if (h.classes == max_classes - 1 || size > _slab_size) {
+            size = _slab_size;
+        }
+        h.cls[h.classes].size = size;
+        h.cls[h.classes].per_slab = _slab_size / size;
+        if (size == _slab_size) {
+            h.classes++;
+            break;
+        }
+        size = RoundUp(std::max<std::size_t>(size * factor, size + alignment), alignment);
+    }
+}
+
+bool MappedLRU::compatible(const Header &h) const {
+    return std::memcmp(h.magic, file_magic, sizeof(h.magic)) == 0 && h.version == file_version &&
+           h.region_size == _region_size && h.slab_size == _slab_size && h.slab_count == _slab_count &&
+           h.buckets == _buckets && h.slab_table == _slab_table && h.index == _index && h.data == _data &&
+           h.classes > 0 && h.classes <= max_classes;
+}
+
+bool MappedLRU::clean() const {
+    Header &h = header();
+    if (h.clean != 1 || h.checksum != meta_checksum() || h.next_slab > _slab_count) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < h.next_slab; i++) {
+        const SlabEntry &entry = at<SlabEntry>(_slab_table)[i];
+        if (entry.cls != 0 && entry.checksum != slab_checksum(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MappedLRU::recover() {
+    Header &h = header();
+    for (std::size_t c = 0; c < h.classes; c++) {
+        Class &cls = h.cls[c];
+        cls.free = cls.head = cls.tail = cls.carve = cls.carve_end = 0;
+        cls.slabs = 0;
+    }
+    std::memset(at<uint64_t>(_index), 0, _buckets * sizeof(uint64_t));
+    h.next_slab = h.clock = h.count = h.cur_size = 0;
+
+    // Chunks that are not valid items become free, slabs never given out are the ones after the last used
+    std::vector<Item *> items;
+    for (std::size_t i = 0; i < _slab_count; i++) {
+        SlabEntry &entry = at<SlabEntry>(_slab_table)[i];
+        if (entry.cls == 0 || entry.cls > h.classes) {
+            entry.cls = 0;
+            continue;
+        }
+
+        std::size_t c = entry.cls - 1;
+        Class &cls = h.cls[c];
+        cls.slabs++;
+        h.next_slab = i + 1;
+
+        char *slab = at<char>(_data + i * _slab_size);
+        for (std::size_t k = 0; k < cls.per_slab; k++) {
+            Item *item = reinterpret_cast<Item *>(slab + k * cls.size);
+            if (valid(item, c)) {
+                items.push_back(item);
+            } else {
+                item->cls = c;
+                release(item);
+            }
+        }
+    }
+
+    // Item could be left twice by interrupted update of value, the later one wins
+    std::sort(items.begin(), items.end(), [](const Item *a, const Item *b) { return a->stamp < b->stamp; });
+    for (Item *item : items) {
+        uint64_t *slot = lookup(item->key(), item->key_size, item->hash);
+        if (*slot != 0) {
+            Item *older = at<Item>(*slot);
+            *slot = older->chain;
+            unlink(older);
+            h.count--;
+            h.cur_size -= older->key_size + older->value_size;
+            release(older);
+            slot = lookup(item->key(), item->key_size, item->hash);
+        }
+
+        item->chain = 0;
+        *slot = offset_of(item);
+        push_back(item);
+        h.count++;
+        h.cur_size += item->key_size + item->value_size;
+    }
+}
+
+uint64_t MappedLRU::slab_checksum(std::size_t slab) const {
+    return Checksum(at<char>(_data + slab * _slab_size), _slab_size, slab);
+}
+
+uint64_t MappedLRU::meta_checksum() const {
+    uint64_t checksum = Checksum(_region, offsetof(Header, checksum));
+    checksum = Checksum(at<char>(_slab_table), _slab_count * sizeof(SlabEntry), checksum);
+    return Checksum(at<char>(_index), _buckets * sizeof(uint64_t), checksum);
+}
+
+std::size_t MappedLRU::class_of(std::size_t size) const {
+    const Header &h = header();
+    std::size_t cls = 0;
+    while (h.cls[cls].size < size) {
+        cls++;
+    }
+    return cls;
+}
+
+bool MappedLRU::valid(const Item *item, std::size_t cls) const {
+    const Header &h = header();
+    return item->live == live_mark && item->cls == cls &&
+           sizeof(Item) + uint64_t(item->key_size) + item->value_size <= h.cls[cls].size &&
+           item->hash == Checksum(item->key(), item->key_size) &&
+           item->checksum == Checksum(item->key(), item->key_size + item->value_size, item->hash + item->key_size);
+}
+
+uint64_t *MappedLRU::lookup(const char *key, std::size_t key_size, uint64_t hash) {
+    uint64_t *slot = &bucket(hash);
+    while (*slot != 0) {
+        Item *item = at<Item>(*slot);
+        if (item->hash == hash && item->key_size == key_size && std::memcmp(item->key(), key, key_size) == 0) {
+            break;
+        }
+        slot = &item->chain;
+    }
+    return slot;
+}
+
+uint64_t *MappedLRU::slot_of(Item *item) {
+    uint64_t offset = offset_of(item);
+    uint64_t *slot = &bucket(item->hash);
+    while (*slot != offset) {
+        slot = &at<Item>(*slot)->chain;
+    }
+    return slot;
+}
+
+bool MappedLRU::put_new_item(const std::string &key, uint64_t hash, const std::string &value) {
+    std::size_t size = sizeof(Item) + key.size() + value.size();
+    if (size > _slab_size) {
+        return false;
+    }
+
+    std::size_t cls = class_of(size);
+    Item *item = alloc(cls);
+    if (item == nullptr) {
+        return false;
+    }
+
+    item->hash = hash;
+    item->key_size = key.size();
+    item->value_size = value.size();
+    item->cls = cls;
+    std::memcpy(item->key(), key.data(), key.size());
+    std::memcpy(item->value(), value.data(), value.size());
+    seal(item);
+
+    // Eviction could have changed the chain, so look for the slot again
+    uint64_t *slot = lookup(key.data(), key.size(), hash);
+    item->chain = 0;
+    *slot = offset_of(item);
+    push_back(item);
+
+    Header &h = header();
+    h.count++;
+    h.cur_size += key.size() + value.size();
+    Metrics::Add(Metrics::Id::kCurrItems);
+    Metrics::Add(Metrics::Id::kBytes, key.size() + value.size());
+    return true;
+}
+
+bool MappedLRU::set_item_value(uint64_t *slot, const std::string &value) {
+    Item *item = at<Item>(*slot);
+    std::size_t size = sizeof(Item) + item->key_size + value.size();
+    if (size > _slab_size) {
+        return false;
+    }
+
+    int64_t delta = int64_t(value.size()) - int64_t(item->value_size);
+    std::size_t cls = class_of(size);
+    unlink(item);
+    if (cls == item->cls) {
+        // Interrupted write leaves checksum mismatch, so item is dropped on recovery
+        std::memcpy(item->value(), value.data(), value.size());
+        item->value_size = value.size();
+        seal(item);
+    } else {
+        // New item is complete before the old one goes, on recovery the later of them wins
+        Item *moved = alloc(cls);
+        if (moved == nullptr) {
+            push_back(item);
+            return false;
+        }
+
+        moved->hash = item->hash;
+        moved->key_size = item->key_size;
+        moved->value_size = value.size();
+        moved->cls = cls;
+        std::memcpy(moved->key(), item->key(), item->key_size);
+        std::memcpy(moved->value(), value.data(), value.size());
+        seal(moved);
+
+        uint64_t *current = slot_of(item);
+        moved->chain = item->chain;
+        *current = offset_of(moved);
+        release(item);
+        item = moved;
+    }
+    push_back(item);
+
+    header().cur_size += delta;
+    Metrics::Add(Metrics::Id::kBytes, delta);
+    return true;
+}
+
+MappedLRU::Item *MappedLRU::alloc(std::size_t cls) {
+    Header &h = header();
+    Class &c = h.cls[cls];
+    while (true) {
+        if (c.free != 0) {
+            Item *item = at<Item>(c.free);
+            c.free = item->prev;
+            return item;
+        }
+
+        if (c.carve != c.carve_end) {
+            Item *item = at<Item>(c.carve);
+            c.carve += c.size;
+            return item;
+        }
+
+        if (h.next_slab < _slab_count) {
+            std::size_t slab = h.next_slab++;
+            at<SlabEntry>(_slab_table)[slab].cls = cls + 1;
+            c.slabs++;
+            c.carve = _data + slab * _slab_size;
+            c.carve_end = c.carve + c.per_slab * c.size;
+            continue;
+        }
+
+        if (c.head == 0) {
+            return nullptr;
+        }
+        remove(slot_of(at<Item>(c.head)));
+        Metrics::Add(Metrics::Id::kEvictions);
+    }
+}
+
+void MappedLRU::release(Item *item) {
+    Class &c = header().cls[item->cls];
+    item->live = 0;
+    item->prev = c.free;
+    c.free = offset_of(item);
+}
+
+void MappedLRU::remove(uint64_t *slot) {
+    Item *item = at<Item>(*slot);
+    *slot = item->chain;
+    unlink(item);
+
+    Header &h = header();
+    h.count--;
+    h.cur_size -= item->key_size + item->value_size;
+    Metrics::Add(Metrics::Id::kCurrItems, -1);
+    Metrics::Add(Metrics::Id::kBytes, -int64_t(item->key_size + item->value_size));
+    release(item);
+}
+
+void MappedLRU::unlink(Item *item) {
+    Class &c = header().cls[item->cls];
+    if (item->prev != 0) {
+        at<Item>(item->prev)->next = item->next;
+    } else {
+        c.head = item->next;
+    }
+
+    if (item->next != 0) {
+        at<Item>(item->next)->prev = item->prev;
+    } else {
+        c.tail = item->prev;
+    }
+    item->prev = item->next = 0;
+}
+
+void MappedLRU::push_back(Item *item) {
+    Header &h = header();
+    Class &c = h.cls[item->cls];
+    uint64_t offset = offset_of(item);
+    item->stamp = ++h.clock;
+    item->prev = c.tail;
+    item->next = 0;
+    if (c.tail != 0) {
+        at<Item>(c.tail)->next = offset;
+    } else {
+        c.head = offset;
+    }
+    c.tail = offset;
+}
+
+void MappedLRU::seal(Item *item) {
+    item->checksum = Checksum(item->key(), item->key_size + item->value_size, item->hash + item->key_size);
+
+    // Contents must be in place before the mark, in case process dies in between
+    std::atomic_signal_fence(std::memory_order_release);
+    item->live = live_mark;
+}
+
+} // namespace Backend
+} // namespace Afina
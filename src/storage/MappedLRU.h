@@ -0,0 +1,191 @@
+#ifndef AFINA_STORAGE_MAPPED_LRU_H
+#define AFINA_STORAGE_MAPPED_LRU_H
+
+#include <cstdint>
+#include <string>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU living in a mapped file
+ * Items, index and allocator state are kept in a file mapped with MAP_SHARED, everything refers to everything
+ * else by offsets from the region start. So the cache survives restart: new process maps the same file and
+ * goes on with items of the previous one without rebuilding anything. It still reads every slab given out
+ * once, to check slab checksums, so reattach costs a sequential read of the used part of the file. File is
+ * locked with flock while storage is open, the second one to open it fails.
+ *
+ * Memory is split into slabs given to size classes as in SlabLRU, every class has its own recency list and
+ * evicts its least recently used item. Neither slabs move between classes nor index grows, both are fixed
+ * once file is created.
+ *
+ * Region is consistent only while no operation is in progress, so file keeps a versioned header with clean
+ * flag. Closing storage syncs region, checksums every slab and header and only then sets the flag, opening
+ * resets it. If file was left unclean, or any checksum doesn't match, storage is recovered from items alone:
+ * every item carries a checksum of its key and value, so slabs are scanned, items passing the check are put
+ * back in recency order of their last access and all the rest is freed. Torn writes lose items, but never
+ * turn into wrong values.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class MappedLRU : public Afina::Storage {
+public:
+    /**
+     * How storage was opened
+     */
+    enum class OpenMode {
+        // File was created or didn't match parameters
+        kCreated,
+
+        // File was closed cleanly, storage went on with it as is
+        kAttached,
+
+        // Storage was rebuilt from items that passed checksum
+        kRecovered
+    };
+
+    /**
+     * Opens storage in file at path of max_size bytes, or creates one. Throws std::runtime_error if file
+     * couldn't be opened, locked or mapped
+     *
+     * @param path file that keeps the storage
+     * @param max_size bytes of slabs, rounded down to slab_size but at least one slab
+     * @param slab_size bytes in a slab, that is also the largest item
+     */
+    explicit MappedLRU(const std::string &path, std::size_t max_size = 64 * 1024 * 1024,
+                       std::size_t slab_size = 1024 * 1024);
+
+    /**
+     * Syncs region and marks file as clean
+     */
+    ~MappedLRU();
+
+    MappedLRU(const MappedLRU &) = delete;
+    MappedLRU &operator=(const MappedLRU &) = delete;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    /**
+     * How storage was opened and number of items it took from file
+     */
+    OpenMode Mode() const { return _mode; }
+    std::size_t Items() const;
+
+private:
+    struct Header;
+    struct Item;
+
+    struct Class;
+    struct SlabEntry;
+
+    template <typename T> T *at(uint64_t offset) const { return reinterpret_cast<T *>(_region + offset); }
+    uint64_t offset_of(const void *ptr) const { return static_cast<const char *>(ptr) - _region; }
+
+    Header &header() const { return *at<Header>(0); }
+    uint64_t &bucket(uint64_t hash) const;
+
+    /**
+     * Lays out a new storage in the whole region
+     */
+    void format();
+
+    /**
+     * Whether header describes storage of the same layout
+     */
+    bool compatible(const Header &header) const;
+
+    /**
+     * Whether storage was closed cleanly and nothing changed since then
+     */
+    bool clean() const;
+
+    /**
+     * Rebuilds allocator, index and recency lists from items passing checksum
+     */
+    void recover();
+
+    /**
+     * Checksums of slab contents and of header along with slab table and index, stored on close and checked
+     * on open
+     */
+    uint64_t slab_checksum(std::size_t slab) const;
+    uint64_t meta_checksum() const;
+
+    /**
+     * Class of the smallest chunks that fit size bytes
+     */
+    std::size_t class_of(std::size_t size) const;
+
+    /**
+     * Whether chunk of the class holds an item that passes checksum
+     */
+    bool valid(const Item *item, std::size_t cls) const;
+
+    /**
+     * Slot of the index that holds item with the key, or the empty slot at the end of the bucket chain
+     */
+    uint64_t *lookup(const char *key, std::size_t key_size, uint64_t hash);
+    uint64_t *slot_of(Item *item);
+
+    bool put_new_item(const std::string &key, uint64_t hash, const std::string &value);
+    bool set_item_value(uint64_t *slot, const std::string &value);
+
+    /**
+     * Takes a chunk of the class, evicting items of this class if there is none. Returns nullptr if nothing
+     * is left to evict
+     */
+    Item *alloc(std::size_t cls);
+
+    /**
+     * Puts chunk to the free list of its class, chunk stops being an item
+     */
+    void release(Item *item);
+
+    /**
+     * Removes item from index and recency list and releases its chunk
+     */
+    void remove(uint64_t *slot);
+
+    void unlink(Item *item);
+    void push_back(Item *item);
+
+    /**
+     * Checksums item contents and marks chunk as item, that is the last write of a new item
+     */
+    void seal(Item *item);
+
+    std::string _path;
+    int _fd;
+    char *_region;
+    std::size_t _region_size;
+
+    // Layout the file must match
+    std::size_t _slab_size;
+    std::size_t _slab_count;
+    std::size_t _buckets;
+    std::size_t _slab_table;
+    std::size_t _index;
+    std::size_t _data;
+
+    OpenMode _mode;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAPPED_LRU_H
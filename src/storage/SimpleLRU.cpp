@@ -1,8 +1,22 @@
 #include "SimpleLRU.h"
 
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <afina/Snapshot.h>
+#include <afina/metrics/Metrics.h>
+
 namespace Afina {
 namespace Backend {
 
+namespace {
+
+// Snapshot section size, so that big storage is loaded by several threads
+const std::size_t section_size = 4 * 1024 * 1024;
+
+} // namespace
+
     void SimpleLRU::delete_chosen_node(SimpleLRU::lru_node &node_to_del) {
         if (node_to_del.prev == nullptr && node_to_del.next == nullptr) { // case head == tail
             _lru_tail = nullptr;
@@ -24,6 +38,9 @@ namespace Backend {
     void SimpleLRU::delete_lru_node() {
         _lru_index.erase(_lru_head->key);
         _cur_size -= _lru_head->key.size() + _lru_head->value.size();
+        Metrics::Add(Metrics::Id::kCurrItems, -1);
+        Metrics::Add(Metrics::Id::kBytes, -int64_t(_lru_head->key.size() + _lru_head->value.size()));
+        Metrics::Add(Metrics::Id::kEvictions);
 
         if (_lru_head->next != nullptr) {
             _lru_head = std::move(_lru_head->next);
@@ -64,6 +81,7 @@ namespace Backend {
             delete_lru_node();
         }
         _cur_size = _cur_size + value.size() - node_found.value.size();
+        Metrics::Add(Metrics::Id::kBytes, int64_t(value.size()) - int64_t(node_found.value.size()));
         node_found.value = value;
 
         return true;
@@ -81,6 +99,8 @@ namespace Backend {
                 _lru_tail = _lru_head.get();
                 _lru_index.insert({std::cref(_lru_head->key), std::ref(*new_node)});
                 _cur_size += ovr_size;
+                Metrics::Add(Metrics::Id::kCurrItems);
+                Metrics::Add(Metrics::Id::kBytes, ovr_size);
                 return true;
             } else {
                 return false;
@@ -93,13 +113,20 @@ namespace Backend {
             }
             auto new_node = new lru_node{key, value, nullptr, nullptr}; //inserting
             auto ptr = std::unique_ptr<lru_node>(new_node);
-            ptr->prev = _lru_tail;
-            _lru_tail->next = std::move(ptr);
-            _lru_tail = _lru_tail->next.get();
+            if (_lru_tail == nullptr) { // everything got evicted
+                _lru_head = std::move(ptr);
+                _lru_tail = _lru_head.get();
+            } else {
+                ptr->prev = _lru_tail;
+                _lru_tail->next = std::move(ptr);
+                _lru_tail = _lru_tail->next.get();
+            }
 
             _lru_index.insert({std::cref(_lru_tail->key), std::ref(*new_node)});
 
             _cur_size += ovr_size;
+            Metrics::Add(Metrics::Id::kCurrItems);
+            Metrics::Add(Metrics::Id::kBytes, ovr_size);
             return true;
         } else { // case inserting is impossible
             return false;
@@ -149,6 +176,8 @@ namespace Backend {
         lru_node& node_to_del = search->second.get();
         _lru_index.erase(key);
         _cur_size -= key.size() + node_to_del.value.size();
+        Metrics::Add(Metrics::Id::kCurrItems, -1);
+        Metrics::Add(Metrics::Id::kBytes, -int64_t(key.size() + node_to_del.value.size()));
         delete_chosen_node(node_to_del);
         return true;
     }
@@ -169,5 +198,129 @@ namespace Backend {
 
     }
 
+    // See SimpleLRU.h
+    bool SimpleLRU::Save(SnapshotWriter &snapshot) {
+        for (lru_node *node = _lru_head.get(); node != nullptr; node = node->next.get()) {
+            snapshot.Add(node->key, node->value);
+            if (snapshot.Pending() >= section_size) {
+                snapshot.EndSection();
+            }
+        }
+        snapshot.EndSection();
+        return true;
+    }
+
+    // See SimpleLRU.h
+    void SimpleLRU::CopyItems(std::vector<std::pair<std::string, std::string>> &items) const {
+        items.reserve(_lru_index.size());
+        for (lru_node *node = _lru_head.get(); node != nullptr; node = node->next.get()) {
+            items.emplace_back(node->key, node->value);
+        }
+    }
+
+    // See SimpleLRU.h
+    void SimpleLRU::SaveItems(SnapshotWriter &snapshot, const std::vector<std::pair<std::string, std::string>> &items) {
+        for (const auto &item : items) {
+            snapshot.Add(item.first, item.second);
+            if (snapshot.Pending() >= section_size) {
+                snapshot.EndSection();
+            }
+        }
+        snapshot.EndSection();
+    }
+
+    // See SimpleLRU.h
+    bool SimpleLRU::Load(SnapshotReader &snapshot, std::size_t threads) {
+        if (_lru_head != nullptr) {
+            throw std::runtime_error("Snapshot could be loaded only into empty storage");
+        }
+
+        // Nodes of a section in order, freed one by one to keep stack shallow
+        struct Chain {
+            Chain() : tail(nullptr), size(0), count(0) {}
+            ~Chain() {
+                while (head != nullptr) {
+                    head = std::move(head->next);
+                }
+            }
+
+            void append(std::unique_ptr<lru_node> node) {
+                node->prev = tail;
+                lru_node *last = node.get();
+                if (tail != nullptr) {
+                    tail->next = std::move(node);
+                } else {
+                    head = std::move(node);
+                }
+                tail = last;
+            }
+
+            std::unique_ptr<lru_node> head;
+            lru_node *tail;
+            std::size_t size;
+            std::size_t count;
+        };
+
+        std::vector<Chain> chains(snapshot.Sections());
+        snapshot.Read(threads, [&chains](SnapshotReader::Section &section) {
+            Chain &chain = chains[section.Index()];
+            const char *key, *value;
+            std::size_t key_size, value_size;
+            while (section.Next(key, key_size, value, value_size)) {
+                chain.append(std::unique_ptr<lru_node>(
+                    new lru_node{std::string(key, key_size), std::string(value, value_size), nullptr, nullptr}));
+                chain.size += key_size + value_size;
+                chain.count++;
+            }
+        });
+
+        Chain all;
+        for (Chain &chain : chains) {
+            if (chain.head == nullptr) {
+                continue;
+            }
+            lru_node *tail = chain.tail;
+            all.append(std::move(chain.head));
+            all.tail = tail;
+            all.size += chain.size;
+            all.count += chain.count;
+        }
+
+        // The oldest items don't fit, just like they would be evicted if put one by one
+        while (all.head != nullptr && all.size > _max_size) {
+            all.size -= all.head->key.size() + all.head->value.size();
+            all.count--;
+            all.head = std::move(all.head->next);
+            if (all.head != nullptr) {
+                all.head->prev = nullptr;
+            } else {
+                all.tail = nullptr;
+            }
+        }
+
+        // Sorted nodes are appended to the tree end, that is a constant time per node
+        std::vector<lru_node *> nodes;
+        nodes.reserve(all.count);
+        for (lru_node *node = all.head.get(); node != nullptr; node = node->next.get()) {
+            nodes.push_back(node);
+        }
+        std::sort(nodes.begin(), nodes.end(), [](const lru_node *a, const lru_node *b) { return a->key < b->key; });
+        for (std::size_t i = 1; i < nodes.size(); i++) {
+            if (nodes[i - 1]->key == nodes[i]->key) {
+                throw std::runtime_error("Snapshot has duplicate keys");
+            }
+        }
+        for (lru_node *node : nodes) {
+            _lru_index.emplace_hint(_lru_index.end(), std::cref(node->key), std::ref(*node));
+        }
+
+        _lru_head = std::move(all.head);
+        _lru_tail = all.tail;
+        _cur_size = all.size;
+        Metrics::Add(Metrics::Id::kCurrItems, all.count);
+        Metrics::Add(Metrics::Id::kBytes, all.size);
+        return true;
+    }
+
 } // namespace Backend
 } // namespace Afina
\ No newline at end of file
@@ -5,8 +5,11 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <afina/Storage.h>
+#include <afina/metrics/Metrics.h>
 
 namespace Afina {
 namespace Backend {
@@ -20,6 +23,9 @@ public:
     explicit SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0), _lru_head(nullptr), _lru_tail(nullptr) {}
 
     ~SimpleLRU() override {
+        // Items die together with the storage
+        Metrics::Add(Metrics::Id::kCurrItems, -int64_t(_lru_index.size()));
+        Metrics::Add(Metrics::Id::kBytes, -int64_t(_cur_size));
         _lru_index.clear();
 
         if (_lru_head != nullptr) {
@@ -48,6 +54,24 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface, big storage is split in sections to be loaded in parallel
+    bool Save(SnapshotWriter &snapshot) override;
+
+    // Implements Afina::Storage interface. Sections become node lists in parallel, then index is built at
+    // once from nodes sorted by key
+    bool Load(SnapshotReader &snapshot, std::size_t threads) override;
+
+protected:
+    /**
+     * Copies items in recency order, so that snapshot could be written out without holding the storage
+     */
+    void CopyItems(std::vector<std::pair<std::string, std::string>> &items) const;
+
+    /**
+     * Writes copied items to snapshot, split in sections as Save does
+     */
+    static void SaveItems(SnapshotWriter &snapshot, const std::vector<std::pair<std::string, std::string>> &items);
+
 private:
 
     // LRU cache node
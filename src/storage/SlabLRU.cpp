@@ -0,0 +1,389 @@
+#include "SlabLRU.h"
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+#include <afina/Snapshot.h>
+#include <afina/metrics/Metrics.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Index starts small, stripes of StripedLRU are many
+const std::size_t initial_buckets = 64;
+
+} // namespace
+
+SlabLRU::SlabLRU(size_t max_size) : SlabLRU(std::make_shared<Allocator::Slab>(max_size)) {}
+
+SlabLRU::SlabLRU(std::shared_ptr<Allocator::Slab> slab)
+    : _slab(std::move(slab)), _lru(_slab->classes(), Lru{nullptr, nullptr}), _index(initial_buckets, nullptr),
+      _count(0), _cur_size(0), _next_peer(0) {}
+
+SlabLRU::~SlabLRU() {
+    Metrics::Add(Metrics::Id::kCurrItems, -int64_t(_count));
+    Metrics::Add(Metrics::Id::kBytes, -int64_t(_cur_size));
+
+    // Allocator could outlive the storage, give chunks back
+    for (auto &lru : _lru) {
+        for (Item *item = lru.head; item != nullptr;) {
+            Item *next = item->next;
+            _slab->free(item);
+            item = next;
+        }
+    }
+}
+
+// See afina/Storage.h
+bool SlabLRU::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    Item **slot = lookup(key, hash);
+    if (*slot == nullptr) {
+        return put_new_item(key, hash, value);
+    }
+    return set_item_value(slot, value);
+}
+
+// See afina/Storage.h
+bool SlabLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = std::hash<std::string>()(key);
+    if (*lookup(key, hash) != nullptr) {
+        return false;
+    }
+    return put_new_item(key, hash, value);
+}
+
+// See afina/Storage.h
+bool SlabLRU::Set(const std::string &key, const std::string &value) {
+    Item **slot = lookup(key, std::hash<std::string>()(key));
+    if (*slot == nullptr) {
+        return false;
+    }
+    return set_item_value(slot, value);
+}
+
+// See afina/Storage.h
+bool SlabLRU::Delete(const std::string &key) {
+    Item **slot = lookup(key, std::hash<std::string>()(key));
+    if (*slot == nullptr) {
+        return false;
+    }
+    remove(slot);
+    return true;
+}
+
+// See afina/Storage.h
+bool SlabLRU::Get(const std::string &key, std::string &value) {
+    Item *item = *lookup(key, std::hash<std::string>()(key));
+    if (item == nullptr) {
+        return false;
+    }
+
+    value.assign(item->value(), item->value_size);
+    unlink(item);
+    push_back(item);
+    return true;
+}
+
+// See afina/Storage.h
+bool SlabLRU::Stats(const std::string &group, std::vector<std::pair<std::string, std::string>> &stats) {
+    if (group != "slabs") {
+        return false;
+    }
+    SlabStats(*_slab, stats);
+    return true;
+}
+
+// See afina/Storage.h
+bool SlabLRU::Save(SnapshotWriter &snapshot) {
+    SaveItems(snapshot);
+    snapshot.EndSection();
+    return true;
+}
+
+// See afina/Storage.h
+bool SlabLRU::Load(SnapshotReader &snapshot, std::size_t) {
+    if (_count != 0) {
+        throw std::runtime_error("Snapshot could be loaded only into empty storage");
+    }
+
+    // Index is sized for all items at once instead of growing step by step
+    std::size_t buckets = _index.size();
+    while (buckets < snapshot.Records()) {
+        buckets *= 2;
+    }
+    _index.assign(buckets, nullptr);
+
+    // Single index takes items one by one anyway, a single thread keeps sections in order
+    std::string key, value;
+    snapshot.Read(1, [this, &key, &value](SnapshotReader::Section &section) {
+        const char *key_data, *value_data;
+        std::size_t key_size, value_size;
+        while (section.Next(key_data, key_size, value_data, value_size)) {
+            key.assign(key_data, key_size);
+            value.assign(value_data, value_size);
+            SlabLRU::Put(key, value);
+        }
+    });
+    return true;
+}
+
+// See SlabLRU.h
+void SlabLRU::SaveItems(SnapshotWriter &snapshot) {
+    for (const Lru &lru : _lru) {
+        for (Item *item = lru.head; item != nullptr; item = item->next) {
+            snapshot.Add(item->key(), item->key_size, item->value(), item->value_size);
+        }
+    }
+}
+
+// See SlabLRU.h
+void SlabLRU::EvictRange(std::size_t cls, const char *begin, const char *end) {
+    // Chunks of the slab are walked by stride, the recency list of a small class could be millions long.
+    // Chunk could be free or hold an item of another storage sharing the allocator, then its header means
+    // nothing to us: it only picks a bucket, and the chunk is ours if that bucket chains to it
+    std::size_t chunk_size = _slab->chunk_size(cls);
+    for (const char *at = begin; at + chunk_size <= end; at += chunk_size) {
+        Item **slot = range_slot(at);
+        if (slot != nullptr) {
+            remove(slot);
+            Metrics::Add(Metrics::Id::kEvictions);
+        }
+    }
+}
+
+// See SlabLRU.h
+std::size_t SlabLRU::CountRange(std::size_t cls, const char *begin, const char *end) {
+    std::size_t count = 0;
+    std::size_t chunk_size = _slab->chunk_size(cls);
+    for (const char *at = begin; at + chunk_size <= end; at += chunk_size) {
+        count += range_slot(at) != nullptr;
+    }
+    return count;
+}
+
+// See SlabLRU.h
+bool SlabLRU::EvictFor(std::size_t cls) {
+    if (_lru[cls].head == nullptr) {
+        return false;
+    }
+    remove(slot_of(_lru[cls].head));
+    Metrics::Add(Metrics::Id::kEvictions);
+    return true;
+}
+
+// See SlabLRU.h
+void SlabLRU::SlabStats(const Allocator::Slab &slab, std::vector<std::pair<std::string, std::string>> &stats) {
+    std::vector<Allocator::Slab::ClassStats> classes = slab.stats();
+    std::size_t active = 0;
+    for (std::size_t i = 0; i < classes.size(); i++) {
+        const Allocator::Slab::ClassStats &cls = classes[i];
+        if (cls.slabs == 0) {
+            continue;
+        }
+        active++;
+
+        // memcached numbers classes from 1
+        std::string prefix = std::to_string(i + 1) + ":";
+        stats.emplace_back(prefix + "chunk_size", std::to_string(cls.chunk_size));
+        stats.emplace_back(prefix + "chunks_per_page", std::to_string(cls.chunks_per_slab));
+        stats.emplace_back(prefix + "total_pages", std::to_string(cls.slabs));
+        stats.emplace_back(prefix + "total_chunks", std::to_string(cls.slabs * cls.chunks_per_slab));
+        stats.emplace_back(prefix + "used_chunks", std::to_string(cls.used_chunks));
+        stats.emplace_back(prefix + "free_chunks", std::to_string(cls.free_chunks));
+        stats.emplace_back(prefix + "free_chunks_end", std::to_string(cls.free_chunks_end));
+    }
+    stats.emplace_back("active_slabs", std::to_string(active));
+    stats.emplace_back("total_malloced", std::to_string(slab.used_slabs() * slab.max_size()));
+    stats.emplace_back("slabs_moved", std::to_string(slab.slabs_moved()));
+    stats.emplace_back("huge_pages", slab.huge_pages() ? "1" : "0");
+}
+
+SlabLRU::Item **SlabLRU::lookup(const std::string &key, std::size_t hash) {
+    Item **slot = &_index[hash & (_index.size() - 1)];
+    while (*slot != nullptr) {
+        Item *item = *slot;
+        if (item->hash == hash && item->key_size == key.size() && std::memcmp(item->key(), key.data(), key.size()) == 0) {
+            break;
+        }
+        slot = &item->chain;
+    }
+    return slot;
+}
+
+SlabLRU::Item **SlabLRU::range_slot(const char *chunk) {
+    const Item *item = reinterpret_cast<const Item *>(chunk);
+    Item **slot = &_index[item->hash & (_index.size() - 1)];
+    while (*slot != nullptr && *slot != item) {
+        slot = &(*slot)->chain;
+    }
+    return *slot != nullptr ? slot : nullptr;
+}
+
+SlabLRU::Item **SlabLRU::slot_of(Item *item) {
+    Item **slot = &_index[item->hash & (_index.size() - 1)];
+    while (*slot != item) {
+        slot = &(*slot)->chain;
+    }
+    return slot;
+}
+
+bool SlabLRU::put_new_item(const std::string &key, std::size_t hash, const std::string &value) {
+    std::size_t size = sizeof(Item) + key.size() + value.size();
+    if (size > _slab->max_size()) {
+        return false;
+    }
+
+    std::size_t cls = _slab->class_of(size);
+    Item *item = static_cast<Item *>(alloc(cls));
+    if (item == nullptr) {
+        return false;
+    }
+
+    item->hash = hash;
+    item->key_size = key.size();
+    item->value_size = value.size();
+    item->cls = cls;
+    std::memcpy(item->key(), key.data(), key.size());
+    std::memcpy(item->value(), value.data(), value.size());
+
+    // Eviction could have changed the chain, so look for the slot again
+    Item **slot = lookup(key, hash);
+    item->chain = nullptr;
+    *slot = item;
+    push_back(item);
+
+    _count++;
+    _cur_size += key.size() + value.size();
+    Metrics::Add(Metrics::Id::kCurrItems);
+    Metrics::Add(Metrics::Id::kBytes, key.size() + value.size());
+
+    if (_count > _index.size()) {
+        grow_index();
+    }
+    return true;
+}
+
+bool SlabLRU::set_item_value(Item **slot, const std::string &value) {
+    Item *item = *slot;
+    std::size_t size = sizeof(Item) + item->key_size + value.size();
+    if (size > _slab->max_size()) {
+        return false;
+    }
+
+    int64_t delta = int64_t(value.size()) - int64_t(item->value_size);
+    std::size_t cls = _slab->class_of(size);
+    unlink(item);
+    if (cls == item->cls) {
+        std::memcpy(item->value(), value.data(), value.size());
+        item->value_size = value.size();
+    } else {
+        // Item moves to another class, the old chunk is kept until the new one is there. Items evicted meanwhile
+        // are of the other class, so the old one stays in place
+        Item *moved = static_cast<Item *>(alloc(cls));
+        if (moved == nullptr) {
+            push_back(item);
+            return false;
+        }
+
+        std::memcpy(moved, item, sizeof(Item) + item->key_size);
+        std::memcpy(moved->value(), value.data(), value.size());
+        moved->value_size = value.size();
+        moved->cls = cls;
+
+        *slot_of(item) = moved;
+        _slab->free(item);
+        item = moved;
+    }
+    push_back(item);
+
+    _cur_size += delta;
+    Metrics::Add(Metrics::Id::kBytes, delta);
+    return true;
+}
+
+void *SlabLRU::alloc(std::size_t cls) {
+    while (true) {
+        void *chunk = _slab->alloc(cls);
+        if (chunk != nullptr) {
+            return chunk;
+        }
+
+        if (_lru[cls].head != nullptr) {
+            remove(slot_of(_lru[cls].head));
+            Metrics::Add(Metrics::Id::kEvictions);
+            continue;
+        }
+
+        // Memory is held by peers, take it from the first one having an item of the class
+        bool evicted = false;
+        for (std::size_t i = 0; i < _peers.size() && !evicted; i++) {
+            SlabLRU *peer = _peers[(_next_peer + i) % _peers.size()];
+            evicted = peer != this && peer->EvictFor(cls);
+        }
+        if (!evicted) {
+            return nullptr;
+        }
+        _next_peer = (_next_peer + 1) % _peers.size();
+    }
+}
+
+void SlabLRU::remove(Item **slot) {
+    Item *item = *slot;
+    *slot = item->chain;
+    unlink(item);
+
+    _count--;
+    _cur_size -= item->key_size + item->value_size;
+    Metrics::Add(Metrics::Id::kCurrItems, -1);
+    Metrics::Add(Metrics::Id::kBytes, -int64_t(item->key_size + item->value_size));
+    _slab->free(item);
+}
+
+void SlabLRU::grow_index() {
+    std::vector<Item *> index(_index.size() * 2, nullptr);
+    for (Item *head : _index) {
+        while (head != nullptr) {
+            Item *next = head->chain;
+            Item *&bucket = index[head->hash & (index.size() - 1)];
+            head->chain = bucket;
+            bucket = head;
+            head = next;
+        }
+    }
+    _index.swap(index);
+}
+
+void SlabLRU::unlink(Item *item) {
+    Lru &lru = _lru[item->cls];
+    if (item->prev != nullptr) {
+        item->prev->next = item->next;
+    } else {
+        lru.head = item->next;
+    }
+
+    if (item->next != nullptr) {
+        item->next->prev = item->prev;
+    } else {
+        lru.tail = item->prev;
+    }
+    item->prev = item->next = nullptr;
+}
+
+void SlabLRU::push_back(Item *item) {
+    Lru &lru = _lru[item->cls];
+    item->prev = lru.tail;
+    item->next = nullptr;
+    if (lru.tail != nullptr) {
+        lru.tail->next = item;
+    } else {
+        lru.head = item;
+    }
+    lru.tail = item;
+}
+
+} // namespace Backend
+} // namespace Afina
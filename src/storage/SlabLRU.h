@@ -0,0 +1,189 @@
+#ifndef AFINA_STORAGE_SLAB_LRU_H
+#define AFINA_STORAGE_SLAB_LRU_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Slab.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU with items in slabs
+ * Every item is a single slab chunk: header, key and value together, the index is a hash table chained through
+ * item headers. So storage makes no heap allocations per item and never takes more than the slab allocator
+ * limit, like memcached does.
+ *
+ * Chunk of one size class can't hold an item of another, so evicting just the least recently used item
+ * doesn't necessarily make room. Every class has its own recency list instead, and a new item evicts the
+ * least recently used item of its class.
+ *
+ * Allocator could be shared by several storages, e.g by stripes of StripedLRU, then each storage evicts
+ * its own items first and asks its peers only once it has no items of the class left. Slabs are moved
+ * between classes by SlabRebalancer, thread safe versions run it in background between Start and Stop.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class SlabLRU : public Afina::Storage {
+public:
+    /**
+     * Storage with its own allocator of max_size bytes
+     */
+    explicit SlabLRU(size_t max_size = 64 * 1024 * 1024);
+
+    /**
+     * Storage sharing allocator with others
+     */
+    explicit SlabLRU(std::shared_ptr<Allocator::Slab> slab);
+
+    ~SlabLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface, knows "slabs" group
+    bool Stats(const std::string &group, std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface, items of every class go in their recency order
+    bool Save(SnapshotWriter &snapshot) override;
+
+    // Implements Afina::Storage interface, sections are loaded one after another in their order
+    bool Load(SnapshotReader &snapshot, std::size_t threads) override;
+
+    /**
+     * Adds items to the current snapshot section without ending it, so that items are copied first and
+     * written out later
+     */
+    virtual void SaveItems(SnapshotWriter &snapshot);
+
+    /**
+     * Evicts items of the class placed in [begin, end), that frees a slab moving to another class. Range is
+     * a whole slab of the class, its chunks are checked one by one rather than the recency list
+     */
+    virtual void EvictRange(std::size_t cls, const char *begin, const char *end);
+
+    /**
+     * Number of items of the class placed in [begin, end), that is how many chunks EvictRange would free
+     */
+    virtual std::size_t CountRange(std::size_t cls, const char *begin, const char *end);
+
+    /**
+     * Evicts the least recently used item of the class on behalf of another storage sharing the allocator.
+     * Returns false if there is no such item or storage is busy, see SetPeers
+     */
+    virtual bool EvictFor(std::size_t cls);
+
+    /**
+     * Storages sharing the allocator, this one could be among them. Chunk freed by a peer is taken by the
+     * caller's thread right away, so a storage that has no items of a class still gets memory once the
+     * allocator is full
+     */
+    void SetPeers(std::vector<SlabLRU *> peers) { _peers = std::move(peers); }
+
+    /**
+     * Allocator items live in
+     */
+    const std::shared_ptr<Allocator::Slab> &SlabAllocator() const { return _slab; }
+
+    /**
+     * Appends memcached "stats slabs" of the allocator to stats: per class lines for classes having slabs
+     * followed by totals
+     */
+    static void SlabStats(const Allocator::Slab &slab, std::vector<std::pair<std::string, std::string>> &stats);
+
+private:
+    // Header of item chunk, key and value follow it
+    struct Item {
+        // Recency list of the class
+        Item *prev;
+        Item *next;
+
+        // Next item in the same hash bucket
+        Item *chain;
+
+        std::size_t hash;
+        uint32_t key_size;
+        uint32_t value_size;
+        uint32_t cls;
+
+        char *key() { return reinterpret_cast<char *>(this + 1); }
+        char *value() { return key() + key_size; }
+    };
+
+    // Recency list of a single class, head is the least recently used item
+    struct Lru {
+        Item *head;
+        Item *tail;
+    };
+
+    /**
+     * Slot of the index that holds item with the key, or the empty slot at the end of the bucket chain
+     */
+    Item **lookup(const std::string &key, std::size_t hash);
+
+    /**
+     * Slot of the index that holds item in the chunk, nullptr if chunk is free or belongs to another storage
+     */
+    Item **range_slot(const char *chunk);
+
+    /**
+     * Slot of the index that holds the item
+     */
+    Item **slot_of(Item *item);
+
+    bool put_new_item(const std::string &key, std::size_t hash, const std::string &value);
+
+    bool set_item_value(Item **slot, const std::string &value);
+
+    /**
+     * Takes a chunk of the class, evicting items of this class if there is none, and then items of peers.
+     * Returns nullptr if nothing is left to evict
+     */
+    void *alloc(std::size_t cls);
+
+    /**
+     * Removes item from index and recency list and releases its chunk
+     */
+    void remove(Item **slot);
+
+    void grow_index();
+
+    void unlink(Item *item);
+
+    void push_back(Item *item);
+
+    std::shared_ptr<Allocator::Slab> _slab;
+    std::vector<Lru> _lru;
+
+    // Hash table, size is power of two
+    std::vector<Item *> _index;
+    std::size_t _count;
+
+    // Sum of key and value sizes of all items
+    std::size_t _cur_size;
+
+    // Storages sharing allocator and the one to ask first next time, so evictions are spread among them
+    std::vector<SlabLRU *> _peers;
+    std::size_t _next_peer;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SLAB_LRU_H
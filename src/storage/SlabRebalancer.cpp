@@ -0,0 +1,114 @@
+#include "SlabRebalancer.h"
+
+#include "SlabLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t SlabRebalancer::max_wait;
+
+SlabRebalancer::SlabRebalancer(std::shared_ptr<Allocator::Slab> slab, std::vector<SlabLRU *> owners,
+                               std::chrono::milliseconds interval)
+    : _slab(std::move(slab)), _owners(std::move(owners)), _interval(interval), _failures(_slab->classes(), 0),
+      _waiting(0), _running(false) {}
+
+SlabRebalancer::~SlabRebalancer() { Stop(); }
+
+// See SlabRebalancer.h
+void SlabRebalancer::Start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _thread = std::thread(&SlabRebalancer::Run, this);
+}
+
+// See SlabRebalancer.h
+void SlabRebalancer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _stop.notify_all();
+    _thread.join();
+    _slab->cancel_move();
+}
+
+/**
+ * Receiver is the class with the most failures since the previous round, donor is the largest class that had
+ * none, so classes under similar pressure never trade slabs back and forth
+ */
+bool SlabRebalancer::Step() {
+    std::size_t cls;
+    char *begin, *end;
+    if (!_slab->moving_range(cls, begin, end)) {
+        std::vector<Allocator::Slab::ClassStats> stats = _slab->stats();
+        std::vector<std::size_t> failures(stats.size());
+        for (std::size_t i = 0; i < stats.size(); i++) {
+            failures[i] = stats[i].failures - _failures[i];
+            _failures[i] = stats[i].failures;
+        }
+
+        std::size_t receiver = stats.size(), donor = stats.size();
+        for (std::size_t i = 0; i < stats.size(); i++) {
+            if (failures[i] > 0 && (receiver == stats.size() || failures[i] > failures[receiver])) {
+                receiver = i;
+            }
+        }
+        for (std::size_t i = 0; i < stats.size(); i++) {
+            if (failures[i] == 0 && stats[i].slabs >= 2 && (donor == stats.size() || stats[i].slabs > stats[donor].slabs)) {
+                donor = i;
+            }
+        }
+
+        if (receiver == stats.size() || donor == stats.size() || !_slab->begin_move(donor, receiver)) {
+            return false;
+        }
+        _waiting = 0;
+        _slab->moving_range(cls, begin, end);
+    }
+
+    // Free chunks come back first, then items are evicted if they are all that holds the slab. Items don't get
+    // into moving slab, so the count could only go down meanwhile
+    if (_slab->finish_move()) {
+        return true;
+    }
+    std::size_t held = 0;
+    for (SlabLRU *owner : _owners) {
+        held += owner->CountRange(cls, begin, end);
+    }
+    if (held >= _slab->moving_left()) {
+        for (SlabLRU *owner : _owners) {
+            owner->EvictRange(cls, begin, end);
+        }
+        if (_slab->finish_move()) {
+            return true;
+        }
+    }
+
+    if (++_waiting >= max_wait) {
+        _slab->cancel_move();
+    }
+    return false;
+}
+
+void SlabRebalancer::Run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running) {
+        _stop.wait_for(lock, _interval);
+        if (!_running) {
+            break;
+        }
+
+        lock.unlock();
+        Step();
+        lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,78 @@
+#ifndef AFINA_STORAGE_SLAB_REBALANCER_H
+#define AFINA_STORAGE_SLAB_REBALANCER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Slab.h>
+
+namespace Afina {
+namespace Backend {
+
+class SlabLRU;
+
+/**
+ * # Slab automove
+ * Once sizes of values shift, say from 200B to 2KB, slabs stay with the classes of old sizes, while new items
+ * evict each other in the few slabs their class has got and hit ratio collapses. Rebalancer watches how
+ * often alloc fails in every class and moves slabs from classes that had no failures since the previous
+ * round to the class that had the most, evicting items of the slab from all storages sharing allocator.
+ * Same idea as memcached slab_automove.
+ *
+ * Items of the slab are evicted only once the rest of its chunks are back, so that evictions always pay off.
+ * Chunk held by someone else than the owners could hold the move, it is cancelled after a few rounds and
+ * another slab is tried next time
+ */
+class SlabRebalancer {
+public:
+    /**
+     * @param slab allocator to rebalance
+     * @param owners storages having items in it, must outlive rebalancer
+     * @param interval time between rounds of the background thread
+     */
+    SlabRebalancer(std::shared_ptr<Allocator::Slab> slab, std::vector<SlabLRU *> owners,
+                   std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    ~SlabRebalancer();
+
+    /**
+     * Runs Step every interval in background until Stop
+     */
+    void Start();
+    void Stop();
+
+    /**
+     * Single round: pushes current move forward or starts a new one if some class lacks memory. Returns
+     * true if a slab has been given to another class
+     */
+    bool Step();
+
+private:
+    // Rounds to wait for the moving slab chunks before giving up
+    static constexpr std::size_t max_wait = 10;
+
+    void Run();
+
+    std::shared_ptr<Allocator::Slab> _slab;
+    std::vector<SlabLRU *> _owners;
+    std::chrono::milliseconds _interval;
+
+    // Failures of every class seen by the previous round
+    std::vector<std::size_t> _failures;
+
+    // Rounds current move has been waiting
+    std::size_t _waiting;
+
+    std::mutex _mutex;
+    std::condition_variable _stop;
+    bool _running;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SLAB_REBALANCER_H
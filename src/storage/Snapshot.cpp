@@ -0,0 +1,314 @@
+#include <afina/Snapshot.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Checksum.h"
+
+namespace Afina {
+
+using Backend::Checksum;
+
+namespace {
+
+const char header_magic[8] = {'A', 'F', 'I', 'N', 'A', 'S', 'N', 'P'};
+const char trailer_magic[8] = {'A', 'F', 'I', 'N', 'A', 'E', 'N', 'D'};
+const uint32_t version = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct Trailer {
+    uint64_t table_offset;
+    uint64_t sections;
+    uint64_t table_checksum;
+    char magic[8];
+};
+
+void PutVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool GetVarint(const char *&pos, const char *end, uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && pos < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*pos++);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::runtime_error Error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::string(strerror(errno)));
+}
+
+} // namespace
+
+// See Snapshot.h
+SnapshotWriter::SnapshotWriter(const std::string &path)
+    : _path(path), _tmp_path(path + ".tmp"), _fd(-1), _section_records(0), _records(0), _offset(0) {
+    _fd = open(_tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd == -1) {
+        throw Error("Failed to create snapshot", _tmp_path);
+    }
+
+    Header header;
+    std::memcpy(header.magic, header_magic, sizeof(header.magic));
+    header.version = version;
+    header.reserved = 0;
+    write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+// See Snapshot.h
+SnapshotWriter::~SnapshotWriter() {
+    if (_fd != -1) {
+        close(_fd);
+        unlink(_tmp_path.c_str());
+    }
+}
+
+// See Snapshot.h
+void SnapshotWriter::Add(const char *key, std::size_t key_size, const char *value, std::size_t value_size) {
+    PutVarint(_section, key_size);
+    PutVarint(_section, value_size);
+    _section.append(key, key_size);
+    _section.append(value, value_size);
+    _section_records++;
+}
+
+// See Snapshot.h
+void SnapshotWriter::EndSection() {
+    if (_section_records == 0) {
+        return;
+    }
+
+    Entry entry;
+    entry.offset = _offset;
+    entry.size = _section.size();
+    entry.records = _section_records;
+    entry.checksum = Checksum(_section.data(), _section.size());
+    write(_section.data(), _section.size());
+    _table.push_back(entry);
+
+    _records += _section_records;
+    _section_records = 0;
+    _section.clear();
+}
+
+// See Snapshot.h
+void SnapshotWriter::Commit() {
+    EndSection();
+
+    Trailer trailer;
+    trailer.table_offset = _offset;
+    trailer.sections = _table.size();
+    trailer.table_checksum = Checksum(reinterpret_cast<const char *>(_table.data()), _table.size() * sizeof(Entry));
+    std::memcpy(trailer.magic, trailer_magic, sizeof(trailer.magic));
+    write(reinterpret_cast<const char *>(_table.data()), _table.size() * sizeof(Entry));
+    write(reinterpret_cast<const char *>(&trailer), sizeof(trailer));
+
+    if (fsync(_fd) != 0) {
+        throw Error("Failed to sync snapshot", _tmp_path);
+    }
+    if (rename(_tmp_path.c_str(), _path.c_str()) != 0) {
+        throw Error("Failed to replace snapshot", _path);
+    }
+    close(_fd);
+    _fd = -1;
+
+    // Rename is durable only once directory is synced too
+    std::size_t slash = _path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : _path.substr(0, std::max<std::size_t>(slash, 1));
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd != -1) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+}
+
+void SnapshotWriter::write(const char *data, std::size_t size) {
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::write(_fd, data + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw Error("Failed to write snapshot", _tmp_path);
+        }
+        done += n;
+    }
+    _offset += size;
+}
+
+// See Snapshot.h
+bool SnapshotReader::Section::Next(const char *&key, std::size_t &key_size, const char *&value,
+                                   std::size_t &value_size) {
+    if (_pos == _end) {
+        return false;
+    }
+
+    uint64_t ks, vs;
+    if (!GetVarint(_pos, _end, ks) || !GetVarint(_pos, _end, vs) || ks > std::size_t(_end - _pos) ||
+        vs > std::size_t(_end - _pos) - ks) {
+        throw std::runtime_error("Malformed snapshot record");
+    }
+
+    key = _pos;
+    key_size = ks;
+    value = _pos + ks;
+    value_size = vs;
+    _pos += ks + vs;
+    return true;
+}
+
+// See Snapshot.h
+SnapshotReader::SnapshotReader(const std::string &path) : _path(path), _fd(-1) {
+    _fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (_fd == -1) {
+        throw Error("Failed to open snapshot", path);
+    }
+
+    struct stat st;
+    if (fstat(_fd, &st) != 0) {
+        close(_fd);
+        throw Error("Failed to open snapshot", path);
+    }
+
+    try {
+        uint64_t size = st.st_size;
+        if (size < sizeof(Header) + sizeof(Trailer)) {
+            throw std::runtime_error("Snapshot " + path + " is truncated");
+        }
+
+        Header header;
+        read(reinterpret_cast<char *>(&header), sizeof(header), 0);
+        if (std::memcmp(header.magic, header_magic, sizeof(header.magic)) != 0 || header.version != version) {
+            throw std::runtime_error("File " + path + " is not a snapshot");
+        }
+
+        Trailer trailer;
+        read(reinterpret_cast<char *>(&trailer), sizeof(trailer), size - sizeof(trailer));
+        if (std::memcmp(trailer.magic, trailer_magic, sizeof(trailer.magic)) != 0 ||
+            trailer.table_offset < sizeof(Header) || trailer.table_offset > size - sizeof(trailer) ||
+            trailer.sections != (size - sizeof(trailer) - trailer.table_offset) / sizeof(Entry) ||
+            trailer.table_offset + trailer.sections * sizeof(Entry) + sizeof(trailer) != size) {
+            throw std::runtime_error("Snapshot " + path + " is truncated");
+        }
+
+        _table.resize(trailer.sections);
+        read(reinterpret_cast<char *>(_table.data()), _table.size() * sizeof(Entry), trailer.table_offset);
+        if (Checksum(reinterpret_cast<const char *>(_table.data()), _table.size() * sizeof(Entry)) !=
+            trailer.table_checksum) {
+            throw std::runtime_error("Snapshot " + path + " is corrupted");
+        }
+        for (const Entry &entry : _table) {
+            if (entry.offset < sizeof(Header) || entry.offset > trailer.table_offset ||
+                entry.size > trailer.table_offset - entry.offset) {
+                throw std::runtime_error("Snapshot " + path + " is corrupted");
+            }
+        }
+    } catch (...) {
+        close(_fd);
+        throw;
+    }
+
+    // Sections are read front to back, let kernel read ahead
+    posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+// See Snapshot.h
+SnapshotReader::~SnapshotReader() { close(_fd); }
+
+// See Snapshot.h
+std::size_t SnapshotReader::Records() const {
+    std::size_t records = 0;
+    for (const Entry &entry : _table) {
+        records += entry.records;
+    }
+    return records;
+}
+
+// See Snapshot.h
+void SnapshotReader::Read(std::size_t threads, const std::function<void(Section &)> &fn) {
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    auto worker = [&] {
+        std::vector<char> buffer;
+        try {
+            for (std::size_t i = next++; i < _table.size() && !failed.load(); i = next++) {
+                const Entry &entry = _table[i];
+                buffer.resize(entry.size);
+                read(buffer.data(), entry.size, entry.offset);
+                if (Checksum(buffer.data(), entry.size) != entry.checksum) {
+                    throw std::runtime_error("Snapshot " + _path + " is corrupted");
+                }
+
+                Section section(i, buffer.data(), entry.size);
+                fn(section);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_lock);
+            if (!failed.exchange(true)) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    // Calling thread is one of workers
+    threads = std::max<std::size_t>(1, std::min(threads, _table.size()));
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void SnapshotReader::read(char *data, std::size_t size, uint64_t offset) {
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(_fd, data + done, size - done, offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            throw Error("Failed to read snapshot", _path);
+        }
+        if (n == 0) {
+            throw std::runtime_error("Snapshot " + _path + " is truncated");
+        }
+        done += n;
+    }
+}
+
+} // namespace Afina
@@ -4,6 +4,10 @@
 
 #include "StripedLRU.h"
 
+#include <stdexcept>
+
+#include <afina/Snapshot.h>
+
 namespace Afina {
 namespace Backend {
 
@@ -31,9 +35,58 @@ bool StripedLRU::Get(const std::string &key, std::string &value)  {
     return stripe_regions[hash_stripes(key) % stripe_count]->Get(key, value);
 }
 
+// Implements Afina::Storage interface
+bool StripedLRU::Stats(const std::string &group, std::vector<std::pair<std::string, std::string>> &stats) {
+    if (group != "slabs") {
+        return false;
+    }
+    SlabLRU::SlabStats(*slab, stats);
+    return true;
+}
+
+// Implements Afina::Storage interface
+bool StripedLRU::Save(SnapshotWriter &snapshot) {
+    for (auto &stripe : stripe_regions) {
+        stripe->SaveItems(snapshot);
+        snapshot.EndSection();
+    }
+    return true;
+}
+
+// Implements Afina::Storage interface
+bool StripedLRU::Load(SnapshotReader &snapshot, std::size_t threads) {
+    snapshot.Read(threads, [this](SnapshotReader::Section &section) {
+        std::string key, value;
+        const char *key_data, *value_data;
+        std::size_t key_size, value_size;
+        while (section.Next(key_data, key_size, value_data, value_size)) {
+            key.assign(key_data, key_size);
+            value.assign(value_data, value_size);
+            stripe_regions[hash_stripes(key) % stripe_count]->Put(key, value);
+        }
+    });
+    return true;
+}
+
+// Implements Afina::Storage interface
+void StripedLRU::Start() {
+    std::vector<SlabLRU *> owners;
+    for (auto &stripe : stripe_regions) {
+        owners.push_back(stripe.get());
+    }
+    rebalancer.reset(new SlabRebalancer(slab, owners));
+    rebalancer->Start();
+}
+
+// Implements Afina::Storage interface
+void StripedLRU::Stop() { rebalancer.reset(); }
+
 StripedLRU* BuildStripedLRU(std::size_t memory_limit, std::size_t stripe_count) {
-    std::size_t stripe_limit = memory_limit / stripe_count;
-    if (stripe_limit < 1024 * 1024) {
+    // Memory is shared by stripes, so only the whole of it must hold a slab
+    if (stripe_count == 0) {
+        throw std::runtime_error("at least one stripe required");
+    }
+    if (memory_limit < 1024 * 1024) {
         throw std::runtime_error("sufficient storage size, min 1 mb");
     }
     return new StripedLRU(stripe_count, memory_limit);
@@ -6,27 +6,39 @@
 #define AFINA_STRIPEDLRU_H
 
 #include <afina/Storage.h>
-#include "ThreadSafeSimpleLRU.h"
+#include "ThreadSafeSlabLRU.h"
+#include "SlabRebalancer.h"
 
 #include <vector>
 
 namespace Afina {
 namespace Backend {
 
+/**
+ * Stripes share one slab allocator of memory_limit bytes, so memory goes wherever keys land: stripe that has
+ * no items of a class evicts from the other stripes. Single rebalancer moves slabs between classes for all
+ * stripes
+ */
 class StripedLRU : public Afina::Storage{
     std::hash<std::string> hash_stripes;
     std::size_t stripe_count;
-    std::vector<std::unique_ptr<ThreadSafeSimplLRU>> stripe_regions;
+    std::shared_ptr<Allocator::Slab> slab;
+    std::vector<std::unique_ptr<ThreadSafeSlabLRU>> stripe_regions;
+    std::unique_ptr<SlabRebalancer> rebalancer;
 
     StripedLRU(std::size_t stripe_count = 1024, std::size_t memory_limit = 1024 * 1000)
-            : stripe_count(stripe_count) {
+            : stripe_count(stripe_count), slab(std::make_shared<Allocator::Slab>(memory_limit)) {
+        std::vector<SlabLRU *> peers;
         for (size_t i = 0; i < stripe_count; i++) {
-            stripe_regions.emplace_back(new ThreadSafeSimplLRU(memory_limit));
-
+            stripe_regions.emplace_back(new ThreadSafeSlabLRU(slab));
+            peers.push_back(stripe_regions.back().get());
+        }
+        for (auto &stripe : stripe_regions) {
+            stripe->SetPeers(peers);
         }
     }
 public:
-    ~StripedLRU() {}
+    ~StripedLRU() { Stop(); }
 
     friend StripedLRU* BuildStripedLRU(std::size_t memory_limit, std::size_t stripe_count );
 
@@ -44,6 +56,23 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override ;
 
+    // Implements Afina::Storage interface
+    bool Stats(const std::string &group, std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Implements Afina::Storage interface. Stripes are saved one by one, each into its own section: stripe is
+    // locked only while its items are copied, so others keep serving requests
+    bool Save(SnapshotWriter &snapshot) override;
+
+    // Implements Afina::Storage interface. Items go to stripes by key, with the same stripe count section keeps
+    // items of a single stripe, so threads rarely meet at stripe locks
+    bool Load(SnapshotReader &snapshot, std::size_t threads) override;
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
 };
 
 StripedLRU* BuildStripedLRU(std::size_t memory_limit = 10, std::size_t stripe_count = 20);
@@ -0,0 +1,58 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_ARENA_LRU_H
+#define AFINA_STORAGE_THREAD_SAFE_ARENA_LRU_H
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "ArenaLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # ArenaLRU thread safe version
+ */
+class ThreadSafeArenaLRU : public ArenaLRU {
+public:
+    ThreadSafeArenaLRU(size_t max_size = 1024 * 1024) : ArenaLRU(max_size) {}
+    ~ThreadSafeArenaLRU() {}
+
+    // see ArenaLRU.h
+    bool Put(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return ArenaLRU::Put(key, value);
+    }
+
+    // see ArenaLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return ArenaLRU::PutIfAbsent(key, value);
+    }
+
+    // see ArenaLRU.h
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return ArenaLRU::Set(key, value);
+    }
+
+    // see ArenaLRU.h
+    bool Delete(const std::string &key) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return ArenaLRU::Delete(key);
+    }
+
+    // see ArenaLRU.h
+    bool Get(const std::string &key, std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return ArenaLRU::Get(key, value);
+    }
+
+private:
+    std::mutex thread_safe_mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_ARENA_LRU_H
@@ -0,0 +1,59 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_MAPPED_LRU_H
+#define AFINA_STORAGE_THREAD_SAFE_MAPPED_LRU_H
+
+#include <mutex>
+#include <string>
+
+#include "MappedLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # MappedLRU thread safe version
+ *
+ *
+ */
+class ThreadSafeMappedLRU : public MappedLRU {
+public:
+    explicit ThreadSafeMappedLRU(const std::string &path, std::size_t max_size = 64 * 1024 * 1024)
+        : MappedLRU(path, max_size) {}
+
+    // see MappedLRU.h
+    bool Put(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return MappedLRU::Put(key, value);
+    }
+
+    // see MappedLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return MappedLRU::PutIfAbsent(key, value);
+    }
+
+    // see MappedLRU.h
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return MappedLRU::Set(key, value);
+    }
+
+    // see MappedLRU.h
+    bool Delete(const std::string &key) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return MappedLRU::Delete(key);
+    }
+
+    // see MappedLRU.h
+    bool Get(const std::string &key, std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return MappedLRU::Get(key, value);
+    }
+
+private:
+    std::mutex thread_safe_mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_MAPPED_LRU_H
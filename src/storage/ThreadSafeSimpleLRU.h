@@ -4,6 +4,8 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "SimpleLRU.h"
 
@@ -50,6 +52,23 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h, storage is locked only while items are copied, file is written after that
+    bool Save(SnapshotWriter &snapshot) override {
+        std::vector<std::pair<std::string, std::string>> items;
+        {
+            std::lock_guard<std::mutex> lock(thread_safe_mutex);
+            CopyItems(items);
+        }
+        SaveItems(snapshot, items);
+        return true;
+    }
+
+    // see SimpleLRU.h
+    bool Load(SnapshotReader &snapshot, std::size_t threads) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SimpleLRU::Load(snapshot, threads);
+    }
+
 private:
     std::mutex thread_safe_mutex;
 };
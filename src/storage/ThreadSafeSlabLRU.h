@@ -0,0 +1,108 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_SLAB_LRU_H
+#define AFINA_STORAGE_THREAD_SAFE_SLAB_LRU_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "SlabLRU.h"
+#include "SlabRebalancer.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SlabLRU thread safe version
+ * Moves slabs between classes in background while started
+ */
+class ThreadSafeSlabLRU : public SlabLRU {
+public:
+    explicit ThreadSafeSlabLRU(size_t max_size = 64 * 1024 * 1024) : SlabLRU(max_size) {}
+    explicit ThreadSafeSlabLRU(std::shared_ptr<Allocator::Slab> slab) : SlabLRU(std::move(slab)) {}
+    ~ThreadSafeSlabLRU() { Stop(); }
+
+    // Implements Afina::Storage interface
+    void Start() override {
+        rebalancer.reset(new SlabRebalancer(SlabAllocator(), {this}));
+        rebalancer->Start();
+    }
+
+    // Implements Afina::Storage interface
+    void Stop() override { rebalancer.reset(); }
+
+    // see SlabLRU.h
+    bool Put(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::Put(key, value);
+    }
+
+    // see SlabLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::PutIfAbsent(key, value);
+    }
+
+    // see SlabLRU.h
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::Set(key, value);
+    }
+
+    // see SlabLRU.h
+    bool Delete(const std::string &key) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::Delete(key);
+    }
+
+    // see SlabLRU.h
+    bool Get(const std::string &key, std::string &value) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::Get(key, value);
+    }
+
+    // see SlabLRU.h
+    bool Stats(const std::string &group, std::vector<std::pair<std::string, std::string>> &stats) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::Stats(group, stats);
+    }
+
+    // see SlabLRU.h, storage is locked for the whole load
+    bool Load(SnapshotReader &snapshot, std::size_t threads) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::Load(snapshot, threads);
+    }
+
+    // see SlabLRU.h, storage is locked only while items are copied
+    void SaveItems(SnapshotWriter &snapshot) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        SlabLRU::SaveItems(snapshot);
+    }
+
+    // see SlabLRU.h
+    void EvictRange(std::size_t cls, const char *begin, const char *end) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        SlabLRU::EvictRange(cls, begin, end);
+    }
+
+    // see SlabLRU.h
+    std::size_t CountRange(std::size_t cls, const char *begin, const char *end) override {
+        std::lock_guard<std::mutex> lock(thread_safe_mutex);
+        return SlabLRU::CountRange(cls, begin, end);
+    }
+
+    // see SlabLRU.h, peer holding its own lock could be asking this one at the same time, so busy storage is
+    // skipped instead of waited for
+    bool EvictFor(std::size_t cls) override {
+        std::unique_lock<std::mutex> lock(thread_safe_mutex, std::try_to_lock);
+        return lock.owns_lock() && SlabLRU::EvictFor(cls);
+    }
+
+private:
+    std::mutex thread_safe_mutex;
+    std::unique_ptr<SlabRebalancer> rebalancer;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_SLAB_LRU_H
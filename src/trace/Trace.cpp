@@ -0,0 +1,271 @@
+#include <afina/trace/Trace.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+#include "storage/Checksum.h"
+
+namespace Afina {
+namespace Trace {
+
+namespace {
+
+const char magic[8] = {'A', 'F', 'I', 'N', 'A', 'T', 'R', 'C'};
+const uint32_t version = 1;
+
+const std::chrono::milliseconds flush_interval(100);
+
+struct Buffer {
+    std::mutex lock;
+    std::string data;
+};
+
+// Never destroyed: detached threads might still trace something while process exits
+Concurrency::ThreadLocal<Buffer> &Buffers() {
+    static Concurrency::ThreadLocal<Buffer> *buffers = new Concurrency::ThreadLocal<Buffer>();
+    return *buffers;
+}
+
+// Set by Start before trace is enabled
+uint64_t start_time = 0;
+uint32_t sample = 1;
+std::size_t buffer_limit = 0;
+
+std::atomic<uint64_t> written(0);
+std::atomic<uint64_t> dropped(0);
+
+// Guards writer state below
+std::mutex lock;
+std::condition_variable stop;
+bool running = false;
+int fd = -1;
+std::thread writer;
+std::string batch;
+
+// Bytes of complete records in the file after header, and whether writing has failed
+std::size_t file_size = 0;
+bool failed = false;
+
+// Takes out everything threads buffered and writes it to the file
+void Flush() {
+    batch.clear();
+    Buffers().for_each([](Buffer &buffer) {
+        std::lock_guard<std::mutex> lock(buffer.lock);
+        batch.append(buffer.data);
+        buffer.data.clear();
+    });
+
+    // Buffers are taken one after another, records of the interval are put back in order of time. Request
+    // stamped just before the previous flush but buffered after it could still come out of order
+    Record *records = reinterpret_cast<Record *>(&batch[0]);
+    std::stable_sort(records, records + batch.size() / sizeof(Record),
+                     [](const Record &a, const Record &b) { return a.time < b.time; });
+
+    // Trace is best effort, records that couldn't be written count as dropped
+    if (failed) {
+        dropped.fetch_add(batch.size() / sizeof(Record), std::memory_order_relaxed);
+        return;
+    }
+
+    std::size_t done = 0;
+    while (done < batch.size()) {
+        ssize_t n = write(fd, batch.data() + done, batch.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            break;
+        }
+        done += n;
+    }
+
+    // Records have no framing but their size, so part of a record would shift all that follow. It is cut off,
+    // and as whatever made write fail would likely do it again, trace is turned off rather than left with
+    // holes. If even cutting fails, torn record stays the last one and reader skips it
+    std::size_t complete = done - done % sizeof(Record);
+    if (done < batch.size()) {
+        if (complete != done) {
+            ftruncate(fd, sizeof(Header) + file_size + complete);
+        }
+        failed = true;
+        detail::enabled.store(false, std::memory_order_release);
+        dropped.fetch_add((batch.size() - complete) / sizeof(Record), std::memory_order_relaxed);
+    }
+    file_size += complete;
+    written.fetch_add(complete / sizeof(Record), std::memory_order_relaxed);
+}
+
+void Run() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (running) {
+        stop.wait_for(guard, flush_interval);
+        Flush();
+    }
+}
+
+} // namespace
+
+namespace detail {
+
+std::atomic<bool> enabled(false);
+
+// See Trace.h
+void Add(Metrics::Op op, const std::vector<std::string> &keys, std::size_t value_size) {
+    if (!enabled.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // Records go to the buffer eight at a time, so a request takes its lock once or twice, and writer takes it
+    // only to copy records out every flush_interval
+    Buffer &buffer = Buffers().local();
+    Record records[8];
+    std::size_t count = 0;
+    auto append = [&buffer, &records, &count]() {
+        std::lock_guard<std::mutex> lock(buffer.lock);
+        if (buffer.data.size() + count * sizeof(Record) > buffer_limit) {
+            dropped.fetch_add(count, std::memory_order_relaxed);
+        } else {
+            buffer.data.append(reinterpret_cast<const char *>(records), count * sizeof(Record));
+        }
+        count = 0;
+    };
+
+    uint64_t now = Metrics::Now() - start_time;
+    for (auto &key : keys) {
+        uint64_t hash = Hash(key);
+        if (hash % sample != 0) {
+            continue;
+        }
+
+        Record &record = records[count++];
+        record.time = now;
+        record.key_hash = hash;
+        record.value_size = value_size;
+        record.key_size = key.size();
+        record.op = static_cast<uint8_t>(op);
+        record.reserved = 0;
+        if (count == sizeof(records) / sizeof(records[0])) {
+            append();
+        }
+    }
+    if (count > 0) {
+        append();
+    }
+}
+
+} // namespace detail
+
+// See Trace.h
+uint64_t Hash(const std::string &key) { return Backend::Checksum(key.data(), key.size()); }
+
+// See Trace.h
+void Start(const std::string &path, uint32_t sample_rate, std::size_t limit) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (running) {
+        throw std::runtime_error("Trace is running already");
+    }
+
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to create trace " + path + ": " + std::strerror(errno));
+    }
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.sample = sample_rate == 0 ? 1 : sample_rate;
+    header.start_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+    if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+        close(fd);
+        fd = -1;
+        throw std::runtime_error("Failed to write trace " + path + ": " + std::strerror(errno));
+    }
+
+    // Leftovers of the previous trace
+    Buffers().for_each([](Buffer &buffer) {
+        std::lock_guard<std::mutex> lock(buffer.lock);
+        buffer.data.clear();
+    });
+
+    start_time = Metrics::Now();
+    file_size = 0;
+    failed = false;
+    sample = header.sample;
+    buffer_limit = limit;
+    written.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+
+    running = true;
+    writer = std::thread(Run);
+    detail::enabled.store(true, std::memory_order_release);
+}
+
+// See Trace.h
+void Stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running) {
+            return;
+        }
+        detail::enabled.store(false, std::memory_order_release);
+        running = false;
+    }
+    stop.notify_all();
+    writer.join();
+
+    std::lock_guard<std::mutex> guard(lock);
+    Flush();
+    close(fd);
+    fd = -1;
+}
+
+// See Trace.h
+uint64_t Written() { return written.load(std::memory_order_relaxed); }
+
+// See Trace.h
+uint64_t Dropped() { return dropped.load(std::memory_order_relaxed); }
+
+// See Trace.h
+Reader::Reader(const std::string &path) : _file(std::fopen(path.c_str(), "rb")), _position(0) {
+    if (_file == nullptr) {
+        throw std::runtime_error("Failed to open trace " + path + ": " + std::strerror(errno));
+    }
+    if (std::fread(&_header, sizeof(_header), 1, _file) != 1 ||
+        std::memcmp(_header.magic, magic, sizeof(magic)) != 0 || _header.version != version) {
+        std::fclose(_file);
+        throw std::runtime_error("File " + path + " is not a trace");
+    }
+}
+
+// See Trace.h
+Reader::~Reader() { std::fclose(_file); }
+
+// See Trace.h
+bool Reader::Next(Record &record) {
+    if (_position == _records.size()) {
+        _records.resize(4096);
+        _records.resize(std::fread(_records.data(), sizeof(Record), _records.size(), _file));
+        _position = 0;
+        if (_records.empty()) {
+            return false;
+        }
+    }
+    record = _records[_position++];
+    return true;
+}
+
+} // namespace Trace
+} // namespace Afina
@@ -0,0 +1,171 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Slab.h>
+
+using Afina::Allocator::Slab;
+
+namespace {
+
+// Item sizes as SlabLRU sees them: 48 bytes header, 10..40 bytes key and a value that is mostly small with a
+// long tail, roughly like memcached production traces
+std::vector<std::size_t> ItemSizes(std::size_t count) {
+    std::vector<std::size_t> sizes;
+    uint64_t seed = 88172645463325252ull;
+    for (std::size_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        std::size_t key = 10 + seed % 31;
+        std::size_t value;
+        std::size_t kind = (seed >> 8) % 100;
+        if (kind < 70) {
+            value = 16 + (seed >> 16) % 240;
+        } else if (kind < 95) {
+            value = 256 + (seed >> 16) % 1792;
+        } else {
+            value = 2048 + (seed >> 16) % 14336;
+        }
+        sizes.push_back(48 + key + value);
+    }
+    return sizes;
+}
+
+struct MallocAlloc {
+    void *alloc(std::size_t size) { return std::malloc(size); }
+    void free(void *ptr) { std::free(ptr); }
+};
+
+struct SlabAlloc {
+    explicit SlabAlloc(Slab &slab) : slab(slab) {}
+
+    void *alloc(std::size_t size) {
+        void *ptr = slab.alloc(slab.class_of(size));
+        if (ptr == nullptr) {
+            std::fprintf(stderr, "slab is out of memory\n");
+            std::abort();
+        }
+        return ptr;
+    }
+    void free(void *ptr) { slab.free(ptr); }
+
+    Slab &slab;
+};
+
+template <typename F> double Measure(std::size_t threads, long ops, F &&body) {
+    std::atomic<bool> go(false);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            body(t);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &t : pool) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+    return double(ops) / sec / 1e6;
+}
+
+// Every thread replaces items in its own working set, like a storage under set-heavy load
+template <typename A> double Local(A &allocator, std::size_t threads, long total, const std::vector<std::size_t> &sizes) {
+    const std::size_t live = 4096;
+    long per_thread = total / long(threads);
+    return Measure(threads, per_thread * long(threads), [&](std::size_t t) {
+        std::vector<char *> ring(live, nullptr);
+        for (long i = 0; i < per_thread; i++) {
+            char *&slot = ring[i % live];
+            if (slot != nullptr) {
+                allocator.free(slot);
+            }
+            slot = static_cast<char *>(allocator.alloc(sizes[(i + t * 7919) % sizes.size()]));
+            slot[0] = char(i);
+        }
+        for (char *ptr : ring) {
+            if (ptr != nullptr) {
+                allocator.free(ptr);
+            }
+        }
+    });
+}
+
+// Threads are paired: one allocates items and passes them over, the other frees, so every free is remote
+template <typename A>
+double Remote(A &allocator, std::size_t threads, long total, const std::vector<std::size_t> &sizes) {
+    const std::size_t capacity = 1024;
+    std::size_t pairs = std::max<std::size_t>(1, threads / 2);
+    long per_pair = total / long(pairs);
+
+    struct Queue {
+        Queue() : head(0), tail(0) {}
+        std::vector<std::atomic<char *>> slots;
+        std::atomic<std::size_t> head;
+        char pad[64];
+        std::atomic<std::size_t> tail;
+    };
+    std::vector<Queue> queues(pairs);
+    for (auto &queue : queues) {
+        queue.slots = std::vector<std::atomic<char *>>(capacity);
+    }
+
+    return Measure(pairs * 2, per_pair * long(pairs), [&](std::size_t t) {
+        Queue &queue = queues[t / 2];
+        if (t % 2 == 0) {
+            for (long i = 0; i < per_pair; i++) {
+                char *ptr = static_cast<char *>(allocator.alloc(sizes[(i + t * 7919) % sizes.size()]));
+                ptr[0] = char(i);
+                std::size_t tail = queue.tail.load(std::memory_order_relaxed);
+                while (tail - queue.head.load(std::memory_order_acquire) == capacity) {
+                    std::this_thread::yield();
+                }
+                queue.slots[tail % capacity].store(ptr, std::memory_order_relaxed);
+                queue.tail.store(tail + 1, std::memory_order_release);
+            }
+        } else {
+            for (long i = 0; i < per_pair; i++) {
+                std::size_t head = queue.head.load(std::memory_order_relaxed);
+                while (queue.tail.load(std::memory_order_acquire) == head) {
+                    std::this_thread::yield();
+                }
+                char *ptr = queue.slots[head % capacity].load(std::memory_order_relaxed);
+                queue.head.store(head + 1, std::memory_order_release);
+                allocator.free(ptr);
+            }
+        }
+    });
+}
+
+} // namespace
+
+int main() {
+    const long total = 4000000;
+    const std::size_t threads[] = {1, 2, 4, 8, 16};
+    const std::vector<std::size_t> sizes = ItemSizes(1 << 16);
+
+    std::printf("%8s %16s %16s %17s %17s\n", "threads", "malloc Mops/s", "slab Mops/s", "malloc remote", "slab remote");
+    for (std::size_t t : threads) {
+        MallocAlloc heap;
+        Slab slab(1024 * 1024 * 1024);
+        SlabAlloc slabs(slab);
+
+        double heap_local = Local(heap, t, total, sizes);
+        double slab_local = Local(slabs, t, total, sizes);
+        double heap_remote = Remote(heap, t, total, sizes);
+        double slab_remote = Remote(slabs, t, total, sizes);
+        std::printf("%8zu %16.2f %16.2f %17.2f %17.2f\n", t, heap_local, slab_local, heap_remote, slab_remote);
+    }
+    return 0;
+}
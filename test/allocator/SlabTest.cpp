@@ -0,0 +1,488 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Slab.h>
+
+using namespace Afina::Allocator;
+
+TEST(SlabTest, Classes) {
+    Slab slab(1024 * 1024, 64 * 1024, 64, 1.25);
+
+    EXPECT_EQ(64, slab.chunk_size(0));
+    EXPECT_EQ(64 * 1024, slab.max_size());
+    EXPECT_EQ(64 * 1024, slab.chunk_size(slab.classes() - 1));
+
+    for (std::size_t i = 1; i < slab.classes(); i++) {
+        EXPECT_GT(slab.chunk_size(i), slab.chunk_size(i - 1));
+        EXPECT_EQ(0, slab.chunk_size(i) % Slab::alignment);
+        if (i + 1 < slab.classes()) {
+            EXPECT_LE(slab.chunk_size(i), slab.chunk_size(i - 1) * 1.25 + Slab::alignment);
+        }
+    }
+
+    EXPECT_EQ(0, slab.class_of(1));
+    EXPECT_EQ(0, slab.class_of(64));
+    EXPECT_EQ(1, slab.class_of(65));
+    for (std::size_t size = 1; size <= slab.max_size(); size += 97) {
+        std::size_t cls = slab.class_of(size);
+        EXPECT_GE(slab.chunk_size(cls), size);
+        if (cls > 0) {
+            EXPECT_LT(slab.chunk_size(cls - 1), size);
+        }
+    }
+}
+
+TEST(SlabTest, AllocFree) {
+    Slab slab(1024 * 1024, 64 * 1024);
+    std::size_t cls = slab.class_of(100);
+
+    std::set<char *> chunks;
+    for (int i = 0; i < 1000; i++) {
+        char *chunk = static_cast<char *>(slab.alloc(cls));
+        ASSERT_NE(nullptr, chunk);
+        std::memset(chunk, i, slab.chunk_size(cls));
+        EXPECT_TRUE(chunks.insert(chunk).second);
+    }
+
+    // Chunks don't overlap
+    char *prev = nullptr;
+    for (char *chunk : chunks) {
+        if (prev != nullptr) {
+            EXPECT_GE(chunk, prev + slab.chunk_size(cls));
+        }
+        prev = chunk;
+    }
+
+    for (char *chunk : chunks) {
+        slab.free(chunk);
+    }
+
+    // Freed chunks are reused, no new slabs are taken
+    std::size_t slabs = slab.used_slabs();
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_NE(nullptr, slab.alloc(cls));
+    }
+    EXPECT_EQ(slabs, slab.used_slabs());
+}
+
+TEST(SlabTest, MemoryLimit) {
+    Slab slab(256 * 1024, 64 * 1024);
+    std::size_t cls = slab.class_of(1000);
+
+    std::size_t count = 0;
+    while (slab.alloc(cls) != nullptr) {
+        count++;
+    }
+    EXPECT_EQ(4 * (64 * 1024 / slab.chunk_size(cls)), count);
+    EXPECT_EQ(4, slab.used_slabs());
+
+    // All slabs are taken, other classes get nothing
+    EXPECT_EQ(nullptr, slab.alloc(slab.class_of(10)));
+    EXPECT_EQ(nullptr, slab.alloc(slab.classes() - 1));
+}
+
+TEST(SlabTest, LargeChunks) {
+    Slab slab(256 * 1024, 64 * 1024);
+    std::size_t cls = slab.classes() - 1;
+
+    void *a = slab.alloc(cls);
+    void *b = slab.alloc(cls);
+    ASSERT_NE(nullptr, a);
+    ASSERT_NE(nullptr, b);
+    std::memset(a, 1, slab.max_size());
+    std::memset(b, 2, slab.max_size());
+
+    slab.free(a);
+    EXPECT_EQ(a, slab.alloc(cls));
+}
+
+TEST(SlabTest, InvalidFree) {
+    Slab slab(256 * 1024, 64 * 1024);
+    char local[16];
+    EXPECT_THROW(slab.free(local), AllocError);
+
+    char *chunk = static_cast<char *>(slab.alloc(slab.class_of(100)));
+    EXPECT_THROW(slab.free(chunk + 1), AllocError);
+
+    // Slab nobody took yet
+    EXPECT_THROW(slab.free(chunk + 128 * 1024), AllocError);
+}
+
+TEST(SlabTest, Stats) {
+    Slab slab(1024 * 1024, 64 * 1024);
+    std::size_t cls = slab.class_of(100);
+
+    std::vector<void *> chunks;
+    for (int i = 0; i < 100; i++) {
+        chunks.push_back(slab.alloc(cls));
+    }
+    for (int i = 0; i < 40; i++) {
+        slab.free(chunks[i]);
+    }
+
+    auto stats = slab.stats();
+    ASSERT_EQ(slab.classes(), stats.size());
+    EXPECT_EQ(slab.chunk_size(cls), stats[cls].chunk_size);
+    EXPECT_EQ(1, stats[cls].slabs);
+    EXPECT_EQ(60, stats[cls].used_chunks);
+    EXPECT_EQ(stats[cls].chunks_per_slab, stats[cls].used_chunks + stats[cls].free_chunks +
+                                              stats[cls].free_chunks_end);
+    EXPECT_EQ(0, stats[0].slabs);
+}
+
+TEST(SlabTest, Move) {
+    Slab slab(256 * 1024, 64 * 1024);
+    std::size_t from = slab.class_of(1000), to = slab.class_of(100);
+
+    std::vector<void *> chunks;
+    for (void *chunk = slab.alloc(from); chunk != nullptr; chunk = slab.alloc(from)) {
+        chunks.push_back(chunk);
+    }
+    EXPECT_EQ(nullptr, slab.alloc(to));
+    for (void *chunk : chunks) {
+        slab.free(chunk);
+    }
+
+    EXPECT_FALSE(slab.begin_move(from, from));
+    ASSERT_TRUE(slab.begin_move(from, to));
+    EXPECT_FALSE(slab.begin_move(from, to));
+    EXPECT_TRUE(slab.finish_move());
+    EXPECT_EQ(1, slab.slabs_moved());
+
+    std::size_t count = 0;
+    while (slab.alloc(to) != nullptr) {
+        count++;
+    }
+    EXPECT_EQ(64 * 1024 / slab.chunk_size(to), count);
+
+    auto stats = slab.stats();
+    EXPECT_EQ(3, stats[from].slabs);
+    EXPECT_EQ(1, stats[to].slabs);
+    EXPECT_LT(0, stats[to].failures);
+}
+
+TEST(SlabTest, MoveWaitsForChunks) {
+    Slab slab(256 * 1024, 64 * 1024);
+    std::size_t from = slab.class_of(1000), to = slab.class_of(100);
+
+    std::vector<void *> chunks;
+    for (void *chunk = slab.alloc(from); chunk != nullptr; chunk = slab.alloc(from)) {
+        chunks.push_back(chunk);
+    }
+    ASSERT_TRUE(slab.begin_move(from, to));
+
+    std::size_t cls;
+    char *begin, *end;
+    ASSERT_TRUE(slab.moving_range(cls, begin, end));
+    EXPECT_EQ(from, cls);
+    EXPECT_EQ(64 * 1024, end - begin);
+
+    // Chunk of the slab is still in use
+    void *live = nullptr;
+    for (void *chunk : chunks) {
+        if (live == nullptr && chunk >= begin && chunk < end) {
+            live = chunk;
+        } else {
+            slab.free(chunk);
+        }
+    }
+    ASSERT_NE(nullptr, live);
+    EXPECT_FALSE(slab.finish_move());
+
+    // Chunks put aside are never handed out again
+    std::vector<void *> again;
+    for (void *chunk = slab.alloc(from); chunk != nullptr; chunk = slab.alloc(from)) {
+        EXPECT_FALSE(chunk >= begin && chunk < end);
+        again.push_back(chunk);
+    }
+    EXPECT_EQ(chunks.size() - 64 * 1024 / slab.chunk_size(from), again.size());
+
+    slab.free(live);
+    EXPECT_TRUE(slab.finish_move());
+    EXPECT_FALSE(slab.moving_range(cls, begin, end));
+    EXPECT_NE(nullptr, slab.alloc(to));
+}
+
+TEST(SlabTest, CancelMove) {
+    Slab slab(256 * 1024, 64 * 1024);
+    std::size_t from = slab.class_of(1000), to = slab.class_of(100);
+
+    std::vector<void *> chunks;
+    for (void *chunk = slab.alloc(from); chunk != nullptr; chunk = slab.alloc(from)) {
+        chunks.push_back(chunk);
+    }
+    ASSERT_TRUE(slab.begin_move(from, to));
+
+    std::size_t cls;
+    char *begin, *end;
+    ASSERT_TRUE(slab.moving_range(cls, begin, end));
+    void *live = nullptr;
+    for (void *chunk : chunks) {
+        if (live == nullptr && chunk >= begin && chunk < end) {
+            live = chunk;
+        } else {
+            slab.free(chunk);
+        }
+    }
+    EXPECT_FALSE(slab.finish_move());
+    slab.cancel_move();
+    EXPECT_FALSE(slab.moving_range(cls, begin, end));
+    slab.free(live);
+
+    // Class got every chunk back
+    std::size_t count = 0;
+    while (slab.alloc(from) != nullptr) {
+        count++;
+    }
+    EXPECT_EQ(chunks.size(), count);
+    EXPECT_EQ(nullptr, slab.alloc(to));
+    EXPECT_EQ(0, slab.slabs_moved());
+}
+
+TEST(SlabTest, MoveDrainsIdleThreadCache) {
+    Slab slab(256 * 1024, 64 * 1024);
+    std::size_t from = slab.class_of(1000), to = slab.class_of(100);
+
+    std::vector<void *> chunks;
+    for (void *chunk = slab.alloc(from); chunk != nullptr; chunk = slab.alloc(from)) {
+        chunks.push_back(chunk);
+    }
+
+    // Thread frees the first chunks last, so they stay in its cache, and never uses the allocator again
+    std::atomic<bool> freed(false), release(false);
+    std::thread idle([&] {
+        for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) {
+            slab.free(*it);
+        }
+        freed = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    while (!freed) {
+        std::this_thread::yield();
+    }
+
+    bool started = slab.begin_move(from, to);
+    std::size_t cls;
+    char *begin = nullptr, *end = nullptr;
+    slab.moving_range(cls, begin, end);
+    bool cached = chunks[0] >= begin && chunks[0] < end;
+    bool finished = slab.finish_move();
+    release = true;
+    idle.join();
+
+    EXPECT_TRUE(started);
+    EXPECT_TRUE(cached);
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(1, slab.slabs_moved());
+    EXPECT_EQ(0, slab.stats()[from].used_chunks);
+}
+
+TEST(SlabTest, MoveAfterCancel) {
+    Slab slab(256 * 1024, 64 * 1024);
+    std::size_t from = slab.class_of(1000), to = slab.class_of(100);
+
+    std::vector<void *> chunks;
+    for (void *chunk = slab.alloc(from); chunk != nullptr; chunk = slab.alloc(from)) {
+        chunks.push_back(chunk);
+    }
+    ASSERT_TRUE(slab.begin_move(from, to));
+
+    std::size_t cls;
+    char *begin, *end;
+    ASSERT_TRUE(slab.moving_range(cls, begin, end));
+    void *live = nullptr;
+    for (void *chunk : chunks) {
+        if (live == nullptr && chunk >= begin && chunk < end) {
+            live = chunk;
+        } else {
+            slab.free(chunk);
+        }
+    }
+    EXPECT_FALSE(slab.finish_move());
+    EXPECT_EQ(1, slab.moving_left());
+    slab.cancel_move();
+
+    // Slab that is held by the live chunk is not picked again
+    ASSERT_TRUE(slab.begin_move(from, to));
+    char *next_begin, *next_end;
+    ASSERT_TRUE(slab.moving_range(cls, next_begin, next_end));
+    EXPECT_NE(begin, next_begin);
+    EXPECT_TRUE(slab.finish_move());
+    EXPECT_EQ(0, slab.moving_left());
+    slab.free(live);
+}
+
+TEST(SlabTest, CrossThreadFree) {
+    Slab slab(4 * 1024 * 1024, 64 * 1024);
+    std::size_t cls = slab.class_of(200);
+    const int rounds = 20;
+    const int batch = 1000;
+
+    // One thread allocates, another frees, so chunks travel from one cache to the other through the class
+    for (int r = 0; r < rounds; r++) {
+        std::vector<void *> chunks;
+        std::thread producer([&] {
+            for (int i = 0; i < batch; i++) {
+                void *chunk = slab.alloc(cls);
+                ASSERT_NE(nullptr, chunk);
+                std::memset(chunk, r, slab.chunk_size(cls));
+                chunks.push_back(chunk);
+            }
+        });
+        producer.join();
+
+        std::thread consumer([&] {
+            for (void *chunk : chunks) {
+                slab.free(chunk);
+            }
+        });
+        consumer.join();
+    }
+
+    // Steady state needs about one batch of chunks, not one per round
+    EXPECT_LE(slab.used_slabs(), 2 * (batch * slab.chunk_size(cls)) / slab.max_size() + 2);
+    auto stats = slab.stats();
+    EXPECT_EQ(0, stats[cls].used_chunks);
+}
+
+TEST(SlabTest, ConcurrentAllocFree) {
+    Slab slab(8 * 1024 * 1024, 64 * 1024);
+    const int threads = 8;
+    const int rounds = 20000;
+
+    // Chunks are passed around through shared slots, so many of them are freed by another thread. A flag in the
+    // chunk catches the same chunk given out twice
+    std::vector<std::atomic<void *>> slots(256);
+    for (auto &slot : slots) {
+        slot.store(nullptr);
+    }
+
+    std::vector<std::thread> pool;
+    std::atomic<int> failures(0);
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            uint64_t seed = t * 2654435761u + 1;
+            for (int i = 0; i < rounds; i++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+
+                std::size_t cls = seed % 8;
+                char *chunk = static_cast<char *>(slab.alloc(cls));
+                if (chunk == nullptr) {
+                    failures++;
+                    continue;
+                }
+                std::atomic<uint64_t> *flag = reinterpret_cast<std::atomic<uint64_t> *>(chunk + 16);
+                if (flag->exchange(1) != 0) {
+                    failures++;
+                }
+
+                void *old = slots[(seed >> 8) % slots.size()].exchange(chunk);
+                if (old != nullptr) {
+                    reinterpret_cast<std::atomic<uint64_t> *>(static_cast<char *>(old) + 16)->store(0);
+                    slab.free(old);
+                }
+            }
+        });
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+    EXPECT_EQ(0, failures.load());
+
+    for (auto &slot : slots) {
+        if (slot.load() != nullptr) {
+            slab.free(slot.load());
+        }
+    }
+    for (auto &cls : slab.stats()) {
+        EXPECT_EQ(0, cls.used_chunks);
+    }
+}
+
+TEST(SlabTest, ConcurrentMove) {
+    Slab slab(1024 * 1024, 4 * 1024);
+    const int threads = 4;
+    const std::size_t moves = 10;
+
+    // Every chunk carries a tag written on alloc and checked on free, a chunk given out twice or a slab moved
+    // under a live chunk breaks it. Few chunks are live at once, so that slabs get free to move
+    std::vector<std::atomic<void *>> slots(16);
+    for (auto &slot : slots) {
+        slot.store(nullptr);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            uint64_t seed = t * 2654435761u + 1;
+            while (!done.load(std::memory_order_relaxed)) {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+
+                char *chunk = static_cast<char *>(slab.alloc(seed % 4));
+                if (chunk == nullptr) {
+                    continue;
+                }
+                __atomic_store_n(reinterpret_cast<uint64_t *>(chunk + 16), reinterpret_cast<uint64_t>(chunk) ^ seed,
+                                 __ATOMIC_RELAXED);
+                __atomic_store_n(reinterpret_cast<uint64_t *>(chunk + 24), seed, __ATOMIC_RELAXED);
+
+                char *old = static_cast<char *>(slots[(seed >> 8) % slots.size()].exchange(chunk));
+                if (old != nullptr) {
+                    uint64_t tag = __atomic_load_n(reinterpret_cast<uint64_t *>(old + 16), __ATOMIC_RELAXED);
+                    uint64_t key = __atomic_load_n(reinterpret_cast<uint64_t *>(old + 24), __ATOMIC_RELAXED);
+                    if (tag != (reinterpret_cast<uint64_t>(old) ^ key)) {
+                        failures++;
+                    }
+                    slab.free(old);
+                }
+            }
+        });
+    }
+
+    // Slabs go around the classes while threads keep allocating
+    std::size_t moved = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (std::size_t i = 0; moved < moves && std::chrono::steady_clock::now() < deadline; i++) {
+        if (!slab.begin_move(i % 4, (i + 1) % 4)) {
+            std::this_thread::yield();
+            continue;
+        }
+        bool finished = false;
+        for (int attempt = 0; attempt < 1000 && !finished; attempt++) {
+            finished = slab.finish_move();
+            std::this_thread::yield();
+        }
+        if (!finished) {
+            slab.cancel_move();
+        }
+        moved += finished;
+    }
+    done = true;
+    for (auto &t : pool) {
+        t.join();
+    }
+    EXPECT_EQ(0, failures.load());
+    EXPECT_EQ(moves, moved);
+    EXPECT_EQ(moved, slab.slabs_moved());
+
+    for (auto &slot : slots) {
+        if (slot.load() != nullptr) {
+            slab.free(slot.load());
+        }
+    }
+}
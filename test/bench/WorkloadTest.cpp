@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench/Workload.h"
+
+using namespace Afina::Bench;
+
+TEST(WorkloadTest, UniformCoversKeys) {
+    auto keys = KeyDistribution::Build("uniform", 16, 0.99, 1);
+    std::vector<std::size_t> hits(16, 0);
+    for (int i = 0; i < 16000; i++) {
+        uint64_t key = keys->Next();
+        ASSERT_LT(key, 16u);
+        hits[key]++;
+    }
+    for (auto count : hits) {
+        EXPECT_GT(count, 700u);
+        EXPECT_LT(count, 1300u);
+    }
+}
+
+TEST(WorkloadTest, ScanWrapsAround) {
+    auto keys = KeyDistribution::Build("scan", 5, 0.99, 3);
+    uint64_t first = keys->Next();
+    for (uint64_t i = 1; i < 12; i++) {
+        EXPECT_EQ((first + i) % 5, keys->Next());
+    }
+}
+
+TEST(WorkloadTest, ZipfIsSkewed) {
+    const uint64_t n = 1000;
+    ZipfKeys keys(n, 0.99, 7);
+    std::vector<std::size_t> hits(n, 0);
+    const int draws = 100000;
+    for (int i = 0; i < draws; i++) {
+        uint64_t rank = keys.NextRank();
+        ASSERT_LT(rank, n);
+        hits[rank]++;
+    }
+
+    // With theta close to 1 the hottest key takes about 1 / H(n) of requests, that is 13% for 1000 keys
+    EXPECT_GT(hits[0], draws / 10);
+    EXPECT_LT(hits[0], draws / 6);
+    EXPECT_GT(hits[0], hits[1]);
+    EXPECT_GT(hits[1], hits[10]);
+
+    std::size_t tail = 0;
+    for (uint64_t i = n / 2; i < n; i++) {
+        tail += hits[i];
+    }
+    EXPECT_LT(tail, draws / 8);
+}
+
+TEST(WorkloadTest, ZipfScattersHotKeys) {
+    ZipfKeys keys(1000, 0.99, 7);
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_LT(keys.Next(), 1000u);
+    }
+}
+
+TEST(WorkloadTest, UnknownDistribution) {
+    EXPECT_THROW(KeyDistribution::Build("gauss", 10, 0.99, 1), std::runtime_error);
+    EXPECT_THROW(KeyDistribution::Build("uniform", 0, 0.99, 1), std::runtime_error);
+    EXPECT_THROW(KeyDistribution::Build("zipf", 10, 1.5, 1), std::runtime_error);
+}
+
+TEST(WorkloadTest, ValueSizes) {
+    Random random(1);
+
+    ValueSizes fixed("100");
+    EXPECT_EQ(100u, fixed.Next(random));
+    EXPECT_EQ(100u, fixed.Max());
+
+    ValueSizes range("10-20");
+    EXPECT_EQ(20u, range.Max());
+    for (int i = 0; i < 100; i++) {
+        std::size_t size = range.Next(random);
+        EXPECT_GE(size, 10u);
+        EXPECT_LE(size, 20u);
+    }
+
+    EXPECT_THROW(ValueSizes(""), std::runtime_error);
+    EXPECT_THROW(ValueSizes("10-"), std::runtime_error);
+    EXPECT_THROW(ValueSizes("20-10"), std::runtime_error);
+    EXPECT_THROW(ValueSizes("1k"), std::runtime_error);
+}
+
+TEST(WorkloadTest, ParseResponses) {
+    std::string data = "STORED\r\nVALUE key1 0 5\r\nhello\r\nEND\r\nEND\r\nERROR\r\nNOT_STORED\r\n";
+    ResponseParser::Counts counts;
+    EXPECT_EQ(data.size(), ResponseParser::Parse(data.data(), data.size(), counts));
+    EXPECT_EQ(5u, counts.responses);
+    EXPECT_EQ(1u, counts.hits);
+    EXPECT_EQ(1u, counts.misses);
+    EXPECT_EQ(1u, counts.errors);
+}
+
+TEST(WorkloadTest, ParseKeepsPartialResponse) {
+    std::string data = "STORED\r\nVALUE key1 0 10\r\nhello\r\n";
+    ResponseParser::Counts counts;
+    EXPECT_EQ(8u, ResponseParser::Parse(data.data(), data.size(), counts));
+    EXPECT_EQ(1u, counts.responses);
+
+    // Value containing line break must not be taken for the end of response
+    data = "VALUE key1 0 10\r\nhel\r\nlo!!!\r\nEN";
+    counts = ResponseParser::Counts();
+    EXPECT_EQ(0u, ResponseParser::Parse(data.data(), data.size(), counts));
+    data += "D\r\n";
+    EXPECT_EQ(data.size(), ResponseParser::Parse(data.data(), data.size(), counts));
+    EXPECT_EQ(1u, counts.hits);
+}
@@ -0,0 +1,40 @@
+#ifndef AFINA_TEST_COMMON_FILE_SIZE_LIMIT_H
+#define AFINA_TEST_COMMON_FILE_SIZE_LIMIT_H
+
+#include <csignal>
+#include <cstddef>
+
+#include <sys/resource.h>
+
+namespace Afina {
+namespace Test {
+
+/**
+ * Files of the process can't grow beyond size while it is alive, writes fail as if disk was full
+ */
+class FileSizeLimit {
+public:
+    explicit FileSizeLimit(std::size_t size) {
+        _handler = std::signal(SIGXFSZ, SIG_IGN);
+        getrlimit(RLIMIT_FSIZE, &_limit);
+        struct rlimit limit = _limit;
+        limit.rlim_cur = size;
+        setrlimit(RLIMIT_FSIZE, &limit);
+    }
+    ~FileSizeLimit() {
+        setrlimit(RLIMIT_FSIZE, &_limit);
+        std::signal(SIGXFSZ, _handler);
+    }
+
+    FileSizeLimit(const FileSizeLimit &) = delete;
+    FileSizeLimit &operator=(const FileSizeLimit &) = delete;
+
+private:
+    struct rlimit _limit;
+    void (*_handler)(int);
+};
+
+} // namespace Test
+} // namespace Afina
+
+#endif // AFINA_TEST_COMMON_FILE_SIZE_LIMIT_H
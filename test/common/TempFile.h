@@ -0,0 +1,30 @@
+#ifndef AFINA_TEST_COMMON_TEMP_FILE_H
+#define AFINA_TEST_COMMON_TEMP_FILE_H
+
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+namespace Afina {
+namespace Test {
+
+/**
+ * File in /tmp removed once test is over. Path has process id in it, so that test binaries running at the same
+ * time never meet
+ */
+class TempFile {
+public:
+    explicit TempFile(const std::string &name) : path("/tmp/afina_" + name + "_" + std::to_string(getpid())) {}
+    ~TempFile() { std::remove(path.c_str()); }
+
+    TempFile(const TempFile &) = delete;
+    TempFile &operator=(const TempFile &) = delete;
+
+    const std::string path;
+};
+
+} // namespace Test
+} // namespace Afina
+
+#endif // AFINA_TEST_COMMON_TEMP_FILE_H
@@ -0,0 +1,79 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+
+using Afina::Concurrency::Executor;
+
+// Counts every heap allocation in the process, shows whether Execute stays off the heap
+static std::atomic<long> allocations(0);
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *result = std::malloc(size);
+    if (result == nullptr) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+struct Result {
+    double mtasks;
+    double allocs_per_task;
+};
+
+// Many threads submit tiny tasks at once, so the benchmark shows how much executor itself costs under contention
+static Result measure(Executor::Mode mode, std::size_t submitters, long total) {
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Executor executor(threads, threads, 1 << 16, std::chrono::milliseconds(100), mode);
+    executor.Start();
+
+    std::atomic<long> counter(0);
+    long per_submitter = total / long(submitters);
+
+    std::vector<std::thread> pool;
+    pool.reserve(submitters);
+    long allocs_before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t s = 0; s < submitters; s++) {
+        pool.emplace_back([&] {
+            for (long i = 0; i < per_submitter; i++) {
+                while (!executor.Execute([&counter] { counter.fetch_add(1, std::memory_order_relaxed); })) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+    executor.Stop(true);
+    auto end = std::chrono::steady_clock::now();
+    // Threads themselves allocate a bit, that is negligible compared to number of tasks
+    long allocs = allocations.load() - allocs_before;
+
+    double sec = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+    return Result{double(counter.load()) / sec / 1e6, double(allocs) / double(counter.load())};
+}
+
+int main() {
+    const long total = 400000;
+    const std::size_t submitters[] = {1, 2, 4, 8, 16, 32, 64};
+
+    std::printf("%12s %18s %14s %18s %14s\n", "submitters", "shared Mtask/s", "allocs/task", "stealing Mtask/s",
+                "allocs/task");
+    for (std::size_t s : submitters) {
+        Result shared = measure(Executor::Mode::kSharedQueue, s, total);
+        Result stealing = measure(Executor::Mode::kWorkStealing, s, total);
+        std::printf("%12zu %18.2f %14.3f %18.2f %14.3f\n", s, shared.mtasks, shared.allocs_per_task,
+                    stealing.mtasks, stealing.allocs_per_task);
+    }
+    return 0;
+}
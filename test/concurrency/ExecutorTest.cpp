@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+
+using Afina::Concurrency::Executor;
+
+class ExecutorTest : public ::testing::TestWithParam<Executor::Mode> {};
+
+TEST_P(ExecutorTest, ExecutesAll) {
+    Executor executor(2, 4, 100000, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    for (int i = 0; i < 10000; i++) {
+        while (!executor.Execute([&counter] { counter.fetch_add(1); })) {
+            std::this_thread::yield();
+        }
+    }
+
+    executor.Stop(true);
+    ASSERT_EQ(10000, counter.load());
+}
+
+TEST_P(ExecutorTest, ManySubmitters) {
+    Executor executor(2, 4, 1024, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 8; t++) {
+        submitters.emplace_back([&] {
+            for (int i = 0; i < 2000; i++) {
+                while (!executor.Execute([&counter] { counter.fetch_add(1); })) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : submitters) {
+        t.join();
+    }
+
+    executor.Stop(true);
+    ASSERT_EQ(8 * 2000, counter.load());
+}
+
+TEST_P(ExecutorTest, NestedExecute) {
+    Executor executor(1, 4, 100000, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(executor.Execute([&] {
+            for (int j = 0; j < 10; j++) {
+                executor.Execute([&counter] { counter.fetch_add(1); });
+            }
+        }));
+    }
+
+    // Let nested tasks get submitted before Stop starts rejecting them
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (counter.load() < 1000 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    executor.Stop(true);
+    ASSERT_EQ(1000, counter.load());
+}
+
+TEST_P(ExecutorTest, RejectsWhenStopped) {
+    Executor executor(1, 1, 10, std::chrono::milliseconds(100), GetParam());
+    ASSERT_FALSE(executor.Execute([] {}));
+
+    executor.Start();
+    ASSERT_TRUE(executor.Execute([] {}));
+
+    executor.Stop(true);
+    ASSERT_FALSE(executor.Execute([] {}));
+}
+
+TEST_P(ExecutorTest, QueueLimit) {
+    Executor executor(1, 1, 2, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    // Occupy the only thread, so that following tasks stay in queue
+    std::atomic<bool> release(false), started(false);
+    ASSERT_TRUE(executor.Execute([&] {
+        started = true;
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    }));
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+
+    ASSERT_TRUE(executor.Execute([] {}));
+    ASSERT_TRUE(executor.Execute([] {}));
+    ASSERT_FALSE(executor.Execute([] {}));
+
+    release = true;
+    executor.Stop(true);
+}
+
+TEST_P(ExecutorTest, GrowsUpToHighWatermark) {
+    Executor executor(1, 4, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    // Tasks block until all of them run at the same time, that requires pool to grow
+    std::atomic<int> running(0);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(executor.Execute([&running] {
+            running.fetch_add(1);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (running.load() < 4 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    executor.Stop(true);
+    ASSERT_EQ(4, running.load());
+}
+
+INSTANTIATE_TEST_CASE_P(Modes, ExecutorTest,
+                        ::testing::Values(Executor::Mode::kSharedQueue, Executor::Mode::kWorkStealing));
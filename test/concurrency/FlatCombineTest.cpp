@@ -0,0 +1,184 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/FlatCombine.h>
+
+using Afina::Concurrency::FlatCombine;
+
+namespace {
+
+struct AddOp {
+    long delta;
+    long result;
+};
+
+// Counter with intentionally non-atomic state, any concurrent access to it would be a data race
+class Counter {
+public:
+    explicit Counter(std::size_t max_batch = 64)
+        : value(0), batches(0), combiner([this](AddOp **ops, std::size_t count) { apply(ops, count); }, max_batch) {}
+
+    long Add(long delta) {
+        AddOp op{delta, 0};
+        combiner.Execute(op);
+        return op.result;
+    }
+
+    long value;
+    long batches;
+    std::size_t biggest_batch = 0;
+
+private:
+    void apply(AddOp **ops, std::size_t count) {
+        batches++;
+        biggest_batch = std::max(biggest_batch, count);
+        for (std::size_t i = 0; i < count; i++) {
+            value += ops[i]->delta;
+            ops[i]->result = value;
+        }
+    }
+
+    FlatCombine<AddOp> combiner;
+};
+
+} // namespace
+
+TEST(FlatCombineTest, SingleThread) {
+    Counter counter;
+    ASSERT_EQ(1, counter.Add(1));
+    ASSERT_EQ(3, counter.Add(2));
+    ASSERT_EQ(2, counter.batches);
+}
+
+TEST(FlatCombineTest, ManyThreads) {
+    Counter counter(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 16; t++) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 5000; i++) {
+                counter.Add(1);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(16 * 5000, counter.value);
+    ASSERT_LE(counter.biggest_batch, 4u);
+}
+
+TEST(FlatCombineTest, ThreadsComeAndGo) {
+    // Slots of exited threads get dropped, operations of new threads must still be seen
+    Counter counter;
+    for (int round = 0; round < 50; round++) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&counter] {
+                for (int i = 0; i < 100; i++) {
+                    counter.Add(1);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+    ASSERT_EQ(50 * 4 * 100, counter.value);
+}
+
+TEST(FlatCombineTest, SeveralInstances) {
+    // The same thread has its own slot in each combiner
+    Counter first, second;
+    for (int i = 0; i < 10; i++) {
+        first.Add(1);
+        second.Add(2);
+    }
+
+    std::unique_ptr<Counter> temporary(new Counter());
+    temporary->Add(5);
+    temporary.reset(new Counter());
+    ASSERT_EQ(7, temporary->Add(7));
+
+    ASSERT_EQ(10, first.value);
+    ASSERT_EQ(20, second.value);
+}
+
+TEST(FlatCombineTest, CombineThrows) {
+    // Failed batch must neither keep the lock nor leave owners of its operations waiting
+    std::atomic<int> calls(0);
+    FlatCombine<AddOp> combiner([&calls](AddOp **ops, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            ops[i]->result = ops[i]->delta;
+        }
+        if (calls++ % 2 == 0) {
+            throw std::runtime_error("combine failed");
+        }
+    });
+
+    std::atomic<int> thrown(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&combiner, &thrown] {
+            for (int i = 0; i < 1000; i++) {
+                AddOp op{1, 0};
+                try {
+                    combiner.Execute(op);
+                } catch (std::runtime_error &) {
+                    thrown++;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_GT(thrown.load(), 0);
+    AddOp op{5, 0};
+    calls = 1;
+    combiner.Execute(op);
+    EXPECT_EQ(5, op.result);
+}
+
+TEST(FlatCombineTest, CombineThrowsInFullBatch) {
+    // Batch of one is applied as soon as it is collected, in the middle of the scan, and every owner gets
+    // failure of its own operation only
+    FlatCombine<AddOp> combiner(
+        [](AddOp **ops, std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) {
+                if (ops[i]->delta < 0) {
+                    throw std::runtime_error("negative delta");
+                }
+                ops[i]->result = ops[i]->delta;
+            }
+        },
+        1);
+
+    std::atomic<int> wrong(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&combiner, &wrong] {
+            for (int i = 0; i < 1000; i++) {
+                AddOp op{i % 2 == 0 ? 1 : -1, 0};
+                bool thrown = false;
+                try {
+                    combiner.Execute(op);
+                } catch (std::runtime_error &) {
+                    thrown = true;
+                }
+                if (thrown != (op.delta < 0) || (!thrown && op.result != 1)) {
+                    wrong++;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(0, wrong.load());
+}
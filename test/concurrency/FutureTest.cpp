@@ -0,0 +1,187 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/ParallelFor.h>
+
+using Afina::Concurrency::Executor;
+using Afina::Concurrency::Future;
+using Afina::Concurrency::parallel_for;
+
+class FutureTest : public ::testing::TestWithParam<Executor::Mode> {};
+
+static int Square(int x) { return x * x; }
+
+TEST_P(FutureTest, SubmitValue) {
+    Executor executor(2, 4, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    Future<int> square = executor.Submit(&Square, 7);
+    Future<std::string> text = executor.Submit([](int n) { return std::string(n, 'x'); }, 3);
+    ASSERT_TRUE(square.valid());
+    ASSERT_EQ(49, square.get());
+    ASSERT_FALSE(square.valid());
+    ASSERT_EQ("xxx", text.get());
+
+    executor.Stop(true);
+}
+
+TEST_P(FutureTest, SubmitVoid) {
+    Executor executor(1, 1, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    Future<void> done = executor.Submit([&counter] { counter.fetch_add(1); });
+    done.get();
+    ASSERT_EQ(1, counter.load());
+
+    executor.Stop(true);
+}
+
+TEST_P(FutureTest, WaitFor) {
+    Executor executor(1, 1, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<bool> release(false);
+    Future<int> result = executor.Submit([&release] {
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+        return 1;
+    });
+    ASSERT_FALSE(result.wait_for(std::chrono::milliseconds(10)));
+    ASSERT_FALSE(result.ready());
+
+    release = true;
+    ASSERT_TRUE(result.wait_for(std::chrono::seconds(10)));
+    ASSERT_TRUE(result.ready());
+    ASSERT_EQ(1, result.get());
+
+    executor.Stop(true);
+}
+
+TEST_P(FutureTest, Exception) {
+    Executor executor(1, 1, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    Future<int> result = executor.Submit([]() -> int { throw std::logic_error("failed"); });
+    ASSERT_THROW(result.get(), std::logic_error);
+
+    executor.Stop(true);
+}
+
+TEST_P(FutureTest, Rejected) {
+    Executor executor(1, 1, 100, std::chrono::milliseconds(100), GetParam());
+
+    Future<int> result = executor.Submit(&Square, 2);
+    ASSERT_TRUE(result.ready());
+    ASSERT_THROW(result.get(), std::runtime_error);
+}
+
+TEST_P(FutureTest, ExecuteBatch) {
+    Executor executor(2, 4, 1000, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    std::vector<std::function<void()>> batch(500, [&counter] { counter.fetch_add(1); });
+    ASSERT_EQ(500, executor.ExecuteBatch(batch.begin(), batch.end()));
+
+    executor.Stop(true);
+    ASSERT_EQ(500, counter.load());
+}
+
+TEST_P(FutureTest, ExecuteBatchLimit) {
+    Executor executor(1, 1, 10, std::chrono::milliseconds(100), GetParam());
+    ASSERT_EQ(0, executor.ExecuteBatch(static_cast<Executor::Task *>(nullptr), static_cast<Executor::Task *>(nullptr)));
+
+    executor.Start();
+
+    // Occupy the only thread, so that following tasks stay in queue
+    std::atomic<bool> release(false), started(false);
+    ASSERT_TRUE(executor.Execute([&] {
+        started = true;
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    }));
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+
+    std::atomic<int> counter(0);
+    std::vector<Executor::Task> batch;
+    for (int i = 0; i < 15; i++) {
+        batch.emplace_back([&counter] { counter.fetch_add(1); });
+    }
+    ASSERT_EQ(10, executor.ExecuteBatch(batch.data(), batch.data() + batch.size()));
+    ASSERT_FALSE(bool(batch[0]));
+    ASSERT_TRUE(bool(batch[10]));
+
+    release = true;
+    executor.Stop(true);
+    ASSERT_EQ(10, counter.load());
+}
+
+TEST_P(FutureTest, ParallelFor) {
+    Executor executor(2, 4, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    for (std::size_t chunk : {0, 1, 7, 1000, 5000}) {
+        std::vector<int> values(1000, 0);
+        parallel_for(executor, 0, values.size(), chunk, [&values](std::size_t i) { values[i] += int(i); });
+        for (std::size_t i = 0; i < values.size(); i++) {
+            ASSERT_EQ(int(i), values[i]);
+        }
+    }
+
+    executor.Stop(true);
+}
+
+TEST_P(FutureTest, ParallelForException) {
+    Executor executor(2, 4, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    ASSERT_THROW(parallel_for(executor, 0, 100, 1,
+                              [&counter](std::size_t i) {
+                                  counter.fetch_add(1);
+                                  if (i == 50) {
+                                      throw std::runtime_error("failed");
+                                  }
+                              }),
+                 std::runtime_error);
+    ASSERT_EQ(100, counter.load());
+
+    executor.Stop(true);
+}
+
+TEST_P(FutureTest, ParallelForWithoutThreads) {
+    // Stopped executor accepts nothing, so caller does all the work itself
+    Executor executor(1, 1, 100, std::chrono::milliseconds(100), GetParam());
+    std::atomic<int> counter(0);
+    parallel_for(executor, 10, 20, 1, [&counter](std::size_t) { counter.fetch_add(1); });
+    ASSERT_EQ(10, counter.load());
+}
+
+TEST_P(FutureTest, NestedParallelFor) {
+    // Every thread is busy with outer loop, inner loops must complete anyway
+    Executor executor(2, 2, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    parallel_for(executor, 0, 8, 1, [&](std::size_t) {
+        parallel_for(executor, 0, 100, 10, [&counter](std::size_t) { counter.fetch_add(1); });
+    });
+    ASSERT_EQ(800, counter.load());
+
+    executor.Stop(true);
+}
+
+INSTANTIATE_TEST_CASE_P(Modes, FutureTest,
+                        ::testing::Values(Executor::Mode::kSharedQueue, Executor::Mode::kWorkStealing));
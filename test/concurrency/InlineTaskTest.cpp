@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <afina/concurrency/Executor.h>
+#include <afina/concurrency/InlineTask.h>
+
+using Afina::Concurrency::Executor;
+using Afina::Concurrency::InlineTask;
+
+namespace {
+
+// Callable counting its own live instances
+struct Tracked {
+    Tracked(int *alive, int *calls) : alive(alive), calls(calls) { (*alive)++; }
+    Tracked(const Tracked &other) : alive(other.alive), calls(other.calls) { (*alive)++; }
+    Tracked(Tracked &&other) : alive(other.alive), calls(other.calls) { (*alive)++; }
+    ~Tracked() { (*alive)--; }
+
+    void operator()() { (*calls)++; }
+
+    int *alive;
+    int *calls;
+};
+
+} // namespace
+
+TEST(InlineTaskTest, Fits) {
+    struct Small {
+        void operator()() {}
+        char data[16];
+    };
+    struct Big {
+        void operator()() {}
+        char data[128];
+    };
+
+    ASSERT_TRUE(InlineTask<64>::fits<Small>());
+    ASSERT_FALSE(InlineTask<64>::fits<Big>());
+    ASSERT_TRUE(InlineTask<128>::fits<Big>());
+}
+
+TEST(InlineTaskTest, CallAndMove) {
+    int alive = 0, calls = 0;
+    {
+        InlineTask<64> task(Tracked(&alive, &calls));
+        ASSERT_TRUE(bool(task));
+        ASSERT_EQ(1, alive);
+
+        InlineTask<64> moved(std::move(task));
+        ASSERT_FALSE(bool(task));
+        ASSERT_TRUE(bool(moved));
+        ASSERT_EQ(1, alive);
+
+        moved();
+        moved();
+        ASSERT_EQ(2, calls);
+
+        InlineTask<64> assigned;
+        ASSERT_FALSE(bool(assigned));
+        assigned = std::move(moved);
+        ASSERT_EQ(1, alive);
+        assigned();
+        ASSERT_EQ(3, calls);
+    }
+    ASSERT_EQ(0, alive);
+}
+
+TEST(InlineTaskTest, AssignDestroysPrevious) {
+    int alive = 0, calls = 0;
+    InlineTask<64> task(Tracked(&alive, &calls));
+    task = InlineTask<64>(Tracked(&alive, &calls));
+    ASSERT_EQ(1, alive);
+
+    task.reset();
+    ASSERT_EQ(0, alive);
+    ASSERT_FALSE(bool(task));
+}
+
+TEST(InlineTaskTest, MoveOnlyCallable) {
+    std::unique_ptr<int> value(new int(41));
+    int result = 0;
+
+    struct Owner {
+        void operator()() { *out = *ptr + 1; }
+        std::unique_ptr<int> ptr;
+        int *out;
+    };
+    Owner owner{std::move(value), &result};
+    InlineTask<64> owning(std::move(owner));
+    InlineTask<64> moved(std::move(owning));
+    moved();
+    ASSERT_EQ(42, result);
+}
+
+class ExecutorTaskTest : public ::testing::TestWithParam<Executor::Mode> {};
+
+TEST_P(ExecutorTaskTest, ExecutesTasks) {
+    Executor executor(1, 2, 1000, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    std::atomic<int> counter(0);
+    for (int i = 0; i < 5000; i++) {
+        while (!executor.Execute(Executor::Task([&counter] { counter.fetch_add(1); }))) {
+            std::this_thread::yield();
+        }
+    }
+
+    executor.Stop(true);
+    ASSERT_EQ(5000, counter.load());
+}
+
+TEST_P(ExecutorTaskTest, DestroysTasks) {
+    int alive = 0, calls = 0;
+    std::mutex mutex;
+    {
+        Executor executor(1, 1, 100, std::chrono::milliseconds(100), GetParam());
+        executor.Start();
+        for (int i = 0; i < 50; i++) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Tracked tracked(&alive, &calls);
+            ASSERT_TRUE(executor.Execute([&mutex, tracked]() mutable {
+                std::lock_guard<std::mutex> lock(mutex);
+                tracked();
+            }));
+        }
+        executor.Stop(true);
+    }
+    ASSERT_EQ(50, calls);
+    ASSERT_EQ(0, alive);
+}
+
+TEST_P(ExecutorTaskTest, BigCallable) {
+    Executor executor(1, 2, 100, std::chrono::milliseconds(100), GetParam());
+    executor.Start();
+
+    // Doesn't fit inline, goes through std::function
+    std::array<long, 32> values;
+    values.fill(1);
+    std::atomic<long> sum(0);
+    ASSERT_TRUE(executor.Execute([values, &sum] {
+        for (auto v : values) {
+            sum.fetch_add(v);
+        }
+    }));
+
+    executor.Stop(true);
+    ASSERT_EQ(32, sum.load());
+}
+
+INSTANTIATE_TEST_CASE_P(Modes, ExecutorTaskTest,
+                        ::testing::Values(Executor::Mode::kSharedQueue, Executor::Mode::kWorkStealing));
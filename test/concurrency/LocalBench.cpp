@@ -0,0 +1,69 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+using namespace Afina::Concurrency;
+
+// Every thread increments "its" counter many times, layouts differ only in where counters live
+template <typename F> static double measure(std::size_t threads, long per_thread, F &&increment) {
+    std::atomic<bool> go(false);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            for (long i = 0; i < per_thread; i++) {
+                increment(t);
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &t : pool) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+    return double(per_thread * long(threads)) / sec / 1e6;
+}
+
+int main() {
+    const long total = 20000000;
+    const std::size_t threads[] = {1, 2, 4, 8, 16, 32, 64};
+
+    std::printf("%8s %16s %16s %16s\n", "threads", "shared Mops/s", "adjacent Mops/s", "thread Mops/s");
+    for (std::size_t t : threads) {
+        long per_thread = total / long(t);
+
+        // Single counter, every increment is a contended RMW
+        std::atomic<long> shared(0);
+        double shared_speed =
+            measure(t, per_thread, [&shared](std::size_t) { shared.fetch_add(1, std::memory_order_relaxed); });
+
+        // Counter per thread, but neighbours share cache lines: classic false sharing
+        std::unique_ptr<std::atomic<long>[]> adjacent(new std::atomic<long>[t]);
+        for (std::size_t i = 0; i < t; i++) {
+            adjacent[i] = 0;
+        }
+        double adjacent_speed = measure(t, per_thread, [&adjacent](std::size_t index) {
+            adjacent[index].store(adjacent[index].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        });
+
+        ThreadLocal<std::atomic<long>> per_thread_counters;
+        double thread_speed = measure(t, per_thread, [&per_thread_counters](std::size_t) {
+            auto &counter = per_thread_counters.local();
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        });
+
+        std::printf("%8zu %16.2f %16.2f %16.2f\n", t, shared_speed, adjacent_speed, thread_speed);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+using Afina::Concurrency::ThreadLocal;
+using Afina::Concurrency::cache_line_size;
+
+namespace {
+
+struct Counter {
+    Counter() : value(0) {}
+
+    void add(long delta) { value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed); }
+
+    std::atomic<long> value;
+};
+
+long sum(long acc, Counter &counter) { return acc + counter.value.load(); }
+
+} // namespace
+
+TEST(ThreadLocalTest, ValuePerThread) {
+    ThreadLocal<Counter> counters;
+    counters.local().add(1);
+    ASSERT_EQ(&counters.local(), &counters.local());
+
+    std::set<Counter *> seen;
+    seen.insert(&counters.local());
+    std::vector<Counter *> values(4);
+    std::atomic<int> ready(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            values[t] = &counters.local();
+            values[t]->add(t + 1);
+
+            // Keep all threads alive at once, so that no value gets reused
+            ready.fetch_add(1);
+            while (ready.load() < 4) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (auto v : values) {
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(v) % cache_line_size);
+        seen.insert(v);
+    }
+    ASSERT_EQ(5u, seen.size());
+    ASSERT_EQ(1 + 1 + 2 + 3 + 4, counters.aggregate(0L, sum));
+}
+
+TEST(ThreadLocalTest, ExitedThreadValueIsKept) {
+    ThreadLocal<Counter> counters;
+    for (int round = 0; round < 20; round++) {
+        std::thread([&counters] { counters.local().add(1); }).join();
+    }
+
+    // Threads run one by one, so all of them share the same value
+    int values = 0;
+    counters.for_each([&values](Counter &) { values++; });
+    ASSERT_EQ(1, values);
+    ASSERT_EQ(20, counters.aggregate(0L, sum));
+}
+
+TEST(ThreadLocalTest, SeveralContainers) {
+    std::unique_ptr<ThreadLocal<Counter>> first(new ThreadLocal<Counter>());
+    ThreadLocal<Counter> second;
+
+    first->local().add(1);
+    second.local().add(2);
+    ASSERT_NE(&first->local(), &second.local());
+
+    // New container must not get value of the destroyed one even if it is placed at the same address
+    first.reset(new ThreadLocal<Counter>());
+    ASSERT_EQ(0, first->local().value.load());
+    ASSERT_EQ(2, second.local().value.load());
+}
+
+TEST(ThreadLocalTest, ContainerDiesBeforeThread) {
+    std::unique_ptr<ThreadLocal<Counter>> counters(new ThreadLocal<Counter>());
+    std::atomic<bool> used(false), destroyed(false);
+    std::thread thread([&] {
+        counters->local().add(1);
+        used = true;
+        while (!destroyed.load()) {
+            std::this_thread::yield();
+        }
+    });
+
+    while (!used.load()) {
+        std::this_thread::yield();
+    }
+    counters.reset();
+    destroyed = true;
+    thread.join();
+}
@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/MPMCQueue.h>
+#include <afina/concurrency/WorkStealingQueue.h>
+
+using Afina::Concurrency::MPMCQueue;
+using Afina::Concurrency::WorkStealingQueue;
+
+TEST(MPMCQueueTest, FifoAndBounds) {
+    MPMCQueue<int> queue(3);
+    ASSERT_EQ(4u, queue.capacity());
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.push(i));
+    }
+    ASSERT_FALSE(queue.push(4));
+
+    int value;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.pop(value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(queue.pop(value));
+}
+
+TEST(MPMCQueueTest, Concurrent) {
+    MPMCQueue<long> queue(64);
+    const int threads = 4, items = 20000;
+
+    std::atomic<long> sum(0);
+    std::atomic<int> consumed(0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            for (int i = 1; i <= items; i++) {
+                while (!queue.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        pool.emplace_back([&] {
+            long value;
+            while (consumed.load() < threads * items) {
+                if (queue.pop(value)) {
+                    sum.fetch_add(value);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+
+    ASSERT_EQ(long(threads) * items * (items + 1) / 2, sum.load());
+}
+
+TEST(WorkStealingQueueTest, OwnerLifoThiefFifo) {
+    WorkStealingQueue<int> queue(2);
+    for (int i = 0; i < 10; i++) {
+        queue.push(i);
+    }
+    ASSERT_EQ(10u, queue.size());
+
+    int value;
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(9, value);
+    ASSERT_TRUE(queue.steal(value));
+    ASSERT_EQ(0, value);
+    ASSERT_EQ(8u, queue.size());
+}
+
+TEST(WorkStealingQueueTest, ConcurrentSteal) {
+    WorkStealingQueue<int> queue;
+    const int items = 100000;
+
+    std::atomic<bool> done(false);
+    std::atomic<long> stolen(0);
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; t++) {
+        thieves.emplace_back([&] {
+            int value;
+            while (!done.load() || !queue.empty()) {
+                if (queue.steal(value)) {
+                    stolen.fetch_add(value);
+                }
+            }
+        });
+    }
+
+    long own = 0;
+    int value;
+    for (int i = 1; i <= items; i++) {
+        queue.push(i);
+        if (i % 3 == 0 && queue.pop(value)) {
+            own += value;
+        }
+    }
+    while (queue.pop(value)) {
+        own += value;
+    }
+    done = true;
+    for (auto &t : thieves) {
+        t.join();
+    }
+
+    ASSERT_EQ(long(items) * (items + 1) / 2, own + stolen.load());
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <afina/coroutine/Engine.h>
+
+using Afina::Coroutine::Engine;
+
+// Counts heap allocations to make sure steady state spawn/exit doesn't hit allocator
+static long allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *result = std::malloc(size);
+    if (result == nullptr) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+// Two coroutines descend to the given depth and then ping-pong control between each other, so every switch
+// has to deal with depth * sizeof(frame) bytes of live stack
+struct PingPong {
+    Engine *engine;
+    void *routines[2];
+    long switches;
+};
+
+static const std::size_t frame_size = 256;
+
+static void descend(PingPong &pp, int self, std::size_t depth) {
+    volatile char frame[frame_size];
+    frame[0] = 0;
+    if (depth > 0) {
+        descend(pp, self, depth - 1);
+        return;
+    }
+
+    for (long i = 0; i < pp.switches; i++) {
+        pp.engine->sched(pp.routines[1 - self]);
+    }
+}
+
+static void bench_main(PingPong &pp, std::size_t depth) {
+    pp.routines[0] = pp.engine->run(descend, pp, 0, std::size_t(depth));
+    pp.routines[1] = pp.engine->run(descend, pp, 1, std::size_t(depth));
+    pp.engine->sched(pp.routines[0]);
+}
+
+static double measure(Engine::StackMode mode, std::size_t depth, long switches) {
+    Engine engine([] {}, mode);
+    PingPong pp{&engine, {nullptr, nullptr}, switches};
+
+    auto start = std::chrono::steady_clock::now();
+    engine.start(bench_main, pp, std::size_t(depth));
+    auto end = std::chrono::steady_clock::now();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return double(ns) / double(2 * switches);
+}
+
+// Main coroutine spawns short-lived coroutines in batches and waits for them, like server spawning one
+// coroutine per request
+struct SpawnExit {
+    Engine *engine;
+    long batches;
+    long batch_size;
+    long finished;
+    long warmup_allocations;
+};
+
+static void short_lived(SpawnExit &se) { se.finished++; }
+
+static void spawn_main(SpawnExit &se) {
+    for (long b = 0; b < se.batches; b++) {
+        // First batch fills up pools, everything after it should be served from them
+        if (b == 1) {
+            se.warmup_allocations = allocations;
+        }
+
+        long target = se.finished + se.batch_size;
+        for (long i = 0; i < se.batch_size; i++) {
+            se.engine->run(short_lived, se);
+        }
+        while (se.finished < target) {
+            se.engine->yield();
+        }
+    }
+}
+
+static void measure_spawn(Engine::StackMode mode, const char *name) {
+    Engine engine([] {}, mode);
+    SpawnExit se{&engine, 2000, 64, 0, 0};
+
+    auto start = std::chrono::steady_clock::now();
+    engine.start(spawn_main, se);
+    auto end = std::chrono::steady_clock::now();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    long steady = se.batches * se.batch_size - se.batch_size;
+    std::printf("%12s %16.1f %20.3f\n", name, double(ns) / double(se.finished),
+                double(allocations - se.warmup_allocations) / double(steady));
+}
+
+int main() {
+    const long switches = 20000;
+    const std::size_t depths[] = {0, 4, 16, 64, 256};
+
+    std::printf("%12s %12s %16s %16s\n", "frames", "stack bytes", "copy ns/switch", "dedicated ns/switch");
+    for (std::size_t depth : depths) {
+        double copy = measure(Engine::StackMode::kCopy, depth, switches);
+        double dedicated = measure(Engine::StackMode::kDedicated, depth, switches);
+        std::printf("%12zu %12zu %16.1f %16.1f\n", depth, depth * frame_size, copy, dedicated);
+    }
+
+    std::printf("\n%12s %16s %20s\n", "mode", "ns/spawn+exit", "allocs/coroutine");
+    measure_spawn(Engine::StackMode::kCopy, "copy");
+    measure_spawn(Engine::StackMode::kDedicated, "dedicated");
+    return 0;
+}
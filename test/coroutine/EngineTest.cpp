@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include <iostream>
+#include <memory>
 #include <sstream>
 
 #include <afina/coroutine/Engine.h>
@@ -79,4 +80,107 @@ TEST(CoroutineTest, Blocker) {
     std::string result = "";
     engine.start(_printer, engine, result, block);
     ASSERT_STREQ("A1 B1 A2 A3 B2 B3 END", result.c_str());
-}
\ No newline at end of file
+}
+
+TEST(CoroutineTest, DedicatedSimpleStart) {
+    Afina::Coroutine::Engine engine([] {}, Afina::Coroutine::Engine::StackMode::kDedicated);
+
+    int result;
+    engine.start(_calculator_add, result, 1, 2);
+
+    ASSERT_EQ(3, result);
+}
+
+TEST(CoroutineTest, DedicatedPrinter) {
+    Afina::Coroutine::Engine engine([] {}, Afina::Coroutine::Engine::StackMode::kDedicated);
+    bool block = false;
+    std::string result = "";
+    std::stringstream().swap(out);
+    engine.start(_printer, engine, result, block);
+    ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
+}
+
+TEST(CoroutineTest, DedicatedBlocker) {
+    Afina::Coroutine::Engine engine([] {}, Afina::Coroutine::Engine::StackMode::kDedicated);
+    bool block = true;
+    std::string result = "";
+    std::stringstream().swap(out);
+    engine.start(_printer, engine, result, block);
+    ASSERT_STREQ("A1 B1 A2 A3 B2 B3 END", result.c_str());
+}
+
+static void _deep(Afina::Coroutine::Engine &pe, int depth, int &sum) {
+    volatile char frame[512];
+    frame[0] = static_cast<char>(depth);
+    if (depth > 0) {
+        _deep(pe, depth - 1, sum);
+    } else {
+        pe.yield();
+    }
+    sum += frame[0];
+}
+
+static void _deep_main(Afina::Coroutine::Engine &pe, int &sum) {
+    for (int i = 0; i < 16; i++) {
+        pe.run(_deep, pe, 64, sum);
+    }
+}
+
+TEST(CoroutineTest, DedicatedDeepStacks) {
+    Afina::Coroutine::Engine engine([] {}, Afina::Coroutine::Engine::StackMode::kDedicated);
+    int sum = 0;
+    engine.start(_deep_main, engine, sum);
+    ASSERT_EQ(16 * (64 * 65 / 2), sum);
+}
+
+static void _blocked_forever(Afina::Coroutine::Engine &pe, std::shared_ptr<int> captured) {
+    std::shared_ptr<int> local = captured;
+    pe.block();
+    ADD_FAILURE() << "Blocked coroutine got control back";
+}
+
+static void _spawn_blocked(Afina::Coroutine::Engine &pe, std::shared_ptr<int> &held) {
+    pe.run(_blocked_forever, pe, std::shared_ptr<int>(held));
+    pe.run(_blocked_forever, pe, std::shared_ptr<int>(held));
+}
+
+TEST(CoroutineTest, DedicatedUnwindOnDestroy) {
+    auto held = std::make_shared<int>(0);
+    {
+        Afina::Coroutine::Engine engine([] {}, Afina::Coroutine::Engine::StackMode::kDedicated);
+        engine.start(_spawn_blocked, engine, held);
+        ASSERT_LT(1, held.use_count());
+    }
+
+    // Arguments and locals of both coroutines are destroyed
+    EXPECT_EQ(1, held.use_count());
+}
+
+static const char _rr_ids[] = {'a', 'b', 'c'};
+
+static void _rr_worker(Afina::Coroutine::Engine &pe, std::string &trace, const char &id) {
+    for (int i = 0; i < 3; i++) {
+        trace += id;
+        pe.yield();
+    }
+}
+
+static void _rr_main(Afina::Coroutine::Engine &pe, std::string &trace) {
+    for (auto &id : _rr_ids) {
+        pe.run(_rr_worker, pe, trace, id);
+    }
+}
+
+TEST(CoroutineTest, RoundRobin) {
+    for (auto mode : {Afina::Coroutine::Engine::StackMode::kCopy, Afina::Coroutine::Engine::StackMode::kDedicated}) {
+        Afina::Coroutine::Engine engine([] {}, mode);
+        std::string trace;
+        engine.start(_rr_main, engine, trace);
+        ASSERT_EQ("abcabcabc", trace);
+
+        // Engine is reusable, second run is served from the context pool
+        trace.clear();
+        engine.start(_rr_main, engine, trace);
+        ASSERT_EQ("abcabcabc", trace);
+    }
+}
@@ -0,0 +1,57 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include <afina/coroutine/Scheduler.h>
+
+using Afina::Coroutine::Scheduler;
+
+// Every coroutine does a bit of arithmetic between yields, so the benchmark mostly measures how the
+// scheduler spreads many short-lived slices over worker threads
+static void worker(std::atomic<long> &sink, int yields) {
+    unsigned long acc = 0;
+    for (int i = 0; i < yields; i++) {
+        for (int j = 0; j < 64; j++) {
+            acc = acc * 6364136223846793005ul + 1442695040888963407ul;
+        }
+        Scheduler::yield();
+    }
+    sink.fetch_add(static_cast<long>(acc & 1));
+}
+
+static void bench_main(Scheduler &scheduler, std::atomic<long> &sink, int coroutines, int yields) {
+    for (int i = 0; i < coroutines; i++) {
+        scheduler.run(worker, sink, int(yields));
+    }
+}
+
+int main() {
+    const int coroutines = 1000;
+    const int yields = 1000;
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("%8s %12s %16s %10s\n", "threads", "ms", "ns/switch", "speedup");
+    double base = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        Scheduler scheduler(threads, 64 * 1024);
+        std::atomic<long> sink(0);
+
+        auto start = std::chrono::steady_clock::now();
+        scheduler.start(bench_main, scheduler, sink, int(coroutines), int(yields));
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        if (threads == 1) {
+            base = ns;
+        }
+        std::printf("%8u %12.1f %16.1f %10.2f\n", threads, ns / 1e6, ns / (double(coroutines) * yields),
+                    base / ns);
+
+        if (threads * 2 > max_threads && threads != max_threads) {
+            threads = max_threads / 2;
+        }
+    }
+    return 0;
+}
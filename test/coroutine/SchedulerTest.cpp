@@ -0,0 +1,111 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+#include <afina/coroutine/Scheduler.h>
+
+using Afina::Coroutine::Scheduler;
+
+void _scheduler_add(int &result, int left, int right) { result = left + right; }
+
+TEST(SchedulerTest, SimpleStart) {
+    Scheduler scheduler(2);
+
+    int result = 0;
+    scheduler.start(_scheduler_add, result, 1, 2);
+
+    ASSERT_EQ(3, result);
+}
+
+void _yielder(std::atomic<long> &counter, int yields) {
+    for (int i = 0; i < yields; i++) {
+        counter.fetch_add(1);
+        Scheduler::yield();
+    }
+}
+
+void _spawner(Scheduler &scheduler, std::atomic<long> &counter, int coroutines, int yields) {
+    for (int i = 0; i < coroutines; i++) {
+        scheduler.run(_yielder, counter, int(yields));
+    }
+}
+
+TEST(SchedulerTest, ManyYielders) {
+    Scheduler scheduler(4, 64 * 1024);
+
+    std::atomic<long> counter(0);
+    scheduler.start(_spawner, scheduler, counter, 1000, 100);
+
+    ASSERT_EQ(1000 * 100, counter.load());
+}
+
+struct PingPong {
+    Scheduler *scheduler;
+    std::atomic<void *> handles[2];
+    int rounds;
+    std::atomic<int> done;
+};
+
+void _ping_pong(PingPong &pp, int self) {
+    pp.handles[self].store(Scheduler::current());
+    while (pp.handles[1 - self].load() == nullptr) {
+        Scheduler::yield();
+    }
+
+    for (int i = 0; i < pp.rounds; i++) {
+        if (self == 0) {
+            pp.scheduler->unblock(pp.handles[1]);
+            Scheduler::block();
+        } else {
+            Scheduler::block();
+            pp.scheduler->unblock(pp.handles[0]);
+        }
+    }
+    pp.done.fetch_add(1);
+}
+
+void _ping_pong_main(PingPong &pp) {
+    pp.scheduler->run(_ping_pong, pp, 0);
+    pp.scheduler->run(_ping_pong, pp, 1);
+}
+
+TEST(SchedulerTest, BlockUnblock) {
+    Scheduler scheduler(2);
+
+    PingPong pp;
+    pp.scheduler = &scheduler;
+    pp.handles[0].store(nullptr);
+    pp.handles[1].store(nullptr);
+    pp.rounds = 10000;
+    pp.done.store(0);
+    scheduler.start(_ping_pong_main, pp);
+
+    ASSERT_EQ(2, pp.done.load());
+}
+
+void _waiter(std::atomic<void *> &handle, bool &woken) {
+    handle.store(Scheduler::current());
+    Scheduler::block();
+    woken = true;
+}
+
+TEST(SchedulerTest, ForeignThreadUnblock) {
+    Scheduler scheduler(1);
+
+    std::atomic<void *> handle(nullptr);
+    bool woken = false;
+
+    std::thread waker([&] {
+        while (handle.load() == nullptr) {
+            std::this_thread::yield();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        scheduler.unblock(handle.load());
+    });
+
+    scheduler.start(_waiter, handle, woken);
+    waker.join();
+
+    ASSERT_TRUE(woken);
+}
@@ -0,0 +1,199 @@
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include <afina/coroutine/Channel.h>
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Sync.h>
+
+using Afina::Coroutine::Channel;
+using Afina::Coroutine::CondVar;
+using Afina::Coroutine::Engine;
+using Afina::Coroutine::Mutex;
+
+static const Engine::StackMode modes[] = {Engine::StackMode::kCopy, Engine::StackMode::kDedicated};
+
+// In kCopy mode coroutine arguments must not live on coroutine stacks, so everything is passed by
+// reference to objects owned by the test itself
+struct Sleeper {
+    int id;
+    uint32_t ms;
+};
+
+static Sleeper sleepers[] = {{1, 30}, {2, 10}, {3, 20}};
+
+void _sleeper(Engine &engine, std::vector<int> &order, Sleeper &sleeper) {
+    engine.sleep(sleeper.ms);
+    order.push_back(sleeper.id);
+}
+
+void _sleepers_main(Engine &engine, std::vector<int> &order) {
+    for (auto &sleeper : sleepers) {
+        engine.run(_sleeper, engine, order, sleeper);
+    }
+}
+
+TEST(CoroutineSyncTest, SleepOrder) {
+    for (auto mode : modes) {
+        Engine engine([] {}, mode);
+        std::vector<int> order;
+
+        auto start = std::chrono::steady_clock::now();
+        engine.start(_sleepers_main, engine, order);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        ASSERT_EQ(std::vector<int>({2, 3, 1}), order);
+        ASSERT_GE(elapsed, std::chrono::milliseconds(30));
+    }
+}
+
+void _timed_waiter(Engine &engine, int &result) { result = engine.block_for(20) ? 1 : 2; }
+
+void _block_for_main(Engine &engine, int &timed_out, int &woken) {
+    engine.run(_timed_waiter, engine, timed_out);
+    void *waiter = engine.run(_timed_waiter, engine, woken);
+    engine.sched(waiter);
+    engine.unblock(waiter);
+}
+
+TEST(CoroutineSyncTest, BlockFor) {
+    for (auto mode : modes) {
+        Engine engine([] {}, mode);
+        int timed_out = 0, woken = 0;
+        engine.start(_block_for_main, engine, timed_out, woken);
+
+        ASSERT_EQ(2, timed_out);
+        ASSERT_EQ(1, woken);
+    }
+}
+
+TEST(CoroutineSyncTest, NextTimeout) {
+    std::vector<int> timeouts;
+    Engine *pengine = nullptr;
+    Engine engine([&] { timeouts.push_back(pengine->next_timeout()); }, Engine::StackMode::kDedicated);
+    pengine = &engine;
+
+    std::vector<int> order;
+    engine.start(_sleepers_main, engine, order);
+
+    // Last call happens once all timers are gone
+    ASSERT_LE(2u, timeouts.size());
+    ASSERT_EQ(-1, timeouts.back());
+    for (std::size_t i = 0; i + 1 < timeouts.size(); i++) {
+        ASSERT_GE(timeouts[i], 0);
+        ASSERT_LE(timeouts[i], 30);
+    }
+}
+
+void _producer(Channel<int> &channel, const int &count) {
+    for (int i = 1; i <= count; i++) {
+        ASSERT_TRUE(channel.push(i));
+    }
+    channel.close();
+}
+
+void _consumer(Channel<int> &channel, long &sum, int &received) {
+    int value;
+    while (channel.pop(value)) {
+        sum += value;
+        received++;
+    }
+}
+
+static const int channel_items = 1000;
+
+void _channel_main(Engine &engine, Channel<int> &channel, long &sum, int &received) {
+    engine.run(_consumer, channel, sum, received);
+    engine.run(_producer, channel, channel_items);
+}
+
+TEST(CoroutineSyncTest, Channel) {
+    for (auto mode : modes) {
+        Engine engine([] {}, mode);
+        Channel<int> channel(engine, 2);
+
+        long sum = 0;
+        int received = 0;
+        engine.start(_channel_main, engine, channel, sum, received);
+
+        ASSERT_EQ(1000, received);
+        ASSERT_EQ(1000 * 1001 / 2, sum);
+        ASSERT_FALSE(channel.push(1));
+    }
+}
+
+void _pop_timeout(Channel<int> &channel, bool &result) {
+    int value;
+    result = channel.pop_for(value, 10);
+}
+
+TEST(CoroutineSyncTest, ChannelPopTimeout) {
+    Engine engine([] {}, Engine::StackMode::kDedicated);
+    Channel<int> channel(engine, 1);
+
+    bool result = true;
+    engine.start(_pop_timeout, channel, result);
+
+    ASSERT_FALSE(result);
+}
+
+static const char locker_ids[] = {'a', 'b'};
+
+void _locker(Engine &engine, Mutex &mutex, std::string &out, const char &id) {
+    for (int i = 0; i < 3; i++) {
+        mutex.lock();
+        out += id;
+        engine.yield();
+        out += id;
+        mutex.unlock();
+        engine.yield();
+    }
+}
+
+void _mutex_main(Engine &engine, Mutex &mutex, std::string &out) {
+    engine.run(_locker, engine, mutex, out, locker_ids[0]);
+    engine.run(_locker, engine, mutex, out, locker_ids[1]);
+}
+
+TEST(CoroutineSyncTest, Mutex) {
+    for (auto mode : modes) {
+        Engine engine([] {}, mode);
+        Mutex mutex(engine);
+        std::string out;
+        engine.start(_mutex_main, engine, mutex, out);
+
+        ASSERT_EQ(12u, out.size());
+        for (std::size_t i = 0; i < out.size(); i += 2) {
+            ASSERT_EQ(out[i], out[i + 1]);
+        }
+    }
+}
+
+void _cv_waiter(CondVar &cv, bool &ready, int &woken) {
+    while (!ready) {
+        cv.wait();
+    }
+    woken++;
+}
+
+void _cv_main(Engine &engine, CondVar &cv, bool &ready, int &woken) {
+    for (int i = 0; i < 3; i++) {
+        engine.run(_cv_waiter, cv, ready, woken);
+    }
+    engine.yield();
+    ready = true;
+    cv.notify_all();
+}
+
+TEST(CoroutineSyncTest, CondVar) {
+    for (auto mode : modes) {
+        Engine engine([] {}, mode);
+        CondVar cv(engine);
+        bool ready = false;
+        int woken = 0;
+        engine.start(_cv_main, engine, cv, ready, woken);
+
+        ASSERT_EQ(3, woken);
+    }
+}
@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include <afina/execute/Get.h>
+#include <afina/execute/Set.h>
+#include <afina/execute/Stats.h>
+#include <afina/metrics/Latency.h>
+#include <afina/metrics/Metrics.h>
+
+#include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+
+using namespace Afina;
+using namespace Afina::Execute;
+
+namespace {
+
+// Parses "STAT name value" lines of stats response
+std::map<std::string, std::string> ParseStats(const std::string &out) {
+    std::map<std::string, std::string> result;
+    std::istringstream lines(out);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line == "END") {
+            result["END"] = "";
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string stat, name, value;
+        fields >> stat >> name >> value;
+        EXPECT_EQ("STAT", stat) << line;
+        result[name] = value;
+    }
+    return result;
+}
+
+std::map<std::string, std::string> RunStats(Storage &storage) {
+    std::string out;
+    Stats().Execute(storage, "", out);
+    EXPECT_EQ(out.size() - 3, out.rfind("END"));
+    return ParseStats(out);
+}
+
+long long Stat(const std::map<std::string, std::string> &stats, const std::string &name) {
+    auto it = stats.find(name);
+    EXPECT_TRUE(it != stats.end()) << name;
+    return it == stats.end() ? -1 : std::stoll(it->second);
+}
+
+} // namespace
+
+TEST(MetricsTest, AddFromManyThreads) {
+    int64_t before = Metrics::Value(Metrics::Id::kBytesRead);
+
+    std::thread threads[4];
+    for (auto &t : threads) {
+        t = std::thread([] {
+            for (int i = 0; i < 1000; i++) {
+                Metrics::Add(Metrics::Id::kBytesRead, 2);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    // Exited threads keep their contribution
+    EXPECT_EQ(before + 8000, Metrics::Value(Metrics::Id::kBytesRead));
+}
+
+TEST(MetricsTest, Names) {
+    EXPECT_STREQ("curr_items", Metrics::Name(Metrics::Id::kCurrItems));
+    EXPECT_STREQ("bytes_written", Metrics::Name(Metrics::Id::kBytesWritten));
+}
+
+TEST(StatsTest, Format) {
+    Backend::SimpleLRU storage;
+    auto stats = RunStats(storage);
+
+    EXPECT_TRUE(stats.count("END"));
+    const char *names[] = {"pid", "uptime", "time", "rusage_user", "rusage_system", "curr_items", "bytes",
+                           "evictions", "cmd_get", "get_hits", "get_misses", "cmd_set", "curr_connections",
+                           "total_connections", "bytes_read", "bytes_written"};
+    for (auto name : names) {
+        EXPECT_TRUE(stats.count(name)) << name;
+    }
+    EXPECT_EQ(getpid(), Stat(stats, "pid"));
+    EXPECT_NE(std::string::npos, stats["rusage_user"].find('.'));
+}
+
+TEST(StatsTest, CommandsAndStorage) {
+    Backend::SimpleLRU storage(64);
+    auto before = RunStats(storage);
+
+    std::string out;
+    Set("key1", 0, 0).Execute(storage, "value1", out);
+    Set("key2", 0, 0).Execute(storage, "value2", out);
+    Get(std::vector<std::string>{"key1", "key3"}).Execute(storage, "", out);
+
+    auto after = RunStats(storage);
+    EXPECT_EQ(2, Stat(after, "cmd_set") - Stat(before, "cmd_set"));
+    EXPECT_EQ(2, Stat(after, "cmd_get") - Stat(before, "cmd_get"));
+    EXPECT_EQ(1, Stat(after, "get_hits") - Stat(before, "get_hits"));
+    EXPECT_EQ(1, Stat(after, "get_misses") - Stat(before, "get_misses"));
+    EXPECT_EQ(2, Stat(after, "curr_items") - Stat(before, "curr_items"));
+    EXPECT_EQ(20, Stat(after, "bytes") - Stat(before, "bytes"));
+
+    // Doesn't fit along with the others, so two oldest entries go away
+    Set("key3", 0, 0).Execute(storage, std::string(55, 'x'), out);
+    auto evicted = RunStats(storage);
+    EXPECT_EQ(2, Stat(evicted, "evictions") - Stat(after, "evictions"));
+    EXPECT_EQ(-1, Stat(evicted, "curr_items") - Stat(after, "curr_items"));
+    EXPECT_EQ(39, Stat(evicted, "bytes") - Stat(after, "bytes"));
+}
+
+TEST(StatsTest, StorageDestroyed) {
+    int64_t items = Metrics::Value(Metrics::Id::kCurrItems);
+    int64_t bytes = Metrics::Value(Metrics::Id::kBytes);
+    {
+        Backend::SimpleLRU storage;
+        storage.Put("key", "value");
+        EXPECT_EQ(items + 1, Metrics::Value(Metrics::Id::kCurrItems));
+    }
+    EXPECT_EQ(items, Metrics::Value(Metrics::Id::kCurrItems));
+    EXPECT_EQ(bytes, Metrics::Value(Metrics::Id::kBytes));
+}
+
+TEST(StatsTest, Latency) {
+    Backend::SimpleLRU storage;
+    Metrics::Record(Metrics::Op::kGet, Metrics::Stage::kExecute, 1500);
+
+    std::string out;
+    Stats(std::vector<std::string>{"latency"}).Execute(storage, "", out);
+    auto stats = ParseStats(out);
+    EXPECT_TRUE(stats.count("END"));
+    EXPECT_GE(Stat(stats, "get_execute_count"), 1);
+    EXPECT_GE(Stat(stats, "get_execute_max"), 1500);
+    EXPECT_LE(Stat(stats, "get_execute_p50"), Stat(stats, "get_execute_p99"));
+    EXPECT_LE(Stat(stats, "get_execute_p999"), Stat(stats, "get_execute_max"));
+
+    // Nothing recorded, nothing reported
+    EXPECT_EQ(0, stats.count("replace_write_count"));
+}
+
+TEST(StatsTest, UnknownGroup) {
+    Backend::SimpleLRU storage;
+    std::string out;
+    EXPECT_THROW(Stats(std::vector<std::string>{"slabs"}).Execute(storage, "", out), std::runtime_error);
+}
+
+TEST(StatsTest, Slabs) {
+    Backend::SlabLRU storage(std::make_shared<Allocator::Slab>(1024 * 1024, 64 * 1024));
+    std::string out;
+    Set("key", 0, 0).Execute(storage, "hello", out);
+
+    Stats(std::vector<std::string>{"slabs"}).Execute(storage, "", out);
+    auto stats = ParseStats(out);
+    EXPECT_TRUE(stats.count("END"));
+    EXPECT_EQ(1, Stat(stats, "active_slabs"));
+    EXPECT_EQ(64 * 1024, Stat(stats, "total_malloced"));
+    EXPECT_EQ(1, Stat(stats, "1:used_chunks"));
+}
@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+
+#include <spdlog/sinks/null_sink.h>
+
+#include <afina/logging/Log.h>
+
+#include "LogBench.h"
+
+using namespace Afina::Logging;
+
+namespace {
+
+/**
+ * Logging done by mt_nonblocking for every event and every accept before macros: calls check level at
+ * runtime, address is resolved whatever level is. Every variant is a call, so that they differ in logging only
+ */
+struct Before {
+    __attribute__((noinline)) static void Event(spdlog::logger &logger, int events) {
+        logger.debug("Worker wokeup: {} events", events);
+        logger.trace("Got EPOLLIN");
+        logger.trace("Got EPOLLOUT");
+    }
+
+    __attribute__((noinline)) static void Accept(spdlog::logger &logger, const sockaddr_in &addr, int fd) {
+        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+        int retval = getnameinfo(reinterpret_cast<const sockaddr *>(&addr), sizeof(addr), hbuf, sizeof hbuf, sbuf,
+                                 sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
+        if (retval == 0) {
+            logger.info("Accepted connection on descriptor {} (host={}, port={})\n", fd, hbuf, sbuf);
+        }
+    }
+};
+
+template <typename F> double Measure(long ops, F &&body) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < ops; i++) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(end - start).count() / ops;
+}
+
+} // namespace
+
+// See LogBench.h
+__attribute__((noinline)) void LogEvent(std::shared_ptr<spdlog::logger> &logger, int events) {
+    AFINA_LOG_DEBUG(logger, "Worker wokeup: {} events", events);
+    AFINA_LOG_TRACE(logger, "Got EPOLLIN");
+    AFINA_LOG_TRACE(logger, "Got EPOLLOUT");
+}
+
+// See LogBench.h
+__attribute__((noinline)) void LogAccept(std::shared_ptr<spdlog::logger> &logger, const sockaddr_in &addr, int fd) {
+    if (AFINA_LOG_ENABLED(logger, spdlog::level::info)) {
+        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+        if (getnameinfo(reinterpret_cast<const sockaddr *>(&addr), sizeof(addr), hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                        NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+            AFINA_LOG_INFO(logger, "Accepted connection on descriptor {} (host={}, port={})", fd, hbuf, sbuf);
+        }
+    }
+}
+
+int main() {
+    const long events = 20000000;
+    const long accepts = 200000;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(40000);
+    inet_pton(AF_INET, "10.1.2.3", &addr.sin_addr);
+
+    // As configured by default: warnings only, written through rings to nowhere
+    auto rings = std::make_shared<LogRings>();
+    rings->Start();
+    std::vector<spdlog::sink_ptr> sinks{std::make_shared<spdlog::sinks::null_sink_mt>()};
+    std::shared_ptr<spdlog::logger> logger = std::make_shared<RingLogger>("network", sinks, rings);
+    logger->set_level(spdlog::level::warn);
+
+    std::printf("%-44s %12s %12s\n", "level warn, per call", "event ns", "accept ns");
+    std::printf("%-44s %12.2f %12.2f\n", "spdlog calls (before)",
+                Measure(events, [&](long i) { Before::Event(*logger, i); }),
+                Measure(accepts, [&](long i) { Before::Accept(*logger, addr, i); }));
+    std::printf("%-44s %12.2f %12.2f\n", "macros, level checked at runtime",
+                Measure(events, [&](long i) { LogEvent(logger, i); }),
+                Measure(accepts, [&](long i) { LogAccept(logger, addr, i); }));
+    std::printf("%-44s %12.2f %12.2f\n", "macros, compiled with AFINA_LOG_LEVEL=warn",
+                Measure(events, [&](long i) { LogEventCompiledOut(logger, i); }),
+                Measure(accepts, [&](long i) { LogAcceptCompiledOut(logger, addr, i); }));
+
+    // Everything enabled: text formatted in place versus binary records formatted by flusher
+    logger->set_level(spdlog::level::trace);
+    std::printf("%-44s %12.2f %12.2f\n", "level trace, spdlog calls",
+                Measure(accepts, [&](long i) { Before::Event(*logger, i); }),
+                Measure(accepts, [&](long i) { Before::Accept(*logger, addr, i); }));
+    // Held the way servers hold it
+    Handle ring = logger;
+    std::printf("%-44s %12.2f %12.2f\n", "level trace, binary records", Measure(accepts, [&](long i) {
+                    AFINA_LOG_DEBUG(ring, "Worker wokeup: {} events", i);
+                    AFINA_LOG_TRACE(ring, "Got EPOLLIN");
+                    AFINA_LOG_TRACE(ring, "Got EPOLLOUT");
+                }),
+                Measure(accepts, [&](long i) {
+                    char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+                    if (getnameinfo(reinterpret_cast<const sockaddr *>(&addr), sizeof(addr), hbuf, sizeof hbuf, sbuf,
+                                    sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+                        AFINA_LOG_INFO(ring, "Accepted connection on descriptor {} (host={}, port={})", i, hbuf, sbuf);
+                    }
+                }));
+    rings->Stop();
+    std::printf("log records dropped: %zu\n", rings->dropped());
+    return 0;
+}
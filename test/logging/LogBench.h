@@ -0,0 +1,22 @@
+#ifndef AFINA_TEST_LOGGING_LOG_BENCH_H
+#define AFINA_TEST_LOGGING_LOG_BENCH_H
+
+#include <memory>
+
+#include <netinet/in.h>
+
+#include <spdlog/logger.h>
+
+/**
+ * Logging of mt_nonblocking worker for a single event and of acceptor for a single connection with macros
+ */
+void LogEvent(std::shared_ptr<spdlog::logger> &logger, int events);
+void LogAccept(std::shared_ptr<spdlog::logger> &logger, const sockaddr_in &addr, int fd);
+
+/**
+ * The same built with AFINA_LOG_LEVEL=warn
+ */
+void LogEventCompiledOut(std::shared_ptr<spdlog::logger> &logger, int events);
+void LogAcceptCompiledOut(std::shared_ptr<spdlog::logger> &logger, const sockaddr_in &addr, int fd);
+
+#endif // AFINA_TEST_LOGGING_LOG_BENCH_H
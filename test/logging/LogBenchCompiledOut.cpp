@@ -0,0 +1,27 @@
+// Build has its own least level, this file pretends to be built with -DAFINA_LOG_LEVEL=warn
+#undef AFINA_LOG_LEVEL
+#define AFINA_LOG_LEVEL 3
+
+#include <netdb.h>
+
+#include <afina/logging/Log.h>
+
+#include "LogBench.h"
+
+// See LogBench.h
+void LogEventCompiledOut(std::shared_ptr<spdlog::logger> &logger, int events) {
+    AFINA_LOG_DEBUG(logger, "Worker wokeup: {} events", events);
+    AFINA_LOG_TRACE(logger, "Got EPOLLIN");
+    AFINA_LOG_TRACE(logger, "Got EPOLLOUT");
+}
+
+// See LogBench.h
+void LogAcceptCompiledOut(std::shared_ptr<spdlog::logger> &logger, const sockaddr_in &addr, int fd) {
+    if (AFINA_LOG_ENABLED(logger, spdlog::level::info)) {
+        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+        if (getnameinfo(reinterpret_cast<const sockaddr *>(&addr), sizeof(addr), hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                        NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+            AFINA_LOG_INFO(logger, "Accepted connection on descriptor {} (host={}, port={})", fd, hbuf, sbuf);
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <afina/logging/Log.h>
+
+using namespace Afina::Logging;
+
+namespace {
+
+class CountingSink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    CountingSink() : count(0) {}
+    void flush() override {}
+
+    std::size_t count;
+    std::string last;
+
+protected:
+    void _sink_it(const spdlog::details::log_msg &msg) override {
+        count++;
+        last.assign(msg.raw.data(), msg.raw.size());
+    }
+};
+
+int Expensive(int &calls) { return ++calls; }
+
+} // namespace
+
+TEST(LogTest, Compiled) {
+    static_assert(Compiled<0, spdlog::level::trace>::value, "everything is compiled in at trace");
+    static_assert(!Compiled<2, spdlog::level::debug>::value, "debug is below info");
+    static_assert(Compiled<2, spdlog::level::info>::value, "info is not below info");
+    static_assert(!Compiled<6, spdlog::level::critical>::value, "nothing is compiled in at off");
+}
+
+TEST(LogTest, LazyArguments) {
+    auto sink = std::make_shared<CountingSink>();
+    auto logger = std::make_shared<spdlog::logger>("test", sink);
+    logger->set_level(spdlog::level::info);
+
+    int calls = 0;
+    AFINA_LOG_DEBUG(logger, "value {}", Expensive(calls));
+    EXPECT_EQ(0, calls);
+    EXPECT_EQ(0, sink->count);
+    EXPECT_FALSE(AFINA_LOG_ENABLED(logger, spdlog::level::debug));
+
+    AFINA_LOG_INFO(logger, "value {}", Expensive(calls));
+    AFINA_LOG_WARN(logger, "no arguments");
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(2, sink->count);
+    EXPECT_EQ("no arguments", sink->last);
+}
+
+TEST(LogTest, RingRecord) {
+    auto sink = std::make_shared<CountingSink>();
+    auto rings = std::make_shared<LogRings>();
+    auto logger = std::make_shared<RingLogger>("test", std::vector<spdlog::sink_ptr>{sink}, rings);
+    logger->set_level(spdlog::level::trace);
+
+    // Arguments go to the ring as they are and get formatted by flusher
+    AFINA_LOG_TRACE(logger, "events {} on {}", 3, "worker");
+    EXPECT_EQ(0, sink->count);
+    logger->flush();
+    EXPECT_EQ(1, sink->count);
+    EXPECT_EQ("events 3 on worker", sink->last);
+}
+
+TEST(LogTest, RingRecordThroughBasePointer) {
+    auto sink = std::make_shared<CountingSink>();
+    auto rings = std::make_shared<LogRings>();
+    std::shared_ptr<spdlog::logger> logger =
+        std::make_shared<RingLogger>("test", std::vector<spdlog::sink_ptr>{sink}, rings);
+    logger->set_level(spdlog::level::info);
+    Handle handle = logger;
+    ASSERT_NE(nullptr, handle.ring());
+
+    // fmt is kept by pointer until flusher formats the record, so what it holds by then is what gets out
+    char fmt[] = "before {}";
+    AFINA_LOG_INFO(logger, fmt, 1);
+    AFINA_LOG_INFO(handle, fmt, 2);
+    std::memcpy(fmt, "after ", 6);
+    EXPECT_EQ(0, sink->count);
+
+    logger->flush();
+    EXPECT_EQ(2, sink->count);
+    EXPECT_EQ("after  2", sink->last);
+
+    Handle plain = std::make_shared<spdlog::logger>("plain", sink);
+    EXPECT_EQ(nullptr, plain.ring());
+    AFINA_LOG_WARN(plain, "formatted {}", "in place");
+    EXPECT_EQ(3, sink->count);
+    EXPECT_EQ("formatted in place", sink->last);
+}
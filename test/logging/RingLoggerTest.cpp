@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <afina/logging/RingLogger.h>
+#include <afina/metrics/Metrics.h>
+
+using namespace Afina::Logging;
+using namespace Afina;
+
+namespace {
+
+// Keeps messages without any decoration
+class MemorySink : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    void flush() override {}
+
+    std::vector<std::string> messages() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _messages;
+    }
+
+protected:
+    void _sink_it(const spdlog::details::log_msg &msg) override { _messages.emplace_back(msg.raw.data(), msg.raw.size()); }
+
+private:
+    std::vector<std::string> _messages;
+};
+
+std::shared_ptr<RingLogger> MakeLogger(std::shared_ptr<MemorySink> sink, std::shared_ptr<LogRings> rings) {
+    auto logger = std::make_shared<RingLogger>("test", std::vector<spdlog::sink_ptr>{sink}, std::move(rings));
+    logger->set_level(spdlog::level::info);
+    return logger;
+}
+
+} // namespace
+
+TEST(RingLoggerTest, Text) {
+    auto sink = std::make_shared<MemorySink>();
+    auto logger = MakeLogger(sink, std::make_shared<LogRings>());
+
+    logger->info("Accepted connection on descriptor {} (host={})", 5, "localhost");
+    logger->warn("Stop");
+    logger->debug("Not logged {}", 1);
+    EXPECT_TRUE(sink->messages().empty());
+
+    logger->flush();
+    EXPECT_EQ((std::vector<std::string>{"Accepted connection on descriptor 5 (host=localhost)", "Stop"}),
+              sink->messages());
+}
+
+TEST(RingLoggerTest, Record) {
+    auto sink = std::make_shared<MemorySink>();
+    auto logger = MakeLogger(sink, std::make_shared<LogRings>());
+
+    char host[16] = "example.org";
+    std::string command = "get";
+    logger->record(spdlog::level::info, "host={} port={} cmd={} ratio={} ok={}", host, uint16_t(8080), command, 0.5,
+                   true);
+    logger->record(spdlog::level::warn, "no arguments");
+    logger->record(spdlog::level::debug, "Not logged {}", 1);
+
+    // Arguments are copied, not referenced
+    host[0] = 'X';
+    command = "set";
+
+    logger->flush();
+    EXPECT_EQ((std::vector<std::string>{"host=example.org port=8080 cmd=get ratio=0.5 ok=true", "no arguments"}),
+              sink->messages());
+}
+
+TEST(RingLoggerTest, Overflow) {
+    auto sink = std::make_shared<MemorySink>();
+    auto rings = std::make_shared<LogRings>(1024);
+    auto logger = MakeLogger(sink, rings);
+
+    // Nobody drains the ring, it holds 1024 / 64 records
+    int64_t before = Metrics::Value(Metrics::Id::kLogDropped);
+    for (int i = 0; i < 100; i++) {
+        logger->record(spdlog::level::info, "record {}", i);
+    }
+    EXPECT_EQ(84, rings->dropped());
+    EXPECT_EQ(before + 84, Metrics::Value(Metrics::Id::kLogDropped));
+
+    // Too large for the ring at all
+    logger->info(std::string(1000, 'x'));
+    EXPECT_EQ(85, rings->dropped());
+
+    logger->flush();
+    auto messages = sink->messages();
+    ASSERT_EQ(16, messages.size());
+    EXPECT_EQ("record 0", messages.front());
+    EXPECT_EQ("record 15", messages.back());
+}
+
+TEST(RingLoggerTest, WrapAround) {
+    auto sink = std::make_shared<MemorySink>();
+    auto rings = std::make_shared<LogRings>(4096);
+    auto logger = MakeLogger(sink, rings);
+
+    // Sizes vary, so records end at different offsets and some start over from the beginning of ring
+    std::vector<std::string> expected;
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 5; i++) {
+            std::string value(std::size_t(round * 7 + i * 13) % 300, char('a' + i));
+            logger->record(spdlog::level::info, "{} {}", round, value);
+            expected.push_back(std::to_string(round) + " " + value);
+        }
+        logger->flush();
+    }
+    EXPECT_EQ(0, rings->dropped());
+    EXPECT_EQ(expected, sink->messages());
+}
+
+TEST(RingLoggerTest, Threads) {
+    auto sink = std::make_shared<MemorySink>();
+    auto rings = std::make_shared<LogRings>(64 * 1024, std::chrono::milliseconds(1));
+    auto logger = MakeLogger(sink, rings);
+    rings->Start();
+
+    const int threads = 4;
+    const int records = 2000;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&logger, t] {
+            for (int i = 0; i < records; i++) {
+                logger->record(spdlog::level::info, "{} {}", t, i);
+                if (i % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+    rings->Stop();
+
+    // Order is kept within every thread, whatever was dropped
+    std::vector<int> last(threads, -1);
+    auto messages = sink->messages();
+    for (auto &message : messages) {
+        std::size_t space = message.find(' ');
+        int t = std::stoi(message.substr(0, space));
+        int i = std::stoi(message.substr(space + 1));
+        EXPECT_LT(last[t], i);
+        last[t] = i;
+    }
+    EXPECT_EQ(threads * records, messages.size() + rings->dropped());
+}
@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <afina/metrics/Histogram.h>
+#include <afina/metrics/Latency.h>
+
+using namespace Afina::Metrics;
+
+TEST(HistogramTest, BucketBounds) {
+    // Every value must be within its bucket and the bucket must be narrow enough
+    for (uint64_t value = 0; value < (1 << 20); value++) {
+        std::size_t bucket = Histogram::BucketOf(value);
+        ASSERT_LT(bucket, Histogram::bucket_count);
+        ASSERT_LE(value, Histogram::UpperBound(bucket));
+        if (bucket > 0) {
+            ASSERT_GT(value, Histogram::UpperBound(bucket - 1));
+        }
+        ASSERT_LE(Histogram::UpperBound(bucket) - value, value / Histogram::sub_buckets);
+    }
+
+    EXPECT_EQ(Histogram::bucket_count - 1, Histogram::BucketOf(Histogram::max_value));
+    EXPECT_EQ(Histogram::max_value, Histogram::UpperBound(Histogram::bucket_count - 1));
+}
+
+TEST(HistogramTest, Empty) {
+    Histogram histogram;
+    Histogram::Snapshot snapshot;
+    snapshot.Add(histogram);
+
+    EXPECT_EQ(0, snapshot.Count());
+    EXPECT_EQ(0, snapshot.Max());
+    EXPECT_EQ(0, snapshot.Percentile(0.99));
+}
+
+TEST(HistogramTest, Percentiles) {
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 10000; value++) {
+        histogram.Record(value);
+    }
+
+    Histogram::Snapshot snapshot;
+    snapshot.Add(histogram);
+    EXPECT_EQ(10000, snapshot.Count());
+    EXPECT_EQ(10000, snapshot.Max());
+
+    // Reported values are rounded up to bucket bound, so they are a bit above exact ones
+    auto near = [](uint64_t exact, uint64_t reported) {
+        return reported >= exact && reported - exact <= exact / Histogram::sub_buckets;
+    };
+    EXPECT_PRED2(near, 5000, snapshot.Percentile(0.5));
+    EXPECT_PRED2(near, 9900, snapshot.Percentile(0.99));
+    EXPECT_PRED2(near, 9990, snapshot.Percentile(0.999));
+    EXPECT_EQ(10000, snapshot.Percentile(1.0));
+    EXPECT_EQ(1, snapshot.Percentile(0.0));
+}
+
+TEST(HistogramTest, Tail) {
+    Histogram histogram;
+    for (int i = 0; i < 990; i++) {
+        histogram.Record(100);
+    }
+    for (int i = 0; i < 10; i++) {
+        histogram.Record(1000000);
+    }
+
+    Histogram::Snapshot snapshot;
+    snapshot.Add(histogram);
+    EXPECT_GE(snapshot.Percentile(0.5), 100);
+    EXPECT_LT(snapshot.Percentile(0.99), 1000000 / 2);
+    EXPECT_EQ(1000000, snapshot.Percentile(0.999));
+    EXPECT_EQ(1000000, snapshot.Max());
+}
+
+TEST(HistogramTest, Huge) {
+    Histogram histogram;
+    histogram.Record(UINT64_MAX);
+
+    Histogram::Snapshot snapshot;
+    snapshot.Add(histogram);
+    EXPECT_EQ(1, snapshot.Count());
+    EXPECT_EQ(Histogram::max_value, snapshot.Max());
+}
+
+TEST(HistogramTest, Merge) {
+    Histogram first, second;
+    for (int i = 0; i < 100; i++) {
+        first.Record(10);
+        second.Record(20);
+    }
+
+    Histogram::Snapshot snapshot;
+    snapshot.Add(first);
+    snapshot.Add(second);
+    EXPECT_EQ(200, snapshot.Count());
+    EXPECT_EQ(10, snapshot.Percentile(0.5));
+    EXPECT_EQ(20, snapshot.Percentile(0.51));
+}
+
+TEST(LatencyTest, OpOf) {
+    EXPECT_EQ(Op::kGet, OpOf("get"));
+    EXPECT_EQ(Op::kGet, OpOf("gets"));
+    EXPECT_EQ(Op::kSet, OpOf("set"));
+    EXPECT_EQ(Op::kStats, OpOf("stats"));
+    EXPECT_EQ(Op::kOther, OpOf("flush_all"));
+    EXPECT_STREQ("get", Name(Op::kGet));
+    EXPECT_STREQ("write", Name(Stage::kWrite));
+}
+
+TEST(LatencyTest, RecordFromManyThreads) {
+    uint64_t before = Latency(Op::kDelete, Stage::kExecute).Count();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 1000; i++) {
+                Record(Op::kDelete, Stage::kExecute, 1000 * (t + 1));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    Histogram::Snapshot snapshot = Latency(Op::kDelete, Stage::kExecute);
+    EXPECT_EQ(before + 4000, snapshot.Count());
+    EXPECT_EQ(4000, snapshot.Max());
+    EXPECT_EQ(0, Latency(Op::kDelete, Stage::kWrite).Count());
+}
@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include <afina/logging/Config.h>
+#include <afina/metrics/Metrics.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/OutputLimits.h"
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "network/st_nonblocking/ServerImpl.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Network;
+
+namespace {
+
+const std::size_t value_size = 1000;
+const std::size_t gets = 20000;
+
+// Response to get of the value
+const std::size_t response_size = std::string("VALUE k 0 1000\r\n").size() + value_size + std::string("\r\nEND\r\n").size();
+
+int Listen() {
+    int s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (s == -1 || bind(s, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(s, 16) == -1) {
+        throw std::runtime_error("Failed to listen");
+    }
+    return s;
+}
+
+// Client with small receive buffer, so responses it doesn't read pile up on server rather than in kernel
+int Connect(int server_socket) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(server_socket, (struct sockaddr *)&addr, &len);
+
+    int s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int buffer = 4096;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    struct timeval timeout = {5, 0};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (connect(s, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        throw std::runtime_error("Failed to connect");
+    }
+    return s;
+}
+
+void SendAll(int s, const std::string &data) {
+    std::size_t done = 0;
+    ssize_t n;
+    while (done < data.size() && (n = send(s, data.data() + done, data.size() - done, 0)) > 0) {
+        done += n;
+    }
+}
+
+std::shared_ptr<Logging::Service> Logs() {
+    auto config = std::make_shared<Logging::Config>();
+    Logging::Appender &console = config->appenders["console"];
+    console.type = Logging::Appender::Type::STDOUT;
+    Logging::Logger &logger = config->loggers["root"];
+    logger.level = Logging::Logger::Level::ERROR;
+    logger.appenders.push_back("console");
+    return std::make_shared<Logging::ServiceImpl>(config);
+}
+
+bool WaitThrottled(int64_t before) {
+    for (int i = 0; i < 500; i++) {
+        if (Metrics::Value(Metrics::Id::kThrottledConnections) > before) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// Pipelines a lot of gets without reading responses, then checks server stopped reading with no more
+// unsent responses than max_output and still answers every request once client reads
+template <typename Server>
+void Flood(std::size_t connection_limit, std::size_t total_limit, int64_t max_output) {
+    auto logs = Logs();
+    logs->Start();
+    auto storage = std::make_shared<Backend::ThreadSafeSimplLRU>(1024 * 1024);
+
+    int server_socket = Listen();
+    Server server(storage, logs);
+    server.Inherit(server_socket);
+    server.Limit(connection_limit, total_limit);
+    server.Start(0, 1, 2);
+
+    int64_t throttled = Metrics::Value(Metrics::Id::kThrottledConnections);
+    int64_t throttles = Metrics::Value(Metrics::Id::kTotalThrottles);
+    int64_t output = Metrics::Value(Metrics::Id::kOutputBytes);
+
+    int client = Connect(server_socket);
+    std::thread sender([client] {
+        std::string requests = "set k 0 0 " + std::to_string(value_size) + "\r\n" + std::string(value_size, 'v') + "\r\n";
+        for (std::size_t i = 0; i < gets; i++) {
+            requests += "get k\r\n";
+        }
+        SendAll(client, requests);
+    });
+
+    ASSERT_TRUE(WaitThrottled(throttled));
+    EXPECT_LE(Metrics::Value(Metrics::Id::kOutputBytes) - output, max_output);
+    EXPECT_GT(Metrics::Value(Metrics::Id::kTotalThrottles), throttles);
+
+    // Every response arrives once client reads
+    std::string expected = "STORED\r\n";
+    std::string value = "VALUE k 0 " + std::to_string(value_size) + "\r\n" + std::string(value_size, 'v') + "\r\nEND\r\n";
+    ASSERT_EQ(response_size, value.size());
+    std::string received;
+    char buf[65536];
+    ssize_t n;
+    while (received.size() < expected.size() + gets * response_size && (n = read(client, buf, sizeof(buf))) > 0) {
+        received.append(buf, n);
+    }
+    if (received.size() < expected.size() + gets * response_size) {
+        // Server stalled, sender may be stuck in send
+        shutdown(client, SHUT_RDWR);
+    }
+    sender.join();
+    ASSERT_EQ(expected.size() + gets * response_size, received.size());
+    EXPECT_EQ(0, received.compare(0, expected.size(), expected));
+    EXPECT_EQ(0, received.compare(received.size() - value.size(), value.size(), value));
+    EXPECT_EQ(throttled, Metrics::Value(Metrics::Id::kThrottledConnections));
+
+    close(client);
+    server.Stop();
+    server.Join();
+    logs->Stop();
+
+    // Loggers are registered globally, the next test registers its own
+    spdlog::drop_all();
+    EXPECT_EQ(output, Metrics::Value(Metrics::Id::kOutputBytes));
+    EXPECT_EQ(throttled, Metrics::Value(Metrics::Id::kThrottledConnections));
+}
+
+} // namespace
+
+TEST(OutputLimitsTest, ConnectionAndTotal) {
+    OutputLimits limits(100, 1000);
+    EXPECT_FALSE(limits.Exceeded(0));
+    EXPECT_FALSE(limits.Exceeded(99));
+    EXPECT_TRUE(limits.Exceeded(100));
+
+    // Resumes at half of the limit
+    EXPECT_FALSE(limits.Drained(51));
+    EXPECT_TRUE(limits.Drained(50));
+
+    // Total stops everyone who has anything to send
+    limits.Queued(1000);
+    EXPECT_TRUE(limits.Exceeded(1));
+    EXPECT_FALSE(limits.Exceeded(0));
+    EXPECT_FALSE(limits.Drained(10));
+    EXPECT_TRUE(limits.Drained(0));
+
+    limits.Sent(1);
+    EXPECT_FALSE(limits.Exceeded(1));
+    EXPECT_TRUE(limits.Drained(10));
+    limits.Sent(999);
+    EXPECT_EQ(0u, limits.Total());
+}
+
+TEST(BackpressureTest, STnonblockConnectionLimit) {
+    Flood<STnonblock::ServerImpl>(64 * 1024, 1024 * 1024 * 1024, 64 * 1024 + response_size);
+}
+
+TEST(BackpressureTest, MTnonblockConnectionLimit) {
+    Flood<MTnonblock::ServerImpl>(64 * 1024, 1024 * 1024 * 1024, 64 * 1024 + response_size);
+}
+
+// Total is accounted once per read, so it could be exceeded by responses to a single read buffer
+TEST(BackpressureTest, STnonblockTotalLimit) {
+    Flood<STnonblock::ServerImpl>(1024 * 1024 * 1024, 64 * 1024, 64 * 1024 + 4096 * response_size);
+}
+
+TEST(BackpressureTest, MTnonblockTotalLimit) {
+    Flood<MTnonblock::ServerImpl>(1024 * 1024 * 1024, 64 * 1024, 64 * 1024 + 4096 * response_size);
+}
@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/Handover.h"
+#include "network/mt_blocking/ServerImpl.h"
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Network;
+
+namespace {
+
+std::string Path(const std::string &name) { return "/tmp/afina_handover_" + name + "_" + std::to_string(getpid()); }
+
+// Socket listening on loopback at port chosen by kernel
+int Listen() {
+    int s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (s == -1 || bind(s, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(s, 16) == -1) {
+        throw std::runtime_error("Failed to listen");
+    }
+    return s;
+}
+
+uint16_t Port(int s) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(s, (struct sockaddr *)&addr, &len);
+    return ntohs(addr.sin_port);
+}
+
+// Sends request on a new connection and reads response of given size
+std::string Request(uint16_t port, const std::string &request, std::size_t response_size) {
+    int s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(s, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(s);
+        return "connect failed";
+    }
+
+    send(s, request.data(), request.size(), 0);
+    std::string response(response_size, '\0');
+    std::size_t done = 0;
+    ssize_t n;
+    while (done < response_size && (n = read(s, &response[done], response_size - done)) > 0) {
+        done += n;
+    }
+    close(s);
+    response.resize(done);
+    return response;
+}
+
+std::shared_ptr<Logging::Service> Logs() {
+    auto config = std::make_shared<Logging::Config>();
+    Logging::Appender &console = config->appenders["console"];
+    console.type = Logging::Appender::Type::STDOUT;
+    Logging::Logger &logger = config->loggers["root"];
+    logger.level = Logging::Logger::Level::ERROR;
+    logger.appenders.push_back("console");
+    return std::make_shared<Logging::ServiceImpl>(config);
+}
+
+} // namespace
+
+TEST(HandoverTest, NoPredecessor) {
+    std::string path = Path("none");
+    Handover handover(path);
+    EXPECT_EQ(-1, handover.Takeover());
+
+    // Path left by crashed process: socket file is kept by a link and put back once server has gone
+    std::string copy = path + "_copy";
+    {
+        Handover crashed(path);
+        crashed.Serve(Listen(), [] {});
+        ASSERT_EQ(0, access(path.c_str(), F_OK));
+        ASSERT_EQ(0, link(path.c_str(), copy.c_str()));
+    }
+    ASSERT_EQ(0, rename(copy.c_str(), path.c_str()));
+    EXPECT_EQ(-1, handover.Takeover());
+    unlink(path.c_str());
+}
+
+TEST(HandoverTest, PassesSocket) {
+    std::string path = Path("socket");
+    int server_socket = Listen();
+    std::promise<void> handed_over;
+
+    Handover old_process(path);
+    old_process.Serve(server_socket, [&handed_over] { handed_over.set_value(); });
+    EXPECT_FALSE(old_process.HandedOver());
+
+    Handover new_process(path);
+    int taken = new_process.Takeover();
+    ASSERT_NE(-1, taken);
+    EXPECT_NE(server_socket, taken);
+    EXPECT_EQ(Port(server_socket), Port(taken));
+    ASSERT_EQ(std::future_status::ready, handed_over.get_future().wait_for(std::chrono::seconds(5)));
+    EXPECT_TRUE(old_process.HandedOver());
+
+    // Successor goes on once storage is released
+    auto waited = std::async(std::launch::async, [&new_process] { new_process.WaitPredecessor(); });
+    EXPECT_EQ(std::future_status::timeout, waited.wait_for(std::chrono::milliseconds(50)));
+    old_process.Release();
+    EXPECT_EQ(std::future_status::ready, waited.wait_for(std::chrono::seconds(5)));
+
+    // And serves path for the next one
+    new_process.Serve(taken, [] {});
+    Handover next_process(path);
+    int next = next_process.Takeover();
+    ASSERT_NE(-1, next);
+    EXPECT_EQ(Port(server_socket), Port(next));
+
+    close(server_socket);
+    close(taken);
+    close(next);
+    unlink(path.c_str());
+}
+
+TEST(HandoverTest, ServerTakesOver) {
+    auto logs = Logs();
+    logs->Start();
+    auto storage = std::make_shared<Backend::ThreadSafeSimplLRU>();
+
+    int server_socket = Listen();
+    uint16_t port = Port(server_socket);
+    MTblocking::ServerImpl old_server(storage, logs);
+    old_server.Inherit(server_socket);
+    old_server.Start(port, 1, 4);
+    EXPECT_EQ(server_socket, old_server.Socket());
+    ASSERT_EQ("STORED\r\n", Request(port, "set foo 0 0 3\r\nbar\r\n", 8));
+
+    std::string path = Path("server");
+    Handover old_process(path);
+    old_process.Serve(old_server.Socket(), [] {});
+
+    Handover new_process(path);
+    MTnonblock::ServerImpl new_server(storage, logs);
+    new_server.Inherit(new_process.Takeover());
+    new_server.Start(port, 1, 1);
+
+    // Socket keeps working once old server stopped
+    old_server.Stop();
+    old_server.Join();
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ("VALUE foo 0 3\r\nbar\r\nEND\r\n", Request(port, "get foo\r\n", 25));
+    }
+
+    new_server.Stop();
+    new_server.Join();
+    logs->Stop();
+    unlink(path.c_str());
+}
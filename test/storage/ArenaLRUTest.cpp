@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include <map>
+#include <random>
+#include <string>
+
+#include "storage/ArenaLRU.h"
+
+using namespace Afina::Backend;
+
+TEST(ArenaLRUTest, Operations) {
+    ArenaLRU storage;
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_FALSE(storage.Set("KEY2", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    EXPECT_TRUE(storage.Put("KEY1", std::string(1000, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(std::string(1000, 'x'), value);
+
+    EXPECT_TRUE(storage.Put("KEY1", ""));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("", value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(ArenaLRUTest, Eviction) {
+    ArenaLRU storage(4096);
+    std::string value;
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(100, 'a' + i % 26)));
+    }
+
+    // Arena holds a few dozens of values, the oldest ones are gone
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY99", value));
+    EXPECT_EQ(std::string(100, 'a' + 99 % 26), value);
+}
+
+TEST(ArenaLRUTest, RecentlyUsedSurvive) {
+    ArenaLRU storage(4096);
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("HOT", "value"));
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(100, 'x')));
+        EXPECT_TRUE(storage.Get("HOT", value));
+    }
+    EXPECT_EQ("value", value);
+}
+
+TEST(ArenaLRUTest, TooBig) {
+    ArenaLRU storage(4096);
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.Put("KEY2", std::string(4096, 'x')));
+    EXPECT_FALSE(storage.Put("KEY1", std::string(4096, 'x')));
+
+    // Nothing is evicted for a value that doesn't fit anyway
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+}
+
+TEST(ArenaLRUTest, KeysInArena) {
+    ArenaLRU storage(4096);
+    std::string value;
+
+    // Key takes arena space as much as value does
+    EXPECT_FALSE(storage.Put(std::string(4096, 'k'), "v"));
+    std::string first(3000, 'a'), second(3000, 'b');
+    EXPECT_TRUE(storage.Put(first, "v1"));
+    EXPECT_TRUE(storage.Put(second, "v2"));
+    EXPECT_FALSE(storage.Get(first, value));
+    EXPECT_TRUE(storage.Get(second, value));
+    EXPECT_EQ("v2", value);
+
+    // Key survives resize of its entry
+    EXPECT_TRUE(storage.Set(second, std::string(500, 'x')));
+    EXPECT_TRUE(storage.Get(second, value));
+    EXPECT_EQ(std::string(500, 'x'), value);
+    EXPECT_TRUE(storage.Delete(second));
+    EXPECT_FALSE(storage.Get(second, value));
+}
+
+TEST(ArenaLRUTest, Fragmentation) {
+    // Values of random sizes replace each other, so arena gets full of holes and has to compact
+    ArenaLRU storage(64 * 1024);
+    std::map<std::string, std::string> model;
+    std::mt19937 rnd(42);
+
+    for (int i = 0; i < 20000; i++) {
+        std::string key = "key" + std::to_string(rnd() % 500);
+        switch (rnd() % 4) {
+        case 0:
+        case 1: {
+            std::string value(1 + rnd() % 1000, 'a' + rnd() % 26);
+            ASSERT_TRUE(storage.Put(key, value));
+            model[key] = value;
+            break;
+        }
+        case 2:
+            storage.Delete(key);
+            model.erase(key);
+            break;
+        default: {
+            // Entry could be evicted, but if it is there, it must be the latest one
+            std::string value;
+            if (storage.Get(key, value)) {
+                ASSERT_TRUE(model.count(key));
+                ASSERT_EQ(model[key], value);
+            }
+        }
+        }
+    }
+}
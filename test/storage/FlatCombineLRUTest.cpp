@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/FlatCombineLRU.h"
+
+using namespace Afina::Backend;
+
+TEST(FlatCombineLRUTest, Operations) {
+    FlatCombineLRU storage;
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_FALSE(storage.Set("KEY2", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(FlatCombineLRUTest, Eviction) {
+    FlatCombineLRU storage(16);
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+}
+
+TEST(FlatCombineLRUTest, ConcurrentAccess) {
+    FlatCombineLRU storage(1024 * 1024);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&storage, t] {
+            std::string value;
+            for (int i = 0; i < 1000; i++) {
+                std::string key = "key_" + std::to_string(t) + "_" + std::to_string(i);
+                ASSERT_TRUE(storage.Put(key, std::to_string(i)));
+                ASSERT_TRUE(storage.Get(key, value));
+                ASSERT_EQ(std::to_string(i), value);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::string value;
+    for (int t = 0; t < 8; t++) {
+        ASSERT_TRUE(storage.Get("key_" + std::to_string(t) + "_999", value));
+        ASSERT_EQ("999", value);
+    }
+}
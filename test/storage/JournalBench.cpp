@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/JournaledStorage.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+// Threads put 100 byte values over a key set, every operation is a change that goes to journal
+static double measure(Afina::Storage &storage, std::size_t threads, long total) {
+    const int keys = 10000;
+    const std::string value(100, 'v');
+    long per_thread = total / long(threads);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            uint64_t seed = t * 2654435761u + 1;
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            for (long i = 0; i < per_thread; i++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+                storage.Put("key" + std::to_string(seed % keys), value);
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &t : pool) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+    return double(per_thread * long(threads)) / sec / 1e6;
+}
+
+int main() {
+    const long total = 400000;
+    const std::size_t threads[] = {1, 2, 4, 8, 16};
+    const std::size_t memory = 64 * 1024 * 1024;
+    const std::string path = "/tmp/afina_journal_bench_" + std::to_string(getpid());
+    const int intervals[] = {1, 10, 100};
+
+    std::printf("%8s %10s", "threads", "off Mops/s");
+    for (int ms : intervals) {
+        std::printf("   %4dms Mops/s rec/batch", ms);
+    }
+    std::printf("\n");
+
+    for (std::size_t t : threads) {
+        ThreadSafeSimplLRU plain(memory);
+        std::printf("%8zu %10.2f", t, measure(plain, t, total));
+
+        for (int ms : intervals) {
+            unlink(path.c_str());
+            JournaledStorage journaled(std::make_shared<ThreadSafeSimplLRU>(memory), path,
+                                       std::chrono::milliseconds(ms));
+            journaled.Start();
+            journaled.Recover();
+            double speed = measure(journaled, t, total);
+            journaled.Stop();
+
+            Journal &log = journaled.Log();
+            std::printf("   %13.2f %9.0f", speed, double(log.Records()) / std::max<uint64_t>(1, log.Batches()));
+        }
+        std::printf("\n");
+    }
+    unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/Snapshot.h>
+#include <afina/metrics/Metrics.h>
+
+#include "common/FileSizeLimit.h"
+#include "common/TempFile.h"
+#include "storage/JournaledStorage.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+using Afina::Test::FileSizeLimit;
+using Afina::Test::TempFile;
+
+namespace {
+
+std::shared_ptr<JournaledStorage> Open(const std::string &path, const std::string &snapshot_path = "") {
+    auto storage = std::make_shared<JournaledStorage>(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+    storage->Start();
+    if (!snapshot_path.empty()) {
+        Afina::SnapshotReader snapshot(snapshot_path);
+        storage->Load(snapshot, 1);
+    }
+    storage->Recover();
+    return storage;
+}
+
+void SaveSnapshot(JournaledStorage &storage, const std::string &path) {
+    Afina::SnapshotWriter snapshot(path);
+    ASSERT_TRUE(storage.Save(snapshot));
+    snapshot.Commit();
+    storage.Compact();
+}
+
+std::size_t FileSize(const std::string &path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+} // namespace
+
+TEST(JournalTest, Replay) {
+    TempFile file("journal_test_replay");
+    {
+        auto storage = Open(file.path);
+        EXPECT_TRUE(storage->Put("KEY1", "val1"));
+        EXPECT_TRUE(storage->Put("KEY2", "val2"));
+        EXPECT_TRUE(storage->PutIfAbsent("KEY3", "val3"));
+        EXPECT_FALSE(storage->PutIfAbsent("KEY3", "other"));
+        EXPECT_TRUE(storage->Set("KEY1", "new1"));
+        EXPECT_FALSE(storage->Set("KEY4", "val4"));
+        EXPECT_TRUE(storage->Delete("KEY2"));
+        storage->Stop();
+        EXPECT_EQ(5, storage->Log().Records());
+    }
+
+    auto storage = Open(file.path);
+    std::string value;
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_EQ("new1", value);
+    EXPECT_FALSE(storage->Get("KEY2", value));
+    EXPECT_TRUE(storage->Get("KEY3", value));
+    EXPECT_EQ("val3", value);
+    EXPECT_FALSE(storage->Get("KEY4", value));
+
+    // New records follow replayed ones
+    EXPECT_TRUE(storage->Put("KEY2", "again"));
+    storage->Stop();
+    storage = Open(file.path);
+    EXPECT_TRUE(storage->Get("KEY2", value));
+    EXPECT_EQ("again", value);
+}
+
+TEST(JournalTest, TornTail) {
+    TempFile file("journal_test_torn");
+    std::size_t complete;
+    {
+        auto storage = Open(file.path);
+        EXPECT_TRUE(storage->Put("KEY1", "val1"));
+        storage->Log().Sync();
+        complete = FileSize(file.path);
+        EXPECT_TRUE(storage->Put("KEY2", "val2"));
+        storage->Stop();
+    }
+    ASSERT_EQ(0, truncate(file.path.c_str(), FileSize(file.path) - 3));
+
+    auto storage = Open(file.path);
+    std::string value;
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_FALSE(storage->Get("KEY2", value));
+    EXPECT_EQ(complete, FileSize(file.path));
+
+    EXPECT_TRUE(storage->Put("KEY3", "val3"));
+    storage->Stop();
+    storage = Open(file.path);
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY3", value));
+    EXPECT_EQ("val3", value);
+}
+
+TEST(JournalTest, WriteFailure) {
+    TempFile file("journal_test_failure");
+    auto storage = Open(file.path);
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    storage->Log().Sync();
+
+    int64_t errors = Afina::Metrics::Value(Afina::Metrics::Id::kJournalErrors);
+    std::string value;
+    {
+        FileSizeLimit limit(FileSize(file.path));
+        EXPECT_TRUE(storage->Put("KEY2", "val2"));
+        EXPECT_THROW(storage->Log().Sync(), std::runtime_error);
+        EXPECT_LT(errors, Afina::Metrics::Value(Afina::Metrics::Id::kJournalErrors));
+
+        // Changes are refused rather than acknowledged and lost
+        EXPECT_THROW(storage->Put("KEY3", "val3"), std::runtime_error);
+        EXPECT_FALSE(storage->Get("KEY3", value));
+
+        // Change that passed the check is logged whatever happened to journal meanwhile
+        EXPECT_NO_THROW(storage->Log().Add(Journal::Op::kPut, "KEY4", "val4"));
+    }
+
+    // Batch that failed goes out once file could grow again
+    storage->Log().Sync();
+    EXPECT_TRUE(storage->Put("KEY3", "val3"));
+    storage->Stop();
+    EXPECT_EQ(4, storage->Log().Records());
+
+    storage = Open(file.path);
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+    EXPECT_TRUE(storage->Get("KEY3", value));
+    EXPECT_TRUE(storage->Get("KEY4", value));
+}
+
+TEST(JournalTest, CompactAfterSnapshot) {
+    TempFile file("journal_test_compact");
+    TempFile snapshot("journal_test_compact_snapshot");
+    std::size_t empty;
+    {
+        auto storage = Open(file.path);
+        storage->Log().Sync();
+        empty = FileSize(file.path);
+        for (int i = 0; i < 100; i++) {
+            ASSERT_TRUE(storage->Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+        }
+        SaveSnapshot(*storage, snapshot.path);
+        EXPECT_EQ(empty, FileSize(file.path));
+
+        EXPECT_TRUE(storage->Put("KEY1", "new1"));
+        EXPECT_TRUE(storage->Delete("KEY2"));
+        storage->Stop();
+    }
+
+    // Only changes after the snapshot are replayed
+    auto storage = Open(file.path, snapshot.path);
+    std::string value;
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_EQ("new1", value);
+    EXPECT_FALSE(storage->Get("KEY2", value));
+    EXPECT_TRUE(storage->Get("KEY99", value));
+    EXPECT_EQ("val99", value);
+
+    // Sequence goes on after compaction, so new records aren't taken for covered ones
+    EXPECT_TRUE(storage->Put("KEY2", "again"));
+    storage->Stop();
+    storage = Open(file.path, snapshot.path);
+    EXPECT_TRUE(storage->Get("KEY2", value));
+    EXPECT_EQ("again", value);
+}
+
+TEST(JournalTest, SnapshotUnderLoad) {
+    TempFile file("journal_test_snapshot_load");
+    TempFile snapshot("journal_test_snapshot_load_snapshot");
+    std::vector<std::string> expected(16);
+    {
+        auto storage = Open(file.path);
+        std::atomic<bool> done(false);
+        std::thread writer([&storage, &done] {
+            for (int i = 0; !done.load(); i++) {
+                std::string key = "KEY" + std::to_string(i % 16);
+                if (i % 5 == 0) {
+                    storage->Delete(key);
+                } else {
+                    storage->Put(key, std::to_string(i));
+                }
+            }
+        });
+        for (int i = 0; i < 5; i++) {
+            SaveSnapshot(*storage, snapshot.path);
+        }
+        done = true;
+        writer.join();
+
+        for (int k = 0; k < 16; k++) {
+            storage->Get("KEY" + std::to_string(k), expected[k]);
+        }
+        storage->Stop();
+    }
+
+    auto storage = Open(file.path, snapshot.path);
+    for (int k = 0; k < 16; k++) {
+        std::string value;
+        storage->Get("KEY" + std::to_string(k), value);
+        EXPECT_EQ(expected[k], value);
+    }
+}
+
+TEST(JournalTest, NotJournal) {
+    TempFile file("journal_test_garbage");
+    FILE *f = fopen(file.path.c_str(), "w");
+    fputs("definitely not a journal", f);
+    fclose(f);
+
+    auto storage = std::make_shared<JournaledStorage>(std::make_shared<ThreadSafeSimplLRU>(), file.path);
+    EXPECT_THROW(storage->Recover(), std::runtime_error);
+}
+
+TEST(JournalTest, ConcurrentWriters) {
+    TempFile file("journal_test_concurrent");
+    const int threads = 4;
+    const int ops = 20000;
+    std::vector<std::string> expected(16);
+    {
+        auto storage = Open(file.path);
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; t++) {
+            writers.emplace_back([&storage, t] {
+                for (int i = 0; i < ops; i++) {
+                    std::string key = "KEY" + std::to_string(i % 16);
+                    if (i % 7 == t) {
+                        storage->Delete(key);
+                    } else {
+                        storage->Put(key, std::to_string(t) + ":" + std::to_string(i));
+                    }
+                }
+            });
+        }
+        for (auto &w : writers) {
+            w.join();
+        }
+        for (int k = 0; k < 16; k++) {
+            storage->Get("KEY" + std::to_string(k), expected[k]);
+        }
+        storage->Stop();
+
+        // Records are written in batches, not one by one
+        EXPECT_LT(storage->Log().Batches() * 10, storage->Log().Records());
+    }
+
+    auto storage = Open(file.path);
+    for (int k = 0; k < 16; k++) {
+        std::string value;
+        storage->Get("KEY" + std::to_string(k), value);
+        EXPECT_EQ(expected[k], value);
+    }
+}
@@ -0,0 +1,196 @@
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "common/TempFile.h"
+#include "storage/MappedLRU.h"
+
+using namespace Afina::Backend;
+using Afina::Test::TempFile;
+
+namespace {
+
+std::string ReadFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string &path, const std::string &data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+}
+
+// Flips a byte of the only place data is found at
+void Corrupt(const std::string &path, const std::string &data) {
+    std::string file = ReadFile(path);
+    std::size_t pos = file.find(data);
+    ASSERT_NE(std::string::npos, pos);
+    ASSERT_EQ(std::string::npos, file.find(data, pos + 1));
+    file[pos] ^= 1;
+    WriteFile(path, file);
+}
+
+// Small slabs, so that tests run out of memory quickly
+const std::size_t memory = 256 * 1024;
+const std::size_t slab = 16 * 1024;
+
+} // namespace
+
+TEST(MappedLRUTest, Operations) {
+    TempFile file("mapped_test_operations");
+    MappedLRU storage(file.path, memory, slab);
+    EXPECT_EQ(MappedLRU::OpenMode::kCreated, storage.Mode());
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_FALSE(storage.Set("KEY2", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    // Item moves to another class
+    EXPECT_TRUE(storage.Put("KEY1", std::string(1000, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(std::string(1000, 'x'), value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ(0, storage.Items());
+
+    EXPECT_FALSE(storage.Put("BIG", std::string(slab, 'x')));
+}
+
+TEST(MappedLRUTest, Eviction) {
+    TempFile file("mapped_test_eviction");
+    MappedLRU storage(file.path, memory, slab);
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("HOT", std::string(100, 'h')));
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(100, 'a' + i % 26)));
+        ASSERT_TRUE(storage.Get("HOT", value));
+    }
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY9999", value));
+    EXPECT_EQ(std::string(100, 'a' + 9999 % 26), value);
+}
+
+TEST(MappedLRUTest, Reattach) {
+    TempFile file("mapped_test_reattach");
+    {
+        MappedLRU storage(file.path, memory, slab);
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+        }
+        std::string value;
+        ASSERT_TRUE(storage.Get("KEY0", value));
+    }
+
+    MappedLRU storage(file.path, memory, slab);
+    EXPECT_EQ(MappedLRU::OpenMode::kAttached, storage.Mode());
+    EXPECT_EQ(1000, storage.Items());
+    std::string value;
+    for (int i = 1; i < 1000; i++) {
+        ASSERT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+        ASSERT_EQ("val" + std::to_string(i), value);
+    }
+
+    // KEY0 is now the least recently used and goes first
+    for (int i = 0; storage.Items() == 1000 + std::size_t(i); i++) {
+        ASSERT_TRUE(storage.Put("NEW" + std::to_string(i), "value"));
+    }
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+}
+
+TEST(MappedLRUTest, Locked) {
+    TempFile file("mapped_test_locked");
+    {
+        MappedLRU storage(file.path, memory, slab);
+        ASSERT_TRUE(storage.Put("KEY", "val"));
+        EXPECT_THROW(MappedLRU(file.path, memory, slab), std::runtime_error);
+
+        // Failed open leaves the file to its owner
+        std::string value;
+        ASSERT_TRUE(storage.Get("KEY", value));
+    }
+
+    MappedLRU storage(file.path, memory, slab);
+    EXPECT_EQ(MappedLRU::OpenMode::kAttached, storage.Mode());
+    EXPECT_EQ(1, storage.Items());
+}
+
+TEST(MappedLRUTest, OtherLayout) {
+    TempFile file("mapped_test_layout");
+    {
+        MappedLRU storage(file.path, memory, slab);
+        ASSERT_TRUE(storage.Put("KEY", "value"));
+    }
+
+    MappedLRU storage(file.path, memory * 2, slab);
+    EXPECT_EQ(MappedLRU::OpenMode::kCreated, storage.Mode());
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY", value));
+}
+
+TEST(MappedLRUTest, Crash) {
+    TempFile file("mapped_test_crash");
+    TempFile copy("mapped_test_crash_copy");
+    {
+        MappedLRU storage(file.path, memory, slab);
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+        }
+        ASSERT_TRUE(storage.Put("KEY5", std::string(500, 'x')));
+        ASSERT_TRUE(storage.Put("TORN", "torn value"));
+
+        // File as process left it dying, not closed
+        WriteFile(copy.path, ReadFile(file.path));
+    }
+    Corrupt(copy.path, "torn value");
+
+    MappedLRU storage(copy.path, memory, slab);
+    EXPECT_EQ(MappedLRU::OpenMode::kRecovered, storage.Mode());
+    EXPECT_EQ(1000, storage.Items());
+    std::string value;
+    EXPECT_FALSE(storage.Get("TORN", value));
+    EXPECT_TRUE(storage.Get("KEY5", value));
+    EXPECT_EQ(std::string(500, 'x'), value);
+    for (int i = 0; i < 1000; i++) {
+        if (i != 5) {
+            ASSERT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+            ASSERT_EQ("val" + std::to_string(i), value);
+        }
+    }
+
+    // Recovered storage keeps working
+    EXPECT_TRUE(storage.Put("TORN", "new value"));
+    EXPECT_TRUE(storage.Get("TORN", value));
+    EXPECT_EQ("new value", value);
+}
+
+TEST(MappedLRUTest, CorruptedSlab) {
+    TempFile file("mapped_test_corrupted");
+    {
+        MappedLRU storage(file.path, memory, slab);
+        ASSERT_TRUE(storage.Put("KEY1", "first value"));
+        ASSERT_TRUE(storage.Put("KEY2", "second value"));
+    }
+    Corrupt(file.path, "second value");
+
+    MappedLRU storage(file.path, memory, slab);
+    EXPECT_EQ(MappedLRU::OpenMode::kRecovered, storage.Mode());
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("first value", value);
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
@@ -0,0 +1,338 @@
+#include "gtest/gtest.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/SlabLRU.h"
+#include "storage/SlabRebalancer.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+using Afina::Allocator::Slab;
+
+namespace {
+
+// Small slabs, so that tests run out of memory quickly
+std::shared_ptr<Slab> MakeSlab(std::size_t memory) { return std::make_shared<Slab>(memory, 16 * 1024); }
+
+std::map<std::string, std::string> SlabStats(Afina::Storage &storage) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    EXPECT_TRUE(storage.Stats("slabs", stats));
+    return std::map<std::string, std::string>(stats.begin(), stats.end());
+}
+
+} // namespace
+
+TEST(SlabLRUTest, Operations) {
+    SlabLRU storage(MakeSlab(1024 * 1024));
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_FALSE(storage.Set("KEY2", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    // Moves to larger class and back
+    EXPECT_TRUE(storage.Put("KEY1", std::string(5000, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(std::string(5000, 'x'), value);
+    EXPECT_TRUE(storage.Put("KEY1", ""));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("", value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TEST(SlabLRUTest, ManyKeys) {
+    SlabLRU storage(MakeSlab(4 * 1024 * 1024));
+    std::string value;
+
+    // Index grows several times
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+        ASSERT_EQ("val" + std::to_string(i), value);
+    }
+}
+
+TEST(SlabLRUTest, EvictionWithinClass) {
+    SlabLRU storage(MakeSlab(64 * 1024));
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("SMALL", "value"));
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(1000, 'a' + i % 26)));
+    }
+
+    // Oldest items of the same class are gone, item of another class is not touched
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.Get("KEY999", value));
+    EXPECT_EQ(std::string(1000, 'a' + 999 % 26), value);
+    EXPECT_TRUE(storage.Get("SMALL", value));
+    EXPECT_EQ("value", value);
+}
+
+TEST(SlabLRUTest, TooBig) {
+    SlabLRU storage(MakeSlab(64 * 1024));
+    std::string value;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.Put("KEY2", std::string(16 * 1024, 'x')));
+    EXPECT_FALSE(storage.Put("KEY1", std::string(16 * 1024, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+}
+
+TEST(SlabLRUTest, SharedSlab) {
+    std::shared_ptr<Slab> slab = MakeSlab(1024 * 1024);
+    std::string value;
+    {
+        SlabLRU first(slab);
+        SlabLRU second(slab);
+        EXPECT_TRUE(first.Put("KEY", "first"));
+        EXPECT_TRUE(second.Put("KEY", "second"));
+        EXPECT_TRUE(first.Get("KEY", value));
+        EXPECT_EQ("first", value);
+    }
+
+    // Storages give chunks back on destruction
+    for (auto &cls : slab->stats()) {
+        EXPECT_EQ(0, cls.used_chunks);
+    }
+}
+
+TEST(SlabLRUTest, EvictRangeOfSharedSlab) {
+    std::shared_ptr<Slab> slab = MakeSlab(1024 * 1024);
+    SlabLRU first(slab);
+    SlabLRU second(slab);
+
+    // Items of both storages in the same slabs, with free chunks among them
+    const int count = 300;
+    for (int i = 0; i < count; i++) {
+        ASSERT_TRUE(first.Put("first_" + std::to_string(i), std::string(150, 'f')));
+        ASSERT_TRUE(second.Put("second_" + std::to_string(i), std::string(150, 's')));
+    }
+    for (int i = 0; i < count; i += 5) {
+        ASSERT_TRUE(first.Delete("first_" + std::to_string(i)));
+    }
+
+    std::size_t cls = 0;
+    while (slab->stats()[cls].used_chunks == 0) {
+        cls++;
+    }
+    ASSERT_TRUE(slab->begin_move(cls, cls + 1));
+    std::size_t moving_cls;
+    char *begin, *end;
+    ASSERT_TRUE(slab->moving_range(moving_cls, begin, end));
+
+    auto alive = [](SlabLRU &storage, const std::string &prefix) {
+        std::string value;
+        int found = 0;
+        for (int i = 0; i < count; i++) {
+            found += storage.Get(prefix + std::to_string(i), value) ? 1 : 0;
+        }
+        return found;
+    };
+
+    // Each storage evicts only its own items, and only those in the slab
+    first.EvictRange(moving_cls, begin, end);
+    int first_left = alive(first, "first_");
+    EXPECT_LT(0, first_left);
+    EXPECT_GT(count - count / 5, first_left);
+    EXPECT_EQ(count, alive(second, "second_"));
+
+    second.EvictRange(moving_cls, begin, end);
+    EXPECT_EQ(first_left, alive(first, "first_"));
+    EXPECT_GT(count, alive(second, "second_"));
+    slab->cancel_move();
+}
+
+TEST(SlabLRUTest, Stats) {
+    SlabLRU storage(MakeSlab(1024 * 1024));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "value"));
+    }
+
+    auto stats = SlabStats(storage);
+    EXPECT_EQ("1", stats["active_slabs"]);
+    EXPECT_EQ(std::to_string(16 * 1024), stats["total_malloced"]);
+    EXPECT_EQ("10", stats["1:used_chunks"]);
+    EXPECT_EQ("64", stats["1:chunk_size"]);
+
+    std::vector<std::pair<std::string, std::string>> unknown;
+    EXPECT_FALSE(storage.Stats("items", unknown));
+}
+
+TEST(SlabLRUTest, RandomWorkload) {
+    SlabLRU storage(MakeSlab(256 * 1024));
+    std::map<std::string, std::string> model;
+    std::mt19937 rnd(42);
+
+    for (int i = 0; i < 50000; i++) {
+        std::string key = "key" + std::to_string(rnd() % 1000);
+        switch (rnd() % 4) {
+        case 0:
+        case 1: {
+            std::string value(rnd() % 3000, 'a' + rnd() % 26);
+            if (storage.Put(key, value)) {
+                model[key] = value;
+            } else {
+                // Failed update must leave nothing behind
+                model.erase(key);
+                storage.Delete(key);
+            }
+            break;
+        }
+        case 2:
+            storage.Delete(key);
+            model.erase(key);
+            break;
+        default: {
+            // Entry could be evicted, but if it is there, it must be the latest one
+            std::string value;
+            if (storage.Get(key, value)) {
+                ASSERT_TRUE(model.count(key));
+                ASSERT_EQ(model[key], value);
+            }
+        }
+        }
+    }
+}
+
+TEST(SlabLRUTest, WorkloadShift) {
+    std::shared_ptr<Slab> slab = MakeSlab(1024 * 1024);
+    SlabLRU storage(slab);
+    SlabRebalancer rebalancer(slab, {&storage});
+
+    // Small values take most of slabs
+    for (int i = 0; i < 3000; i++) {
+        ASSERT_TRUE(storage.Put("small_" + std::to_string(i), std::string(200, 's')));
+    }
+
+    // Then values get larger, they have only the slabs left
+    std::string large(2000, 'l');
+    std::size_t cls = slab->class_of(2100);
+    int next = 0;
+    for (; next < 200; next++) {
+        storage.Put("large_" + std::to_string(next), large);
+    }
+    std::size_t before = slab->stats()[cls].slabs;
+    EXPECT_TRUE(rebalancer.Step());
+
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 50; i++, next++) {
+            EXPECT_TRUE(storage.Put("large_" + std::to_string(next), large));
+        }
+        rebalancer.Step();
+    }
+
+    EXPECT_LT(before, slab->stats()[cls].slabs);
+    EXPECT_LT(0, slab->slabs_moved());
+
+    // Recent large items fit now
+    std::string value;
+    for (int i = next - 100; i < next; i++) {
+        ASSERT_TRUE(storage.Get("large_" + std::to_string(i), value));
+        EXPECT_EQ(large, value);
+    }
+    auto stats = SlabStats(storage);
+    EXPECT_EQ(std::to_string(slab->slabs_moved()), stats["slabs_moved"]);
+}
+
+TEST(SlabLRUTest, Striped) {
+    std::unique_ptr<StripedLRU> storage(BuildStripedLRU(16 * 1024 * 1024, 8));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&storage, t] {
+            std::string value;
+            for (int i = 0; i < 2000; i++) {
+                std::string key = "key_" + std::to_string(t) + "_" + std::to_string(i);
+                ASSERT_TRUE(storage->Put(key, std::to_string(i)));
+                ASSERT_TRUE(storage->Get(key, value));
+                ASSERT_EQ(std::to_string(i), value);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    auto stats = SlabStats(*storage);
+    EXPECT_EQ("8000", stats["1:used_chunks"]);
+}
+
+TEST(SlabLRUTest, StripedEvictsOtherStripes) {
+    // Single slab for all stripes
+    const std::size_t stripes = 64;
+    std::unique_ptr<StripedLRU> storage(BuildStripedLRU(1024 * 1024, stripes));
+
+    // Keys of the first stripe take the whole slab
+    std::vector<std::string> keys[2];
+    for (int i = 0; keys[0].size() < 20000 || keys[1].size() < 100; i++) {
+        std::string key = "key_" + std::to_string(i);
+        std::size_t stripe = std::hash<std::string>()(key) % stripes;
+        if (stripe < 2) {
+            keys[stripe].push_back(key);
+        }
+    }
+    for (const std::string &key : keys[0]) {
+        ASSERT_TRUE(storage->Put(key, "value"));
+    }
+    auto stats = SlabStats(*storage);
+    EXPECT_EQ("0", stats["1:free_chunks_end"]);
+
+    // Second stripe has no items to evict, but still gets memory
+    std::string value;
+    for (const std::string &key : keys[1]) {
+        ASSERT_TRUE(storage->Put(key, "value"));
+        ASSERT_TRUE(storage->Get(key, value));
+        EXPECT_EQ("value", value);
+    }
+}
+
+TEST(SlabLRUTest, StuckMoveKeepsItems) {
+    std::shared_ptr<Slab> slab = MakeSlab(1024 * 1024);
+    SlabLRU owner(slab);
+    SlabLRU foreign(slab);
+    SlabRebalancer rebalancer(slab, {&owner});
+
+    // Storages fill every slab of the smallest class together, so chunks of the other one hold any move
+    const int count = 8192;
+    for (int i = 0; i < count; i++) {
+        ASSERT_TRUE(owner.Put("o_" + std::to_string(i), "12345678"));
+        ASSERT_TRUE(foreign.Put("f_" + std::to_string(i), "12345678"));
+    }
+    EXPECT_FALSE(owner.Put("large", std::string(2000, 'l')));
+
+    auto alive = [](SlabLRU &storage, const std::string &prefix) {
+        std::string value;
+        int found = 0;
+        for (int i = 0; i < count; i++) {
+            found += storage.Get(prefix + std::to_string(i), value) ? 1 : 0;
+        }
+        return found;
+    };
+    ASSERT_EQ(count, alive(owner, "o_"));
+
+    // Moves never finish and get cancelled, owner items stay
+    for (int round = 0; round < 25; round++) {
+        EXPECT_FALSE(rebalancer.Step());
+    }
+    EXPECT_EQ(0, slab->slabs_moved());
+    EXPECT_EQ(count, alive(owner, "o_"));
+    EXPECT_EQ(count, alive(foreign, "f_"));
+}
@@ -0,0 +1,240 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <afina/Snapshot.h>
+
+#include "common/TempFile.h"
+#include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Backend;
+using Afina::Test::TempFile;
+
+namespace {
+
+void Save(Storage &storage, const std::string &path) {
+    SnapshotWriter snapshot(path);
+    ASSERT_TRUE(storage.Save(snapshot));
+    snapshot.Commit();
+}
+
+void Load(Storage &storage, const std::string &path, std::size_t threads = 4) {
+    SnapshotReader snapshot(path);
+    ASSERT_TRUE(storage.Load(snapshot, threads));
+}
+
+} // namespace
+
+TEST(SnapshotTest, SimpleLRU) {
+    TempFile file("snapshot_test");
+    SimpleLRU storage(1024);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+    ASSERT_TRUE(storage.Put("EMPTY", ""));
+
+    std::string value;
+    ASSERT_TRUE(storage.Get("KEY0", value));
+    Save(storage, file.path);
+
+    SimpleLRU loaded(1024);
+    Load(loaded, file.path);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(loaded.Get("KEY" + std::to_string(i), value));
+        EXPECT_EQ("val" + std::to_string(i), value);
+    }
+    ASSERT_TRUE(loaded.Get("EMPTY", value));
+    EXPECT_EQ("", value);
+}
+
+TEST(SnapshotTest, RecencyOrder) {
+    TempFile file("snapshot_test");
+    SimpleLRU storage(90);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), "value"));
+    }
+
+    // Storage is full, KEY0 becomes the most recently used, KEY1 is the next to go
+    std::string value;
+    ASSERT_TRUE(storage.Get("KEY0", value));
+    Save(storage, file.path);
+
+    SimpleLRU loaded(90);
+    Load(loaded, file.path);
+    ASSERT_TRUE(loaded.Put("NEW", "value"));
+    EXPECT_FALSE(loaded.Get("KEY1", value));
+    EXPECT_TRUE(loaded.Get("KEY0", value));
+    EXPECT_TRUE(loaded.Get("KEY2", value));
+}
+
+TEST(SnapshotTest, SmallerStorage) {
+    TempFile file("snapshot_test");
+    SimpleLRU storage(1000);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), "value"));
+    }
+    Save(storage, file.path);
+
+    // Only the most recent items fit
+    SimpleLRU loaded(40);
+    Load(loaded, file.path);
+    std::string value;
+    EXPECT_FALSE(loaded.Get("KEY5", value));
+    EXPECT_TRUE(loaded.Get("KEY6", value));
+    EXPECT_TRUE(loaded.Get("KEY9", value));
+}
+
+TEST(SnapshotTest, ManySections) {
+    TempFile file("snapshot_test");
+    SimpleLRU storage(64 * 1024 * 1024);
+    for (int i = 0; i < 20000; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(1000, 'a' + i % 26)));
+    }
+    Save(storage, file.path);
+
+    SnapshotReader snapshot(file.path);
+    EXPECT_LT(1, snapshot.Sections());
+    EXPECT_EQ(20000, snapshot.Records());
+
+    SimpleLRU loaded(64 * 1024 * 1024);
+    ASSERT_TRUE(loaded.Load(snapshot, 4));
+    std::string value;
+    for (int i = 0; i < 20000; i++) {
+        ASSERT_TRUE(loaded.Get("KEY" + std::to_string(i), value));
+        ASSERT_EQ(std::string(1000, 'a' + i % 26), value);
+    }
+}
+
+TEST(SnapshotTest, SlabLRU) {
+    TempFile file("snapshot_test");
+    // Small slabs, so that every class gets some
+    SlabLRU storage(std::make_shared<Allocator::Slab>(4 * 1024 * 1024, 16 * 1024));
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(i, 'x')));
+    }
+    Save(storage, file.path);
+
+    SlabLRU loaded(std::make_shared<Allocator::Slab>(4 * 1024 * 1024, 16 * 1024));
+    Load(loaded, file.path);
+    std::string value;
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(loaded.Get("KEY" + std::to_string(i), value));
+        ASSERT_EQ(std::string(i, 'x'), value);
+    }
+}
+
+TEST(SnapshotTest, StripedUnderLoad) {
+    TempFile file("snapshot_test");
+    std::unique_ptr<StripedLRU> storage(BuildStripedLRU(16 * 1024 * 1024, 8));
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage->Put("KEY" + std::to_string(i), std::to_string(i)));
+    }
+
+    // Requests keep going while stripes are saved
+    std::atomic<bool> done(false);
+    std::thread writer([&] {
+        for (int i = 0; !done.load(); i++) {
+            storage->Put("OTHER" + std::to_string(i % 1000), "value");
+        }
+    });
+    Save(*storage, file.path);
+    done = true;
+    writer.join();
+
+    std::unique_ptr<StripedLRU> loaded(BuildStripedLRU(16 * 1024 * 1024, 8));
+    Load(*loaded, file.path);
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(loaded->Get("KEY" + std::to_string(i), value));
+        ASSERT_EQ(std::to_string(i), value);
+    }
+}
+
+TEST(SnapshotTest, ThreadSafeUnderLoad) {
+    TempFile file("snapshot_test");
+    ThreadSafeSimplLRU storage(64 * 1024 * 1024);
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(1000, 'a' + i % 26)));
+    }
+
+    // Items copied under lock make the snapshot, later changes don't get there
+    std::atomic<bool> done(false);
+    std::thread writer([&] {
+        for (int i = 0; !done.load(); i++) {
+            storage.Put("OTHER" + std::to_string(i % 1000), "value");
+        }
+    });
+    Save(storage, file.path);
+    done = true;
+    writer.join();
+
+    ThreadSafeSimplLRU loaded(64 * 1024 * 1024);
+    Load(loaded, file.path);
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_TRUE(loaded.Get("KEY" + std::to_string(i), value));
+        ASSERT_EQ(std::string(1000, 'a' + i % 26), value);
+    }
+}
+
+TEST(SnapshotTest, Corrupted) {
+    TempFile file("snapshot_test");
+    SimpleLRU storage(1024);
+    ASSERT_TRUE(storage.Put("KEY", "value"));
+    Save(storage, file.path);
+
+    {
+        std::fstream out(file.path, std::ios::in | std::ios::out | std::ios::binary);
+        out.seekp(20);
+        out.put('!');
+    }
+    SimpleLRU loaded(1024);
+    SnapshotReader snapshot(file.path);
+    EXPECT_THROW(loaded.Load(snapshot, 1), std::runtime_error);
+
+    std::string value;
+    EXPECT_FALSE(loaded.Get("KEY", value));
+}
+
+TEST(SnapshotTest, Truncated) {
+    TempFile file("snapshot_test");
+    SimpleLRU storage(1024);
+    ASSERT_TRUE(storage.Put("KEY", "value"));
+    Save(storage, file.path);
+
+    ASSERT_EQ(0, truncate(file.path.c_str(), 30));
+    EXPECT_THROW(SnapshotReader snapshot(file.path), std::runtime_error);
+}
+
+TEST(SnapshotTest, Unfinished) {
+    TempFile file("snapshot_test");
+    SimpleLRU storage(1024);
+    ASSERT_TRUE(storage.Put("KEY", "value"));
+    Save(storage, file.path);
+
+    // Snapshot that didn't commit leaves the previous one in place
+    ASSERT_TRUE(storage.Put("KEY", "other"));
+    {
+        SnapshotWriter snapshot(file.path);
+        ASSERT_TRUE(storage.Save(snapshot));
+    }
+    EXPECT_NE(0, access((file.path + ".tmp").c_str(), F_OK));
+
+    SimpleLRU loaded(1024);
+    Load(loaded, file.path);
+    std::string value;
+    ASSERT_TRUE(loaded.Get("KEY", value));
+    EXPECT_EQ("value", value);
+}
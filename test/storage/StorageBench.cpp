@@ -0,0 +1,76 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/FlatCombineLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+// Threads hammer storage with 90% gets and 10% puts over a small hot key set, so every operation contends
+static double measure(Afina::Storage &storage, std::size_t threads, long total) {
+    const int keys = 1000;
+    std::vector<std::string> names;
+    for (int i = 0; i < keys; i++) {
+        names.push_back("key" + std::to_string(i));
+        storage.Put(names.back(), "value" + std::to_string(i));
+    }
+
+    long per_thread = total / long(threads);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            std::string value;
+            uint64_t seed = t * 2654435761u + 1;
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            for (long i = 0; i < per_thread; i++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+                const std::string &key = names[seed % keys];
+                if (seed % 10 == 0) {
+                    storage.Put(key, "new value");
+                } else {
+                    storage.Get(key, value);
+                }
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &t : pool) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+    return double(per_thread * long(threads)) / sec / 1e6;
+}
+
+int main() {
+    const long total = 400000;
+    const std::size_t threads[] = {1, 2, 4, 8, 16, 32, 64};
+    const std::size_t memory = 64 * 1024 * 1024;
+
+    std::printf("%8s %14s %14s %14s\n", "threads", "mt_lru Mops/s", "mt_slru Mops/s", "mt_fclru Mops/s");
+    for (std::size_t t : threads) {
+        ThreadSafeSimplLRU locked(memory);
+        std::unique_ptr<StripedLRU> striped(BuildStripedLRU(memory, 16));
+        FlatCombineLRU combined(memory);
+
+        double locked_speed = measure(locked, t, total);
+        double striped_speed = measure(*striped, t, total);
+        double combined_speed = measure(combined, t, total);
+        std::printf("%8zu %14.2f %14.2f %14.2f\n", t, locked_speed, striped_speed, combined_speed);
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/trace/Trace.h>
+
+#include "common/FileSizeLimit.h"
+#include "common/TempFile.h"
+#include "sim/Simulator.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using Afina::Test::FileSizeLimit;
+using Afina::Test::TempFile;
+
+namespace {
+
+std::vector<Trace::Record> ReadAll(const std::string &path) {
+    Trace::Reader reader(path);
+    std::vector<Trace::Record> records;
+    Trace::Record record;
+    while (reader.Next(record)) {
+        records.push_back(record);
+    }
+    return records;
+}
+
+} // namespace
+
+TEST(TraceTest, RecordAndRead) {
+    TempFile file("trace_test_read");
+    Trace::Start(file.path);
+    Trace::Request(Metrics::Op::kSet, {"key"}, 10);
+    Trace::Request(Metrics::Op::kGet, {"key", "other key"}, 0);
+    Trace::Stop();
+
+    // Stopped trace records nothing
+    Trace::Request(Metrics::Op::kGet, {"key"}, 0);
+
+    EXPECT_EQ(3u, Trace::Written());
+    EXPECT_EQ(0u, Trace::Dropped());
+
+    Trace::Reader reader(file.path);
+    EXPECT_EQ(1u, reader.header().sample);
+
+    std::vector<Trace::Record> records = ReadAll(file.path);
+    ASSERT_EQ(3u, records.size());
+    EXPECT_EQ(static_cast<uint8_t>(Metrics::Op::kSet), records[0].op);
+    EXPECT_EQ(Trace::Hash("key"), records[0].key_hash);
+    EXPECT_EQ(3u, records[0].key_size);
+    EXPECT_EQ(10u, records[0].value_size);
+
+    EXPECT_EQ(static_cast<uint8_t>(Metrics::Op::kGet), records[1].op);
+    EXPECT_EQ(Trace::Hash("key"), records[1].key_hash);
+    EXPECT_EQ(Trace::Hash("other key"), records[2].key_hash);
+    EXPECT_EQ(9u, records[2].key_size);
+    EXPECT_LE(records[0].time, records[1].time);
+}
+
+TEST(TraceTest, OrderedByTime) {
+    TempFile file("trace_test_order");
+    Trace::Start(file.path);
+    Trace::Request(Metrics::Op::kGet, {"first"}, 0);
+    std::thread other([] { Trace::Request(Metrics::Op::kGet, {"second"}, 0); });
+    other.join();
+    Trace::Request(Metrics::Op::kGet, {"third"}, 0);
+    Trace::Stop();
+
+    // Two requests of this thread sit in one buffer, the other one comes from another
+    std::vector<Trace::Record> records = ReadAll(file.path);
+    ASSERT_EQ(3u, records.size());
+    EXPECT_EQ(Trace::Hash("first"), records[0].key_hash);
+    EXPECT_EQ(Trace::Hash("second"), records[1].key_hash);
+    EXPECT_EQ(Trace::Hash("third"), records[2].key_hash);
+}
+
+TEST(TraceTest, SampleByKey) {
+    TempFile file("trace_test_sample");
+    Trace::Start(file.path, 4);
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 1000; i++) {
+            Trace::Request(Metrics::Op::kGet, {"key" + std::to_string(i)}, 0);
+        }
+    }
+    Trace::Stop();
+
+    std::vector<Trace::Record> records = ReadAll(file.path);
+    EXPECT_GT(records.size(), 2 * 150u);
+    EXPECT_LT(records.size(), 2 * 350u);
+
+    // Sampled key has all of its requests
+    EXPECT_EQ(0u, records.size() % 2);
+    for (auto &record : records) {
+        EXPECT_EQ(0u, record.key_hash % 4);
+    }
+}
+
+TEST(TraceTest, DropWhenBufferIsFull) {
+    TempFile file("trace_test_drop");
+    Trace::Start(file.path, 1, 2 * sizeof(Trace::Record));
+    for (int i = 0; i < 10; i++) {
+        Trace::Request(Metrics::Op::kGet, {"key"}, 0);
+    }
+    Trace::Stop();
+
+    EXPECT_EQ(10u, Trace::Written() + Trace::Dropped());
+    EXPECT_GE(Trace::Dropped(), 1u);
+    EXPECT_EQ(Trace::Written(), ReadAll(file.path).size());
+}
+
+TEST(TraceTest, WriteFailure) {
+    TempFile file("trace_test_failure");
+    Trace::Start(file.path);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    {
+        // Room for ten records and a part of the next one
+        FileSizeLimit limit(sizeof(Trace::Header) + 10 * sizeof(Trace::Record) + 7);
+        Trace::Request(Metrics::Op::kGet, keys, 0);
+        for (int i = 0; i < 500 && Trace::detail::enabled.load(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // Trace is off after failure
+    EXPECT_FALSE(Trace::detail::enabled.load());
+    Trace::Request(Metrics::Op::kGet, keys, 0);
+    Trace::Stop();
+    EXPECT_EQ(10u, Trace::Written());
+    EXPECT_EQ(90u, Trace::Dropped());
+
+    // File ends at the last complete record
+    std::FILE *f = std::fopen(file.path.c_str(), "rb");
+    ASSERT_NE(nullptr, f);
+    std::fseek(f, 0, SEEK_END);
+    EXPECT_EQ(long(sizeof(Trace::Header) + 10 * sizeof(Trace::Record)), std::ftell(f));
+    std::fclose(f);
+
+    std::vector<Trace::Record> records = ReadAll(file.path);
+    ASSERT_EQ(10u, records.size());
+    EXPECT_EQ(Trace::Hash("key0"), records[0].key_hash);
+
+    // Next trace starts over
+    Trace::Start(file.path);
+    Trace::Request(Metrics::Op::kGet, {"key"}, 0);
+    Trace::Stop();
+    EXPECT_EQ(1u, Trace::Written());
+    EXPECT_EQ(0u, Trace::Dropped());
+}
+
+TEST(TraceTest, NotTrace) {
+    TempFile file("trace_test_not_trace");
+    FILE *f = std::fopen(file.path.c_str(), "w");
+    std::fputs("definitely not a trace file", f);
+    std::fclose(f);
+
+    EXPECT_THROW(Trace::Reader reader(file.path), std::runtime_error);
+    EXPECT_THROW(Trace::Reader reader(file.path + "_missing"), std::runtime_error);
+}
+
+TEST(SimulatorTest, Replay) {
+    TempFile file("trace_test_replay");
+    Trace::Start(file.path);
+    Trace::Request(Metrics::Op::kSet, {"a"}, 10);
+    Trace::Request(Metrics::Op::kSet, {"b"}, 10);
+    Trace::Request(Metrics::Op::kGet, {"a", "c"}, 0);
+    Trace::Request(Metrics::Op::kAdd, {"a"}, 10);
+    Trace::Request(Metrics::Op::kDelete, {"a"}, 0);
+    Trace::Request(Metrics::Op::kGet, {"a"}, 0);
+    Trace::Request(Metrics::Op::kGet, {"a"}, 0);
+    Trace::Stop();
+
+    Trace::Reader trace(file.path);
+    Backend::SimpleLRU storage(1024);
+    Sim::Result result = Sim::Replay(trace, storage, false);
+    EXPECT_EQ(4u, result.gets);
+    EXPECT_EQ(1u, result.hits);
+    EXPECT_EQ(3u, result.sets);
+    EXPECT_EQ(2u, result.stored);
+    EXPECT_EQ(1u, result.deletes);
+
+    // Missed get brings the key back
+    Trace::Reader again(file.path);
+    Backend::SimpleLRU filled(1024);
+    result = Sim::Replay(again, filled, true);
+    EXPECT_EQ(2u, result.hits);
+}
+
+TEST(SimulatorTest, HitRatioGrowsWithMemory) {
+    TempFile file("trace_test_curve");
+    Trace::Start(file.path);
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 100; i++) {
+            std::string key = "key" + std::to_string(i);
+            Trace::Request(Metrics::Op::kGet, {key}, 0);
+            Trace::Request(Metrics::Op::kSet, {key}, 100);
+        }
+    }
+    Trace::Stop();
+
+    // Keys go round in a cycle, so LRU smaller than the working set never hits
+    for (auto &engine : Sim::Engines()) {
+        Trace::Reader small_trace(file.path);
+        auto small_storage = Sim::Build(engine, engine == "mt_slru" ? 1024 * 1024 : 5 * 1024);
+        Trace::Reader large_trace(file.path);
+        auto large_storage = Sim::Build(engine, 64 * 1024 * 1024);
+
+        double small = Sim::Replay(small_trace, *small_storage, false).HitRatio();
+        double large = Sim::Replay(large_trace, *large_storage, false).HitRatio();
+        EXPECT_NEAR(0.9, large, 0.001) << engine;
+        EXPECT_LE(small, large) << engine;
+    }
+}
+
+TEST(SimulatorTest, ParseSize) {
+    EXPECT_EQ(100u, Sim::ParseSize("100"));
+    EXPECT_EQ(2048u, Sim::ParseSize("2K"));
+    EXPECT_EQ(3u * 1024 * 1024, Sim::ParseSize("3M"));
+    EXPECT_EQ(1024u * 1024 * 1024, Sim::ParseSize("1G"));
+    EXPECT_THROW(Sim::ParseSize("M"), std::runtime_error);
+    EXPECT_THROW(Sim::ParseSize("10X"), std::runtime_error);
+}